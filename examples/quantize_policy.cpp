@@ -0,0 +1,107 @@
+/// @file quantize_policy.cpp
+/// @brief 策略量化工具：把fp32策略转换为fp16或int8的safetensors，int8按 DataLogger 记录的观察CSV标定
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/mlp_policy.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void PrintUsage(const char* program) {
+    std::cerr << "Usage: " << program << " INPUT OUTPUT.safetensors --precision=int8|fp16 [OBSERVATION_CSV ...]\n"
+              << "  INPUT            fp32 policy (.safetensors or .mlp, see scripts/export_policy.py)\n"
+              << "  OBSERVATION_CSV  *_observation.csv recorded by DataLogger; required for int8, which calibrates\n"
+              << "                   the range of every layer input on them. The action error against fp32 is\n"
+              << "                   reported over the same observations." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> paths;
+    std::string precision_name;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--precision=", 12) == 0) {
+            precision_name = argv[i] + 12;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    WeightPrecision precision;
+    if (paths.size() < 2 || !ParsePrecision(precision_name, &precision) || precision == WeightPrecision::kFloat32) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::string error;
+    MlpPolicy reference;
+    if (!reference.Load(paths[0], &error)) {
+        std::cerr << "Failed to load " << paths[0] << ": " << error << std::endl;
+        return 1;
+    }
+    std::cout << "Loaded " << paths[0] << ": " << reference.Describe() << std::endl;
+
+    const size_t observation_size = reference.InputSize();
+    std::vector<float> observations;
+    for (size_t i = 2; i < paths.size(); ++i) {
+        if (!ReadObservationCsv(paths[i], observation_size, &observations, &error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+    const size_t samples = observations.size() / observation_size;
+    if (precision == WeightPrecision::kInt8 && samples == 0) {
+        std::cerr << "int8 needs recorded observations to calibrate the input ranges" << std::endl;
+        return 1;
+    }
+
+    std::vector<float> input_ranges;
+    for (size_t row = 0; row < samples; ++row) {
+        reference.CalibrateInputRanges(observations.data() + row * observation_size, observation_size, &input_ranges);
+    }
+    if (samples > 0) {
+        std::cout << "Calibrated on " << samples << " observations, largest input range per layer:";
+        // input_ranges 按层依次排列各输入维的范围
+        size_t offset = 0;
+        for (size_t layer = 0; layer < reference.LayerCount(); ++layer) {
+            auto begin = input_ranges.begin() + offset;
+            offset += reference.LayerInputSize(layer);
+            std::cout << " " << *std::max_element(begin, input_ranges.begin() + offset);
+        }
+        std::cout << std::endl;
+    }
+
+    MlpPolicy quantized;
+    if (!quantized.Quantize(reference, precision, input_ranges, &error) ||
+        !quantized.SaveSafetensors(paths[1], &error)) {
+        std::cerr << "Failed to quantize: " << error << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << paths[1] << ": " << quantized.Describe() << ", " << quantized.WeightBytes() / 1024
+              << " kB of weights (fp32 " << reference.WeightBytes() / 1024 << " kB)" << std::endl;
+
+    if (samples > 0) {
+        std::vector<float> expected(reference.OutputSize());
+        std::vector<float> actual(quantized.OutputSize());
+        double max_error = 0.0;
+        double max_action = 0.0;
+        double sum_error = 0.0;
+        for (size_t row = 0; row < samples; ++row) {
+            const float* observation = observations.data() + row * observation_size;
+            reference.Evaluate(observation, observation_size, expected.data());
+            quantized.Evaluate(observation, observation_size, actual.data());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                double difference = std::fabs(static_cast<double>(actual[i]) - expected[i]);
+                max_error = std::max(max_error, difference);
+                max_action = std::max(max_action, std::fabs(static_cast<double>(expected[i])));
+                sum_error += difference;
+            }
+        }
+        std::cout << "Action error against fp32: max " << max_error << " ("
+                  << (max_action > 0.0 ? 100.0 * max_error / max_action : 0.0) << "% of the largest action), mean "
+                  << sum_error / static_cast<double>(samples * expected.size()) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+/// @file shm_echo_server.cpp
+/// @brief 共享内存推理服务器参考实现：回显观察的前12个元素作为动作
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/shm_transport.h"
+#include <csignal>
+#include <iostream>
+#include <string>
+
+static ShmServer* g_server = nullptr;
+
+static void HandleSignal(int) {
+    // Stop() 只写一个原子变量，Run() 至多在一个等待周期后返回
+    if (g_server != nullptr) {
+        g_server->Stop();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string name = argc > 1 ? argv[1] : "lite3_inference";
+
+    ShmServer server(name);
+    if (!server.Create()) {
+        return 1;
+    }
+    g_server = &server;
+    signal(SIGINT, HandleSignal);
+    signal(SIGTERM, HandleSignal);
+
+    std::cout << "Serving echo actions on /dev/shm/" << name << " (client address shm:" << name << ")" << std::endl;
+    server.Run(&ShmServer::Echo);
+    std::cout << "Shared memory server stopped" << std::endl;
+    return 0;
+}
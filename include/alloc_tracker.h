@@ -0,0 +1,66 @@
+/// @file alloc_tracker.h
+/// @brief 控制线程的堆分配检查
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef ALLOC_TRACKER_H_
+#define ALLOC_TRACKER_H_
+
+#include <cstdint>
+
+/// @brief 当前线程所处的阶段（ControlPhase），-1表示不在任何阶段内
+extern __thread int g_alloc_tracker_phase;
+
+/// @brief 堆分配检查器
+///
+/// src/alloc_hooks.cpp 替换全局的 operator new、malloc/calloc/realloc 以及 posix_memalign/aligned_alloc/
+/// memalign/valloc（转发给glibc的 __libc_* 实现）。该文件只链接进控制程序与检查分配的测试，
+/// 未链接时本检查器不计数。
+/// 默认关闭，此时每次分配只多一次原子读。打开后，只统计被 TrackCurrentThread() 标记的线程
+/// 在 Arm()（预热结束）之后的分配，并按 ScopedPhase 所标记的阶段归类；kAbort 模式下
+/// 首次分配即终止程序，便于在调试器中定位调用栈。
+class AllocTracker {
+public:
+    enum Mode {
+        kOff = 0,
+        kReport,   // 统计并在退出时报告
+        kAbort,    // 预热后一旦分配即 abort()
+    };
+
+    /// @brief 设置模式（在启动控制线程前调用）
+    static void SetMode(Mode mode);
+
+    /// @brief 当前模式
+    static Mode GetMode();
+
+    /// @brief 将当前线程标记为受检查线程
+    static void TrackCurrentThread();
+
+    /// @brief 预热结束，开始统计
+    static void Arm();
+
+    /// @brief 停止统计（退出阶段的清理允许分配）
+    static void Disarm();
+
+    /// @brief 预热后受检查线程的分配总次数
+    static uint64_t TotalCount();
+
+    /// @brief 某阶段内的分配次数
+    /// @param phase ControlPhase，-1表示不在任何阶段内
+    static uint64_t PhaseCount(int phase);
+
+    /// @brief 打印统计报告
+    static void PrintReport();
+
+    /// @brief 记录一次分配（由 alloc_hooks.cpp 中的分配函数调用；不得分配内存）
+    static void RecordAllocation();
+
+    /// @brief 设置当前线程的阶段，返回之前的阶段（供 ScopedPhase 使用）
+    static int SwapPhase(int phase) {
+        int previous = g_alloc_tracker_phase;
+        g_alloc_tracker_phase = phase;
+        return previous;
+    }
+};
+
+#endif  // ALLOC_TRACKER_H_
@@ -0,0 +1,204 @@
+/// @file async_logger.h
+/// @brief 异步、限频的控制台日志
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef ASYNC_LOGGER_H_
+#define ASYNC_LOGGER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+/// @brief 日志级别
+enum LogLevel : uint8_t {
+    kLogInfo = 0,   // 输出到stdout
+    kLogWarn,       // 输出到stderr
+    kLogError,      // 输出到stderr
+};
+
+/// @brief 日志参数（整数、浮点或复制进记录的字符串）
+struct LogArg {
+    enum Type : uint8_t { kInt, kUInt, kDouble, kString };
+    Type type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        uint16_t str_offset;  // 字符串在记录内联缓冲中的偏移
+    };
+};
+
+/// @brief 定长日志记录，由写线程填充、后台线程格式化
+struct LogRecord {
+    static constexpr int kMaxArgs = 6;
+    static constexpr int kInlineTextSize = 80;
+
+    uint64_t stamp_ns;                   // 写入时刻（CLOCK_MONOTONIC）
+    const char* format;                  // 格式串，须为静态字符串，"{}" 为占位符
+    uint32_t suppressed;                 // 上次输出后被限频/去重丢弃的条数
+    LogLevel level;
+    uint8_t arg_count;
+    uint16_t text_used;
+    LogArg args[kMaxArgs];
+    char text[kInlineTextSize];          // 字符串参数的内联存储（超长截断）
+};
+
+/// @brief 日志调用点的限频与去重状态，每个调用点一个静态实例
+///
+/// 同一调用点通常只在一个线程中使用，状态读写不加锁。
+struct LogSite {
+    LogSite(int64_t min_interval_ms, bool dedup)
+        : min_interval_ns(static_cast<uint64_t>(min_interval_ms) * 1000000ULL), dedup(dedup),
+          last_emit_ns(0), last_hash(0), suppressed(0) {
+    }
+
+    uint64_t min_interval_ns;   // 两条输出的最小间隔，0为不限频
+    bool dedup;                 // 是否合并重复内容
+    uint64_t last_emit_ns;
+    uint64_t last_hash;
+    uint32_t suppressed;
+};
+
+/// @brief 异步日志器
+///
+/// 写线程只把格式串指针和参数拷贝进预分配的无锁环形队列（多写者、单读者），
+/// 不格式化、不分配内存、不做系统调用；队列满时丢弃并计数，绝不阻塞。
+/// 后台线程每隔数毫秒取出记录，格式化后一次性写到终端。
+class AsyncLogger {
+public:
+    /// @brief 全局实例
+    static AsyncLogger& Instance();
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    /// @brief 启动后台输出线程（Start前写入的记录会保留到启动后输出）
+    void Start();
+
+    /// @brief 输出剩余记录并停止后台线程
+    void Stop();
+
+    /// @brief 写入一条日志
+    /// @param level 级别
+    /// @param site 调用点状态，可为nullptr（不限频、不去重）
+    /// @param format 静态格式串，"{}" 依次替换为参数
+    /// @param args 参数：整数、浮点、const char* 或 std::string，最多 LogRecord::kMaxArgs 个
+    template <typename... Args>
+    void Log(LogLevel level, LogSite* site, const char* format, const Args&... args) {
+        static_assert(sizeof...(Args) <= LogRecord::kMaxArgs, "too many log arguments");
+        LogRecord record;
+        record.stamp_ns = NowNs();
+        record.format = format;
+        record.level = level;
+        record.arg_count = 0;
+        record.text_used = 0;
+        int expand[] = {0, (AppendArg(&record, args), 0)...};
+        (void)expand;
+        Submit(site, &record);
+    }
+
+    /// @brief 因队列满而丢弃的记录数
+    uint64_t DroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+    /// @brief 将记录格式化为一行文本（供后台线程与测试使用）
+    static std::string Format(const LogRecord& record);
+
+private:
+    static constexpr size_t kCapacity = 1024;  // 须为2的幂
+
+    struct Cell {
+        std::atomic<uint64_t> sequence;
+        LogRecord record;
+    };
+
+    AsyncLogger();
+    ~AsyncLogger();
+
+    static uint64_t NowNs();
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type
+    AppendArg(LogRecord* record, const T& value) {
+        LogArg& arg = record->args[record->arg_count++];
+        if (std::is_signed<T>::value) {
+            arg.type = LogArg::kInt;
+            arg.i = static_cast<int64_t>(value);
+        } else {
+            arg.type = LogArg::kUInt;
+            arg.u = static_cast<uint64_t>(value);
+        }
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type
+    AppendArg(LogRecord* record, const T& value) {
+        LogArg& arg = record->args[record->arg_count++];
+        arg.type = LogArg::kDouble;
+        arg.d = static_cast<double>(value);
+    }
+
+    static void AppendArg(LogRecord* record, bool value) {
+        AppendString(record, value ? "true" : "false", value ? 4 : 5);
+    }
+
+    static void AppendArg(LogRecord* record, const char* value) {
+        AppendString(record, value, value ? strlen(value) : 0);
+    }
+
+    static void AppendArg(LogRecord* record, const std::string& value) {
+        AppendString(record, value.data(), value.size());
+    }
+
+    static void AppendString(LogRecord* record, const char* value, size_t length);
+
+    /// @brief 限频、去重后放入队列
+    void Submit(LogSite* site, LogRecord* record);
+
+    /// @brief 放入队列（多写者）
+    bool Push(const LogRecord& record);
+
+    /// @brief 取出一条记录（仅后台线程）
+    bool Pop(LogRecord* record);
+
+    /// @brief 取出并输出所有记录
+    void Drain();
+
+    void Run();
+
+    Cell* cells_;
+    std::atomic<uint64_t> enqueue_pos_;
+    uint64_t dequeue_pos_;
+    std::atomic<uint64_t> dropped_;
+    uint64_t reported_dropped_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_;
+};
+
+/// @brief 每条都输出
+#define ASYNC_LOG(level, ...) \
+    AsyncLogger::Instance().Log(level, nullptr, __VA_ARGS__)
+
+/// @brief 同一调用点至多每 interval_ms 毫秒输出一条，期间丢弃的条数附在下一条之后
+#define ASYNC_LOG_EVERY_MS(level, interval_ms, ...)                          \
+    do {                                                                     \
+        static LogSite async_log_site_((interval_ms), false);                \
+        AsyncLogger::Instance().Log(level, &async_log_site_, __VA_ARGS__);   \
+    } while (0)
+
+/// @brief 同一调用点连续的相同内容只输出一次（至多每秒提示一次重复次数）
+#define ASYNC_LOG_DEDUP(level, ...)                                          \
+    do {                                                                     \
+        static LogSite async_log_site_(0, true);                             \
+        AsyncLogger::Instance().Log(level, &async_log_site_, __VA_ARGS__);   \
+    } while (0)
+
+#endif  // ASYNC_LOGGER_H_
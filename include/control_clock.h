@@ -0,0 +1,68 @@
+/// @file control_clock.h
+/// @brief 控制时钟抽象：真实时钟与仿真时钟
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef CONTROL_CLOCK_H_
+#define CONTROL_CLOCK_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/// @brief 控制时钟
+///
+/// 控制循环、MotionSpline 的插值时间以及 EventReactor 的定时器都以该时钟为准。
+/// 真实时钟跟随 CLOCK_MONOTONIC；仿真时钟只在 EventReactor 推进时前进，
+/// 控制逻辑因此可以远快于真实时间运行。
+class ControlClock {
+public:
+    virtual ~ControlClock() = default;
+
+    /// @brief 当前时间（纳秒），起点由具体实现决定
+    virtual uint64_t NowNs() const = 0;
+
+    /// @brief 是否为仿真时钟
+    virtual bool IsSimulated() const = 0;
+
+    /// @brief 当前时间，表示为 steady_clock 的时间点
+    ///
+    /// 真实时钟与 steady_clock 同为 CLOCK_MONOTONIC，两者的时间点可以互相比较；
+    /// 仿真时钟的时间点只能与同一时钟取得的时间点比较。
+    std::chrono::steady_clock::time_point Now() const {
+        return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(NowNs()));
+    }
+
+    /// @brief 当前时间（秒），对应 DRTimer::GetCurrentTime()
+    double GetCurrentTime() const { return NowNs() * 1e-9; }
+
+    /// @brief 相对于start_time的时间（秒），对应 DRTimer::GetIntervalTime()
+    double GetIntervalTime(double start_time) const { return GetCurrentTime() - start_time; }
+};
+
+/// @brief 真实时钟（CLOCK_MONOTONIC，与 DRTimer 相同）
+class RealTimeClock : public ControlClock {
+public:
+    uint64_t NowNs() const override;
+    bool IsSimulated() const override { return false; }
+};
+
+/// @brief 仿真时钟，从0开始，只能由推进者（EventReactor）向前拨动
+class SimulatedClock : public ControlClock {
+public:
+    SimulatedClock() : now_ns_(0) {}
+
+    uint64_t NowNs() const override { return now_ns_.load(std::memory_order_acquire); }
+    bool IsSimulated() const override { return true; }
+
+    /// @brief 将时间推进到time_ns（早于当前时间时忽略）
+    void AdvanceTo(uint64_t time_ns);
+
+    /// @brief 将时间推进delta_ns
+    void Advance(uint64_t delta_ns) { AdvanceTo(NowNs() + delta_ns); }
+
+private:
+    std::atomic<uint64_t> now_ns_;
+};
+
+#endif  // CONTROL_CLOCK_H_
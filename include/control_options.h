@@ -0,0 +1,54 @@
+/// @file control_options.h
+/// @brief 控制程序的命令行参数
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef CONTROL_OPTIONS_H_
+#define CONTROL_OPTIONS_H_
+
+#include <string>
+#include "alloc_tracker.h"
+#include "rt_profile.h"
+#include "stale_action_policy.h"
+
+/// @brief 控制程序的运行参数
+struct ControlOptions {
+    std::string server_address = "localhost:50151";  // 推理服务器地址
+    RtConfig rt;                                      // 实时配置
+    int profile_period_s = 10;                        // 阶段延迟汇总的打印周期（秒），0为只在退出时打印
+    bool state_triggered = false;                     // 由机器人状态包驱动控制周期，而非本地定时器
+    int state_decimation = 1;                         // 状态触发模式下每N个状态包执行一个控制周期
+    bool sim_clock = false;                           // 使用仿真时钟，控制逻辑尽可能快地运行
+    int sim_duration_s = 0;                           // 仿真时钟下运行的仿真时长（秒），0为直到按下Esc
+    AllocTracker::Mode alloc_check = AllocTracker::kOff;  // 预热后控制线程的堆分配检查
+    std::string trace_path;                           // 时间线导出文件，空为不记录
+    int grpc_async = 0;                               // 异步推理的在途请求上限，0为使用推理线程同步调用
+    bool grpc_stream = false;                         // 推理线程使用 StreamPredict 长连接流
+    bool grpc_session = false;                        // 推理线程使用 OpenSession 协商后的紧凑会话请求
+    bool trace_inference = false;                     // 追踪推理的网络、服务器排队与模型计算耗时
+    int grpc_health_period_ms = 500;                  // 后台健康检查与重连的周期（毫秒），0为关闭
+    std::string grpc_hedge_address;                   // 对冲请求的备用服务器地址，空为不对冲
+    double grpc_hedge_after = 0.5;                    // 主服务器超过该比例的策略周期未应答时发出对冲请求
+    bool eval_both_terrains = false;                  // 每次推理都通过 BatchPredict 同时评估两个地形模型
+    bool recurrent = false;                           // 策略为循环策略：记录隐状态的范数
+    std::string shadow_address;                       // 影子策略（只记录、不驱动）的服务器地址，空为不评估
+    std::string shadow_model;                         // 影子策略的模型类型，空为与在线策略相同
+    double inference_deadline = 1.0;                  // 单个推理请求的截止时间（策略周期的倍数）
+    StaleActionConfig stale_action;                   // 错过截止时间后的动作处理（策略周期由主程序设置）
+};
+
+/// @brief 解析命令行参数
+///
+/// 用法：Lite_motion [server_address] [--option[=value] ...]
+/// 第一个不以 "--" 开头的参数为服务器地址，以保持与原有用法兼容。
+/// @param argc 参数个数
+/// @param argv 参数列表
+/// @param options 输出：解析得到的参数
+/// @return 是否解析成功（遇到 --help 或未知参数时返回false）
+bool ParseControlOptions(int argc, char* argv[], ControlOptions* options);
+
+/// @brief 打印用法说明
+/// @param program 程序名
+void PrintControlUsage(const char* program);
+
+#endif  // CONTROL_OPTIONS_H_
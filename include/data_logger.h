@@ -6,6 +6,7 @@
 #include <fstream>
 #include <iostream>
 #include "grpc_client.h"
+#include "inference_timing.h"
 
 /// @brief 数据记录器类，用于保存机器人数据到CSV文件
 class DataLogger {
@@ -39,6 +40,41 @@ public:
     /// @return 是否成功保存
     bool SaveAction(int timestamp, const RobotAction& action);
     
+    /// @brief 同时记录推理延迟分解（须在Initialize()前调用）
+    void EnableInferenceTiming() { inference_timing_enabled_ = true; }
+    
+    /// @brief 保存推理延迟分解（各列为纳秒）
+    /// @param timestamp 时间戳
+    /// @param timing 推理延迟分解
+    /// @return 是否成功保存
+    bool SaveInferenceTiming(int timestamp, const InferenceTiming& timing);
+    
+    /// @brief 同时记录循环策略的隐状态范数（须在Initialize()前调用）
+    void EnableRecurrentState() { recurrent_state_enabled_ = true; }
+    
+    /// @brief 保存循环策略隐状态的维数与L2范数
+    /// @param timestamp 时间戳
+    /// @param state_size 隐状态维数
+    /// @param state_norm 隐状态的L2范数
+    /// @return 是否成功保存
+    bool SaveRecurrentState(int timestamp, int state_size, float state_norm);
+    
+    /// @brief 同时记录影子策略的动作（须在Initialize()前调用）
+    void EnableShadowAction() { shadow_action_enabled_ = true; }
+    
+    /// @brief 保存同一观察下在线策略与影子策略的原始动作
+    /// @param timestamp 时间戳
+    /// @param seq 观察序号
+    /// @param live_action 在线策略的12个原始动作
+    /// @param shadow_action 影子策略的12个原始动作
+    /// @return 是否成功保存
+    bool SaveShadowAction(int timestamp, uint64_t seq, const float* live_action, const float* shadow_action);
+    
+    /// @brief 将缓冲的数据写入文件
+    ///
+    /// Save* 只写入流缓冲，不逐行刷新；由调用者以较低频率（如10Hz）调用本函数。
+    void Flush();
+    
     /// @brief 关闭所有文件
     void Close();
     
@@ -49,16 +85,25 @@ public:
 private:
     std::string base_filename_;
     bool initialized_;
+    bool inference_timing_enabled_;
+    bool recurrent_state_enabled_;
+    bool shadow_action_enabled_;
     
     // 文件流
     std::ofstream observation_file_;
     std::ofstream raw_action_file_;
     std::ofstream action_file_;
+    std::ofstream inference_timing_file_;
+    std::ofstream recurrent_state_file_;
+    std::ofstream shadow_action_file_;
     
     // 文件名
     std::string observation_filename_;
     std::string raw_action_filename_;
     std::string action_filename_;
+    std::string inference_timing_filename_;
+    std::string recurrent_state_filename_;
+    std::string shadow_action_filename_;
     
     /// @brief 写入CSV头部
     /// @param file 文件流
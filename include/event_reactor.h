@@ -0,0 +1,117 @@
+/// @file event_reactor.h
+/// @brief 基于epoll的事件反应器，用于驱动控制循环
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef EVENT_REACTOR_H_
+#define EVENT_REACTOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "control_clock.h"
+
+/// @brief 事件反应器
+///
+/// 所有事件源（周期定时器、eventfd通知、任意文件描述符）都注册到同一个epoll实例上，
+/// Run() 在单次 epoll_wait 中等待，只有就绪的事件源才会调用对应的处理函数。
+/// 除 Notify() 与 Stop() 外，所有接口都只能在运行 Run() 的线程中调用。
+///
+/// 使用仿真时钟时，定时器不再对应timerfd：Run() 先无等待地处理已就绪的fd事件，
+/// 再把时钟直接拨到最早到期的定时器并触发它，因此控制逻辑以CPU所能达到的最快速度运行。
+class EventReactor {
+public:
+    /// @brief 事件处理函数
+    /// @param count 定时器为到期次数（大于1表示错过了周期），eventfd为累计通知次数，普通文件描述符为0
+    using Handler = std::function<void(uint64_t count)>;
+
+    /// @brief 构造函数
+    /// @param clock 定时器所用的时钟，nullptr或真实时钟时使用timerfd；仿真时钟由本对象推进
+    explicit EventReactor(ControlClock* clock = nullptr);
+    ~EventReactor();
+
+    EventReactor(const EventReactor&) = delete;
+    EventReactor& operator=(const EventReactor&) = delete;
+
+    /// @brief 初始化epoll实例
+    /// @return 是否成功
+    bool Initialize();
+
+    /// @brief 注册周期定时器（CLOCK_MONOTONIC timerfd）
+    /// @param period_us 周期（微秒）
+    /// @param handler 到期时调用的处理函数
+    /// @return 定时器的文件描述符（仿真时钟下为非负的定时器编号），失败返回-1
+    int AddTimer(int64_t period_us, Handler handler);
+
+    /// @brief 注册跨线程通知源（eventfd）
+    /// @param handler 收到通知时调用的处理函数
+    /// @return eventfd文件描述符，供 Notify() 使用，失败返回-1
+    int AddNotifier(Handler handler);
+
+    /// @brief 注册任意可读文件描述符，处理函数负责读取数据
+    /// @param fd 文件描述符（所有权仍归调用者）
+    /// @param handler 可读时调用的处理函数
+    /// @return 是否成功
+    bool AddFd(int fd, Handler handler);
+
+    /// @brief 触发一个通知源，可在任意线程（包括接收线程）调用
+    /// @param notifier_fd AddNotifier() 返回的文件描述符
+    static void Notify(int notifier_fd);
+
+    /// @brief 运行事件循环，直到 Stop() 被调用
+    void Run();
+
+    /// @brief 请求退出事件循环，可在任意线程调用
+    void Stop();
+
+    /// @brief 是否正在运行
+    bool IsRunning() const { return running_; }
+
+    /// @brief 获取定时器错过的周期总数
+    uint64_t GetMissedTimerTicks() const { return missed_timer_ticks_; }
+
+private:
+    enum class SourceType {
+        kTimer,
+        kNotifier,
+        kFd,
+    };
+
+    struct Source {
+        int fd;
+        SourceType type;
+        bool owned;
+        Handler handler;
+    };
+
+    /// @brief 仿真时钟下的定时器
+    struct SimTimer {
+        uint64_t period_ns;
+        uint64_t deadline_ns;
+        Handler handler;
+    };
+
+    /// @brief 将事件源加入epoll
+    bool Register(int fd, SourceType type, bool owned, Handler handler);
+
+    /// @brief 等待并处理fd事件
+    /// @param timeout_ms epoll_wait超时
+    /// @return 是否应继续运行
+    bool PollOnce(int timeout_ms);
+
+    /// @brief 将仿真时钟推进到最早到期的定时器并触发它
+    void FireNextSimTimer();
+
+    int epoll_fd_;
+    int stop_fd_;
+    std::atomic<bool> running_;
+    uint64_t missed_timer_ticks_;
+    std::vector<std::unique_ptr<Source>> sources_;
+
+    SimulatedClock* sim_clock_;
+    std::vector<SimTimer> sim_timers_;
+};
+
+#endif  // EVENT_REACTOR_H_
@@ -1,10 +1,20 @@
 #ifndef GRPC_CLIENT_H
 #define GRPC_CLIENT_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <grpcpp/grpcpp.h>
+#include <google/protobuf/arena.h>
 #include "robot_types.h"
+#include "inference_backend.h"
 #include "inference.grpc.pb.h"
 
 // 前向声明
@@ -12,19 +22,58 @@ namespace inference {
     class InferenceService;
 }
 
+/// @brief 批量推理中的一项
+struct BatchPredictItem {
+    const std::vector<float>* observation;  // 观察数据，须在调用期间有效
+    std::string model_type;                 // 模型类型标识
+};
+
 /// @brief gRPC客户端类，用于与推理服务器通信
-class GrpcClient {
+///
+/// 除阻塞的 Predict() 外，PredictAsync() 经由内部完成队列发出请求并立即返回，
+/// 结果由一个内部线程轮询完成队列后交给回调或 future。在途请求数有上限，
+/// 每个请求有各自的截止时间。
+class GrpcClient : public InferenceBackend {
 public:
+    /// @brief 异步推理完成回调，在内部完成队列线程上调用，应尽快返回
+    using PredictCallback = std::function<void(const inference::InferenceResponse&)>;
+
+    /// @brief 默认的在途异步请求上限
+    static constexpr int kDefaultMaxInFlight = 4;
+
+    /// @brief 异步请求的默认截止时间（毫秒）
+    static constexpr int kDefaultAsyncDeadlineMs = 1000;
+
+    /// @brief 同步请求的默认截止时间（毫秒），控制程序按策略周期用 SetRequestDeadline() 缩短
+    static constexpr int kDefaultRequestDeadlineMs = 10000;
+
+    /// @brief 流式推理中等待单个响应的默认超时（毫秒）
+    static constexpr int kDefaultStreamTimeoutMs = 1000;
+
+    /// @brief 观察格式标识，打开会话时发送给服务器（参见ConvertRobotDataToObservation）
+    static constexpr const char* kObservationSchema = "lite3_obs_v1";
+
+    /// @brief 同时保持的会话数上限（每个模型类型与确定性的组合一个会话）
+    static constexpr size_t kMaxSessions = 4;
+
+    /// @brief 后台健康检查的默认周期（毫秒）
+    static constexpr int kDefaultHealthPeriodMs = 500;
+
+    /// @brief 重连探测的退避范围（毫秒），每次失败后加倍
+    static constexpr int kMinReconnectBackoffMs = 100;
+    static constexpr int kMaxReconnectBackoffMs = 2000;
+
     /// @brief 构造函数
-    /// @param server_address 服务器地址，格式为 "ip:port"
+    /// @param server_address 服务器地址，格式为 "ip:port"；与服务器同机时可用
+    ///        "unix:/path/to.sock" 或 "unix-abstract:name"，经Unix域套接字通信，不走TCP协议栈
     explicit GrpcClient(const std::string& server_address);
     
     /// @brief 析构函数
-    ~GrpcClient();
+    ~GrpcClient() override;
     
     /// @brief 连接到服务器
     /// @return 连接是否成功
-    bool Connect();
+    bool Connect() override;
     
     /// @brief 发送推理请求并获取响应
     /// @param observation 观察数据
@@ -33,19 +82,370 @@ public:
     /// @return 推理响应
     inference::InferenceResponse Predict(const std::vector<float>& observation, 
                                        const std::string& model_type = "default",
-                                       bool deterministic = true);
+                                       bool deterministic = true) override;
+
+    /// @brief 发送推理请求，复用客户端持有的请求与响应消息
+    ///
+    /// 请求与响应分配在客户端的arena上并跨调用复用：观察整块拷贝进已有的repeated字段，
+    /// 模型类型不变时不重新赋值，响应解析进上一次的消息并沿用其容量。稳态下除gRPC
+    /// 每次调用自身的状态外不再分配内存。返回的响应归客户端所有，在下一次调用前有效，
+    /// 动作可经 action().data() 直接读取而无需拷贝。只能由同一个线程调用。
+    ///
+    /// 开启 SetRecurrent() 后，循环策略的隐状态由客户端保存：成功响应的 states 在下一次调用时与请求的 states 交换
+    /// （同一arena上的repeated字段交换只交换指针，不拷贝），随请求回传给服务器；失败的调用不改变
+    /// 保存的隐状态，下一次请求仍携带最近一个成功响应的状态。对冲请求同样携带隐状态，会话推理不携带。
+    /// @param observation 观察数据
+    /// @param count 观察数据长度
+    /// @param model_type 模型类型标识
+    /// @param deterministic 是否确定性推理
+    /// @return 推理响应
+    const inference::InferenceResponse& PredictInPlace(const float* observation, size_t count,
+                                                       const char* model_type = "default",
+                                                       bool deterministic = true) override;
     
+    /// @brief 清除保存的隐状态，下一次请求从初始状态开始（只能由 PredictInPlace() 的调用线程调用）
+    void ResetRecurrentState() override;
+
+    /// @brief 把响应中的隐状态随下一个请求带回（须在首次推理前调用，默认关闭）
+    ///
+    /// 只有 PredictInPlace() 的一元与对冲请求携带隐状态。关闭时各种推理方式一致地忽略响应的 states，
+    /// 循环策略每一步都从初始状态开始，因此不会随所选的RPC方式改变行为。
+    void SetRecurrent(bool enabled) { recurrent_ = enabled; }
+
+    /// @brief 在请求中携带客户端发送时刻，请服务器在响应中填写各阶段时间戳（须在首次推理前调用）
+    ///
+    /// 用 ComputeInferenceTiming() 从响应中得到网络、服务器排队与模型计算的时间分解。
+    /// 会话推理的消息不携带时间戳。
+    void SetTracing(bool enabled) { tracing_ = enabled; }
+
+    /// @brief 让 PredictInPlace() 改用会话推理（须在首次推理前调用）
+    ///
+    /// 每个（模型类型，确定性）组合首次推理时通过 OpenSession 协商一次观察格式与长度、动作长度，
+    /// 之后每步只发送会话号、序号与原始的小端float32观察数据，动作同样以原始字节返回并整块拷贝。
+    /// 服务器未实现 OpenSession 时退回普通的 Predict；服务器不认识会话号（如重启后）或观察长度改变时重新打开会话。
+    /// 打开会话与每步推理一样受 SetRequestDeadline() 的截止时间限制。
+    void SetSessionMode(bool enabled) { session_mode_ = enabled; }
+
+    /// @brief 打开（或重新打开）一个会话
+    /// @param model_type 模型类型标识
+    /// @param deterministic 是否确定性推理
+    /// @param observation_size 观察长度
+    /// @param error 失败原因
+    /// @return 是否成功
+    bool OpenSession(const char* model_type, bool deterministic, size_t observation_size, std::string* error);
+
+    /// @brief 会话被打开的次数（大于会话数说明服务器曾丢失会话）
+    uint64_t SessionOpenCount() const { return session_open_count_.load(std::memory_order_relaxed); }
+
+    /// @brief 在一次 BatchPredict 调用中完成多项推理
+    ///
+    /// 请求与响应消息分配在同一个arena上，调用结束时一次性释放。
+    /// 调用失败时每一项的响应都为失败；服务器返回的响应少于请求数时，缺少的项为失败。
+    /// @param items N个（观察，模型类型）
+    /// @param deterministic 是否确定性推理
+    /// @return N个响应，与items一一对应
+    std::vector<inference::InferenceResponse> PredictBatch(const std::vector<BatchPredictItem>& items,
+                                                           bool deterministic = true);
+
+    /// @brief 在一次 BatchPredict 调用中完成多项推理，复用客户端持有的请求与响应消息
+    ///
+    /// 与 PredictInPlace() 一样，批量请求与响应分配在客户端的arena上并跨调用复用，各项请求原地填充，
+    /// 响应解析进上一次的消息并沿用其容量；项数不变时稳态下除gRPC每次调用自身的状态外不再分配内存。
+    /// 失败与缺少响应的处理同 PredictBatch()。返回的响应归客户端所有，在下一次调用前有效。
+    /// 只能由同一个线程调用；需要自行保存响应时使用 PredictBatch()。
+    /// @param items N个（观察，模型类型）
+    /// @param deterministic 是否确定性推理
+    /// @return N个响应，与items一一对应
+    const google::protobuf::RepeatedPtrField<inference::InferenceResponse>& PredictBatchInPlace(
+        const std::vector<BatchPredictItem>& items, bool deterministic = true);
+
+    /// @brief 异步发送推理请求，不等待响应
+    ///
+    /// 请求完成、失败或超时后，callback 在完成队列线程上被调用恰好一次；
+    /// 失败时响应的 success 为false，error_message 给出原因。
+    /// @param observation 观察数据
+    /// @param model_type 模型类型标识
+    /// @param callback 完成回调
+    /// @param deadline_ms 本请求的截止时间（毫秒）
+    /// @param deterministic 是否确定性推理
+    /// @return 是否已发出（未连接或在途请求已达上限时返回false，且不会调用callback）
+    bool PredictAsync(const std::vector<float>& observation, const std::string& model_type,
+                      PredictCallback callback, int deadline_ms = kDefaultAsyncDeadlineMs,
+                      bool deterministic = true);
+
+    /// @brief 异步发送推理请求，通过future取回响应
+    ///
+    /// 未能发出时，future立即就绪，响应的 success 为false。
+    /// @param observation 观察数据
+    /// @param model_type 模型类型标识
+    /// @param deadline_ms 本请求的截止时间（毫秒）
+    /// @param deterministic 是否确定性推理
+    /// @return 响应的future
+    std::future<inference::InferenceResponse> PredictAsync(const std::vector<float>& observation,
+                                                          const std::string& model_type,
+                                                          int deadline_ms = kDefaultAsyncDeadlineMs,
+                                                          bool deterministic = true);
+
+    /// @brief 启动完成队列线程（可重复调用，只启动一次）
+    ///
+    /// 否则在首次 PredictAsync() 时启动。新线程继承调用线程的调度策略与CPU亲和性，
+    /// 因此应在调用线程切换到实时调度之前调用，使回调线程保持普通调度、可在任意CPU上运行。
+    void StartCompletionThread();
+
+    /// @brief 设置在途异步请求上限
+    /// @param max_in_flight 上限，至少为1
+    void SetMaxInFlight(int max_in_flight);
+
+    /// @brief 当前在途的异步请求数
+    int InFlightCount();
+
+    /// @brief 取消所有在途异步请求，并等待它们的回调执行完毕
+    void CancelAsync();
+
+    /// @brief 通过长连接的双向流发送推理请求并等待对应的响应
+    ///
+    /// 首次调用（或出错后的下一次调用）时打开 StreamPredict 流，之后的请求都复用该流，
+    /// 省去每次调用的头部、流建立与HTTP/2帧开销。流上同一时刻只有一个请求在途，
+    /// 调用者处理不过来的观察由调用者丢弃，不会在流中堆积。超时或出错时取消并关闭流，
+    /// 下次调用时重新打开；服务器未实现 StreamPredict 时自动退回 Predict()。
+    /// 只能由同一个线程调用。
+    /// @param observation 观察数据
+    /// @param model_type 模型类型标识
+    /// @param deterministic 是否确定性推理
+    /// @param timeout_ms 等待响应的超时（毫秒）
+    /// @return 推理响应
+    inference::InferenceResponse StreamPredict(const std::vector<float>& observation,
+                                               const std::string& model_type = "default",
+                                               bool deterministic = true,
+                                               int timeout_ms = kDefaultStreamTimeoutMs);
+
+    /// @brief 结束流式推理的流（下次 StreamPredict() 时重新打开）
+    void CloseStream();
+
+    /// @brief 流被打开的次数（大于1说明发生过重连）
+    uint64_t StreamOpenCount() const { return stream_open_count_.load(std::memory_order_relaxed); }
+
     /// @brief 检查连接状态
     /// @return 是否已连接
-    bool IsConnected() const;
+    bool IsConnected() const override;
+
+    /// @brief 设置同步请求的截止时间（Predict、PredictInPlace、会话推理、对冲与批量推理）
+    ///
+    /// 打开会话与连接探测是一次性的握手，不受影响。须在首次推理前调用。
+    void SetRequestDeadline(std::chrono::microseconds deadline) override { request_deadline_ = deadline; }
+
+    /// @brief 同步请求的截止时间
+    std::chrono::microseconds RequestDeadline() const { return request_deadline_; }
+
+    /// @brief 因超过截止时间而失败的请求数
+    uint64_t DeadlineMissCount() const { return deadline_miss_count_.load(std::memory_order_relaxed); }
+
+    /// @brief 启动后台健康检查线程（须在 Connect() 之后调用）
+    ///
+    /// 已连接时只查看通道状态，不向服务器发请求；通道进入 TRANSIENT_FAILURE 即标记为断开，
+    /// 推理调用随即立刻失败而不再等待超时。断开后按退避间隔（kMinReconnectBackoffMs 起每次加倍，
+    /// 至多 kMaxReconnectBackoffMs）重新探测，成功后恢复连接。推理调用线程不参与重连。
+    /// @param period_ms 已连接时的检查周期（毫秒）
+    void StartHealthCheck(int period_ms = kDefaultHealthPeriodMs);
+
+    /// @brief 停止后台健康检查线程
+    void StopHealthCheck();
+
+    /// @brief 健康检查恢复连接的次数
+    uint64_t ReconnectCount() const { return reconnect_count_.load(std::memory_order_relaxed); }
+
+    /// @brief 为 PredictInPlace() 启用对冲请求（须在首次推理前调用，不用于会话推理）
+    ///
+    /// 请求先发往主服务器；hedge_delay 内未得到成功响应（或主服务器先返回失败、或已断开）时，
+    /// 同一请求再发往备用服务器，先到的成功响应胜出，另一个请求被取消。
+    /// @param secondary_address 备用服务器地址
+    /// @param hedge_delay 等待主服务器的时长
+    void SetHedging(const std::string& secondary_address, std::chrono::microseconds hedge_delay);
+
+    /// @brief 发往备用服务器的请求数
+    uint64_t HedgeCount() const { return hedge_count_.load(std::memory_order_relaxed); }
+
+    /// @brief 采用备用服务器响应的次数
+    uint64_t HedgeWinCount() const { return hedge_win_count_.load(std::memory_order_relaxed); }
+
+    /// @brief 地址是否为Unix域套接字（"unix:" 或 "unix-abstract:"）
+    static bool IsUnixAddress(const std::string& server_address);
+
+    /// @brief 面向小消息、低延迟的通道参数
+    ///
+    /// 关闭压缩、重试与BDP探测；流式推理等长调用启用保活，对端失联时很快发现。
+    /// TCP连接上gRPC默认已开启 TCP_NODELAY，Unix域套接字没有Nagle算法，无需设置。
+    static grpc::ChannelArguments MakeChannelArguments();
+
+    /// @brief 填充推理请求
+    ///
+    /// 观察整块拷贝进repeated字段；重复填充同一个请求时沿用其已有的容量，不再分配。
+    /// @param observation 观察数据
+    /// @param count 观察数据长度
+    /// @param model_type 模型类型标识
+    /// @param deterministic 是否确定性推理
+    /// @param request 待填充的请求
+    static void FillRequest(const float* observation, size_t count, const char* model_type,
+                            bool deterministic, inference::InferenceRequest* request);
+
+    /// @brief 填充会话内的一步请求
+    ///
+    /// 观察以小端float32原始字节整块拷贝进bytes字段；重复填充时沿用已有的容量。
+    /// @param session_id 会话号
+    /// @param seq 请求序号
+    /// @param observation 观察数据
+    /// @param count 观察数据长度
+    /// @param request 待填充的请求
+    static void FillSessionStep(uint64_t session_id, uint64_t seq, const float* observation, size_t count,
+                                inference::SessionStepRequest* request);
 
 private:
+    struct AsyncCall;
+    struct HedgeCall;
+
+    /// @brief 流上操作的完成队列tag
+    enum StreamTag {
+        kStreamStart = 1,
+        kStreamWrite = 2,
+        kStreamRead = 4,
+        kStreamWritesDone = 8,
+        kStreamFinish = 16,
+    };
+
+    /// @brief 打开流
+    bool OpenStream(std::chrono::system_clock::time_point deadline, std::string* error);
+
+    /// @brief 等待流上所有在途操作完成
+    /// @return 是否全部成功完成（超时或任一操作失败返回false）
+    bool WaitStream(std::chrono::system_clock::time_point deadline, std::string* error);
+
+    /// @brief 关闭流并取得其最终状态
+    /// @param graceful 是否先半关闭写端再结束；否则直接取消
+    grpc::Status ResetStream(bool graceful);
+
+    /// @brief 完成队列线程主循环
+    void CompletionLoop();
+
+    /// @brief 用 "test" 模型发送一个探测请求
+    /// @return 服务器是否正常应答
+    static bool Probe(inference::InferenceService::Stub* stub, int timeout_ms, std::string* error);
+
+    /// @brief 健康检查线程主循环
+    void HealthLoop(int period_ms);
+
+    /// @brief 对冲发送 reused_request_，返回先到的成功响应
+    const inference::InferenceResponse& HedgedPredict();
+
+    /// @brief 向一个服务器异步发出 reused_request_
+    void StartHedgeCall(inference::InferenceService::Stub* stub, HedgeCall* call,
+                        std::chrono::system_clock::time_point deadline);
+
+    /// @brief 一个已打开的会话
+    struct Session {
+        std::string model_type;
+        bool deterministic;
+        uint64_t id;
+        uint32_t observation_size;
+        uint32_t action_size;
+        uint64_t next_seq;
+    };
+
+    /// @brief 从现在起算的同步请求截止时刻
+    std::chrono::system_clock::time_point RequestDeadlineFromNow() const {
+        return std::chrono::system_clock::now() + request_deadline_;
+    }
+
+    /// @brief 统计超过截止时间的调用
+    void CountDeadlineMiss(const grpc::Status& status) {
+        if (status.error_code() == grpc::StatusCode::DEADLINE_EXCEEDED) {
+            deadline_miss_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief 追踪延迟时在请求中写入客户端发送时刻
+    void StampRequest(inference::InferenceRequest* request) const;
+
+    /// @brief 把上一个成功响应的隐状态交换进 reused_request_
+    void CarryRecurrentState();
+
+    /// @brief 查找（模型类型，确定性）对应的会话，没有时返回nullptr
+    Session* FindSession(const char* model_type, bool deterministic);
+
+    /// @brief 通过会话发送一步推理，结果写入 reused_response_
+    const inference::InferenceResponse& SessionPredict(const float* observation, size_t count,
+                                                       const char* model_type, bool deterministic);
+
+    /// @brief 发送会话内的一步请求
+    grpc::Status SendSessionStep(Session* session, const float* observation, size_t count);
+
     std::string server_address_;
     std::unique_ptr<inference::InferenceService::Stub> stub_;
     std::shared_ptr<grpc::Channel> channel_;
-    bool connected_;
+    std::atomic<bool> connected_;
+    std::chrono::microseconds request_deadline_;
+    std::atomic<uint64_t> deadline_miss_count_;
+
+    // 后台健康检查
+    std::thread health_thread_;
+    std::mutex health_mutex_;
+    std::condition_variable health_cv_;
+    bool health_stop_;
+    std::atomic<uint64_t> reconnect_count_;
+
+    // 对冲请求（仅 PredictInPlace() 的调用线程访问）
+    std::string hedge_address_;
+    std::shared_ptr<grpc::Channel> hedge_channel_;
+    std::unique_ptr<inference::InferenceService::Stub> hedge_stub_;
+    std::chrono::microseconds hedge_delay_;
+    grpc::CompletionQueue hedge_cq_;
+    std::unique_ptr<HedgeCall> hedge_calls_[2];  // 主服务器、备用服务器
+    std::atomic<uint64_t> hedge_count_;
+    std::atomic<uint64_t> hedge_win_count_;
+
+    // PredictInPlace() 复用的消息（仅其调用线程访问）
+    google::protobuf::Arena arena_;
+    inference::InferenceRequest* reused_request_;
+    inference::InferenceResponse* reused_response_;
+    inference::BatchInferenceRequest* reused_batch_request_;    // PredictBatchInPlace() 复用（仅其调用线程访问）
+    inference::BatchInferenceResponse* reused_batch_response_;
+    // 上一个成功的响应（reused_response_ 或对冲调用的响应），其 states 在下一次调用时交换进请求
+    inference::InferenceResponse* state_response_;
+    bool recurrent_;  // 是否携带隐状态
+
+    bool tracing_;
+
+    // 会话推理（仅 PredictInPlace() 的调用线程访问）
+    bool session_mode_;
+    bool session_unsupported_;  // 服务器未实现 OpenSession
+    std::vector<Session> sessions_;
+    inference::SessionStepRequest* reused_step_request_;
+    inference::SessionStepResponse* reused_step_response_;
+    std::atomic<uint64_t> session_open_count_;
+
+    // 异步请求
+    grpc::CompletionQueue cq_;
+    std::once_flag cq_thread_once_;
+    std::thread cq_thread_;
+    std::mutex async_mutex_;
+    std::condition_variable async_cv_;
+    std::unordered_set<AsyncCall*> in_flight_calls_;
+    int max_in_flight_;
+
+    // 流式推理（仅 StreamPredict() 的调用线程访问）
+    grpc::CompletionQueue stream_cq_;
+    std::unique_ptr<grpc::ClientContext> stream_context_;
+    std::unique_ptr<grpc::ClientAsyncReaderWriter<inference::InferenceRequest, inference::InferenceResponse>> stream_;
+    int stream_pending_;       // 在途操作的 StreamTag 位掩码
+    bool stream_unsupported_;  // 服务器未实现 StreamPredict
+    std::atomic<uint64_t> stream_open_count_;
 };
 
+/// @brief 观察向量长度（参见ConvertRobotDataToObservation）
+constexpr size_t kObservationSize = 65;
+
+/// @brief 动作向量长度，对应12个关节
+constexpr size_t kActionSize = 12;
+
 /// @brief 观察数据结构，用于存储机器人状态
 struct Observation {
     std::vector<float> data;  // 观察数据向量
@@ -62,7 +462,23 @@ struct RobotAction {
 /// @return 观察数据
 Observation ConvertRobotDataToObservation(const RobotData& robot_data, const std::vector<float>& action_data, const RobotMoveCommand& robot_move_command);
 
+/// @brief 将RobotData转换为Observation，写入已有对象（复用其容量，稳态下不分配内存）
+/// @param robot_data 机器人数据
+/// @param action_data 上一时刻的动作数据
+/// @param robot_move_command 运动命令
+/// @param observation 输出：观察数据
+void ConvertRobotDataToObservation(const RobotData& robot_data, const std::vector<float>& action_data,
+                                   const RobotMoveCommand& robot_move_command, Observation* observation);
+
+/// @brief 对观察数据应用缩放与噪声，写入已有对象（复用其容量，稳态下不分配内存）
+/// @param obs 原始观察数据
+/// @param processed_obs 输出：处理后的观察数据
+void ApplyObservationScalingAndNoise(const Observation& obs, Observation* processed_obs);
+
 /// @brief 将RobotAction转换为RobotCmd
+///
+/// 关节位置为动作加中立姿态；动作不足12个（如推理失败得到的空动作）时各关节为中立姿态。
+/// 增益均为0，由调用者设置。
 /// @param action 动作数据
 /// @return 机器人命令
 RobotCmd CreateRobotCmd(const RobotAction& action);
@@ -72,4 +488,14 @@ RobotCmd CreateRobotCmd(const RobotAction& action);
 /// @return 动作数据
 RobotAction ConvertResponseToAction(const inference::InferenceResponse& response);
 
+/// @brief 将原始（未缩放的）模型输出转换为RobotAction
+/// @param raw_action 原始动作数据
+/// @return 应用动作缩放后的动作数据
+RobotAction ConvertRawActionToAction(const std::vector<float>& raw_action);
+
+/// @brief 将原始模型输出转换为RobotAction，写入已有对象（复用其容量，稳态下不分配内存）
+/// @param raw_action 原始动作数据
+/// @param action 输出：应用动作缩放后的动作数据
+void ConvertRawActionToAction(const std::vector<float>& raw_action, RobotAction* action);
+
 #endif // GRPC_CLIENT_H 
\ No newline at end of file
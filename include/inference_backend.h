@@ -0,0 +1,77 @@
+/// @file inference_backend.h
+/// @brief 推理后端接口：gRPC 与共享内存传输的共同调用方式
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef INFERENCE_BACKEND_H_
+#define INFERENCE_BACKEND_H_
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "inference.pb.h"
+
+/// @brief 推理后端
+///
+/// 调用者只依赖同步推理这一组接口，可在 GrpcClient 与 ShmClient 之间互换；
+/// 流式、异步与批量推理等只有gRPC才有的能力仍通过 GrpcClient 使用。
+class InferenceBackend {
+public:
+    virtual ~InferenceBackend() = default;
+
+    /// @brief 连接到服务器
+    /// @return 连接是否成功
+    virtual bool Connect() = 0;
+
+    /// @brief 检查连接状态
+    /// @return 是否已连接
+    virtual bool IsConnected() const = 0;
+
+    /// @brief 设置单个同步请求的截止时间，超时的请求以失败返回
+    ///
+    /// 控制程序按策略周期设置，使迟到的动作尽早失败，由调用者按过期动作策略处理。
+    /// @param deadline 截止时间（从发出请求起算）
+    virtual void SetRequestDeadline(std::chrono::microseconds deadline) = 0;
+
+    /// @brief 发送推理请求并获取响应
+    /// @param observation 观察数据
+    /// @param model_type 模型类型标识
+    /// @param deterministic 是否确定性推理
+    /// @return 推理响应
+    virtual inference::InferenceResponse Predict(const std::vector<float>& observation,
+                                                 const std::string& model_type = "default",
+                                                 bool deterministic = true) = 0;
+
+    /// @brief 发送推理请求，响应写入后端持有的消息
+    ///
+    /// 返回的响应归后端所有，在下一次调用前有效。只能由同一个线程调用。
+    /// @param observation 观察数据
+    /// @param count 观察数据长度
+    /// @param model_type 模型类型标识
+    /// @param deterministic 是否确定性推理
+    /// @return 推理响应
+    virtual const inference::InferenceResponse& PredictInPlace(const float* observation, size_t count,
+                                                               const char* model_type = "default",
+                                                               bool deterministic = true) = 0;
+
+    /// @brief 清除循环策略的隐状态，下一次推理从初始状态开始
+    ///
+    /// 隐状态由后端保存，随每个请求发给策略（见 InferenceRequest.states）；切换模型或重新站立时由调用者清除。
+    /// 不支持隐状态的后端（共享内存传输）忽略本调用。只能由 PredictInPlace() 的调用线程调用。
+    virtual void ResetRecurrentState() {}
+
+    /// @brief 重新加载一个模型（训练出新权重后替换）
+    ///
+    /// 只有在进程内加载模型的后端（LocalPolicyBackend）支持；远程策略的模型由服务器管理，默认返回失败。
+    /// 只能由 PredictInPlace() 的调用线程调用。
+    /// @param model_type 模型类型标识
+    /// @param error 失败原因
+    /// @return 是否成功
+    virtual bool ReloadModel(const std::string& model_type, std::string* error) {
+        *error = "the backend does not load " + model_type + " itself";
+        return false;
+    }
+};
+
+#endif  // INFERENCE_BACKEND_H_
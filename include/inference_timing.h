@@ -0,0 +1,85 @@
+/// @file inference_timing.h
+/// @brief 推理端到端时间分解：请求/响应中的时间戳与NTP式时钟偏差估计
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef INFERENCE_TIMING_H_
+#define INFERENCE_TIMING_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "inference.pb.h"
+
+/// @brief 一次推理的时间分解（纳秒）
+///
+/// 上行与下行以估计的时钟偏差换算到客户端时钟，二者之和等于往返时间减去服务器内的耗时；
+/// 服务器与客户端时钟不同步时，单个样本的上下行分配有误差，但二者之和始终准确。
+struct InferenceTiming {
+    bool valid = false;           // 服务器是否返回了完整的时间戳
+    int64_t round_trip_ns = 0;    // 客户端发送到收到响应
+    int64_t uplink_ns = 0;        // 客户端发送到服务器收到
+    int64_t server_queue_ns = 0;  // 服务器收到到开始计算（排队、反序列化）
+    int64_t compute_ns = 0;       // 模型计算
+    int64_t server_reply_ns = 0;  // 计算结束到服务器发送（后处理、序列化）
+    int64_t downlink_ns = 0;      // 服务器发送到客户端收到
+    int64_t clock_offset_ns = 0;  // 估计的时钟偏差（服务器时钟减客户端时钟）
+};
+
+/// @brief 墙上时钟当前时间（Unix纪元起的纳秒），请求与响应中的时间戳都用它
+int64_t WallClockNs();
+
+/// @brief NTP式时钟偏差估计
+///
+/// 每个样本由客户端发送 t1、服务器收到 t2、服务器发送 t3、客户端收到 t4 四个时间戳给出
+/// 偏差 ((t2 - t1) + (t3 - t4)) / 2 与网络延迟 (t4 - t1) - (t3 - t2)。排队会让上下行不对称，
+/// 偏差误差至多为延迟的一半，因此取最近 kWindow 个样本中延迟最小者的偏差（NTP的时钟过滤）。
+/// 固定内存，不分配；只能由单个线程调用。
+class ClockOffsetEstimator {
+public:
+    /// @brief 参与估计的最近样本数
+    static constexpr size_t kWindow = 64;
+
+    ClockOffsetEstimator();
+
+    /// @brief 加入一个样本
+    void AddSample(int64_t client_send_ns, int64_t server_receive_ns, int64_t server_send_ns,
+                   int64_t client_receive_ns);
+
+    /// @brief 当前估计的偏差（服务器时钟减客户端时钟，纳秒），无样本时为0
+    int64_t Offset() const { return offset_ns_; }
+
+    /// @brief 估计所用样本的网络延迟（纳秒），即偏差误差的上界的两倍
+    int64_t Delay() const { return delay_ns_; }
+
+    /// @brief 已加入的样本数
+    uint64_t SampleCount() const { return sample_count_; }
+
+    /// @brief 清空所有样本
+    void Reset();
+
+private:
+    struct Sample {
+        int64_t offset_ns;
+        int64_t delay_ns;
+    };
+
+    std::array<Sample, kWindow> samples_;
+    uint64_t sample_count_;
+    int64_t offset_ns_;
+    int64_t delay_ns_;
+};
+
+/// @brief 根据响应中的时间戳计算时间分解并更新时钟偏差估计
+///
+/// 服务器须回传请求中的 client_send_ns，并填写 server_receive_ns、compute_start_ns、
+/// compute_end_ns 与 server_send_ns；任一为0时返回false，timing->valid 为false。
+/// @param response 推理响应
+/// @param client_receive_ns 客户端收到响应的时刻（WallClockNs）
+/// @param estimator 时钟偏差估计器
+/// @param timing 输出：时间分解
+/// @return 时间戳是否完整
+bool ComputeInferenceTiming(const inference::InferenceResponse& response, int64_t client_receive_ns,
+                            ClockOffsetEstimator* estimator, InferenceTiming* timing);
+
+#endif  // INFERENCE_TIMING_H_
@@ -0,0 +1,253 @@
+/// @file inference_worker.h
+/// @brief 推理工作线程，将策略推理与200Hz控制循环解耦
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef INFERENCE_WORKER_H
+#define INFERENCE_WORKER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "async_logger.h"
+#include "control_clock.h"
+#include "grpc_client.h"
+#include "inference_timing.h"
+#include "phase_profiler.h"
+#include "triple_buffer.h"
+
+/// @brief 提交给推理线程的观察样本
+struct ObservationSample {
+    std::array<float, kObservationSize> data;       // 处理后的观察数据
+    const char* model_type = "default";              // 模型类型（须指向静态字符串）
+    uint64_t seq = 0;                                // 观察序号，从1开始
+    std::chrono::steady_clock::time_point stamp;     // 观察生成时刻
+    uint32_t state_epoch = 0;                        // 循环策略隐状态的纪元，每次 ResetRecurrentState() 加1
+};
+
+/// @brief 批量推理时同时评估的模型数上限
+constexpr int kMaxBatchModels = 4;
+
+/// @brief 推理线程发布的动作样本
+struct ActionSample {
+    std::array<float, kActionSize> data;             // 原始（未缩放的）模型输出
+    uint64_t seq = 0;                                // 对应的观察序号，0表示尚无动作
+    std::chrono::steady_clock::time_point obs_stamp; // 对应观察的生成时刻
+    std::chrono::steady_clock::time_point done_stamp;// 推理完成时刻
+    InferenceTiming timing;                          // 开启延迟追踪时的时间分解
+    int state_size = 0;                              // 循环策略返回的隐状态维数，非循环策略为0
+    float state_norm = 0.0f;                         // 隐状态的L2范数
+
+    // 批量推理时，同一观察在每个模型下的输出
+    int model_count = 0;
+    std::array<const char*, kMaxBatchModels> model_types;
+    std::array<std::array<float, kActionSize>, kMaxBatchModels> model_data;
+
+    /// @brief 指定模型的输出；未批量评估该模型时返回data
+    const float* ModelAction(const char* model_type) const {
+        for (int i = 0; i < model_count; ++i) {
+            if (std::strcmp(model_types[i], model_type) == 0) {
+                return model_data[i].data();
+            }
+        }
+        return data.data();
+    }
+};
+
+/// @brief 推理线程与动作新鲜度统计
+struct InferenceWorkerStats {
+    uint64_t submitted;          // 提交的观察数
+    uint64_t overwritten;        // 未被推理线程取走就被新观察覆盖的数量
+    uint64_t completed;          // 完成的推理次数
+    uint64_t failed;             // 失败的推理次数
+    uint64_t superseded;         // 异步模式下晚于更新动作到达而被丢弃的响应数
+    uint64_t control_ticks;      // 记录的控制周期数
+    uint64_t stale_ticks;        // 使用了过期动作的控制周期数
+    double max_action_age_ms;    // 控制周期所用动作的最大年龄
+    double mean_action_age_ms;   // 控制周期所用动作的平均年龄
+    uint64_t state_resets;       // 循环策略隐状态的清除次数
+};
+
+/// @brief 推理工作线程
+///
+/// 控制线程通过 SubmitObservation() 提交最新观察、通过 FetchLatestAction() 读取最新动作，
+/// 两者都经由无锁三缓冲完成，不会因网络延迟而阻塞。推理线程只处理最新的观察，
+/// 旧观察会被直接覆盖。
+class InferenceWorker {
+public:
+    /// @brief 构造函数
+    /// @param backend 已连接的推理后端（GrpcClient 或 ShmClient），生命周期须长于本对象
+    explicit InferenceWorker(InferenceBackend* backend);
+
+    /// @brief 析构函数，停止工作线程
+    ~InferenceWorker();
+
+    /// @brief 设置阶段延迟统计器，推理线程将记录gRPC往返耗时（须在Start()前调用）
+    /// @param profiler 统计器，可为nullptr
+    void SetProfiler(PhaseProfiler* profiler);
+
+    /// @brief 观察与动作的时间戳改用控制时钟（须在Start()前调用），默认为 steady_clock
+    ///
+    /// 仿真时钟下动作的新鲜度按仿真时间计算，与 StaleActionPolicy 使用同一时间基准。
+    /// @param clock 控制时钟，生命周期须长于本对象
+    void SetClock(const ControlClock* clock) { clock_ = clock; }
+
+    /// @brief 设置动作就绪通知（可在任意时刻调用）
+    ///
+    /// 每发布一个新动作，推理线程都会对该fd调用 EventReactor::Notify()，
+    /// 使控制线程无需等到下一个周期即可下发指令。
+    /// @param notifier_fd EventReactor::AddNotifier() 返回的fd，-1表示不通知
+    void SetCompletionNotifier(int notifier_fd);
+
+    /// @brief 改用 GrpcClient::PredictAsync 流水线推理（须在Start()前调用，仅gRPC后端）
+    ///
+    /// 观察照常经三缓冲交给工作线程，工作线程发出异步请求后不等待响应即处理下一个观察，
+    /// 至多max_in_flight个请求同时在途；控制线程的提交路径与同步模式相同，不分配内存、不加锁。
+    /// 响应在gRPC完成队列线程上发布，早于已发布动作的响应被丢弃；在途请求已满时新观察被丢弃，
+    /// 计入overwritten。完成队列线程在本调用中启动，因此须在控制线程切换到实时调度之前调用。
+    /// @param max_in_flight 在途请求上限
+    /// @param deadline_ms 每个请求的截止时间（毫秒）
+    void SetAsync(int max_in_flight, int deadline_ms);
+
+    /// @brief 推理线程改用 GrpcClient::StreamPredict 长连接流（须在Start()前调用，仅gRPC后端）
+    void SetStreaming(bool streaming);
+
+    /// @brief 每个观察都通过一次 BatchPredict 在多个模型下评估（须在Start()前调用，仅gRPC后端）
+    ///
+    /// 发布的动作样本中 data 为提交时所选模型的输出，ModelAction() 可取得其余模型的输出，
+    /// 控制线程切换模型时无需等待新的推理。
+    /// @param model_types 模型类型（须指向静态字符串），至多kMaxBatchModels个，为空时关闭
+    /// @return 是否设置成功
+    bool SetBatchModels(const std::vector<const char*>& model_types);
+
+    /// @brief 开启端到端延迟追踪（须在Start()前调用，仅gRPC后端）
+    ///
+    /// 请求携带客户端发送时刻，服务器在响应中填写各阶段时间戳；每个响应的上行、服务器排队、
+    /// 模型计算、服务器回复与下行耗时记入阶段统计器，并随动作样本发布（ActionSample::timing）。
+    void SetTracing(bool tracing);
+
+    /// @brief 设置工作线程的名称（时间线中的线程名，也用于统计输出），默认 "inference"（须在Start()前调用）
+    /// @param name 名称，须指向静态字符串
+    void SetName(const char* name) { name_ = name; }
+
+    /// @brief 启动工作线程
+    /// @return 是否启动成功
+    bool Start();
+
+    /// @brief 停止工作线程（异步模式下取消在途请求）
+    void Stop();
+
+    /// @brief 提交最新观察（仅控制线程调用，不阻塞）
+    /// @param observation 处理后的观察数据，长度应为kObservationSize
+    /// @param model_type 模型类型，须指向静态字符串
+    void SubmitObservation(const std::vector<float>& observation, const char* model_type);
+
+    /// @brief 清除循环策略的隐状态（仅控制线程调用，不阻塞）
+    ///
+    /// 之后提交的观察从初始状态开始推理；推理线程在处理第一个这样的观察前调用后端的 ResetRecurrentState()。
+    /// 观察的模型类型改变时推理线程也会清除隐状态，切换模型无需调用。只有一元推理携带隐状态。
+    void ResetRecurrentState();
+
+    /// @brief 请求重新加载模型（可在任意线程调用，不阻塞）
+    ///
+    /// 推理线程在处理下一个观察前调用后端的 ReloadModel()，重新加载该观察所选的模型；
+    /// 加载失败时继续使用旧模型。结果输出到日志。异步模式下没有推理线程，请求被忽略。
+    void RequestReload() { reload_requested_.store(true, std::memory_order_release); }
+
+    /// @brief 读取最新动作（仅控制线程调用，不阻塞）
+    /// @param action 输出：当前持有的最新动作
+    /// @return 是否取到了自上次调用以来的新动作
+    bool FetchLatestAction(ActionSample* action);
+
+    /// @brief 记录一个控制周期所使用动作的新鲜度（仅控制线程调用）
+    void RecordControlTick();
+
+    /// @brief 获取统计信息
+    InferenceWorkerStats GetStats() const;
+
+    /// @brief 打印统计信息
+    void PrintStats() const;
+
+private:
+    /// @brief 当前时刻（控制时钟或 steady_clock）
+    std::chrono::steady_clock::time_point Now() const {
+        return clock_ != nullptr ? clock_->Now() : std::chrono::steady_clock::now();
+    }
+
+    /// @brief 工作线程主循环
+    void Run();
+
+    /// @brief 等待新观察的通知
+    /// @return 是否收到通知（超时返回false）
+    bool WaitForObservation();
+
+    /// @brief 发布推理得到的动作并通知控制线程（仅由唯一的发布线程调用）
+    /// @param batch_responses 批量推理时各模型的响应（与batch_items_对应），否则为nullptr
+    /// @return 响应是否有效
+    bool PublishAction(const inference::InferenceResponse& response, uint64_t seq,
+                       std::chrono::steady_clock::time_point obs_stamp,
+                       const google::protobuf::RepeatedPtrField<inference::InferenceResponse>* batch_responses = nullptr);
+
+    /// @brief 开启延迟追踪时，由响应中的时间戳计算时间分解并记入统计（仅由唯一的发布线程调用）
+    /// @param receive_ns 收到响应的时刻（WallClockNs）
+    void TraceResponse(const inference::InferenceResponse& response, int64_t receive_ns);
+
+    /// @brief 批量评估一个观察并发布（推理线程）
+    void RunBatch(const ObservationSample& observation);
+
+    /// @brief 为一个观察发出异步请求，不等待响应（推理线程）
+    void RunAsync(const ObservationSample& observation);
+
+    /// @brief 异步请求完成（在gRPC完成队列线程上调用）
+    void OnAsyncResponse(const inference::InferenceResponse& response, uint64_t seq,
+                         std::chrono::steady_clock::time_point obs_stamp, uint64_t start_ns);
+
+    InferenceBackend* backend_;
+    const char* name_;
+    GrpcClient* client_;  // 后端为gRPC时与backend_相同，否则为nullptr
+    PhaseProfiler* profiler_;
+    const ControlClock* clock_;  // nullptr 时使用 steady_clock
+    std::atomic<int> completion_notifier_fd_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+    int event_fd_;
+    bool async_;
+    bool streaming_;
+    int async_deadline_ms_;
+    uint64_t published_seq_;  // 仅完成队列线程访问
+    bool tracing_;
+    ClockOffsetEstimator clock_offset_;  // 以下两项仅发布线程访问
+    InferenceTiming timing_;             // 最近一个响应的时间分解
+    LogSite failure_log_site_;           // 推理失败日志的限频状态，每个工作线程各一份，仅发布线程访问
+
+    TripleBuffer<ObservationSample> observation_buffer_;
+    TripleBuffer<ActionSample> action_buffer_;
+    std::vector<float> request_observation_;  // 推理线程复用的请求缓冲
+    std::vector<BatchPredictItem> batch_items_;  // 批量推理的各项，均指向request_observation_
+    uint32_t backend_state_epoch_;         // 推理线程：后端隐状态所属的纪元
+    const char* backend_state_model_;      // 推理线程：后端隐状态所属的模型类型，nullptr表示尚未推理
+    std::atomic<bool> reload_requested_;   // 推理线程在下一个观察前重新加载模型
+
+    // 控制线程写、其他线程读的统计量
+    uint64_t next_seq_;
+    uint32_t state_epoch_;
+    std::atomic<uint64_t> submitted_;
+    std::atomic<uint64_t> overwritten_;
+    std::atomic<uint64_t> control_ticks_;
+    std::atomic<uint64_t> stale_ticks_;
+    std::atomic<uint64_t> aged_ticks_;
+    std::atomic<int64_t> max_action_age_us_;
+    std::atomic<int64_t> total_action_age_us_;
+
+    // 推理线程写、其他线程读的统计量
+    std::atomic<uint64_t> completed_;
+    std::atomic<uint64_t> failed_;
+    std::atomic<uint64_t> superseded_;
+    std::atomic<uint64_t> state_resets_;
+};
+
+#endif // INFERENCE_WORKER_H
@@ -0,0 +1,92 @@
+/// @file latency_histogram.h
+/// @brief 固定内存的HDR风格延迟直方图
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// @brief 延迟直方图（纳秒）
+///
+/// 采用对数-线性分桶：小于32ns的值精确计数，之后每个2的幂区间再均分为32个子桶，
+/// 相对误差不超过约3%，覆盖到约 2^40 ns（约18分钟）。所有桶都是预先分配的定长数组。
+/// Record() 只能由单个线程调用，不分配内存、不加锁；其他线程可随时读取统计结果。
+class LatencyHistogram {
+public:
+    /// @brief 统计摘要
+    struct Summary {
+        uint64_t count;
+        double mean_us;
+        double p50_us;
+        double p99_us;
+        double p999_us;
+        double max_us;
+    };
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /// @brief 记录一个样本（仅写线程调用）
+    /// @param value_ns 延迟（纳秒）
+    void Record(uint64_t value_ns) {
+        size_t index = BucketIndex(value_ns);
+        Increment(counts_[index], 1);
+        Increment(total_count_, 1);
+        Increment(total_ns_, value_ns);
+        if (value_ns > max_ns_.load(std::memory_order_relaxed)) {
+            max_ns_.store(value_ns, std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief 样本总数
+    uint64_t Count() const { return total_count_.load(std::memory_order_relaxed); }
+
+    /// @brief 最大值（纳秒）
+    uint64_t Max() const { return max_ns_.load(std::memory_order_relaxed); }
+
+    /// @brief 计算分位数
+    /// @param percentile 分位（0~100）
+    /// @return 对应桶的上界（纳秒），无样本时返回0
+    uint64_t ValueAtPercentile(double percentile) const;
+
+    /// @brief 获取统计摘要
+    Summary GetSummary() const;
+
+    /// @brief 格式化统计摘要为一行文本
+    /// @param name 名称
+    std::string FormatSummary(const char* name) const;
+
+    /// @brief 清空所有计数（仅在写线程停止时调用）
+    void Reset();
+
+    /// @brief 值所在桶的索引
+    static size_t BucketIndex(uint64_t value_ns);
+
+    /// @brief 桶的上界（纳秒）
+    static uint64_t BucketUpperBound(size_t index);
+
+    static constexpr int kSubBucketBits = 5;
+    static constexpr uint64_t kSubBucketCount = 1ULL << kSubBucketBits;
+    static constexpr int kMaxValueBits = 40;
+    static constexpr size_t kBucketCount = kSubBucketCount + (kMaxValueBits - kSubBucketBits) * kSubBucketCount;
+
+private:
+    /// @brief 单写者自增，避免原子读改写指令
+    static void Increment(std::atomic<uint64_t>& counter, uint64_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> counts_[kBucketCount];
+    std::atomic<uint64_t> total_count_;
+    std::atomic<uint64_t> total_ns_;
+    std::atomic<uint64_t> max_ns_;
+};
+
+#endif  // LATENCY_HISTOGRAM_H_
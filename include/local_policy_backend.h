@@ -0,0 +1,112 @@
+/// @file local_policy_backend.h
+/// @brief 进程内策略推理后端：在调用线程上直接计算MLP策略，不经过推理服务器
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef LOCAL_POLICY_BACKEND_H_
+#define LOCAL_POLICY_BACKEND_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <google/protobuf/arena.h>
+#include "inference_backend.h"
+#include "mlp_policy.h"
+
+/// @brief 进程内策略推理后端
+///
+/// 地址格式为 "local:DIR"。Connect() 加载 DIR 下的每个 "<模型类型>.safetensors"（内存映射，权重原地使用）
+/// 或 "<模型类型>.mlp"（文本，格式见 MlpPolicy），检查其输入输出维数与 kObservationSize（
+/// ConvertRobotDataToObservation）、kActionSize（ConvertResponseToAction）一致；推理请求按模型类型选择模型，
+/// 在调用线程上计算，返回与推理服务器相同的原始（未缩放的）动作。稳态下不分配内存。
+/// 只能由同一个线程推理。
+///
+/// 循环策略（带GRU的模型，见 MlpPolicy）的隐状态保存在后端中，每次推理后更新，并写入响应的 states 字段；
+/// 推理的模型与上一次不同（切换模型类型或重新加载）时从零状态开始。
+class LocalPolicyBackend : public InferenceBackend {
+public:
+    /// @brief 同时加载的模型数上限
+    static constexpr size_t kMaxModels = 8;
+
+    /// @brief 构造函数
+    /// @param address 地址，格式为 "local:DIR"
+    explicit LocalPolicyBackend(const std::string& address);
+
+    /// @brief 加载目录下的全部模型
+    ///
+    /// 全部加载成功后才替换已有的模型；失败时保留之前加载的模型。
+    /// @return 是否至少加载了一个模型且全部有效
+    bool Connect() override;
+
+    /// @brief 是否已加载模型
+    bool IsConnected() const override { return connected_; }
+
+    /// @brief 本地计算没有网络等待，忽略截止时间
+    void SetRequestDeadline(std::chrono::microseconds) override {}
+
+    /// @brief 计算一次推理（拷贝 PredictInPlace() 的结果）
+    inference::InferenceResponse Predict(const std::vector<float>& observation,
+                                         const std::string& model_type = "default",
+                                         bool deterministic = true) override;
+
+    /// @brief 计算一次推理，动作写入后端持有的响应（稳态下不分配内存）
+    ///
+    /// MLP策略总是输出确定性的动作，deterministic 被忽略。
+    const inference::InferenceResponse& PredictInPlace(const float* observation, size_t count,
+                                                       const char* model_type = "default",
+                                                       bool deterministic = true) override;
+
+    /// @brief 清除循环策略的隐状态
+    void ResetRecurrentState() override;
+
+    /// @brief 直接添加一个已构建的模型（用于测试与基准）
+    /// @param model_type 模型类型标识
+    /// @param policy 模型，维数须与观察、动作一致
+    /// @param error 失败原因
+    /// @return 是否成功
+    bool AddModel(const std::string& model_type, std::unique_ptr<MlpPolicy> policy, std::string* error);
+
+    /// @brief 从目录重新加载一个模型（训练出新权重后替换）
+    ///
+    /// 新模型加载并检查通过后才替换旧模型，失败时旧模型继续使用。须在推理线程上调用，
+    /// 运行中由 InferenceWorker::RequestReload() 触发。
+    /// @param model_type 模型类型，对应 DIR 下的 "<模型类型>.safetensors" 或 "<模型类型>.mlp"
+    /// @param error 失败原因
+    /// @return 是否成功
+    bool ReloadModel(const std::string& model_type, std::string* error) override;
+
+    /// @brief 已加载的模型数
+    size_t ModelCount() const { return models_.size(); }
+
+    /// @brief 地址是否为进程内策略地址（"local:"）
+    static bool IsLocalAddress(const std::string& address);
+
+private:
+    typedef std::vector<std::pair<std::string, std::unique_ptr<MlpPolicy>>> ModelList;
+
+    /// @brief 加载目录下的全部模型到 models
+    bool LoadDirectory(ModelList* models);
+
+    /// @brief 检查模型的维数，并检查是否与 models 中已有的模型重名
+    static bool CheckModel(const ModelList& models, const std::string& model_type, const MlpPolicy& policy,
+                           std::string* error);
+
+    /// @brief 查找模型，没有时返回nullptr
+    MlpPolicy* FindModel(const char* model_type);
+
+    /// @brief 将响应置为失败
+    const inference::InferenceResponse& Fail(const char* error);
+
+    std::string directory_;
+    bool connected_;
+    ModelList models_;
+
+    google::protobuf::Arena arena_;
+    inference::InferenceResponse* response_;
+
+    std::vector<float> state_;          // 循环策略的隐状态，空表示初始的零状态
+    const MlpPolicy* state_model_;      // state_ 所属的模型
+};
+
+#endif  // LOCAL_POLICY_BACKEND_H_
@@ -0,0 +1,278 @@
+/// @file mlp_policy.h
+/// @brief 进程内的MLP策略推理：全连接层加激活函数，矩阵向量乘法使用 lib/eigen3
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef MLP_POLICY_H_
+#define MLP_POLICY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SafetensorsFile;
+
+/// @brief 激活函数
+enum class Activation {
+    kIdentity,
+    kRelu,
+    kElu,   // alpha = 1，与PyTorch nn.ELU() 的默认值相同
+    kTanh,
+};
+
+/// @brief 按名称（identity、relu、elu、tanh）解析激活函数
+/// @return 名称是否有效
+bool ParseActivation(const std::string& name, Activation* activation);
+
+/// @brief 激活函数的名称
+const char* ActivationName(Activation activation);
+
+/// @brief 权重的存储精度（激活值与偏置总是fp32）
+enum class WeightPrecision {
+    kFloat32,
+    kFloat16,  // IEEE半精度存储，转换为fp32后累加
+    kInt8,     // int8权重按输出通道缩放；输入按标定的各维范围量化为8位整数，int32累加
+};
+
+/// @brief 按名称（fp32、fp16、int8）解析权重精度
+/// @return 名称是否有效
+bool ParsePrecision(const std::string& name, WeightPrecision* precision);
+
+/// @brief 权重精度的名称
+const char* PrecisionName(WeightPrecision precision);
+
+/// @brief fp32转IEEE半精度（就近舍入到偶数，超出范围时为无穷大）
+uint16_t FloatToHalf(float value);
+
+/// @brief IEEE半精度转fp32
+float HalfToFloat(uint16_t half);
+
+/// @brief 读取 DataLogger 记录的观察CSV（"*_observation.csv"：timestamp 列后接观察各维）
+/// @param path 文件路径
+/// @param observation_size 观察维数
+/// @param observations 输出：逐行追加的观察数据
+/// @param error 失败原因
+/// @return 是否成功
+bool ReadObservationCsv(const std::string& path, size_t observation_size, std::vector<float>* observations,
+                        std::string* error);
+
+/// @brief MLP策略
+///
+/// 每层计算 y = act(W x + b)，W 为行主序的 [输出, 输入] 矩阵，与PyTorch nn.Linear 的 weight 布局相同，
+/// 导出时无需转置。各层的中间结果写入加载时按最宽的层预先分配的两块缓冲，Evaluate() 不分配内存。
+/// 加载后只读；Evaluate() 使用内部缓冲，只能由同一个线程调用。
+///
+/// safetensors文件（LoadSafetensors()）以只读内存映射加载，各层直接使用映射中的权重，不拷贝。
+/// 取名为 "<前缀><序号>.weight"/"<前缀><序号>.bias" 的F32张量（前缀默认 "actor."，即rsl_rl的命名），
+/// 按序号排列；"__metadata__" 中的 "activation" 为隐藏层激活函数（默认 elu），"prefix" 可覆盖前缀，
+/// 最后一层不加激活函数。
+///
+/// 各层可以量化（Quantize()，见 examples/quantize_policy.cpp）：fp16 层的权重占一半内存，转换为fp32后累加；
+/// int8 层的权重占四分之一，按标定时记录的各输入维范围把输入量化为 [-127, 127] 的整数，点积在int32上累加。
+/// 各维的量化步长乘进了权重的对应列，再按输出通道（行）取权重的缩放系数。两种内核都是简单的循环，
+/// 由编译器在x86（SSE2）与aarch64（NEON）上向量化。量化的模型保存为safetensors（SaveSafetensors()）：
+/// fp16 层的 weight 为F16张量；int8 层的 weight 为I8张量，另有 "<层>.weight_scale"（F32，[输出]）
+/// 与 "<层>.input_scale"（F32，[输入]，各输入维的量化步长）。加载时按 weight 的 dtype 确定精度，
+/// 同样原地使用映射的数据。
+///
+/// 文本格式（scripts/export_policy.py 从PyTorch检查点导出）：
+///     lite3_mlp 1
+///     layer <输出> <输入> <激活函数>
+///     <输出 x 输入 个权重，行主序>
+///     <输出 个偏置>
+///     layer ...
+/// 以 '#' 开头的行为注释。
+///
+/// 循环策略（rsl_rl 的 ActorCriticRecurrent）在第一层之前有一个单层GRU，MLP的输入是GRU的隐状态，
+/// 用 EvaluateRecurrent() 推理，隐状态由调用者保存。GRU权重总是fp32，门的顺序与PyTorch nn.GRU 相同（r、z、n）：
+/// safetensors中为 "<记忆前缀>weight_ih_l0"、"weight_hh_l0"、"bias_ih_l0"、"bias_hh_l0"
+/// （"__metadata__" 中的 "memory_prefix"，默认 "memory_a.rnn."）；文本格式在第一层之前加一块
+///     gru <隐状态> <输入>
+///     <3隐状态 x 输入 个 W_ih> <3隐状态 x 隐状态 个 W_hh> <3隐状态 个 b_ih> <3隐状态 个 b_hh>
+class MlpPolicy {
+public:
+    /// @brief 层数上限
+    static constexpr size_t kMaxLayers = 8;
+
+    MlpPolicy();
+    ~MlpPolicy();
+
+    MlpPolicy(const MlpPolicy&) = delete;
+    MlpPolicy& operator=(const MlpPolicy&) = delete;
+
+    /// @brief 追加一层，权重与偏置被拷贝进对象
+    /// @param weight 行主序的 [output_size, input_size] 权重
+    /// @param bias output_size 个偏置
+    /// @param output_size 输出维数
+    /// @param input_size 输入维数，须等于上一层的输出维数
+    /// @param activation 激活函数
+    /// @param error 失败原因
+    /// @return 是否成功
+    bool AddLayer(const float* weight, const float* bias, size_t output_size, size_t input_size,
+                  Activation activation, std::string* error);
+
+    /// @brief 追加一层，直接引用调用方的权重与偏置，不拷贝
+    ///
+    /// 参数与 AddLayer() 相同；weight 与 bias 须在模型被清空或销毁前保持有效。
+    bool AttachLayer(const float* weight, const float* bias, size_t output_size, size_t input_size,
+                     Activation activation, std::string* error);
+
+    /// @brief 设置GRU（模型成为循环策略），权重与偏置被拷贝进对象，须在追加层之前调用
+    /// @param weight_ih 行主序的 [3 * hidden_size, input_size] 输入权重，门的顺序为 r、z、n
+    /// @param weight_hh 行主序的 [3 * hidden_size, hidden_size] 隐状态权重
+    /// @param bias_ih 3 * hidden_size 个输入偏置
+    /// @param bias_hh 3 * hidden_size 个隐状态偏置
+    /// @param hidden_size 隐状态维数，须等于第一层的输入维数
+    /// @param input_size 观察维数
+    /// @param error 失败原因
+    /// @return 是否成功
+    bool SetGru(const float* weight_ih, const float* weight_hh, const float* bias_ih, const float* bias_hh,
+                size_t hidden_size, size_t input_size, std::string* error);
+
+    /// @brief 按扩展名加载：".safetensors" 使用 LoadSafetensors()，其余使用 LoadText()
+    bool Load(const std::string& path, std::string* error);
+
+    /// @brief 内存映射加载safetensors文件（替换已有的层），权重原地使用
+    /// @param path 文件路径
+    /// @param error 失败原因
+    /// @return 是否成功
+    bool LoadSafetensors(const std::string& path, std::string* error);
+
+    /// @brief 从文本文件加载（替换已有的层）
+    /// @param path 文件路径
+    /// @param error 失败原因
+    /// @return 是否成功
+    bool LoadText(const std::string& path, std::string* error);
+
+    /// @brief 将fp32模型量化为本模型（替换已有的层，权重拷贝进对象）
+    /// @param source fp32模型
+    /// @param precision 目标精度
+    /// @param input_ranges 各层各输入维的最大绝对值（CalibrateInputRanges() 的结果），仅 kInt8 需要
+    /// @param error 失败原因
+    /// @return 是否成功
+    bool Quantize(const MlpPolicy& source, WeightPrecision precision, const std::vector<float>& input_ranges,
+                  std::string* error);
+
+    /// @brief 以一个观察计算一次前向推理，同时更新各层各输入维的最大绝对值（用于int8标定）
+    /// @param observation 观察数据
+    /// @param count 观察数据长度，须等于 InputSize()
+    /// @param input_ranges 输入输出：按层依次排列的各输入维最大绝对值（共各层输入维数之和个），
+    ///                     长度不符时重置为0
+    /// @return 是否成功
+    bool CalibrateInputRanges(const float* observation, size_t count, std::vector<float>* input_ranges);
+
+    /// @brief 保存为safetensors（rsl_rl的张量命名，各精度的张量见类说明）
+    ///
+    /// 隐藏层须使用同一种激活函数，最后一层不加激活函数。
+    /// @param path 文件路径
+    /// @param error 失败原因
+    /// @return 是否成功
+    bool SaveSafetensors(const std::string& path, std::string* error) const;
+
+    /// @brief 删除所有层
+    void Clear();
+
+    /// @brief 输入维数（循环策略为GRU的输入维数），没有层时为0
+    size_t InputSize() const;
+
+    /// @brief 输出维数，没有层时为0
+    size_t OutputSize() const;
+
+    /// @brief 隐状态维数，非循环策略为0
+    size_t StateSize() const { return gru_.hidden_size; }
+
+    /// @brief 层数
+    size_t LayerCount() const { return layers_.size(); }
+
+    /// @brief 第 index 层的输入维数
+    size_t LayerInputSize(size_t index) const { return layers_[index].input_size; }
+
+    /// @brief 权重与偏置的总数
+    size_t ParameterCount() const;
+
+    /// @brief 权重、偏置与缩放系数占用的字节数
+    size_t WeightBytes() const;
+
+    /// @brief 第一层的权重精度（量化的模型各层精度相同），没有层时为 kFloat32
+    WeightPrecision Precision() const;
+
+    /// @brief 权重是否直接使用内存映射的文件
+    bool IsMapped() const { return mapped_ != nullptr; }
+
+    /// @brief 各层维数的描述，如 "65 -> 512 -> 256 -> 12 (elu)"，量化的模型附带精度，如 "(elu, int8)"，
+    /// 循环策略以GRU开头，如 "65 -> gru 256 -> 512 -> 12 (elu)"
+    std::string Describe() const;
+
+    /// @brief 计算一次前向推理（不分配内存）
+    /// @param observation 观察数据
+    /// @param count 观察数据长度，须等于 InputSize()
+    /// @param action 输出：OutputSize() 个动作
+    /// @return 是否成功（没有层、长度不符或模型是循环策略时返回false）
+    bool Evaluate(const float* observation, size_t count, float* action);
+
+    /// @brief 循环策略推理一步（不分配内存）：由观察与隐状态计算新的隐状态，再由新的隐状态计算动作
+    ///
+    /// 三个门在一次遍历中计算：两次 [3 * 隐状态] 的矩阵向量乘之后，逐个隐状态单元计算 r、z、n 与新的隐状态，
+    /// 不写出中间的门向量。
+    /// @param observation 观察数据
+    /// @param count 观察数据长度，须等于 InputSize()
+    /// @param state StateSize() 个隐状态，nullptr 表示初始的零状态
+    /// @param next_state 输出：StateSize() 个新的隐状态，可以与 state 相同
+    /// @param action 输出：OutputSize() 个动作
+    /// @return 是否成功（没有层、长度不符或模型不是循环策略时返回false）
+    bool EvaluateRecurrent(const float* observation, size_t count, const float* state, float* next_state,
+                           float* action);
+
+private:
+    /// @brief 一层的参数
+    struct Layer {
+        std::vector<float> storage;           // 拷贝的fp32权重、偏置与缩放系数；引用外部内存时为空
+        std::vector<uint16_t> half_storage;   // 拷贝的fp16权重
+        std::vector<int8_t> int8_storage;     // 拷贝的int8权重
+        WeightPrecision precision;
+        const void* weight;                   // 行主序的 [output_size, input_size]，类型由 precision 决定
+        const float* bias;
+        const float* weight_scale;            // int8：每个输出通道的缩放系数
+        const float* input_scale;             // int8：每个输入维的量化步长
+        size_t output_size;
+        size_t input_size;
+        Activation activation;
+    };
+
+    /// @brief GRU的参数（hidden_size 为0时没有GRU）
+    struct Gru {
+        std::vector<float> storage;  // 拷贝的权重与偏置；引用外部内存时为空
+        const float* weight_ih;      // 行主序的 [3 * hidden_size, input_size]
+        const float* weight_hh;      // 行主序的 [3 * hidden_size, hidden_size]
+        const float* bias_ih;
+        const float* bias_hh;
+        size_t hidden_size;
+        size_t input_size;
+    };
+
+    /// @brief 检查维数后设置GRU，并分配门的缓冲
+    bool AttachGru(const float* weight_ih, const float* weight_hh, const float* bias_ih, const float* bias_hh,
+                   size_t hidden_size, size_t input_size, std::string* error);
+
+    /// @brief 检查维数后追加一层，并扩大中间缓冲
+    bool AppendLayer(Layer layer, std::string* error);
+
+    /// @brief 前向推理
+    /// @param input_ranges 非空时记录各层输入的最大绝对值
+    void Forward(const float* observation, float* action, float* input_ranges);
+
+    /// @brief 对一层的输出就地应用激活函数
+    static void Activate(Activation activation, float* values, size_t count);
+
+    std::vector<Layer> layers_;
+    Gru gru_;
+    std::vector<float> gates_[2];   // GRU的 W_ih x + b_ih 与 W_hh h + b_hh，各 3 * hidden_size
+    std::vector<float> zero_state_;  // 初始的零隐状态
+    std::vector<float> buffers_[2];  // 相邻两层交替使用的中间结果
+    std::vector<int16_t> quantized_input_;  // int8层量化后的输入（取值在 [-127, 127]）
+    std::unique_ptr<SafetensorsFile> mapped_;  // 层引用其中的张量时持有映射
+};
+
+#endif  // MLP_POLICY_H_
@@ -0,0 +1,127 @@
+/// @file phase_profiler.h
+/// @brief 控制循环各阶段的延迟统计
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef PHASE_PROFILER_H_
+#define PHASE_PROFILER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <time.h>
+#include "alloc_tracker.h"
+#include "latency_histogram.h"
+#include "trace_recorder.h"
+
+/// @brief 控制循环中被计时的阶段
+enum ControlPhase {
+    kPhaseObservation = 0,   // ConvertRobotDataToObservation
+    kPhaseScaling,           // ApplyObservationScalingAndNoise
+    kPhaseInference,         // gRPC往返（推理线程）
+    kPhaseLogObservation,    // DataLogger::SaveObservation
+    kPhaseLogRawAction,      // DataLogger::SaveRawAction
+    kPhaseLogAction,         // DataLogger::SaveAction
+    kPhaseSendCmd,           // Sender::SendCmd
+    kPhaseControlTick,       // 整个控制周期
+    kPhaseStateToCmd,        // 最新状态包到达至SendCmd
+    kPhaseStateInterval,     // 相邻状态包的到达间隔
+    kPhaseUplink,            // 推理请求上行（开启延迟追踪时，下同）
+    kPhaseServerQueue,       // 服务器收到请求到开始计算
+    kPhaseCompute,           // 模型计算
+    kPhaseServerReply,       // 计算结束到服务器发送响应
+    kPhaseDownlink,          // 推理响应下行
+    kPhaseCount
+};
+
+/// @brief 阶段延迟统计器
+///
+/// 每个阶段对应一个固定内存的直方图。同一阶段只能由一个线程记录（控制线程或推理线程），
+/// 记录过程不分配内存、不加锁，可在生产环境中常开。后台报告线程周期性打印汇总。
+class PhaseProfiler {
+public:
+    PhaseProfiler();
+    ~PhaseProfiler();
+
+    PhaseProfiler(const PhaseProfiler&) = delete;
+    PhaseProfiler& operator=(const PhaseProfiler&) = delete;
+
+    /// @brief 单调时钟当前时间（纳秒），走vDSO，不陷入内核
+    static uint64_t NowNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    /// @brief 记录一个阶段耗时
+    /// @param phase 阶段
+    /// @param duration_ns 耗时（纳秒）
+    void Record(ControlPhase phase, uint64_t duration_ns) {
+        histograms_[phase].Record(duration_ns);
+    }
+
+    /// @brief 获取阶段直方图
+    const LatencyHistogram& Histogram(ControlPhase phase) const { return histograms_[phase]; }
+
+    /// @brief 启动周期报告线程
+    /// @param period_s 报告周期（秒），不大于0时不启动
+    void StartReporter(int period_s);
+
+    /// @brief 停止周期报告线程
+    void StopReporter();
+
+    /// @brief 打印所有阶段的汇总
+    /// @param title 标题
+    void PrintSummary(const char* title) const;
+
+    /// @brief 阶段名称
+    static const char* PhaseName(ControlPhase phase);
+
+private:
+    void ReporterLoop(int period_s);
+
+    LatencyHistogram histograms_[kPhaseCount];
+
+    std::thread reporter_;
+    std::mutex reporter_mutex_;
+    std::condition_variable reporter_cv_;
+    bool reporter_stop_;
+};
+
+/// @brief 作用域计时，析构时记录耗时；profiler为nullptr时不计时
+///
+/// 同时把当前线程标记为处于该阶段，供 AllocTracker 按阶段归类分配；
+/// TraceRecorder 启用时还在时间线上记录该阶段的开始与结束。
+class ScopedPhase {
+public:
+    ScopedPhase(PhaseProfiler* profiler, ControlPhase phase)
+        : profiler_(profiler), phase_(phase), start_ns_(profiler ? PhaseProfiler::NowNs() : 0),
+          previous_alloc_phase_(AllocTracker::SwapPhase(phase)) {
+        if (TraceRecorder::Instance().IsEnabled()) {
+            TraceRecorder::Instance().Begin(PhaseProfiler::PhaseName(phase));
+        }
+    }
+
+    ~ScopedPhase() {
+        if (TraceRecorder::Instance().IsEnabled()) {
+            TraceRecorder::Instance().End(PhaseProfiler::PhaseName(phase_));
+        }
+        if (profiler_ != nullptr) {
+            profiler_->Record(phase_, PhaseProfiler::NowNs() - start_ns_);
+        }
+        AllocTracker::SwapPhase(previous_alloc_phase_);
+    }
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    PhaseProfiler* profiler_;
+    ControlPhase phase_;
+    uint64_t start_ns_;
+    int previous_alloc_phase_;
+};
+
+#endif  // PHASE_PROFILER_H_
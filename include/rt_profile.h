@@ -0,0 +1,82 @@
+/// @file rt_profile.h
+/// @brief 控制进程的实时运行配置（SCHED_FIFO、CPU绑定、内存锁定与预缺页）
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef RT_PROFILE_H_
+#define RT_PROFILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// @brief 实时配置参数
+struct RtConfig {
+    bool enabled = false;                          // 是否启用实时模式（--rt）
+    int control_priority = 80;                     // 控制线程SCHED_FIFO优先级
+    int receive_priority = 85;                     // 接收线程SCHED_FIFO优先级，高于控制线程以便状态及时到达
+    int control_cpu = -1;                          // 控制线程绑定的CPU，-1表示不绑定
+    int receive_cpu = -1;                          // 接收线程绑定的CPU，-1表示不绑定
+    bool lock_memory = true;                       // 是否调用mlockall
+    size_t prefault_stack_bytes = 256 * 1024;      // 控制线程栈预缺页大小
+    size_t prefault_heap_bytes = 8 * 1024 * 1024;  // 堆预缺页大小
+};
+
+/// @brief 线程实际获得的调度参数
+struct ThreadSchedInfo {
+    bool valid = false;    // 是否已采集
+    int policy = 0;        // 调度策略（SCHED_OTHER/SCHED_FIFO/...）
+    int priority = 0;      // 静态优先级
+    uint64_t cpu_mask = 0; // 可运行的CPU掩码（前64个CPU）
+};
+
+/// @brief 实时运行配置
+///
+/// SDK中的接收线程由 Receiver 内部创建，无法直接获取句柄。Linux下新线程会继承创建者的
+/// 调度策略与CPU亲和性，因此在创建接收线程前先让当前线程进入接收配置，创建完成后再切换为控制配置。
+/// mlockall(MCL_FUTURE) 会让之后创建的线程栈在映射时即被锁定并填充。
+class RtProfile {
+public:
+    /// @brief 构造函数
+    /// @param config 实时配置参数
+    explicit RtProfile(const RtConfig& config);
+
+    /// @brief 是否启用实时模式
+    bool Enabled() const { return config_.enabled; }
+
+    /// @brief 锁定内存并对堆进行预缺页，应在创建其他线程之前调用
+    /// @return 是否全部成功
+    bool LockMemory();
+
+    /// @brief 当前线程进入接收线程配置，此后创建的线程将继承该配置
+    /// @return 是否成功
+    bool EnterReceiveProfile();
+
+    /// @brief 当前线程进入控制线程配置，并对栈进行预缺页
+    /// @return 是否成功
+    bool EnterControlProfile();
+
+    /// @brief 打印启动时的实时配置报告
+    void PrintReport() const;
+
+    /// @brief 采集当前线程的调度参数
+    static ThreadSchedInfo GetCurrentThreadSchedInfo();
+
+    /// @brief 格式化调度参数
+    /// @param name 线程名称
+    /// @param info 调度参数
+    static std::string FormatSchedInfo(const char* name, const ThreadSchedInfo& info);
+
+private:
+    /// @brief 为当前线程设置SCHED_FIFO优先级与CPU绑定
+    bool ApplyToCurrentThread(const char* name, int priority, int cpu);
+
+    /// @brief 对当前线程栈进行预缺页
+    void PrefaultStack() const;
+
+    RtConfig config_;
+    bool memory_locked_;
+    std::string report_;
+};
+
+#endif  // RT_PROFILE_H_
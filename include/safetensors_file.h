@@ -0,0 +1,85 @@
+/// @file safetensors_file.h
+/// @brief 以只读内存映射打开safetensors文件，张量数据原地使用，不拷贝
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef SAFETENSORS_FILE_H_
+#define SAFETENSORS_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// @brief 文件中的一个张量
+struct SafetensorsTensor {
+    std::string name;
+    std::string dtype;          // "F32"、"F16"、"I8" 等
+    std::vector<size_t> shape;
+    const void* data;           // 指向映射内存，随文件关闭失效
+    size_t size_bytes;
+};
+
+/// @brief 内存映射的safetensors文件
+///
+/// 格式：8字节小端的头部长度 N，N 字节的JSON头部（张量名 -> dtype、shape、data_offsets，
+/// 以及可选的 "__metadata__" 字符串表），随后是张量数据，data_offsets 相对数据区起点。
+/// 文件以 MAP_PRIVATE 只读映射并预缺页，张量数据在文件关闭前一直有效。
+/// 映射期间文件不应被原地改写；更新模型时应写入临时文件再 rename 替换，已映射的旧文件不受影响。
+/// 只支持小端主机（x86_64 与 aarch64）。
+class SafetensorsFile {
+public:
+    SafetensorsFile();
+    ~SafetensorsFile();
+
+    SafetensorsFile(const SafetensorsFile&) = delete;
+    SafetensorsFile& operator=(const SafetensorsFile&) = delete;
+
+    /// @brief 映射并解析文件（关闭已打开的文件）
+    /// @param path 文件路径
+    /// @param error 失败原因
+    /// @return 是否成功；头部格式错误、偏移越界或张量未按元素大小对齐时失败
+    bool Open(const std::string& path, std::string* error);
+
+    /// @brief 解除映射
+    void Close();
+
+    /// @brief 是否已打开
+    bool IsOpen() const { return mapping_ != nullptr; }
+
+    /// @brief 全部张量，按在头部中出现的顺序
+    const std::vector<SafetensorsTensor>& Tensors() const { return tensors_; }
+
+    /// @brief 按名称查找张量，没有时返回nullptr
+    const SafetensorsTensor* Find(const std::string& name) const;
+
+    /// @brief "__metadata__" 中的一项，没有时返回 fallback
+    std::string Metadata(const std::string& key, const std::string& fallback) const;
+
+    /// @brief 映射的字节数（整个文件）
+    size_t MappedBytes() const { return mapped_size_; }
+
+    /// @brief 一种 dtype 的元素字节数，未知的 dtype 返回0
+    static size_t DtypeSize(const std::string& dtype);
+
+    /// @brief 写出safetensors文件
+    ///
+    /// 数据按元素大小从大到小连续存放（忽略 tensors 中的偏移），头部用空格补齐到8字节，保证每个张量对齐。
+    /// 先写入 "<path>.tmp" 再 rename 替换，正在映射旧文件的进程不受影响。
+    /// @param path 文件路径
+    /// @param tensors 张量，data 与 size_bytes 给出数据
+    /// @param metadata "__metadata__" 字符串表
+    /// @param error 失败原因
+    /// @return 是否成功
+    static bool Write(const std::string& path, const std::vector<SafetensorsTensor>& tensors,
+                      const std::vector<std::pair<std::string, std::string>>& metadata, std::string* error);
+
+private:
+    void* mapping_;
+    size_t mapped_size_;
+    std::vector<SafetensorsTensor> tensors_;
+    std::vector<std::pair<std::string, std::string>> metadata_;
+};
+
+#endif  // SAFETENSORS_FILE_H_
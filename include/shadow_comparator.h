@@ -0,0 +1,86 @@
+/// @file shadow_comparator.h
+/// @brief 影子策略评估：按观察配对候选模型与在线策略的动作，统计逐关节偏差
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef SHADOW_COMPARATOR_H_
+#define SHADOW_COMPARATOR_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "grpc_client.h"
+
+/// @brief 一个关节上影子动作与在线动作的偏差（原始动作，未缩放）
+struct JointDivergence {
+    double mean_abs;  // 平均绝对偏差
+    double rms;       // 均方根偏差
+    double max_abs;   // 最大绝对偏差
+};
+
+/// @brief 影子策略的动作比较
+///
+/// 影子策略（待验证的候选模型）与在线策略收到相同的观察，在各自的 InferenceWorker 线程上推理，
+/// 只记录、不驱动机器人。两个工作线程的观察序号一致，控制线程把取到的两路动作分别交给 AddLive() 与
+/// AddShadow()，存入按序号取模的 kPendingSlots 个槽；NextMatch() 取出两路都已到达的同一观察的动作，
+/// 计入逐关节统计。影子推理落后超过 kPendingSlots 个观察，或某一路推理失败时，动作无法配对，
+/// 之后被新的动作覆盖。只能由控制线程调用，不分配内存。
+class ShadowComparator {
+public:
+    /// @brief 等待配对的动作槽数
+    static constexpr size_t kPendingSlots = 16;
+
+    ShadowComparator();
+
+    /// @brief 记录在线策略的动作
+    /// @param seq 观察序号（ActionSample::seq），0被忽略
+    /// @param action kActionSize 个原始动作
+    void AddLive(uint64_t seq, const float* action);
+
+    /// @brief 记录影子策略的动作
+    /// @param seq 观察序号，0被忽略
+    /// @param action kActionSize 个原始动作
+    void AddShadow(uint64_t seq, const float* action);
+
+    /// @brief 取出序号最小的一对已配对的动作并计入统计
+    /// @param seq 输出：观察序号
+    /// @param live 输出：在线动作，下一次调用 AddLive() 前有效
+    /// @param shadow 输出：影子动作，下一次调用 AddShadow() 前有效
+    /// @return 是否取到
+    bool NextMatch(uint64_t* seq, const float** live, const float** shadow);
+
+    /// @brief 记录的在线动作数
+    uint64_t LiveCount() const { return live_count_; }
+
+    /// @brief 记录的影子动作数
+    uint64_t ShadowCount() const { return shadow_count_; }
+
+    /// @brief 配对并比较的动作数
+    uint64_t MatchedCount() const { return matched_count_; }
+
+    /// @brief 一个关节的偏差，尚未配对时全为0
+    JointDivergence Joint(size_t joint) const;
+
+    /// @brief 打印配对数与逐关节偏差
+    void PrintStats() const;
+
+private:
+    /// @brief 一个等待配对的动作
+    struct Slot {
+        uint64_t seq;  // 0表示空
+        std::array<float, kActionSize> action;
+    };
+
+    static void Store(std::array<Slot, kPendingSlots>* slots, uint64_t seq, const float* action);
+
+    std::array<Slot, kPendingSlots> live_;
+    std::array<Slot, kPendingSlots> shadow_;
+    uint64_t live_count_;
+    uint64_t shadow_count_;
+    uint64_t matched_count_;
+    std::array<double, kActionSize> sum_abs_;
+    std::array<double, kActionSize> sum_square_;
+    std::array<double, kActionSize> max_abs_;
+};
+
+#endif  // SHADOW_COMPARATOR_H_
@@ -0,0 +1,180 @@
+/// @file shm_transport.h
+/// @brief 同机部署时的共享内存推理传输：/dev/shm 中的定长槽位环，futex唤醒
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef SHM_TRANSPORT_H_
+#define SHM_TRANSPORT_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <google/protobuf/arena.h>
+#include "inference_backend.h"
+
+/// @brief 区域头部的魔数与布局版本，布局改变时须同步修改 scripts/shm_policy_server.py
+constexpr uint32_t kShmMagic = 0x4C335348;  // "HS3L"
+constexpr uint32_t kShmVersion = 1;
+
+/// @brief 槽位数与各字段容量
+constexpr size_t kShmSlotCount = 8;
+constexpr size_t kShmMaxObservation = 128;
+constexpr size_t kShmMaxAction = 32;
+constexpr size_t kShmModelTypeSize = 32;
+constexpr size_t kShmErrorSize = 128;
+
+/// @brief 槽位状态（同时是futex字）
+enum ShmSlotState : uint32_t {
+    kShmSlotFree = 0,      // 空闲，客户端可写入请求
+    kShmSlotRequest = 1,   // 请求已写入，等待服务器处理
+    kShmSlotResponse = 2,  // 响应已写入，等待客户端取走
+};
+
+/// @brief 一个请求/响应槽位，布局固定（所有字段均为小端32位或字节数组）
+struct alignas(64) ShmSlot {
+    std::atomic<uint32_t> state;              // ShmSlotState
+    uint32_t seq;                             // 请求序号
+    uint32_t deterministic;                   // 是否确定性推理
+    uint32_t observation_count;               // 观察长度
+    char model_type[kShmModelTypeSize];       // 模型类型，以'\0'结尾
+    float observation[kShmMaxObservation];
+    uint32_t success;                         // 推理是否成功
+    uint32_t action_count;                    // 动作长度
+    float action[kShmMaxAction];
+    char error_message[kShmErrorSize];        // 失败原因，以'\0'结尾
+};
+
+/// @brief 区域头部
+struct alignas(64) ShmHeader {
+    uint32_t magic;                         // kShmMagic，服务器初始化完成后最后写入
+    uint32_t version;                       // kShmVersion
+    uint32_t slot_count;                    // kShmSlotCount
+    uint32_t slot_size;                     // sizeof(ShmSlot)
+    std::atomic<uint32_t> request_seq;      // 已提交的请求数（futex字，服务器在此等待新请求）
+    std::atomic<uint32_t> server_pid;       // 服务器进程号，服务器退出时清零
+};
+
+/// @brief 共享内存区域：头部之后紧跟 kShmSlotCount 个槽位
+struct ShmRegion {
+    ShmHeader header;
+    ShmSlot slots[kShmSlotCount];
+};
+
+static_assert(sizeof(ShmHeader) == 64, "ShmHeader layout changed");
+static_assert(sizeof(ShmSlot) == 832, "ShmSlot layout changed");
+static_assert(offsetof(ShmSlot, observation) == 48 && offsetof(ShmSlot, success) == 560 &&
+              offsetof(ShmSlot, action) == 568 && offsetof(ShmSlot, error_message) == 696,
+              "ShmSlot layout changed");
+
+/// @brief 共享内存推理客户端
+///
+/// 地址格式为 "shm:NAME"，对应服务器创建的 /dev/shm/NAME。第N个请求使用第 N % kShmSlotCount
+/// 个槽位：写入观察后置为 kShmSlotRequest、递增头部的 request_seq 并唤醒服务器，
+/// 然后先让出CPU自旋一小段时间、再在槽位状态上futex等待响应。请求超时后槽位留给服务器
+/// 处理完毕，轮到它时再丢弃迟到的响应。同一区域只能有一个客户端，且只能由同一个线程调用。
+class ShmClient : public InferenceBackend {
+public:
+    /// @brief 等待单个响应的默认超时（毫秒）
+    static constexpr int kDefaultTimeoutMs = 1000;
+
+    /// @brief 构造函数
+    /// @param server_address 服务器地址，格式为 "shm:NAME"
+    explicit ShmClient(const std::string& server_address);
+
+    /// @brief 析构函数，解除映射
+    ~ShmClient() override;
+
+    ShmClient(const ShmClient&) = delete;
+    ShmClient& operator=(const ShmClient&) = delete;
+
+    /// @brief 映射服务器创建的区域并发送一个测试请求
+    /// @return 连接是否成功
+    bool Connect() override;
+
+    /// @brief 检查连接状态
+    bool IsConnected() const override;
+
+    /// @brief 发送推理请求并获取响应（拷贝 PredictInPlace() 的结果）
+    inference::InferenceResponse Predict(const std::vector<float>& observation,
+                                         const std::string& model_type = "default",
+                                         bool deterministic = true) override;
+
+    /// @brief 发送推理请求，响应写入客户端持有的消息（稳态下不分配内存）
+    const inference::InferenceResponse& PredictInPlace(const float* observation, size_t count,
+                                                       const char* model_type = "default",
+                                                       bool deterministic = true) override;
+
+    /// @brief 设置等待单个响应的超时
+    void SetRequestDeadline(std::chrono::microseconds deadline) override { timeout_ = deadline; }
+
+    /// @brief 设置等待单个响应的超时
+    /// @param timeout_ms 超时（毫秒）
+    void SetTimeout(int timeout_ms) { timeout_ = std::chrono::milliseconds(timeout_ms); }
+
+    /// @brief 地址是否为共享内存地址（"shm:"）
+    static bool IsShmAddress(const std::string& server_address);
+
+private:
+    /// @brief 将响应置为失败
+    const inference::InferenceResponse& Fail(const char* error);
+
+    std::string name_;
+    ShmRegion* region_;
+    bool connected_;
+    std::chrono::microseconds timeout_;
+    uint32_t next_seq_;
+
+    google::protobuf::Arena arena_;
+    inference::InferenceResponse* response_;
+};
+
+/// @brief 共享内存推理服务器（C++参考实现）
+///
+/// 创建区域并按序号依次处理请求；等待新请求时先让出CPU自旋一小段时间，再在 request_seq 上futex等待。
+/// 处理函数直接读写槽位：读取观察与模型类型，写入 success、action_count、action 与 error_message。
+class ShmServer {
+public:
+    using Handler = std::function<void(ShmSlot* slot)>;
+
+    /// @brief 构造函数
+    /// @param name 区域名，对应 /dev/shm/NAME
+    explicit ShmServer(const std::string& name);
+
+    /// @brief 析构函数，清除服务器进程号并删除区域
+    ~ShmServer();
+
+    ShmServer(const ShmServer&) = delete;
+    ShmServer& operator=(const ShmServer&) = delete;
+
+    /// @brief 创建并初始化区域（已存在的同名区域会被替换）
+    /// @return 是否成功
+    bool Create();
+
+    /// @brief 处理所有待处理的请求，没有请求时至多等待timeout_ms
+    /// @param handler 处理函数
+    /// @param timeout_ms 等待超时（毫秒）
+    /// @return 处理的请求数
+    int ServeOnce(const Handler& handler, int timeout_ms);
+
+    /// @brief 循环处理请求，直到 Stop()
+    /// @param handler 处理函数
+    void Run(const Handler& handler);
+
+    /// @brief 使 Run() 返回（可在其他线程调用）
+    void Stop();
+
+    /// @brief 回显处理函数：返回12个动作，依次为观察的前12个元素（不足时补0）
+    static void Echo(ShmSlot* slot);
+
+private:
+    std::string name_;
+    ShmRegion* region_;
+    uint32_t next_seq_;
+    std::atomic<bool> running_;
+};
+
+#endif  // SHM_TRANSPORT_H_
@@ -0,0 +1,121 @@
+/// @file stale_action_policy.h
+/// @brief 过期动作策略：推理错过截止时间时保持、向中立姿态衰减上一个动作，或切换为阻尼
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef STALE_ACTION_POLICY_H_
+#define STALE_ACTION_POLICY_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "latency_histogram.h"
+
+/// @brief 错过截止时间后如何使用上一个动作
+enum class StaleActionMode {
+    kHold,   // 保持上一个动作不变
+    kDecay,  // 上一个动作按错过的时长指数衰减，趋向中立姿态（原始动作为0）
+};
+
+/// @brief 一个控制周期的处理结果
+enum class ActionFallback {
+    kFresh,    // 动作按时到达，直接使用
+    kHold,     // 保持上一个动作
+    kDecay,    // 使用乘以 Scale() 后的上一个动作
+    kDamping,  // 零刚度阻尼，直到 Reset()
+};
+
+/// @brief 过期动作策略的配置
+struct StaleActionConfig {
+    StaleActionMode mode = StaleActionMode::kHold;
+    std::chrono::microseconds policy_period = std::chrono::microseconds(20000);  // 策略周期，即单个请求的截止时间
+    double decay_per_period = 0.5;  // 衰减模式下每多错过一个周期，动作乘以的系数
+    int damp_after = 0;             // 连续错过这么多个周期后切换为阻尼，0为从不
+    double damping_kd = 1.0;        // 阻尼模式的微分增益（比例增益为0）
+};
+
+/// @brief 过期动作统计
+struct StaleActionStats {
+    uint64_t ticks;              // 记录的控制周期数
+    uint64_t held_ticks;         // 保持上一个动作的控制周期数
+    uint64_t decayed_ticks;      // 使用衰减后动作的控制周期数
+    uint64_t damping_ticks;      // 处于阻尼的控制周期数
+    uint64_t missed_periods;     // 错过截止时间的策略周期总数
+    uint64_t max_missed_streak;  // 连续错过的最多周期数
+    uint64_t damping_entries;    // 切换为阻尼的次数
+};
+
+/// @brief 过期动作策略
+///
+/// 每个请求的截止时间为一个策略周期 P：观察在 t 时刻提交，动作最迟在 t + P 到达，并一直使用到
+/// 下一个观察的动作到达（最迟 t + 2P）。因此所用动作的年龄（距其观察的时长）小于 2P 时视为按时，
+/// 此后每多一个 P 计为错过一个周期。尚无动作时从 Start() 起计算，首个动作同样应在 P 内到达。
+/// 错过后按配置保持或衰减上一个动作，连续错过 damp_after 个周期后切换为阻尼并保持，
+/// 以免服务器恢复后策略从已经塌下的姿态突然重新发力。
+/// 只能由控制线程调用，不分配内存。
+class StaleActionPolicy {
+public:
+    /// @brief 错过周期数直方图的桶数，最后一个桶包含更多的错过
+    static constexpr int kMissBuckets = 9;
+
+    explicit StaleActionPolicy(const StaleActionConfig& config);
+
+    StaleActionPolicy(const StaleActionPolicy&) = delete;
+    StaleActionPolicy& operator=(const StaleActionPolicy&) = delete;
+
+    /// @brief 开始计时（首个观察提交时调用）
+    ///
+    /// 在首个动作到达前，过期与否按距本时刻的时间判断；未调用时以首次 Update() 的时刻代替，
+    /// 这只在该 Update() 恰好与首个观察同一时刻时才正确。
+    void Start(std::chrono::steady_clock::time_point now);
+
+    /// @brief 每个控制周期调用一次，决定如何使用当前持有的动作
+    /// @param action_seq 当前动作对应的观察序号，0表示尚无动作
+    /// @param obs_stamp 当前动作对应观察的生成时刻
+    /// @param now 当前时刻
+    /// @return 处理结果
+    ActionFallback Update(uint64_t action_seq, std::chrono::steady_clock::time_point obs_stamp,
+                          std::chrono::steady_clock::time_point now);
+
+    /// @brief 最近一次 Update() 后动作应乘以的系数（仅kDecay时小于1）
+    float Scale() const { return scale_; }
+
+    /// @brief 最近一次 Update() 时当前动作已错过的周期数
+    int MissedPeriods() const { return missed_; }
+
+    /// @brief 是否处于阻尼
+    bool IsDamping() const { return damping_; }
+
+    /// @brief 退出阻尼并重新计时（统计保留）
+    void Reset(std::chrono::steady_clock::time_point now);
+
+    /// @brief 配置
+    const StaleActionConfig& Config() const { return config_; }
+
+    /// @brief 获取统计信息
+    StaleActionStats GetStats() const { return stats_; }
+
+    /// @brief 所用动作年龄的分布
+    const LatencyHistogram& AgeHistogram() const { return age_histogram_; }
+
+    /// @brief 错过周期数为 missed（最后一个桶为至少 kMissBuckets - 1）的控制周期数
+    uint64_t MissHistogram(int missed) const;
+
+    /// @brief 打印统计信息
+    void PrintStats() const;
+
+private:
+    StaleActionConfig config_;
+    std::chrono::steady_clock::time_point start_;
+    bool started_;
+    bool damping_;
+    float scale_;
+    int missed_;
+    int counted_missed_;  // 本次连续错过中已计入 missed_periods 的周期数
+
+    StaleActionStats stats_;
+    std::array<uint64_t, kMissBuckets> miss_counts_;
+    LatencyHistogram age_histogram_;
+};
+
+#endif  // STALE_ACTION_POLICY_H_
@@ -0,0 +1,106 @@
+/// @file task_executor.h
+/// @brief 确定性的多速率任务调度器
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef TASK_EXECUTOR_H_
+#define TASK_EXECUTOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+/// @brief 单个任务的运行统计
+struct TaskStats {
+    const char* name;       // 任务名称
+    int period_ticks;       // 周期（节拍数）
+    int phase;              // 相位（节拍数）
+    uint64_t runs;          // 运行次数
+    uint64_t overruns;      // 超出预算的次数
+    double max_us;          // 最长耗时
+    double mean_us;         // 平均耗时
+};
+
+/// @brief 多速率任务调度器
+///
+/// 调度器以固定节拍驱动（由控制线程在每个周期调用一次 Tick()）。任务注册时指定周期与相位，
+/// 满足 tick % period == phase 且位于 [start_tick, end_tick) 窗口内时运行；同一节拍内的任务
+/// 严格按注册顺序执行。未指定相位的任务会被放到负载最轻的相位上，避免多个低频任务挤在同一节拍，
+/// 使最坏节拍耗时保持平稳。所有任务须在第一次 Tick() 之前注册，运行期间不分配内存。
+class TaskExecutor {
+public:
+    /// @brief 任务回调，参数为当前节拍号
+    using Task = std::function<void(uint64_t tick)>;
+
+    static constexpr int kAutoPhase = -1;
+    static constexpr uint64_t kNoEnd = std::numeric_limits<uint64_t>::max();
+
+    /// @brief 构造函数
+    /// @param tick_period_us 节拍周期（微秒），用作任务与节拍的默认耗时预算
+    explicit TaskExecutor(int64_t tick_period_us);
+
+    /// @brief 注册任务
+    /// @param name 任务名称，须指向静态字符串
+    /// @param period_ticks 周期（节拍数，>=1）
+    /// @param task 任务回调
+    /// @param phase 相位（0 ~ period_ticks-1），kAutoPhase表示自动分散
+    /// @param start_tick 起始节拍（含）
+    /// @param end_tick 结束节拍（不含），kNoEnd表示不结束
+    /// @param budget_us 单次耗时预算（微秒），0表示使用节拍周期
+    /// @return 任务索引，参数非法时返回-1
+    int AddTask(const char* name, int period_ticks, Task task, int phase = kAutoPhase,
+                uint64_t start_tick = 0, uint64_t end_tick = kNoEnd, int64_t budget_us = 0);
+
+    /// @brief 执行当前节拍的所有到期任务，然后推进节拍
+    void Tick();
+
+    /// @brief 当前（下一次 Tick() 将执行的）节拍号
+    uint64_t CurrentTick() const { return tick_; }
+
+    /// @brief 节拍周期（微秒）
+    int64_t TickPeriodUs() const { return tick_period_us_; }
+
+    /// @brief 将毫秒换算为节拍数
+    uint64_t MsToTicks(int64_t ms) const { return static_cast<uint64_t>(ms * 1000 / tick_period_us_); }
+
+    /// @brief 获取任务统计
+    /// @param index 任务索引
+    TaskStats GetTaskStats(int index) const;
+
+    /// @brief 任务数量
+    int TaskCount() const { return static_cast<int>(tasks_.size()); }
+
+    /// @brief 节拍总耗时超出节拍周期的次数
+    uint64_t TickOverruns() const { return tick_overruns_; }
+
+    /// @brief 打印所有任务的统计
+    void PrintStats() const;
+
+private:
+    struct TaskEntry {
+        const char* name;
+        int period_ticks;
+        int phase;
+        uint64_t start_tick;
+        uint64_t end_tick;
+        uint64_t budget_ns;
+        Task task;
+        uint64_t runs;
+        uint64_t overruns;
+        uint64_t max_ns;
+        uint64_t total_ns;
+    };
+
+    /// @brief 为新任务选择负载最轻的相位
+    int ChooseAutoPhase(int period_ticks) const;
+
+    int64_t tick_period_us_;
+    uint64_t tick_;
+    std::vector<TaskEntry> tasks_;
+
+    uint64_t tick_overruns_;
+    uint64_t max_tick_ns_;
+};
+
+#endif  // TASK_EXECUTOR_H_
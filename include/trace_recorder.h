@@ -0,0 +1,111 @@
+/// @file trace_recorder.h
+/// @brief 多线程时间线记录，导出为 Chrome trace-event JSON（chrome://tracing、Perfetto 可直接打开）
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef TRACE_RECORDER_H_
+#define TRACE_RECORDER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief 时间线记录器
+///
+/// 每个线程首次记录时注册一块预分配的环形缓冲区（单写者、无锁），之后记录事件只是
+/// 几次原子存储，不加锁、不分配内存。缓冲区写满后覆盖最旧的事件，因此导出的总是
+/// 每个线程最近的一段时间线。默认关闭，关闭时每个记录点只多一次原子读。
+///
+/// 导出在退出时由调用者触发，或在运行中收到 SIGUSR1 时由后台线程完成
+/// （第N次信号写入 "<path>.N"，不影响控制线程）。
+class TraceRecorder {
+public:
+    /// @brief 事件类型，取值即 trace-event 的 "ph" 字段
+    enum EventType : uint8_t {
+        kBegin = 'B',
+        kEnd = 'E',
+        kInstant = 'i',
+    };
+
+    /// @brief 每个线程保留的事件数（须为2的幂），控制线程约可覆盖最近十余秒
+    static constexpr size_t kEventsPerThread = 1 << 16;
+
+    /// @brief 全局实例
+    static TraceRecorder& Instance();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    /// @brief 开始记录，并安装 SIGUSR1 导出处理
+    /// @param path 导出文件路径
+    /// @return 是否成功
+    bool Enable(const std::string& path);
+
+    /// @brief 停止记录与信号导出线程（已记录的事件保留，仍可导出）
+    void Disable();
+
+    /// @brief 是否正在记录
+    bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    /// @brief 设置当前线程在时间线上的名称
+    /// @param name 静态字符串
+    void SetThreadName(const char* name);
+
+    /// @brief 记录一个事件（未启用时忽略）
+    /// @param type 事件类型
+    /// @param name 静态字符串
+    void Record(EventType type, const char* name);
+
+    void Begin(const char* name) { Record(kBegin, name); }
+    void End(const char* name) { Record(kEnd, name); }
+    void Instant(const char* name) { Record(kInstant, name); }
+
+    /// @brief 将所有线程的缓冲区导出为 JSON 文件（可与记录并发进行）
+    /// @param path 文件路径
+    /// @return 是否成功
+    bool Dump(const std::string& path);
+
+    /// @brief Enable() 时指定的导出路径
+    const std::string& Path() const { return path_; }
+
+private:
+    struct Event {
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> ts_ns;
+        std::atomic<uint8_t> type;
+    };
+
+    struct ThreadBuffer {
+        int tid;
+        std::atomic<const char*> name;
+        std::unique_ptr<Event[]> events;
+        std::atomic<uint64_t> write_index;  // 已写完的事件数
+        std::atomic<uint64_t> claim_index;  // 已开始写的事件数
+    };
+
+    TraceRecorder();
+    ~TraceRecorder();
+
+    ThreadBuffer* CurrentBuffer();
+    void SignalLoop();
+    static void OnSignal(int signo);
+
+    static thread_local ThreadBuffer* current_buffer_;
+
+    std::atomic<bool> enabled_;
+    std::string path_;
+
+    std::mutex buffers_mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+    std::thread signal_thread_;
+    std::atomic<bool> signal_thread_stop_;
+    int dump_count_;  // 仅由信号导出线程访问
+};
+
+#endif  // TRACE_RECORDER_H_
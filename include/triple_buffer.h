@@ -0,0 +1,61 @@
+/// @file triple_buffer.h
+/// @brief 单生产者/单消费者无锁三缓冲，用于在线程间传递“最新值”
+/// @version 0.1
+/// @date 2026-10-16
+
+#ifndef TRIPLE_BUFFER_H_
+#define TRIPLE_BUFFER_H_
+
+#include <atomic>
+#include <cstdint>
+
+/// @brief 无锁三缓冲
+///
+/// 生产者始终写入自己独占的后台缓冲区，Publish() 将其与中间缓冲区原子交换；
+/// 消费者调用 Update() 时若有新数据，则将前台缓冲区与中间缓冲区交换。
+/// 双方都不会阻塞，未被读取的旧数据会被新数据直接覆盖。
+/// @tparam T 缓冲的数据类型，应为定长、可拷贝的结构体
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle_(1), back_(0), front_(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /// @brief 获取生产者的可写缓冲区（仅生产者线程调用）
+    T& WriteBuffer() { return buffers_[back_]; }
+
+    /// @brief 发布生产者缓冲区中的数据（仅生产者线程调用）
+    /// @return 上一次发布的数据是否在被读取前就被覆盖
+    bool Publish() {
+        uint8_t previous = middle_.exchange(back_ | kDirtyBit, std::memory_order_acq_rel);
+        back_ = previous & kIndexMask;
+        return (previous & kDirtyBit) != 0;
+    }
+
+    /// @brief 取得最新发布的数据（仅消费者线程调用）
+    /// @return 是否取到了新数据
+    bool Update() {
+        if ((middle_.load(std::memory_order_relaxed) & kDirtyBit) == 0) {
+            return false;
+        }
+        uint8_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = previous & kIndexMask;
+        return true;
+    }
+
+    /// @brief 获取消费者当前持有的数据（仅消费者线程调用）
+    const T& ReadBuffer() const { return buffers_[front_]; }
+
+private:
+    static constexpr uint8_t kDirtyBit = 0x4;
+    static constexpr uint8_t kIndexMask = 0x3;
+
+    T buffers_[3];
+    std::atomic<uint8_t> middle_;  // 中间缓冲区索引 | 新数据标志
+    uint8_t back_;                 // 生产者独占
+    uint8_t front_;                // 消费者独占
+};
+
+#endif  // TRIPLE_BUFFER_H_
@@ -13,12 +13,30 @@
 #include "receiver.h"
 #include "motion_spline.h"
 #include "utils.h"
+#include "alloc_tracker.h"
+#include "async_logger.h"
+#include "control_clock.h"
+#include "control_options.h"
+#include "rt_profile.h"
 #include "grpc_client.h"
+#include "local_policy_backend.h"
+#include "shm_transport.h"
+#include "stale_action_policy.h"
 #include "data_logger.h"
+#include "event_reactor.h"
+#include "inference_worker.h"
+#include "shadow_comparator.h"
+#include "phase_profiler.h"
+#include "task_executor.h"
+#include "trace_recorder.h"
 #include "kyeboard_handler.h"
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <iostream>
 #include <time.h>
+#include <signal.h>
+#include <errno.h>
 #include <string.h>
 #include <fstream>
 #include <cmath>
@@ -28,6 +46,12 @@
 using namespace std;
 
   bool is_message_updated_ = false; ///< Flag to check if message has been updated
+  int state_notifier_fd = -1; ///< Reactor eventfd signalled when a robot state packet arrives
+  std::atomic<uint64_t> state_arrival_ns(0); ///< CLOCK_MONOTONIC arrival time of the newest state packet
+  ThreadSchedInfo receive_thread_info; ///< Scheduling actually seen by the SDK receive thread
+  std::atomic<bool> receive_thread_info_claimed(false); ///< Set by the one callback that records receive_thread_info
+  std::atomic<bool> receive_thread_info_ready(false);   ///< Set once receive_thread_info is filled in
+  std::atomic<bool> reload_requested(false); ///< Set by SIGHUP; the input task asks the workers to reload their models
   bool zero_actions = true; ///< Flag to enable zero actions debugging mode
   int key_space_cooldown_timer = 0;
 
@@ -39,16 +63,44 @@ using namespace std;
   ModelType model_type = FLAT_TERRAIN;
 
   /**
-   * @brief Callback function to set message update flag
+   * @brief Callback function to signal a robot state update
+   * 
+   * Runs on the receive thread, so it only wakes the control reactor; the
+   * update flag itself is set on the control thread.
    * 
    * @param code The code indicating the type of message received
    */
   void OnMessageUpdate(uint32_t code){
+    // The SDK may call back on more than one receive thread; only the first caller writes the info
+    bool expected = false;
+    if(!receive_thread_info_claimed.load(std::memory_order_relaxed) &&
+       receive_thread_info_claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel)){
+      receive_thread_info = RtProfile::GetCurrentThreadSchedInfo();
+      receive_thread_info_ready.store(true, std::memory_order_release);
+    }
     if(code == 0x0906){
-      is_message_updated_ = true;
+      state_arrival_ns.store(PhaseProfiler::NowNs(), std::memory_order_release);
+      if(TraceRecorder::Instance().IsEnabled()){
+        TraceRecorder::Instance().SetThreadName("receive");
+        TraceRecorder::Instance().Instant("state_packet");
+      }
+      if(state_notifier_fd >= 0){
+        EventReactor::Notify(state_notifier_fd);
+      }
     }
   }
 
+  /**
+   * @brief SIGHUP handler: request a reload of the local policy models
+   * 
+   * Only stores a flag (async-signal-safe); the model files are read on the
+   * inference threads.
+   */
+  void OnReloadSignal(int){
+    reload_requested.store(true, std::memory_order_relaxed);
+  }
+
+  const int kInputPeriodMs = 20; ///< Keyboard input is sampled at 50 Hz
   int zero_action_cool_down = 0;
   /**
    * @brief Update robot move command based on keyboard input
@@ -91,7 +143,7 @@ using namespace std;
     zero_action_cool_down++;
     bool zero_command = robot_move_command.forward_speed == 0 && robot_move_command.left_speed == 0 && robot_move_command.turn_speed == 0;
     if (zero_command) {
-      if (zero_action_cool_down > 200) {
+      if (zero_action_cool_down > 1000 / kInputPeriodMs) {
         zero_actions = true;
       }
       else {
@@ -105,11 +157,11 @@ using namespace std;
 
 
     if (keyboard_handler->IsKeyPressed("1")) {
-      std::cout << "Switch to flat terrain" << std::endl;
+      ASYNC_LOG_DEDUP(kLogInfo, "Switch to flat terrain");
       model_type = FLAT_TERRAIN;
     }
     if (keyboard_handler->IsKeyPressed("2")) {
-      std::cout << "Switch to rough terrain" << std::endl;
+      ASYNC_LOG_DEDUP(kLogInfo, "Switch to rough terrain");
       model_type = ROUGH_TERRAIN;
     }
     
@@ -117,13 +169,13 @@ using namespace std;
     if (left_shift_pressed) {
       static bool shift_status_printed = false;
       if (!shift_status_printed) {
-        std::cout << "Speed boost activated (2x speed)" << std::endl;
+        ASYNC_LOG(kLogInfo, "Speed boost activated (2x speed)");
         shift_status_printed = true;
       }
     } else {
       static bool shift_status_printed = false;
       if (shift_status_printed) {
-        std::cout << "Speed boost deactivated (normal speed)" << std::endl;
+        ASYNC_LOG(kLogInfo, "Speed boost deactivated (normal speed)");
         shift_status_printed = false;
       }
     }
@@ -132,36 +184,202 @@ using namespace std;
 
 int main(int argc, char* argv[]){
 
-  DRTimer set_timer;
+  ControlOptions options;
+  if (!ParseControlOptions(argc, argv, &options)) {
+    PrintControlUsage(argv[0]);
+    return -1;
+  }
+
+  // Lock memory before any other thread is created so their stacks are locked too
+  RtProfile rt_profile(options.rt);
+  rt_profile.LockMemory();
+
+  // Console output from the control loop is formatted and written on a background thread
+  AsyncLogger::Instance().Start();
+
+  // Heap allocations on the control thread are counted (or fatal) once the policy has warmed up
+  AllocTracker::SetMode(options.alloc_check);
+
+  // Opt-in timeline of the control, receive and inference threads
+  if (!options.trace_path.empty()) {
+    if (!TraceRecorder::Instance().Enable(options.trace_path)) {
+      std::cerr << "Failed to enable tracing. Exiting..." << std::endl;
+      return -1;
+    }
+    TraceRecorder::Instance().SetThreadName("control");
+    std::cout << "Tracing to " << options.trace_path << " (send SIGUSR1 for a snapshot)" << std::endl;
+  }
+
+  // Control time base: wall clock, or a simulated clock that the reactor steps as fast as possible
+  std::unique_ptr<ControlClock> set_timer;
+  if (options.sim_clock) {
+    set_timer = std::make_unique<SimulatedClock>();
+  } else {
+    set_timer = std::make_unique<RealTimeClock>();
+  }
   double now_time,start_time;
   RobotCmd robot_joint_cmd;
   RobotCmd robot_joint_cmd_nn;
   memset(&robot_joint_cmd, 0, sizeof(robot_joint_cmd));
   memset(&robot_joint_cmd_nn, 0, sizeof(robot_joint_cmd_nn));
 
-  Sender* send_cmd          = new Sender("192.168.2.1",43893);              ///< Create send thread
+  // A simulated clock steps far faster than real time, so it never talks to the robot: no sender is created
+  // and no command leaves the process, even if a robot answers on the network
+  Sender* send_cmd          = options.sim_clock ? nullptr : new Sender("192.168.2.1",43893);  ///< Create send thread
   // Sender* send_cmd          = new Sender("192.168.1.120",43893);              ///< Create send thread
-  Receiver* robot_data_recv = new Receiver();                                 ///< Create a receive resolution
-  robot_data_recv->RegisterCallBack(OnMessageUpdate);
   MotionSpline motion_spline;                                            ///< Demos for testing can be deleted by yourself
-  RobotData *robot_data = &robot_data_recv->GetState();
 
-  // Initialize gRPC client
-  std::string server_address = "localhost:50151";  // 默认服务器地址，可以通过命令行参数修改
-  if (argc > 1) {
-    server_address = argv[1];
-  }
+  // The policy runs at 50 Hz; inference deadlines and the stale action policy are derived from its period
+  const int kPolicyPeriodUs = 20 * 1000;
+
+  // Initialize inference client: shared memory for "shm:NAME", in-process MLP for "local:DIR", gRPC otherwise
+  std::string server_address = options.server_address;  // 默认服务器地址，可以通过命令行参数修改
   
-  std::unique_ptr<GrpcClient> client = std::make_unique<GrpcClient>(server_address);
+  std::unique_ptr<InferenceBackend> client;
+  if (ShmClient::IsShmAddress(server_address)) {
+    client = std::make_unique<ShmClient>(server_address);
+  } else if (LocalPolicyBackend::IsLocalAddress(server_address)) {
+    client = std::make_unique<LocalPolicyBackend>(server_address);
+  } else {
+    std::unique_ptr<GrpcClient> grpc_client = std::make_unique<GrpcClient>(server_address);
+    if (options.grpc_session) {
+      // Each step then carries only the session id, a sequence number and the raw observation floats
+      grpc_client->SetSessionMode(true);
+      std::cout << "Session gRPC: observation layout negotiated once with OpenSession" << std::endl;
+    }
+    // The hidden state in each response goes back with the next request only for a recurrent policy
+    grpc_client->SetRecurrent(options.recurrent);
+    client = std::move(grpc_client);
+  }
   
-  // Connect to gRPC server
+  // Connect to inference server
   if (!client->Connect()) {
-    std::cerr << "Failed to connect to gRPC server. Exiting..." << std::endl;
+    std::cerr << "Failed to connect to inference server. Exiting..." << std::endl;
     return -1;
   }
+
+  // An action that arrives after the next observation is useless, so a slow request fails instead of waiting
+  std::chrono::microseconds request_deadline(static_cast<int64_t>(options.inference_deadline * kPolicyPeriodUs));
+  client->SetRequestDeadline(request_deadline);
+  std::cout << "Inference deadline: " << request_deadline.count() << " us per request" << std::endl;
+
+  if (GrpcClient* grpc_client = dynamic_cast<GrpcClient*>(client.get())) {
+    // Reconnect in the background after a server restart; inference fails fast while disconnected
+    if (options.grpc_health_period_ms > 0) {
+      grpc_client->StartHealthCheck(options.grpc_health_period_ms);
+    }
+    if (!options.grpc_hedge_address.empty()) {
+      std::chrono::microseconds hedge_delay(static_cast<int64_t>(options.grpc_hedge_after * kPolicyPeriodUs));
+      grpc_client->SetHedging(options.grpc_hedge_address, hedge_delay);
+      std::cout << "Hedged gRPC: requests unanswered after " << hedge_delay.count() << " us also go to "
+                << options.grpc_hedge_address << std::endl;
+    }
+  }
+  
+  // Per-phase latency histograms; recording is lock-free and allocation-free
+  PhaseProfiler profiler;
+
+  // Run inference on its own thread so a slow RPC never stalls the control loop
+  InferenceWorker inference_worker(client.get());
+  inference_worker.SetProfiler(&profiler);
+  // Action age is measured on the control clock, so simulated runs reach the stale action paths too
+  inference_worker.SetClock(set_timer.get());
+  if (options.grpc_async > 0) {
+    // The worker pipelines requests without waiting for each response; a response older than five policy periods
+    // is useless. This also starts the completion queue thread, so it must stay before the real-time profile
+    const int kAsyncDeadlineMs = 5 * kPolicyPeriodUs / 1000;
+    inference_worker.SetAsync(options.grpc_async, kAsyncDeadlineMs);
+    std::cout << "Async gRPC: up to " << options.grpc_async << " request(s) in flight" << std::endl;
+  }
+  if (options.eval_both_terrains) {
+    // Both terrain policies run on every observation, so switching with keys 1/2 takes effect on the next action
+    if (!inference_worker.SetBatchModels({"flat_terrain", "rough_terrain"})) {
+      return -1;
+    }
+    std::cout << "Batch gRPC: flat and rough terrain models evaluated in one BatchPredict call" << std::endl;
+  }
+  if (options.grpc_stream) {
+    inference_worker.SetStreaming(true);
+    std::cout << "Streaming gRPC: observations share one StreamPredict stream" << std::endl;
+  }
+  if (options.trace_inference) {
+    // The server stamps each response; phase summaries and the data log then split the round trip
+    inference_worker.SetTracing(true);
+    std::cout << "Inference tracing: network, server queue and model compute recorded per step" << std::endl;
+  }
+  if (!inference_worker.Start()) {
+    std::cerr << "Failed to start inference worker. Exiting..." << std::endl;
+    return -1;
+  }
+
+  // Shadow policy: a candidate model sees every observation on its own worker thread and connection,
+  // and its actions are only logged. Submitting never blocks; when the candidate falls behind, its
+  // worker skips to the newest observation and the older ones are dropped
+  std::unique_ptr<InferenceBackend> shadow_client;
+  std::unique_ptr<InferenceWorker> shadow_worker;
+  if (!options.shadow_address.empty()) {
+    if (ShmClient::IsShmAddress(options.shadow_address)) {
+      shadow_client = std::make_unique<ShmClient>(options.shadow_address);
+    } else if (LocalPolicyBackend::IsLocalAddress(options.shadow_address)) {
+      shadow_client = std::make_unique<LocalPolicyBackend>(options.shadow_address);
+    } else {
+      std::unique_ptr<GrpcClient> shadow_grpc = std::make_unique<GrpcClient>(options.shadow_address);
+      shadow_grpc->SetRecurrent(options.recurrent);
+      shadow_client = std::move(shadow_grpc);
+    }
+    if (shadow_client->Connect()) {
+      shadow_client->SetRequestDeadline(request_deadline);
+      GrpcClient* shadow_grpc = dynamic_cast<GrpcClient*>(shadow_client.get());
+      if (shadow_grpc != nullptr && options.grpc_health_period_ms > 0) {
+        shadow_grpc->StartHealthCheck(options.grpc_health_period_ms);
+      }
+      shadow_worker = std::make_unique<InferenceWorker>(shadow_client.get());
+      shadow_worker->SetName("shadow");
+      shadow_worker->SetClock(set_timer.get());
+      if (!shadow_worker->Start()) {
+        shadow_worker.reset();
+      }
+    }
+    if (shadow_worker) {
+      std::cout << "Shadow policy: " << options.shadow_address << " ("
+                << (options.shadow_model.empty() ? "same model type as the live policy" : options.shadow_model)
+                << "), logged only" << std::endl;
+    } else {
+      // The candidate is optional; the live policy runs without it
+      std::cerr << "Failed to start the shadow policy at " << options.shadow_address << ", continuing without it"
+                << std::endl;
+      shadow_client.reset();
+    }
+  }
+  ShadowComparator shadow_comparator;
+  ActionSample shadow_sample;
+
+  // Retrained local policies are picked up without a restart: SIGHUP reloads the model in use from its directory
+  if (LocalPolicyBackend::IsLocalAddress(server_address) ||
+      (shadow_worker && LocalPolicyBackend::IsLocalAddress(options.shadow_address))) {
+    struct sigaction reload_action;
+    memset(&reload_action, 0, sizeof(reload_action));
+    reload_action.sa_handler = OnReloadSignal;
+    reload_action.sa_flags = SA_RESTART;
+    sigemptyset(&reload_action.sa_mask);
+    if (sigaction(SIGHUP, &reload_action, nullptr) == 0) {
+      std::cout << "Local policy: send SIGHUP to reload the model in use" << std::endl;
+    } else {
+      std::cerr << "Failed to install SIGHUP handler: " << strerror(errno) << std::endl;
+    }
+  }
   
   // Initialize data logger
   std::unique_ptr<DataLogger> data_logger = std::make_unique<DataLogger>("robot_data");
+  if (options.trace_inference) {
+    data_logger->EnableInferenceTiming();
+  }
+  if (options.recurrent) {
+    data_logger->EnableRecurrentState();
+  }
+  if (shadow_worker) {
+    data_logger->EnableShadowAction();
+  }
   if (!data_logger->Initialize()) {
     std::cerr << "Failed to initialize data logger. Exiting..." << std::endl;
     return -1;
@@ -172,11 +390,64 @@ int main(int argc, char* argv[]){
   
   
 
+  // All control-thread work is dispatched from one epoll reactor
+  EventReactor reactor(set_timer.get());
+  if (!reactor.Initialize()) {
+    std::cerr << "Failed to initialize event reactor. Exiting..." << std::endl;
+    return -1;
+  }
+
+  // Robot state packets (0x0906) are forwarded from the receive thread. In
+  // state-triggered mode every Nth packet also runs a control step.
+  std::function<void()> state_step;
+  uint64_t state_packets = 0;
+  uint64_t last_state_arrival_ns = 0;
+  state_notifier_fd = reactor.AddNotifier([&](uint64_t count) {
+    is_message_updated_ = true;
+
+    uint64_t arrival_ns = state_arrival_ns.load(std::memory_order_acquire);
+    if (last_state_arrival_ns != 0 && arrival_ns > last_state_arrival_ns) {
+      profiler.Record(kPhaseStateInterval, (arrival_ns - last_state_arrival_ns) / count);
+    }
+    last_state_arrival_ns = arrival_ns;
+
+    // Packets that piled up while the loop was busy collapse into one step
+    state_packets += count;
+    if (state_step && state_packets >= static_cast<uint64_t>(options.state_decimation)) {
+      state_packets = 0;
+      state_step();
+    }
+
+    static bool receive_thread_reported = false;
+    if (!receive_thread_reported && receive_thread_info_ready.load(std::memory_order_acquire)) {
+      std::cout << RtProfile::FormatSchedInfo("receive", receive_thread_info) << std::endl;
+      receive_thread_reported = true;
+    }
+  });
+  if (state_notifier_fd < 0) {
+    std::cerr << "Failed to register robot state notifier. Exiting..." << std::endl;
+    return -1;
+  }
+
+  // Start the reporter while this thread still has the default scheduling, so
+  // printing summaries never competes with the control loop at FIFO priority
+  profiler.StartReporter(options.profile_period_s);
+
+  // The SDK creates its receive threads internally; they inherit the receive
+  // profile from this thread, which then switches to the control profile
+  rt_profile.EnterReceiveProfile();
+  Receiver* robot_data_recv = new Receiver();                                 ///< Create a receive resolution
+  robot_data_recv->RegisterCallBack(OnMessageUpdate);
+  RobotData *robot_data = &robot_data_recv->GetState();
   robot_data_recv->StartWork();
-  set_timer.TimeInit(5);                                                      ///< Timer initialization, input: cycle; Unit: ms
-  send_cmd->RobotStateInit();                                                 ///< Return all joints to zero and gain control
+  rt_profile.EnterControlProfile();
+  rt_profile.PrintReport();
 
-  start_time = set_timer.GetCurrentTime();                                    ///< Obtain time for algorithm usage
+  if (send_cmd != nullptr) {
+    send_cmd->RobotStateInit();                                               ///< Return all joints to zero and gain control
+  }
+
+  start_time = set_timer->GetCurrentTime();                                    ///< Obtain time for algorithm usage
   motion_spline.GetInitData(robot_data->joint_data,0.000);                ///< Obtain all joint states once before each stage (action)
   
   double fl_leg_positions[3];  
@@ -187,175 +458,358 @@ int main(int argc, char* argv[]){
 
   int time_step = 5;
 
-  int time_tick = 0;
-  bool is_running = true;
- 
-  while(is_running){
+  RobotMoveCommand robot_move_command = {0.0f, 0.0f, 0.0f};
+
+  // Keyboard input: SDL has no pollable fd, so it is sampled on its own 50 Hz timer
+  auto input_step = [&](uint64_t) {
     // Process keyboard input
     keyboard_handler.update();
     if (keyboard_handler.IsKeyPressed("escape")) {
-      is_running = false;
+      reactor.Stop();
     }
     
     // Update robot move command based on continuous key presses
-    RobotMoveCommand robot_move_command = {0.0f, 0.0f, 0.0f};
     UpdateRobotMoveCommand(&keyboard_handler, robot_move_command);
+
+    // Only flags are set here; each worker reloads on its own thread before its next inference
+    if (reload_requested.exchange(false, std::memory_order_relaxed)) {
+      inference_worker.RequestReload();
+      if (shadow_worker) {
+        shadow_worker->RequestReload();
+      }
+    }
     
     // Print current move command status (optional, for debugging)
     if (robot_move_command.forward_speed != 0 || robot_move_command.left_speed != 0 || 
         robot_move_command.turn_speed != 0) {
-      std::cout << "Move Command - F:" << robot_move_command.forward_speed 
-                << " L:" << robot_move_command.left_speed 
-                << " T:" << robot_move_command.turn_speed << std::endl;
+      ASYNC_LOG_DEDUP(kLogInfo, "Move Command - F:{} L:{} T:{}", robot_move_command.forward_speed,
+                      robot_move_command.left_speed, robot_move_command.turn_speed);
     }
-    
-    if (set_timer.TimerInterrupt() == true){                                  ///< Time interrupt flag
-      continue;
-    }
-    now_time = set_timer.GetIntervalTime(start_time);                         ///< Get the current time
-    time_tick++;
-    // stand up first
-    if(time_tick < 5000 / time_step){
-      // 
-      cout << "try to pre stand" << endl;
-      fl_leg_positions[0] = 0 * kDegree2Radian;  
-      fl_leg_positions[1] = -70 * kDegree2Radian;
-      fl_leg_positions[2] = 150 * kDegree2Radian;
-      fr_leg_positions[0] = 0 * kDegree2Radian;  
-      fr_leg_positions[1] = -70 * kDegree2Radian;
-      fr_leg_positions[2] = 150 * kDegree2Radian;
-      hl_leg_positions[0] = 0 * kDegree2Radian;  
-      hl_leg_positions[1] = -70 * kDegree2Radian;
-      hl_leg_positions[2] = 150 * kDegree2Radian;
-      hr_leg_positions[0] = 0 * kDegree2Radian;  
-      hr_leg_positions[1] = -70 * kDegree2Radian;
-      hr_leg_positions[2] = 150 * kDegree2Radian;
-      robot_joint_cmd = CreateRobotCmdFromNumber(fl_leg_positions, fr_leg_positions, hl_leg_positions, hr_leg_positions, 45, 0.7);
-
-      motion_spline.Motion(robot_joint_cmd,now_time,*robot_data, 45, 0.7, 1.0);    
+  };
+ 
+  // Multi-rate tasks of the control loop. Tasks due on the same tick run in registration order.
+  TaskExecutor executor(time_step * 1000);
+  const uint64_t kStandTick = executor.MsToTicks(5000);
+  const uint64_t kPolicyTick = executor.MsToTicks(10000);
+  vector<float> last_action(12, 0.0f);
+  vector<float> decayed_action(12, 0.0f);
+
+  // What the control loop does with an action that missed its deadline
+  options.stale_action.policy_period = std::chrono::microseconds(kPolicyPeriodUs);
+  StaleActionPolicy stale_action_policy(options.stale_action);
+  bool stale_action_started = false;
+
+  // Buffers reused by every policy step so the steady state does not allocate
+  Observation observation;
+  Observation processed_observation;
+  ActionSample action_sample;
+  RobotAction action;
+  observation.data.reserve(kObservationSize);
+  processed_observation.data.reserve(kObservationSize);
+  action.data.reserve(kActionSize);
+
+  // stand up first
+  executor.AddTask("pre_stand", 1, [&](uint64_t) {
+    ASYNC_LOG_DEDUP(kLogInfo, "try to pre stand");
+    fl_leg_positions[0] = 0 * kDegree2Radian;  
+    fl_leg_positions[1] = -70 * kDegree2Radian;
+    fl_leg_positions[2] = 150 * kDegree2Radian;
+    fr_leg_positions[0] = 0 * kDegree2Radian;  
+    fr_leg_positions[1] = -70 * kDegree2Radian;
+    fr_leg_positions[2] = 150 * kDegree2Radian;
+    hl_leg_positions[0] = 0 * kDegree2Radian;  
+    hl_leg_positions[1] = -70 * kDegree2Radian;
+    hl_leg_positions[2] = 150 * kDegree2Radian;
+    hr_leg_positions[0] = 0 * kDegree2Radian;  
+    hr_leg_positions[1] = -70 * kDegree2Radian;
+    hr_leg_positions[2] = 150 * kDegree2Radian;
+    robot_joint_cmd = CreateRobotCmdFromNumber(fl_leg_positions, fr_leg_positions, hl_leg_positions, hr_leg_positions, 45, 0.7);
+
+    motion_spline.Motion(robot_joint_cmd,now_time,*robot_data, 45, 0.7, 1.0);    
+  }, 0, 0, kStandTick);
+
+  executor.AddTask("stand_init", 1, [&](uint64_t) {
+    motion_spline.GetInitData(robot_data->joint_data,now_time);         ///< Obtain all joint states once before each stage (action)
+    // a recurrent policy starts from its initial hidden state after standing up; switching terrain
+    // models (keys 1/2) resets it too, since the worker sees the model type change
+    inference_worker.ResetRecurrentState();
+    if (shadow_worker) {
+      shadow_worker->ResetRecurrentState();
+    }
+  }, 0, kStandTick, kStandTick + 1);
+
+  executor.AddTask("stand", 1, [&](uint64_t) {
+    ASYNC_LOG_DEDUP(kLogInfo, "try to stand");
+    fl_leg_positions[0] = 0 * kDegree2Radian;  
+    fl_leg_positions[1] = -57 * kDegree2Radian;
+    fl_leg_positions[2] = 103 * kDegree2Radian;
+    fr_leg_positions[0] = 0 * kDegree2Radian;  
+    fr_leg_positions[1] = -57 * kDegree2Radian;
+    fr_leg_positions[2] = 103 * kDegree2Radian;
+    hl_leg_positions[0] = 0 * kDegree2Radian;  
+    hl_leg_positions[1] = -57 * kDegree2Radian;
+    hl_leg_positions[2] = 103 * kDegree2Radian;
+    hr_leg_positions[0] = 0 * kDegree2Radian;  
+    hr_leg_positions[1] = -57 * kDegree2Radian;
+    hr_leg_positions[2] = 103 * kDegree2Radian;
+    robot_joint_cmd = CreateRobotCmdFromNumber(fl_leg_positions, fr_leg_positions, hl_leg_positions, hr_leg_positions, 45, 0.7);
+
+    motion_spline.Motion(robot_joint_cmd,now_time,*robot_data, 45, 0.7, 1.5); 
+  }, 0, kStandTick, kPolicyTick);
+
+  // compute action from neural network every 0.02s (50Hz)
+  executor.AddTask("policy", 20 / time_step, [&](uint64_t tick) {
+
+    // Convert RobotData to Observation
+    {
+      ScopedPhase phase(&profiler, kPhaseObservation);
+      ConvertRobotDataToObservation(*robot_data, last_action, robot_move_command, &observation);
+    }
+
+    // Apply scaling and noise to match training conditions
+    {
+      ScopedPhase phase(&profiler, kPhaseScaling);
+      ApplyObservationScalingAndNoise(observation, &processed_observation);
+    }
+
+    // Save observation data to file
+    {
+      ScopedPhase phase(&profiler, kPhaseLogObservation);
+      data_logger->SaveObservation(tick, processed_observation);
+    }
+
+    // Hand the observation to the inference worker; the action arrives asynchronously
+    if (model_type == FLAT_TERRAIN) {
+      inference_worker.SubmitObservation(processed_observation.data, "flat_terrain"); // stand_still, flat_terrain
+    } else if (model_type == ROUGH_TERRAIN) {
+      inference_worker.SubmitObservation(processed_observation.data, "rough_terrain"); // stand_still, flat_terrain
+    } else {
+      ASYNC_LOG(kLogError, "Invalid model type");
+      reactor.Stop();
+    }
+    // The first action is due one policy period after the first observation, whatever phase joint_cmd runs on
+    if (!stale_action_started) {
+      stale_action_policy.Start(set_timer->Now());
+      stale_action_started = true;
+    }
+
+    // The candidate gets the same observation after the live policy; its observation numbers match the live ones
+    if (shadow_worker) {
+      const char* live_model = model_type == ROUGH_TERRAIN ? "rough_terrain" : "flat_terrain";
+      shadow_worker->SubmitObservation(processed_observation.data,
+                                       options.shadow_model.empty() ? live_model : options.shadow_model.c_str());
+    }
+  }, TaskExecutor::kAutoPhase, kPolicyTick);
+
+  // turn a raw action (original model output) into the leg position targets
+  auto set_leg_positions = [&](const vector<float>& raw_action) {
+    // Convert the raw action to RobotAction (with action scaling applied for robot control)
+    ConvertRawActionToAction(raw_action, &action);
+
+    // Set Zero actions for debugging (only when debug mode is enabled)
+    if (zero_actions) {
+      for (int i = 0; i < 12; ++i) {
+        action.data[i] = 0.0f;
+      }
+      ASYNC_LOG_DEDUP(kLogInfo, "Applied zero actions (debug mode active)");
+    }
+
+    // Convert the action back to RobotCmd
+    robot_joint_cmd_nn = CreateRobotCmd(action);
+
+    fl_leg_positions[0] = robot_joint_cmd_nn.fl_leg[0].position;
+    fl_leg_positions[1] = robot_joint_cmd_nn.fl_leg[1].position;
+    fl_leg_positions[2] = robot_joint_cmd_nn.fl_leg[2].position;  
+    fr_leg_positions[0] = robot_joint_cmd_nn.fr_leg[0].position;  
+    fr_leg_positions[1] = robot_joint_cmd_nn.fr_leg[1].position;
+    fr_leg_positions[2] = robot_joint_cmd_nn.fr_leg[2].position;
+    hl_leg_positions[0] = robot_joint_cmd_nn.hl_leg[0].position;
+    hl_leg_positions[1] = robot_joint_cmd_nn.hl_leg[1].position;
+    hl_leg_positions[2] = robot_joint_cmd_nn.hl_leg[2].position;
+    hr_leg_positions[0] = robot_joint_cmd_nn.hr_leg[0].position;
+    hr_leg_positions[1] = robot_joint_cmd_nn.hr_leg[1].position;
+    hr_leg_positions[2] = robot_joint_cmd_nn.hr_leg[2].position;
+  };
+
+  // pick up the newest action published by the inference worker
+  auto apply_latest_action = [&](uint64_t tick) {
+    if (!inference_worker.FetchLatestAction(&action_sample)) {
+      return false;
+    }
+      
+    // Extract action data from the sample (original model output, not scaled); with
+    // --eval-both-terrains the sample carries the output of the currently selected model too
+    const float* model_action = action_sample.ModelAction(model_type == ROUGH_TERRAIN ? "rough_terrain" : "flat_terrain");
+    last_action.assign(model_action, model_action + kActionSize);
+    if (shadow_worker) {
+      shadow_comparator.AddLive(action_sample.seq, model_action);
+    }
+
+    // Save raw action data to file
+    {
+      ScopedPhase phase(&profiler, kPhaseLogRawAction);
+      data_logger->SaveRawAction(tick, last_action);
+      if (action_sample.timing.valid) {
+        data_logger->SaveInferenceTiming(tick, action_sample.timing);
+      }
+      if (options.recurrent) {
+        data_logger->SaveRecurrentState(tick, action_sample.state_size, action_sample.state_norm);
+      }
+    }
+
+    set_leg_positions(last_action);
+
+    // Save processed action data to file
+    {
+      ScopedPhase phase(&profiler, kPhaseLogAction);
+      data_logger->SaveAction(tick, action);
+    }
+    return true;
+  };
+
+  auto send_command = [&]() {
+    if(is_message_updated_ && send_cmd != nullptr){ 
+      {
+        ScopedPhase phase(&profiler, kPhaseSendCmd);
+        send_cmd->SendCmd(robot_joint_cmd);  
+      }
+      profiler.Record(kPhaseStateToCmd, PhaseProfiler::NowNs() - state_arrival_ns.load(std::memory_order_acquire));
     } 
-    if(time_tick == 5000 / time_step){
-      motion_spline.GetInitData(robot_data->joint_data,now_time);         ///< Obtain all joint states once before each stage (action)
-    }
-    // if(time_tick >= 5000){
-    if(time_tick >= 5000 / time_step && time_tick < 10000 / time_step){
-      // 
-      cout << "try to stand" << endl;
-      fl_leg_positions[0] = 0 * kDegree2Radian;  
-      fl_leg_positions[1] = -57 * kDegree2Radian;
-      fl_leg_positions[2] = 103 * kDegree2Radian;
-      fr_leg_positions[0] = 0 * kDegree2Radian;  
-      fr_leg_positions[1] = -57 * kDegree2Radian;
-      fr_leg_positions[2] = 103 * kDegree2Radian;
-      hl_leg_positions[0] = 0 * kDegree2Radian;  
-      hl_leg_positions[1] = -57 * kDegree2Radian;
-      hl_leg_positions[2] = 103 * kDegree2Radian;
-      hr_leg_positions[0] = 0 * kDegree2Radian;  
-      hr_leg_positions[1] = -57 * kDegree2Radian;
-      hr_leg_positions[2] = 103 * kDegree2Radian;
-      robot_joint_cmd = CreateRobotCmdFromNumber(fl_leg_positions, fr_leg_positions, hl_leg_positions, hr_leg_positions, 45, 0.7);
-
-      motion_spline.Motion(robot_joint_cmd,now_time,*robot_data, 45, 0.7, 1.5); 
-    }
-    // compute action from neural network every 0.02s (50Hz)   4 * 0.005
-    if (time_tick % (20 / time_step) == 0 && time_tick >= 10000 / time_step) {
-
-      static vector<float> last_action;
-      if (last_action.empty()) {
-        last_action = vector<float>(12, 0.0f);
+  };
+
+  executor.AddTask("apply_action", 1, [&](uint64_t tick) {
+    apply_latest_action(tick);
+  }, 0, kPolicyTick);
+
+  executor.AddTask("joint_cmd", 1, [&](uint64_t) {
+    inference_worker.RecordControlTick();
+
+    // An action past its deadline is held, decayed toward the neutral pose, or replaced by damping
+    ActionFallback fallback = stale_action_policy.Update(action_sample.seq, action_sample.obs_stamp,
+                                                         set_timer->Now());
+    if (fallback == ActionFallback::kDamping) {
+      ASYNC_LOG_DEDUP(kLogError, "Inference missed {} policy periods in a row, switched to damping",
+                      options.stale_action.damp_after);
+      robot_joint_cmd = CreateRobotCmdFromNumber(fl_leg_positions, fr_leg_positions, hl_leg_positions, hr_leg_positions,
+                                                 0, options.stale_action.damping_kd);
+      return;
+    }
+    if (fallback == ActionFallback::kDecay && action_sample.seq != 0) {
+      for (size_t i = 0; i < last_action.size(); ++i) {
+        decayed_action[i] = last_action[i] * stale_action_policy.Scale();
       }
-      // Convert RobotData to Observation
-      Observation observation = ConvertRobotDataToObservation(*robot_data, last_action, robot_move_command);
-
-      // Apply scaling and noise to match training conditions
-      Observation processed_observation = ApplyObservationScalingAndNoise(observation);
-
-      // Save observation data to file
-      data_logger->SaveObservation(time_tick, processed_observation);
-
-      // Send the observation and receive the action
-      inference::InferenceResponse response;
-      if (model_type == FLAT_TERRAIN) {
-        response = client->Predict(processed_observation.data, "flat_terrain", true); // stand_still, flat_terrain
-      } else if (model_type == ROUGH_TERRAIN) {
-        response = client->Predict(processed_observation.data, "rough_terrain", true); // stand_still, flat_terrain
-      } else {
-        std::cout << "Invalid model type" << std::endl;
-        return -1;
+      set_leg_positions(decayed_action);
+    }
+    robot_joint_cmd = CreateRobotCmdFromNumber(fl_leg_positions, fr_leg_positions, hl_leg_positions, hr_leg_positions, 30, 0.7);
+  }, 0, kPolicyTick);
+
+  executor.AddTask("send_cmd", 1, [&](uint64_t) {
+    send_command();
+  }, 0);
+
+  // Pair shadow actions with the live ones after the command is out, so the comparison never delays SendCmd
+  if (shadow_worker) {
+    executor.AddTask("shadow_compare", 1, [&](uint64_t tick) {
+      if (shadow_worker->FetchLatestAction(&shadow_sample)) {
+        shadow_comparator.AddShadow(shadow_sample.seq, shadow_sample.data.data());
       }
-      
-      // Extract action data from response (original model output, not scaled)
-      last_action.clear();
-      for (int i = 0; i < response.action_size(); ++i) {
-          last_action.push_back(response.action(i));
+      uint64_t seq;
+      const float* live_action;
+      const float* shadow_action;
+      while (shadow_comparator.NextMatch(&seq, &live_action, &shadow_action)) {
+        data_logger->SaveShadowAction(tick, seq, live_action, shadow_action);
       }
+    }, 0, kPolicyTick);
+  }
 
-      // Save raw action data to file
-      data_logger->SaveRawAction(time_tick, last_action);
+  // Flush the CSV logs at 10 Hz instead of on every row
+  executor.AddTask("log_flush", 100 / time_step, [&](uint64_t) {
+    data_logger->Flush();
+  });
+
+  // Warmup is over two seconds into the policy: from here on the control thread must not allocate
+  const uint64_t kAllocCheckTick = kPolicyTick + executor.MsToTicks(2000);
+  executor.AddTask("alloc_check", 1, [&](uint64_t) {
+    AllocTracker::Arm();
+  }, 0, kAllocCheckTick, kAllocCheckTick + 1);
+
+  // Control step, driven by the 5 ms timer or by robot state packets
+  auto control_step = [&](uint64_t) {
+    ScopedPhase tick_phase(&profiler, kPhaseControlTick);
+    now_time = set_timer->GetIntervalTime(start_time);                        ///< Get the current time
+    executor.Tick();
+    if (options.sim_clock && options.sim_duration_s > 0 && now_time >= options.sim_duration_s) {
+      reactor.Stop();
+    }
+  };
 
-      // Convert the response to RobotAction (with action scaling applied for robot control)
-      RobotAction action = ConvertResponseToAction(response);
+  if (reactor.AddTimer(kInputPeriodMs * 1000, input_step) < 0) {
+    std::cerr << "Failed to register input timer. Exiting..." << std::endl;
+    return -1;
+  }
 
-      // Set Zero actions for debugging (only when debug mode is enabled)
-      if (zero_actions) {
-        for (int i = 0; i < 12; ++i) {
-          action.data[i] = 0.0f;
-        }
-        std::cout << "Applied zero actions (debug mode active)" << std::endl;
+  if (options.state_triggered) {
+    // Phase-lock the loop to the robot: the step runs right after a state packet
+    // arrives, and a finished inference is sent without waiting for the next packet
+    state_step = [&]() { control_step(1); };
+    int action_notifier_fd = reactor.AddNotifier([&](uint64_t) {
+      // Damping is latched; a late action must not re-engage the policy gains
+      if (!stale_action_policy.IsDamping() && apply_latest_action(executor.CurrentTick())) {
+        robot_joint_cmd = CreateRobotCmdFromNumber(fl_leg_positions, fr_leg_positions, hl_leg_positions, hr_leg_positions, 30, 0.7);
+        send_command();
       }
+    });
+    if (action_notifier_fd < 0) {
+      std::cerr << "Failed to register action notifier. Exiting..." << std::endl;
+      return -1;
+    }
+    inference_worker.SetCompletionNotifier(action_notifier_fd);
+    std::cout << "State-triggered control: one step every " << options.state_decimation << " state packet(s)" << std::endl;
+  } else if (reactor.AddTimer(time_step * 1000, control_step) < 0) {        ///< Timer initialization, input: cycle; Unit: us
+    std::cerr << "Failed to register control timer. Exiting..." << std::endl;
+    return -1;
+  }
 
-      // Convert the action back to RobotCmd
-      robot_joint_cmd_nn = CreateRobotCmd(action);
-
-      // Save processed action data to file
-      data_logger->SaveAction(time_tick, action);
-
-      fl_leg_positions[0] = robot_joint_cmd_nn.fl_leg[0].position;
-      fl_leg_positions[1] = robot_joint_cmd_nn.fl_leg[1].position;
-      fl_leg_positions[2] = robot_joint_cmd_nn.fl_leg[2].position;  
-      fr_leg_positions[0] = robot_joint_cmd_nn.fr_leg[0].position;  
-      fr_leg_positions[1] = robot_joint_cmd_nn.fr_leg[1].position;
-      fr_leg_positions[2] = robot_joint_cmd_nn.fr_leg[2].position;
-      hl_leg_positions[0] = robot_joint_cmd_nn.hl_leg[0].position;
-      hl_leg_positions[1] = robot_joint_cmd_nn.hl_leg[1].position;
-      hl_leg_positions[2] = robot_joint_cmd_nn.hl_leg[2].position;
-      hr_leg_positions[0] = robot_joint_cmd_nn.hr_leg[0].position;
-      hr_leg_positions[1] = robot_joint_cmd_nn.hr_leg[1].position;
-      hr_leg_positions[2] = robot_joint_cmd_nn.hr_leg[2].position;
-    }
-    // // do spline interpolation
-    if (time_tick >= 10000 / time_step) {
-      robot_joint_cmd = CreateRobotCmdFromNumber(fl_leg_positions, fr_leg_positions, hl_leg_positions, hr_leg_positions, 30, 0.7);
-    }
-    if(is_message_updated_){ 
-      // if (time_tick < 10000){
-      //   send_cmd->SendCmd(robot_joint_cmd);
-      // }
-      send_cmd->SendCmd(robot_joint_cmd);  
-    } 
+  if (options.sim_clock) {
+    std::cout << "Simulated clock: running as fast as possible, commands are not sent";
+    if (options.sim_duration_s > 0) {
+      std::cout << " for " << options.sim_duration_s << " simulated seconds";
+    }
+    std::cout << std::endl;
+  }
 
-    // // print robot data
-    // // Open the file in append mode
-    // std::ofstream file("robot_data.csv", std::ios::app);
-
-    // // print robot data
-    // // Open the file in append mode
-    // if (!file.is_open()) {
-    //     std::cerr << "Failed to open file: robot_data.csv" << std::endl;
-    //     return 1; // Exit the program if the file cannot be opened
-    // }
-    // // // Print robot data to the file
-    // // file << time_tick << endl;
-    // // // PrintRobotCmd(robot_joint_cmd, file);
-    // // PrintRobotData(robot_data, file);
-    // if (time_tick == 1) {
-    //   WriteCSVHeader(file);
-    // }
-    // SaveRobotDataToCSV(robot_data, file);
-    // // Close the file
-    // file.close();
- 
+  RealTimeClock wall_clock;
+  double wall_start_time = wall_clock.GetCurrentTime();
+  AllocTracker::TrackCurrentThread();
+  reactor.Run();
+  AllocTracker::Disarm();
+  if (options.sim_clock) {
+    std::cout << "Simulated " << set_timer->GetIntervalTime(start_time) << " s in "
+              << wall_clock.GetIntervalTime(wall_start_time) << " s of wall time" << std::endl;
+  }
+  
+  inference_worker.Stop();
+  if (shadow_worker) {
+    shadow_worker->Stop();
+  }
+  if (TraceRecorder::Instance().IsEnabled()) {
+    TraceRecorder::Instance().Disable();
+    if (TraceRecorder::Instance().Dump(options.trace_path)) {
+      std::cout << "Trace written to " << options.trace_path << std::endl;
+    }
+  }
+  AsyncLogger::Instance().Stop();
+  std::cout << "Control loop stopped, missed timer ticks: " << reactor.GetMissedTimerTicks() << std::endl;
+  inference_worker.PrintStats();
+  if (shadow_worker) {
+    shadow_worker->PrintStats();
+    shadow_comparator.PrintStats();
   }
+  stale_action_policy.PrintStats();
+  profiler.StopReporter();
+  profiler.PrintSummary("Phase latency (final)");
+  executor.PrintStats();
+  AllocTracker::PrintReport();
   
   // Close data logger before exiting
   if (data_logger) {
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""
+将PyTorch训练得到的MLP策略导出为进程内推理使用的格式（见 include/mlp_policy.h）
+
+输出文件扩展名为 .safetensors 时写出safetensors（推荐，Lite_motion内存映射加载，权重原地使用），
+否则写出文本格式。写入临时文件后再替换目标文件，正在运行的程序映射的旧文件不受影响。
+
+检查点中前缀为 --prefix（默认 "actor."）的 nn.Linear 层按序号依次导出，例如 rsl_rl 的
+actor.0.weight、actor.0.bias、actor.2.weight ...；隐藏层使用 --activation，最后一层不加激活函数。
+循环策略（rsl_rl 的 ActorCriticRecurrent）的单层GRU "<--memory-prefix>weight_ih_l0" 等
+（默认 memory_a.rnn.）存在时一并导出，MLP的输入为GRU的隐状态；LSTM与多层GRU不支持。
+文件名即模型类型，放在同一目录下后以 local:DIR 作为服务器地址启动:
+    python3 scripts/export_policy.py model_flat.pt policies/flat_terrain.safetensors
+    python3 scripts/export_policy.py model_rough.pt policies/rough_terrain.safetensors
+    ./Lite_motion local:policies
+
+不依赖PyTorch生成随机权重的模型（用于联调与基准）:
+    python3 scripts/export_policy.py --random 65,512,256,128,12 policies/flat_terrain.mlp
+    python3 scripts/export_policy.py --random 65,256,256,12 --gru policies/flat_terrain.safetensors
+"""
+
+import argparse
+import json
+import os
+import random
+import re
+import struct
+import sys
+
+MAGIC = "lite3_mlp 1"
+ACTIVATIONS = ("identity", "relu", "elu", "tanh")
+
+
+def load_state_dict(checkpoint):
+    import torch
+
+    state = torch.load(checkpoint, map_location="cpu")
+    if isinstance(state, dict) and "model_state_dict" in state:
+        state = state["model_state_dict"]
+    elif isinstance(state, torch.nn.Module):
+        state = state.state_dict()
+    return state
+
+
+def load_linear_layers(state, prefix, checkpoint):
+    """从检查点中按序号取出 (weight, bias) 列表，weight 为 [输出, 输入] 的嵌套列表"""
+    pattern = re.compile(re.escape(prefix) + r"(\d+)\.weight$")
+    indices = sorted(int(match.group(1)) for match in map(pattern.match, state.keys()) if match)
+    if not indices:
+        raise ValueError(f"no '{prefix}N.weight' tensors in {checkpoint}")
+
+    layers = []
+    for index in indices:
+        weight = state[f"{prefix}{index}.weight"].float()
+        bias = state[f"{prefix}{index}.bias"].float()
+        layers.append((weight.tolist(), bias.tolist()))
+    return layers
+
+
+def load_gru(state, prefix, checkpoint):
+    """取出单层GRU的 {weight_ih, weight_hh, bias_ih, bias_hh}，没有GRU时返回None"""
+    if f"{prefix}weight_ih_l0" not in state:
+        return None
+    if f"{prefix}weight_ih_l1" in state:
+        raise ValueError(f"{checkpoint}: only a single-layer GRU is supported")
+    gru = {name: state[f"{prefix}{name}_l0"].float().tolist()
+           for name in ("weight_ih", "weight_hh", "bias_ih", "bias_hh")}
+    if len(gru["weight_ih"]) != 3 * len(gru["weight_hh"][0]):
+        raise ValueError(f"{checkpoint}: '{prefix}' is not a GRU (LSTM is not supported)")
+    return gru
+
+
+def random_gru(inputs, hidden, seed):
+    """生成随机的GRU权重（与nn.GRU的初始化相同，按隐状态维数缩放）"""
+    rng = random.Random(seed + 1)
+    scale = 1.0 / hidden ** 0.5
+
+    def vector(count):
+        return [rng.uniform(-scale, scale) for _ in range(count)]
+
+    return {"weight_ih": [vector(inputs) for _ in range(3 * hidden)],
+            "weight_hh": [vector(hidden) for _ in range(3 * hidden)],
+            "bias_ih": vector(3 * hidden), "bias_hh": vector(3 * hidden)}
+
+
+def random_layers(sizes, seed):
+    """按 [输入, 隐藏..., 输出] 生成随机权重（按输入维数缩放，输出保持在合理范围）"""
+    rng = random.Random(seed)
+    layers = []
+    for inputs, outputs in zip(sizes[:-1], sizes[1:]):
+        scale = 1.0 / inputs ** 0.5
+        weight = [[rng.uniform(-scale, scale) for _ in range(inputs)] for _ in range(outputs)]
+        bias = [rng.uniform(-0.1, 0.1) for _ in range(outputs)]
+        layers.append((weight, bias))
+    return layers
+
+
+def write_safetensors(path, layers, activation, prefix, gru=None, memory_prefix="memory_a.rnn."):
+    """写出safetensors：各层为 <prefix><2i>.weight/.bias（与rsl_rl的nn.Sequential序号一致），F32小端；
+    GRU为 <memory_prefix>weight_ih_l0 等"""
+    header = {"__metadata__": {"format": "lite3_mlp", "activation": activation, "prefix": prefix}}
+    tensors = []
+    for index, (weight, bias) in enumerate(layers):
+        tensors.append((f"{prefix}{2 * index}.weight", weight))
+        tensors.append((f"{prefix}{2 * index}.bias", bias))
+    if gru is not None:
+        header["__metadata__"]["memory_prefix"] = memory_prefix
+        for name in ("weight_ih", "weight_hh", "bias_ih", "bias_hh"):
+            tensors.append((f"{memory_prefix}{name}_l0", gru[name]))
+
+    blobs = []
+    offset = 0
+    for name, values in tensors:
+        if isinstance(values[0], list):
+            shape = [len(values), len(values[0])]
+            values = [v for row in values for v in row]
+        else:
+            shape = [len(values)]
+        blob = struct.pack(f"<{len(values)}f", *values)
+        header[name] = {"dtype": "F32", "shape": shape, "data_offsets": [offset, offset + len(blob)]}
+        blobs.append(blob)
+        offset += len(blob)
+
+    encoded = json.dumps(header, separators=(",", ":")).encode("utf-8")
+    # 头部用空格补齐到8字节，保证张量数据对齐
+    encoded += b" " * (-len(encoded) % 8)
+    with open(path, "wb") as out:
+        out.write(struct.pack("<Q", len(encoded)))
+        out.write(encoded)
+        for blob in blobs:
+            out.write(blob)
+
+
+def write_mlp(path, layers, activation, gru=None):
+    with open(path, "w") as out:
+        out.write(MAGIC + "\n")
+        if gru is not None:
+            out.write(f"gru {len(gru['weight_hh'][0])} {len(gru['weight_ih'][0])}\n")
+            for row in gru["weight_ih"] + gru["weight_hh"] + [gru["bias_ih"], gru["bias_hh"]]:
+                out.write(" ".join(f"{value:.9g}" for value in row) + "\n")
+        for index, (weight, bias) in enumerate(layers):
+            layer_activation = activation if index + 1 < len(layers) else "identity"
+            out.write(f"layer {len(weight)} {len(weight[0])} {layer_activation}\n")
+            for row in weight:
+                out.write(" ".join(f"{value:.9g}" for value in row) + "\n")
+            out.write(" ".join(f"{value:.9g}" for value in bias) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="导出MLP策略供 local:DIR 进程内推理使用")
+    parser.add_argument("checkpoint", nargs="?", help="PyTorch检查点（state_dict、rsl_rl检查点或nn.Module）")
+    parser.add_argument("output", help="输出文件（.safetensors 或 .mlp），文件名（不含扩展名）为模型类型")
+    parser.add_argument("--prefix", default="actor.", help="策略网络各层的键前缀（默认 actor.）")
+    parser.add_argument("--activation", default="elu", choices=ACTIVATIONS, help="隐藏层激活函数（默认 elu）")
+    parser.add_argument("--memory-prefix", default="memory_a.rnn.", help="循环策略GRU的键前缀（默认 memory_a.rnn.）")
+    parser.add_argument("--random", metavar="SIZES", help="不读检查点，按逗号分隔的层维数生成随机权重")
+    parser.add_argument("--gru", action="store_true", help="与 --random 一起使用：前两个维数为GRU的输入与隐状态")
+    parser.add_argument("--seed", type=int, default=0, help="随机权重的种子")
+    args = parser.parse_args()
+
+    gru = None
+    if args.random:
+        sizes = [int(size) for size in args.random.split(",")]
+        if args.gru:
+            if len(sizes) < 3:
+                parser.error("--gru needs the GRU input, the hidden size and at least one layer")
+            gru = random_gru(sizes[0], sizes[1], args.seed)
+            sizes = sizes[1:]
+        layers = random_layers(sizes, args.seed)
+    elif args.checkpoint:
+        state = load_state_dict(args.checkpoint)
+        layers = load_linear_layers(state, args.prefix, args.checkpoint)
+        gru = load_gru(state, args.memory_prefix, args.checkpoint)
+    else:
+        parser.error("a checkpoint or --random is required")
+
+    temporary = args.output + ".tmp"
+    if args.output.endswith(".safetensors"):
+        write_safetensors(temporary, layers, args.activation, args.prefix, gru, args.memory_prefix)
+    else:
+        write_mlp(temporary, layers, args.activation, gru)
+    os.replace(temporary, args.output)
+    sizes = [len(layers[0][0][0])] + [len(weight) for weight, _ in layers]
+    if gru is not None:
+        sizes = [len(gru["weight_ih"][0]), f"gru {sizes[0]}"] + sizes[1:]
+    print(f"Wrote {args.output}: {' -> '.join(map(str, sizes))} ({args.activation})")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+"""
+共享内存推理服务器助手，供Python策略服务器与 Lite_motion 在同一台机器上通过 /dev/shm 交换观察与动作
+
+区域布局与协议见 include/shm_transport.h：客户端写入槽位并递增头部的 request_seq，
+服务器在 request_seq 上futex等待，按序号依次处理槽位，写入动作后将槽位状态置为“响应已写入”
+并唤醒客户端。槽位状态用 FUTEX_WAKE_OP 一次完成写入与唤醒，内核中的原子操作同时充当
+内存屏障，保证客户端看到状态时动作已经写好（在ARM上同样成立）。
+
+用法:
+    from shm_policy_server import ShmPolicyServer
+
+    def handler(observation, model_type, deterministic):
+        return policy(observation)          # 返回动作序列（12个浮点数）
+
+    server = ShmPolicyServer("lite3_inference")
+    server.create()
+    server.serve_forever(handler)
+
+    # 之后启动: ./Lite_motion shm:lite3_inference
+
+直接运行本脚本启动一个回显服务器:
+    python3 scripts/shm_policy_server.py lite3_inference
+"""
+
+import argparse
+import ctypes
+import mmap
+import os
+import platform
+import struct
+import sys
+
+# 与 include/shm_transport.h 保持一致
+SHM_MAGIC = 0x4C335348
+SHM_VERSION = 1
+SLOT_COUNT = 8
+MAX_OBSERVATION = 128
+MAX_ACTION = 32
+MODEL_TYPE_SIZE = 32
+ERROR_SIZE = 128
+HEADER_SIZE = 64
+SLOT_SIZE = 832
+REGION_SIZE = HEADER_SIZE + SLOT_COUNT * SLOT_SIZE
+
+# 头部字段偏移
+HEADER_MAGIC = 0
+HEADER_VERSION = 4
+HEADER_SLOT_COUNT = 8
+HEADER_SLOT_SIZE = 12
+HEADER_REQUEST_SEQ = 16
+HEADER_SERVER_PID = 20
+
+# 槽位字段偏移
+SLOT_STATE = 0
+SLOT_SEQ = 4
+SLOT_DETERMINISTIC = 8
+SLOT_OBSERVATION_COUNT = 12
+SLOT_MODEL_TYPE = 16
+SLOT_OBSERVATION = 48
+SLOT_SUCCESS = 560
+SLOT_ACTION_COUNT = 564
+SLOT_ACTION = 568
+SLOT_ERROR_MESSAGE = 696
+
+STATE_REQUEST = 1
+STATE_RESPONSE = 2
+
+SYS_FUTEX = {"x86_64": 202, "aarch64": 98}[platform.machine()]
+FUTEX_WAIT = 0
+FUTEX_WAKE_OP = 5
+# FUTEX_OP(FUTEX_OP_SET, STATE_RESPONSE, FUTEX_OP_CMP_EQ, 0)：将状态置为响应已写入
+FUTEX_OP_SET_RESPONSE = STATE_RESPONSE << 12
+
+_libc = ctypes.CDLL(None, use_errno=True)
+_libc.syscall.restype = ctypes.c_long
+
+
+class _Timespec(ctypes.Structure):
+    _fields_ = [("tv_sec", ctypes.c_long), ("tv_nsec", ctypes.c_long)]
+
+
+def _futex_wait(address, expected, timeout_s):
+    """在futex字上等待其值不再为expected，至多timeout_s秒"""
+    timeout = _Timespec(int(timeout_s), int((timeout_s - int(timeout_s)) * 1e9))
+    _libc.syscall(ctypes.c_long(SYS_FUTEX), ctypes.c_void_p(address), ctypes.c_int(FUTEX_WAIT),
+                  ctypes.c_uint32(expected), ctypes.byref(timeout), None, ctypes.c_int(0))
+
+
+def _futex_set_response_and_wake(address):
+    """原子地将槽位状态置为响应已写入，并唤醒等待的客户端"""
+    _libc.syscall(ctypes.c_long(SYS_FUTEX), ctypes.c_void_p(address), ctypes.c_int(FUTEX_WAKE_OP),
+                  ctypes.c_int(1), ctypes.c_void_p(1), ctypes.c_void_p(address),
+                  ctypes.c_int(FUTEX_OP_SET_RESPONSE))
+
+
+class ShmPolicyServer:
+    """共享内存推理服务器"""
+
+    def __init__(self, name):
+        """
+        Args:
+            name: 区域名，对应 /dev/shm/NAME（客户端地址为 shm:NAME）
+        """
+        self.path = os.path.join("/dev/shm", name.lstrip("/"))
+        self.buffer = None
+        self.next_seq = 0
+
+    def create(self):
+        """创建并初始化区域（替换已存在的同名区域）"""
+        if os.path.exists(self.path):
+            os.unlink(self.path)
+        fd = os.open(self.path, os.O_RDWR | os.O_CREAT | os.O_EXCL, 0o666)
+        try:
+            os.ftruncate(fd, REGION_SIZE)
+            self.buffer = mmap.mmap(fd, REGION_SIZE)
+        finally:
+            os.close(fd)
+
+        self._header = (ctypes.c_uint32 * 6).from_buffer(self.buffer, 0)
+        self._request_seq_address = ctypes.addressof(self._header) + HEADER_REQUEST_SEQ
+        self._slot_states = [ctypes.c_uint32.from_buffer(self.buffer, self._slot_offset(i) + SLOT_STATE)
+                             for i in range(SLOT_COUNT)]
+
+        self._header[HEADER_VERSION // 4] = SHM_VERSION
+        self._header[HEADER_SLOT_COUNT // 4] = SLOT_COUNT
+        self._header[HEADER_SLOT_SIZE // 4] = SLOT_SIZE
+        self._header[HEADER_SERVER_PID // 4] = os.getpid()
+        self.next_seq = 0
+        # 魔数最后写入，客户端据此判断初始化已完成
+        self._header[HEADER_MAGIC // 4] = SHM_MAGIC
+
+    def close(self):
+        """清除服务器进程号并删除区域"""
+        if self.buffer is None:
+            return
+        self._header[HEADER_SERVER_PID // 4] = 0
+        del self._header, self._slot_states
+        self.buffer.close()
+        self.buffer = None
+        os.unlink(self.path)
+
+    def serve_once(self, handler, timeout=0.1):
+        """
+        处理所有待处理的请求，没有请求时至多等待timeout秒
+
+        Args:
+            handler: handler(observation, model_type, deterministic) -> 动作序列（浮点数）；
+                     observation 是直接指向共享内存的float型 memoryview（可用 np.frombuffer
+                     零拷贝转为数组），只在调用期间有效；
+                     抛出异常时，异常信息作为失败原因返回给客户端
+            timeout: 等待超时（秒）
+
+        Returns:
+            int: 处理的请求数
+        """
+        submitted = self._header[HEADER_REQUEST_SEQ // 4]
+        if submitted == self.next_seq:
+            _futex_wait(self._request_seq_address, self.next_seq, timeout)
+            submitted = self._header[HEADER_REQUEST_SEQ // 4]
+
+        served = 0
+        while self.next_seq != submitted:
+            index = self.next_seq % SLOT_COUNT
+            offset = self._slot_offset(index)
+            state = self._slot_states[index]
+            seq = self._read_u32(offset + SLOT_SEQ)
+            if state.value == STATE_REQUEST and seq == self.next_seq:
+                self._serve_slot(handler, offset)
+                _futex_set_response_and_wake(ctypes.addressof(state))
+                served += 1
+            self.next_seq = (self.next_seq + 1) & 0xFFFFFFFF
+        return served
+
+    def serve_forever(self, handler):
+        """循环处理请求，直到 KeyboardInterrupt"""
+        try:
+            while True:
+                self.serve_once(handler)
+        except KeyboardInterrupt:
+            pass
+
+    def _slot_offset(self, index):
+        return HEADER_SIZE + index * SLOT_SIZE
+
+    def _read_u32(self, offset):
+        return struct.unpack_from("<I", self.buffer, offset)[0]
+
+    def _serve_slot(self, handler, offset):
+        count = min(self._read_u32(offset + SLOT_OBSERVATION_COUNT), MAX_OBSERVATION)
+        begin = offset + SLOT_OBSERVATION
+        observation = memoryview(self.buffer)[begin:begin + 4 * count].cast("f")
+        model_type = bytes(self.buffer[offset + SLOT_MODEL_TYPE:offset + SLOT_MODEL_TYPE + MODEL_TYPE_SIZE])
+        model_type = model_type.split(b"\0", 1)[0].decode()
+        deterministic = self._read_u32(offset + SLOT_DETERMINISTIC) != 0
+
+        try:
+            action = [float(value) for value in handler(observation, model_type, deterministic)][:MAX_ACTION]
+            struct.pack_into(f"<{len(action)}f", self.buffer, offset + SLOT_ACTION, *action)
+            struct.pack_into("<II", self.buffer, offset + SLOT_SUCCESS, 1, len(action))
+        except Exception as error:
+            message = str(error).encode()[:ERROR_SIZE - 1] + b"\0"
+            self.buffer[offset + SLOT_ERROR_MESSAGE:offset + SLOT_ERROR_MESSAGE + len(message)] = message
+            struct.pack_into("<II", self.buffer, offset + SLOT_SUCCESS, 0, 0)
+        finally:
+            # 释放对共享内存的引用，区域才能被关闭
+            observation.release()
+
+
+def echo_handler(observation, model_type, deterministic):
+    """回显处理函数：返回12个动作，依次为观察的前12个元素（不足时补0）"""
+    count = min(len(observation), 12)
+    return list(observation[:count]) + [0.0] * (12 - count)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="共享内存回显推理服务器")
+    parser.add_argument("name", nargs="?", default="lite3_inference", help="区域名，客户端地址为 shm:NAME")
+    args = parser.parse_args()
+
+    server = ShmPolicyServer(args.name)
+    server.create()
+    print(f"Serving echo actions on /dev/shm/{args.name} (client address shm:{args.name})")
+    try:
+        server.serve_forever(echo_handler)
+    finally:
+        server.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,113 @@
+#include "../include/alloc_tracker.h"
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+// 替换全局的分配函数，把每次分配报告给 AllocTracker。替换对整个进程生效，
+// 因此本文件只链接进控制程序与检查分配的测试（见 CMakeLists.txt），不随 src/ 进入其他程序。
+
+#if defined(__GLIBC__)
+
+// glibc导出的原始分配函数，替换后的malloc等转发至此
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+
+void* malloc(size_t size) {
+    AllocTracker::RecordAllocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    AllocTracker::RecordAllocation();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    AllocTracker::RecordAllocation();
+    return __libc_realloc(ptr, size);
+}
+
+// 对齐分配（Eigen、部分libstdc++实现的对齐 operator new 等）同样计数
+int posix_memalign(void** memptr, size_t alignment, size_t size) {
+    // 对齐须为 sizeof(void*) 的2的幂倍
+    if (alignment == 0 || alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    AllocTracker::RecordAllocation();
+    void* ptr = __libc_memalign(alignment, size);
+    if (ptr == nullptr) {
+        return ENOMEM;
+    }
+    *memptr = ptr;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    AllocTracker::RecordAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    AllocTracker::RecordAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void* valloc(size_t size) {
+    AllocTracker::RecordAllocation();
+    return __libc_valloc(size);
+}
+}
+
+namespace {
+
+void* AllocateOrThrow(size_t size) {
+    AllocTracker::RecordAllocation();
+    void* ptr = __libc_malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* AllocateAlignedOrThrow(size_t size, std::align_val_t alignment) {
+    AllocTracker::RecordAllocation();
+    void* ptr = __libc_memalign(static_cast<size_t>(alignment), size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return AllocateOrThrow(size); }
+void* operator new[](size_t size) { return AllocateOrThrow(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return AllocateAlignedOrThrow(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return AllocateAlignedOrThrow(size, alignment); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    AllocTracker::RecordAllocation();
+    return __libc_malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    AllocTracker::RecordAllocation();
+    return __libc_malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+
+#endif  // __GLIBC__
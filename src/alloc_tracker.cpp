@@ -0,0 +1,99 @@
+#include "../include/alloc_tracker.h"
+#include "../include/phase_profiler.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+__thread int g_alloc_tracker_phase = -1;
+
+namespace {
+
+std::atomic<int> g_mode(AllocTracker::kOff);
+std::atomic<bool> g_armed(false);
+__thread bool t_tracked = false;
+
+// 最后一个槽位统计不在任何阶段内的分配
+std::atomic<uint64_t> g_counts[kPhaseCount + 1];
+
+const char* SlotName(int slot) {
+    return slot < kPhaseCount ? PhaseProfiler::PhaseName(static_cast<ControlPhase>(slot)) : "(no phase)";
+}
+
+}  // namespace
+
+void AllocTracker::RecordAllocation() {
+    if (!g_armed.load(std::memory_order_relaxed) || !t_tracked) {
+        return;
+    }
+
+    int phase = g_alloc_tracker_phase;
+    int slot = (phase >= 0 && phase < kPhaseCount) ? phase : kPhaseCount;
+    g_counts[slot].fetch_add(1, std::memory_order_relaxed);
+
+    if (g_mode.load(std::memory_order_relaxed) == AllocTracker::kAbort) {
+        g_armed.store(false, std::memory_order_relaxed);
+        const char* prefix = "AllocTracker: heap allocation on the control thread in phase ";
+        const char* name = SlotName(slot);
+        ssize_t ignored = write(STDERR_FILENO, prefix, strlen(prefix));
+        ignored = write(STDERR_FILENO, name, strlen(name));
+        ignored = write(STDERR_FILENO, "\n", 1);
+        (void)ignored;
+        abort();
+    }
+}
+
+void AllocTracker::SetMode(Mode mode) {
+    g_mode.store(mode, std::memory_order_relaxed);
+}
+
+AllocTracker::Mode AllocTracker::GetMode() {
+    return static_cast<Mode>(g_mode.load(std::memory_order_relaxed));
+}
+
+void AllocTracker::TrackCurrentThread() {
+    t_tracked = true;
+}
+
+void AllocTracker::Arm() {
+    if (GetMode() == kOff) {
+        return;
+    }
+    for (int i = 0; i <= kPhaseCount; ++i) {
+        g_counts[i].store(0, std::memory_order_relaxed);
+    }
+    g_armed.store(true, std::memory_order_release);
+}
+
+void AllocTracker::Disarm() {
+    g_armed.store(false, std::memory_order_release);
+}
+
+uint64_t AllocTracker::TotalCount() {
+    uint64_t total = 0;
+    for (int i = 0; i <= kPhaseCount; ++i) {
+        total += g_counts[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t AllocTracker::PhaseCount(int phase) {
+    int slot = (phase >= 0 && phase < kPhaseCount) ? phase : kPhaseCount;
+    return g_counts[slot].load(std::memory_order_relaxed);
+}
+
+void AllocTracker::PrintReport() {
+    if (GetMode() == kOff) {
+        return;
+    }
+
+    uint64_t total = TotalCount();
+    std::cout << "Allocation check: " << total << " heap allocations on the control thread after warmup" << std::endl;
+    for (int i = 0; i <= kPhaseCount; ++i) {
+        uint64_t count = g_counts[i].load(std::memory_order_relaxed);
+        if (count > 0) {
+            std::cout << "  " << SlotName(i) << ": " << count << std::endl;
+        }
+    }
+}
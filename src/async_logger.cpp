@@ -0,0 +1,242 @@
+#include "../include/async_logger.h"
+#include <chrono>
+#include <cstdio>
+#include <time.h>
+
+namespace {
+
+/// @brief 去重时，相同内容至多每隔该时间再输出一次
+const uint64_t kDedupRepeatNs = 1000000000ULL;
+
+/// @brief 后台线程的输出周期
+const int kDrainPeriodMs = 10;
+
+uint64_t HashBytes(uint64_t hash, const void* data, size_t length) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/// @brief 记录内容（格式串与参数值）的FNV-1a哈希
+uint64_t HashRecord(const LogRecord& record) {
+    uint64_t hash = 14695981039346656037ULL;
+    hash = HashBytes(hash, &record.format, sizeof(record.format));
+    for (int i = 0; i < record.arg_count; ++i) {
+        const LogArg& arg = record.args[i];
+        hash = HashBytes(hash, &arg.type, sizeof(arg.type));
+        if (arg.type == LogArg::kString) {
+            hash = HashBytes(hash, &arg.str_offset, sizeof(arg.str_offset));
+        } else {
+            hash = HashBytes(hash, &arg.u, sizeof(arg.u));
+        }
+    }
+    return HashBytes(hash, record.text, record.text_used);
+}
+
+}  // namespace
+
+AsyncLogger& AsyncLogger::Instance() {
+    static AsyncLogger logger;
+    return logger;
+}
+
+AsyncLogger::AsyncLogger()
+    : cells_(new Cell[kCapacity]), enqueue_pos_(0), dequeue_pos_(0), dropped_(0), reported_dropped_(0),
+      running_(false) {
+    for (size_t i = 0; i < kCapacity; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+AsyncLogger::~AsyncLogger() {
+    Stop();
+    delete[] cells_;
+}
+
+void AsyncLogger::Start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    thread_ = std::thread(&AsyncLogger::Run, this);
+}
+
+void AsyncLogger::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    // 输出后台线程退出后（或从未启动时）残留的记录
+    Drain();
+}
+
+uint64_t AsyncLogger::NowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void AsyncLogger::AppendString(LogRecord* record, const char* value, size_t length) {
+    LogArg& arg = record->args[record->arg_count++];
+    arg.type = LogArg::kString;
+    arg.str_offset = record->text_used;
+
+    size_t available = LogRecord::kInlineTextSize - record->text_used;
+    if (available == 0) {
+        // 缓冲已满，指向最后一个字节的结束符
+        arg.str_offset = LogRecord::kInlineTextSize - 1;
+        return;
+    }
+    size_t copied = length < available - 1 ? length : available - 1;
+    if (copied > 0) {
+        memcpy(record->text + record->text_used, value, copied);
+    }
+    record->text[record->text_used + copied] = '\0';
+    record->text_used = static_cast<uint16_t>(record->text_used + copied + 1);
+}
+
+void AsyncLogger::Submit(LogSite* site, LogRecord* record) {
+    record->suppressed = 0;
+    if (site != nullptr) {
+        bool emitted_before = site->last_emit_ns != 0;
+        uint64_t since_last = record->stamp_ns - site->last_emit_ns;
+
+        if (site->min_interval_ns > 0 && emitted_before && since_last < site->min_interval_ns) {
+            site->suppressed++;
+            return;
+        }
+        uint64_t hash = 0;
+        if (site->dedup) {
+            hash = HashRecord(*record);
+            if (emitted_before && hash == site->last_hash && since_last < kDedupRepeatNs) {
+                site->suppressed++;
+                return;
+            }
+        }
+
+        record->suppressed = site->suppressed;
+        site->suppressed = 0;
+        site->last_emit_ns = record->stamp_ns;
+        site->last_hash = hash;
+    }
+
+    if (!Push(*record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool AsyncLogger::Push(const LogRecord& record) {
+    // 有界多写者队列：每个槽位的序号表示其可写/可读状态
+    uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = cells_[pos & (kCapacity - 1)];
+        uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.record = record;
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // 队列已满
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool AsyncLogger::Pop(LogRecord* record) {
+    Cell& cell = cells_[dequeue_pos_ & (kCapacity - 1)];
+    uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != dequeue_pos_ + 1) {
+        return false;
+    }
+    *record = cell.record;
+    cell.sequence.store(dequeue_pos_ + kCapacity, std::memory_order_release);
+    dequeue_pos_++;
+    return true;
+}
+
+void AsyncLogger::Drain() {
+    std::string out;
+    std::string err;
+    LogRecord record;
+    while (Pop(&record)) {
+        std::string& target = record.level == kLogInfo ? out : err;
+        target += Format(record);
+        target += '\n';
+    }
+
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported_dropped_) {
+        err += "[logger] dropped " + std::to_string(dropped - reported_dropped_) + " records (queue full)\n";
+        reported_dropped_ = dropped;
+    }
+
+    if (!out.empty()) {
+        fwrite(out.data(), 1, out.size(), stdout);
+        fflush(stdout);
+    }
+    if (!err.empty()) {
+        fwrite(err.data(), 1, err.size(), stderr);
+        fflush(stderr);
+    }
+}
+
+void AsyncLogger::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        cv_.wait_for(lock, std::chrono::milliseconds(kDrainPeriodMs));
+        lock.unlock();
+        Drain();
+        lock.lock();
+    }
+}
+
+std::string AsyncLogger::Format(const LogRecord& record) {
+    std::string line;
+    int next_arg = 0;
+    const char* p = record.format;
+    while (*p != '\0') {
+        if (p[0] == '{' && p[1] == '}') {
+            if (next_arg < record.arg_count) {
+                const LogArg& arg = record.args[next_arg++];
+                char buffer[32];
+                switch (arg.type) {
+                    case LogArg::kInt:
+                        snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(arg.i));
+                        line += buffer;
+                        break;
+                    case LogArg::kUInt:
+                        snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(arg.u));
+                        line += buffer;
+                        break;
+                    case LogArg::kDouble:
+                        snprintf(buffer, sizeof(buffer), "%g", arg.d);
+                        line += buffer;
+                        break;
+                    case LogArg::kString:
+                        line += record.text + arg.str_offset;
+                        break;
+                }
+            }
+            p += 2;
+        } else {
+            line += *p++;
+        }
+    }
+
+    if (record.suppressed > 0) {
+        line += " [+" + std::to_string(record.suppressed) + " suppressed]";
+    }
+    return line;
+}
@@ -0,0 +1,14 @@
+#include "../include/control_clock.h"
+#include <time.h>
+
+uint64_t RealTimeClock::NowNs() const {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void SimulatedClock::AdvanceTo(uint64_t time_ns) {
+    if (time_ns > now_ns_.load(std::memory_order_relaxed)) {
+        now_ns_.store(time_ns, std::memory_order_release);
+    }
+}
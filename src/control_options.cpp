@@ -0,0 +1,283 @@
+#include "../include/control_options.h"
+#include "../include/local_policy_backend.h"
+#include "../include/shm_transport.h"
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+/// @brief 将 "--name=value" 拆分为名称与取值
+void SplitOption(const std::string& arg, std::string* name, std::string* value) {
+    size_t pos = arg.find('=');
+    if (pos == std::string::npos) {
+        *name = arg;
+        value->clear();
+    } else {
+        *name = arg.substr(0, pos);
+        *value = arg.substr(pos + 1);
+    }
+}
+
+/// @brief 解析整数取值
+bool ParseInt(const std::string& name, const std::string& value, int* out) {
+    char* end = nullptr;
+    long parsed = std::strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0') {
+        std::cerr << "Invalid value for " << name << ": '" << value << "'" << std::endl;
+        return false;
+    }
+    *out = static_cast<int>(parsed);
+    return true;
+}
+
+/// @brief 解析浮点取值
+bool ParseDouble(const std::string& name, const std::string& value, double* out) {
+    char* end = nullptr;
+    double parsed = std::strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0') {
+        std::cerr << "Invalid value for " << name << ": '" << value << "'" << std::endl;
+        return false;
+    }
+    *out = parsed;
+    return true;
+}
+
+}  // namespace
+
+bool ParseControlOptions(int argc, char* argv[], ControlOptions* options) {
+    bool server_address_set = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            if (server_address_set) {
+                std::cerr << "Unexpected argument: " << arg << std::endl;
+                return false;
+            }
+            options->server_address = arg;
+            server_address_set = true;
+            continue;
+        }
+
+        std::string name, value;
+        SplitOption(arg, &name, &value);
+
+        if (name == "--help") {
+            return false;
+        } else if (name == "--rt") {
+            options->rt.enabled = true;
+        } else if (name == "--rt-control-prio") {
+            if (!ParseInt(name, value, &options->rt.control_priority)) return false;
+        } else if (name == "--rt-receive-prio") {
+            if (!ParseInt(name, value, &options->rt.receive_priority)) return false;
+        } else if (name == "--rt-control-cpu") {
+            if (!ParseInt(name, value, &options->rt.control_cpu)) return false;
+        } else if (name == "--rt-receive-cpu") {
+            if (!ParseInt(name, value, &options->rt.receive_cpu)) return false;
+        } else if (name == "--rt-no-mlock") {
+            options->rt.lock_memory = false;
+        } else if (name == "--state-triggered") {
+            options->state_triggered = true;
+        } else if (name == "--state-decimation") {
+            if (!ParseInt(name, value, &options->state_decimation)) return false;
+            if (options->state_decimation < 1) {
+                std::cerr << "--state-decimation must be at least 1" << std::endl;
+                return false;
+            }
+        } else if (name == "--sim-clock") {
+            options->sim_clock = true;
+        } else if (name == "--sim-duration") {
+            if (!ParseInt(name, value, &options->sim_duration_s)) return false;
+        } else if (name == "--alloc-check") {
+            if (value == "report") {
+                options->alloc_check = AllocTracker::kReport;
+            } else if (value == "abort") {
+                options->alloc_check = AllocTracker::kAbort;
+            } else {
+                std::cerr << "Invalid value for --alloc-check: '" << value << "' (expected report or abort)" << std::endl;
+                return false;
+            }
+        } else if (name == "--grpc-async") {
+            if (!ParseInt(name, value, &options->grpc_async)) return false;
+            if (options->grpc_async < 1) {
+                std::cerr << "--grpc-async must be at least 1" << std::endl;
+                return false;
+            }
+        } else if (name == "--grpc-stream") {
+            options->grpc_stream = true;
+        } else if (name == "--grpc-session") {
+            options->grpc_session = true;
+        } else if (name == "--grpc-health-period") {
+            if (!ParseInt(name, value, &options->grpc_health_period_ms)) return false;
+            if (options->grpc_health_period_ms < 0) {
+                std::cerr << "--grpc-health-period must not be negative" << std::endl;
+                return false;
+            }
+        } else if (name == "--grpc-hedge") {
+            if (value.empty()) {
+                std::cerr << "--grpc-hedge requires a secondary server address" << std::endl;
+                return false;
+            }
+            options->grpc_hedge_address = value;
+        } else if (name == "--grpc-hedge-after") {
+            if (!ParseDouble(name, value, &options->grpc_hedge_after)) return false;
+            if (options->grpc_hedge_after < 0.0 || options->grpc_hedge_after > 1.0) {
+                std::cerr << "--grpc-hedge-after must be between 0 and 1" << std::endl;
+                return false;
+            }
+        } else if (name == "--inference-deadline") {
+            if (!ParseDouble(name, value, &options->inference_deadline)) return false;
+            if (options->inference_deadline <= 0.0) {
+                std::cerr << "--inference-deadline must be positive" << std::endl;
+                return false;
+            }
+        } else if (name == "--stale-action") {
+            if (value == "hold") {
+                options->stale_action.mode = StaleActionMode::kHold;
+            } else if (value == "decay") {
+                options->stale_action.mode = StaleActionMode::kDecay;
+            } else {
+                std::cerr << "Invalid value for --stale-action: '" << value << "' (expected hold or decay)" << std::endl;
+                return false;
+            }
+        } else if (name == "--stale-decay") {
+            if (!ParseDouble(name, value, &options->stale_action.decay_per_period)) return false;
+            if (options->stale_action.decay_per_period < 0.0 || options->stale_action.decay_per_period > 1.0) {
+                std::cerr << "--stale-decay must be between 0 and 1" << std::endl;
+                return false;
+            }
+        } else if (name == "--damp-after") {
+            if (!ParseInt(name, value, &options->stale_action.damp_after)) return false;
+            if (options->stale_action.damp_after < 0) {
+                std::cerr << "--damp-after must not be negative" << std::endl;
+                return false;
+            }
+        } else if (name == "--trace-inference") {
+            options->trace_inference = true;
+        } else if (name == "--eval-both-terrains") {
+            options->eval_both_terrains = true;
+        } else if (name == "--recurrent") {
+            options->recurrent = true;
+        } else if (name == "--shadow") {
+            if (value.empty()) {
+                std::cerr << "--shadow requires the address of the candidate policy" << std::endl;
+                return false;
+            }
+            options->shadow_address = value;
+        } else if (name == "--shadow-model") {
+            if (value.empty()) {
+                std::cerr << "--shadow-model requires a model type" << std::endl;
+                return false;
+            }
+            options->shadow_model = value;
+        } else if (name == "--trace") {
+            if (value.empty()) {
+                std::cerr << "--trace requires a file name" << std::endl;
+                return false;
+            }
+            options->trace_path = value;
+        } else if (name == "--profile-period") {
+            if (!ParseInt(name, value, &options->profile_period_s)) return false;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options->grpc_async > 0 && options->grpc_stream) {
+        std::cerr << "--grpc-async cannot be combined with --grpc-stream" << std::endl;
+        return false;
+    }
+    if (options->eval_both_terrains && (options->grpc_async > 0 || options->grpc_stream)) {
+        std::cerr << "--eval-both-terrains cannot be combined with --grpc-async or --grpc-stream" << std::endl;
+        return false;
+    }
+    if (options->grpc_session && (options->grpc_async > 0 || options->grpc_stream || options->eval_both_terrains)) {
+        std::cerr << "--grpc-session cannot be combined with --grpc-async, --grpc-stream or --eval-both-terrains"
+                  << std::endl;
+        return false;
+    }
+    const bool shm_address = ShmClient::IsShmAddress(options->server_address);
+    const bool local_address = LocalPolicyBackend::IsLocalAddress(options->server_address);
+    if (options->trace_inference && (options->grpc_session || shm_address || local_address)) {
+        std::cerr << "--trace-inference cannot be combined with --grpc-session or a shm: or local: server address"
+                  << std::endl;
+        return false;
+    }
+    if (options->trace_inference && !options->grpc_hedge_address.empty()) {
+        // 时钟偏差估计器只对应一台服务器；备用服务器的应答会混入另一台主机的时钟
+        std::cerr << "--trace-inference cannot be combined with --grpc-hedge" << std::endl;
+        return false;
+    }
+    if (!options->grpc_hedge_address.empty() &&
+        (options->grpc_async > 0 || options->grpc_stream || options->grpc_session || options->eval_both_terrains ||
+         shm_address || local_address)) {
+        std::cerr << "--grpc-hedge cannot be combined with --grpc-async, --grpc-stream, --grpc-session, "
+                     "--eval-both-terrains or a shm: or local: server address" << std::endl;
+        return false;
+    }
+    if (!options->grpc_hedge_address.empty() && options->grpc_hedge_after >= options->inference_deadline) {
+        std::cerr << "--grpc-hedge-after must be less than --inference-deadline" << std::endl;
+        return false;
+    }
+    if ((shm_address || local_address) &&
+        (options->grpc_async > 0 || options->grpc_stream || options->grpc_session || options->eval_both_terrains)) {
+        std::cerr << "A shm: or local: server address cannot be combined with --grpc-async, --grpc-stream, "
+                     "--grpc-session or --eval-both-terrains" << std::endl;
+        return false;
+    }
+    if (options->recurrent &&
+        (options->grpc_async > 0 || options->grpc_stream || options->grpc_session || options->eval_both_terrains ||
+         shm_address)) {
+        // 只有一元推理（gRPC或进程内）携带隐状态
+        std::cerr << "--recurrent cannot be combined with --grpc-async, --grpc-stream, --grpc-session, "
+                     "--eval-both-terrains or a shm: server address" << std::endl;
+        return false;
+    }
+    if (!options->shadow_model.empty() && options->shadow_address.empty()) {
+        std::cerr << "--shadow-model requires --shadow" << std::endl;
+        return false;
+    }
+    if (options->sim_clock && options->state_triggered) {
+        std::cerr << "--sim-clock cannot be combined with --state-triggered" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void PrintControlUsage(const char* program) {
+    std::cout << "Usage: " << program << " [server_address] [options]" << std::endl;
+    std::cout << "  server_address           gRPC inference server (default localhost:50151;" << std::endl;
+    std::cout << "                           unix:/path/to.sock or shm:NAME for a server on the same machine)" << std::endl;
+    std::cout << "                           or local:DIR to run the *.mlp policies in DIR in-process" << std::endl;
+    std::cout << "  --rt                     enable the real-time profile" << std::endl;
+    std::cout << "  --rt-control-prio=N      SCHED_FIFO priority of the control thread (default 80)" << std::endl;
+    std::cout << "  --rt-receive-prio=N      SCHED_FIFO priority of the receive threads (default 85)" << std::endl;
+    std::cout << "  --rt-control-cpu=N       pin the control thread to CPU N" << std::endl;
+    std::cout << "  --rt-receive-cpu=N       pin the receive threads to CPU N" << std::endl;
+    std::cout << "  --rt-no-mlock            do not lock and prefault memory" << std::endl;
+    std::cout << "  --state-triggered        run each control step when a robot state packet arrives" << std::endl;
+    std::cout << "  --state-decimation=N     in state-triggered mode, run one step every N packets (default 1)" << std::endl;
+    std::cout << "  --sim-clock              run on a simulated clock, as fast as possible" << std::endl;
+    std::cout << "  --sim-duration=S         with --sim-clock, stop after S simulated seconds" << std::endl;
+    std::cout << "  --alloc-check=MODE       after warmup, count (report) or abort on (abort) control-thread heap allocations" << std::endl;
+    std::cout << "  --grpc-async=N           pipeline inference with up to N async gRPC requests in flight" << std::endl;
+    std::cout << "  --grpc-stream            send observations over one persistent StreamPredict stream" << std::endl;
+    std::cout << "  --grpc-session           negotiate the payload once with OpenSession, then send raw float steps" << std::endl;
+    std::cout << "  --eval-both-terrains     evaluate the flat and rough terrain models in one BatchPredict call" << std::endl;
+    std::cout << "  --recurrent              the policy is recurrent: carry its hidden state and log its norm" << std::endl;
+    std::cout << "  --shadow=ADDRESS         also run a candidate policy at ADDRESS (gRPC, shm: or local:DIR) on every" << std::endl;
+    std::cout << "                           observation; its actions are logged next to the live ones, never sent" << std::endl;
+    std::cout << "  --shadow-model=TYPE      model type of the candidate (default: the live model type)" << std::endl;
+    std::cout << "  --grpc-health-period=MS  check the connection every MS ms and reconnect in the background (default 500, 0 = off)" << std::endl;
+    std::cout << "  --grpc-hedge=ADDRESS     resend a slow or failed request to a standby server; the first answer wins" << std::endl;
+    std::cout << "  --grpc-hedge-after=F     hedge after F of the 20 ms policy period without an answer (default 0.5)" << std::endl;
+    std::cout << "  --inference-deadline=F   fail a request not answered within F policy periods (default 1)" << std::endl;
+    std::cout << "  --stale-action=MODE      after a missed deadline, hold the last action or decay it to neutral (default hold)" << std::endl;
+    std::cout << "  --stale-decay=F          with --stale-action=decay, scale the action by F per missed period (default 0.5)" << std::endl;
+    std::cout << "  --damp-after=N           switch to zero-stiffness damping after N missed periods in a row (default 0 = never)" << std::endl;
+    std::cout << "  --trace-inference        split each inference into network, server queue and model compute time" << std::endl;
+    std::cout << "  --trace=FILE             record a thread timeline, written to FILE at exit and to FILE.N on SIGUSR1" << std::endl;
+    std::cout << "  --profile-period=S       print phase latency summaries every S seconds (default 10, 0 = at exit only)" << std::endl;
+    std::cout << "  --help                   show this message" << std::endl;
+}
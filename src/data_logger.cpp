@@ -4,7 +4,8 @@
 #include <ctime>
 
 DataLogger::DataLogger(const std::string& base_filename) 
-    : base_filename_(base_filename), initialized_(false) {
+    : base_filename_(base_filename), initialized_(false), inference_timing_enabled_(false),
+      recurrent_state_enabled_(false), shadow_action_enabled_(false) {
     
     // 生成带时间戳的文件名
     std::time_t now = std::time(nullptr);
@@ -24,6 +25,9 @@ DataLogger::DataLogger(const std::string& base_filename)
     observation_filename_ = timestamp_suffix + "_observation.csv";
     raw_action_filename_ = timestamp_suffix + "_raw_action.csv";
     action_filename_ = timestamp_suffix + "_action.csv";
+    inference_timing_filename_ = timestamp_suffix + "_inference_timing.csv";
+    recurrent_state_filename_ = timestamp_suffix + "_recurrent_state.csv";
+    shadow_action_filename_ = timestamp_suffix + "_shadow_action.csv";
 }
 
 DataLogger::~DataLogger() {
@@ -55,6 +59,55 @@ bool DataLogger::Initialize() {
         return false;
     }
     
+    // 打开推理延迟分解文件
+    if (inference_timing_enabled_) {
+        inference_timing_file_.open(inference_timing_filename_, std::ios::out);
+        if (!inference_timing_file_.is_open()) {
+            std::cerr << "Failed to open inference timing file: " << inference_timing_filename_ << std::endl;
+            observation_file_.close();
+            raw_action_file_.close();
+            action_file_.close();
+            return false;
+        }
+        inference_timing_file_ << "timestamp,round_trip_ns,uplink_ns,server_queue_ns,compute_ns,"
+                                  "server_reply_ns,downlink_ns,clock_offset_ns" << std::endl;
+    }
+    
+    // 打开循环策略隐状态文件
+    if (recurrent_state_enabled_) {
+        recurrent_state_file_.open(recurrent_state_filename_, std::ios::out);
+        if (!recurrent_state_file_.is_open()) {
+            std::cerr << "Failed to open recurrent state file: " << recurrent_state_filename_ << std::endl;
+            observation_file_.close();
+            raw_action_file_.close();
+            action_file_.close();
+            inference_timing_file_.close();
+            return false;
+        }
+        recurrent_state_file_ << "timestamp,state_size,state_norm" << std::endl;
+    }
+    
+    // 打开影子策略动作文件
+    if (shadow_action_enabled_) {
+        shadow_action_file_.open(shadow_action_filename_, std::ios::out);
+        if (!shadow_action_file_.is_open()) {
+            std::cerr << "Failed to open shadow action file: " << shadow_action_filename_ << std::endl;
+            observation_file_.close();
+            raw_action_file_.close();
+            action_file_.close();
+            inference_timing_file_.close();
+            recurrent_state_file_.close();
+            return false;
+        }
+        shadow_action_file_ << "timestamp,seq";
+        for (const char* prefix : {"live_action", "shadow_action"}) {
+            for (int i = 0; i < 12; ++i) {
+                shadow_action_file_ << "," << prefix << "_" << i;
+            }
+        }
+        shadow_action_file_ << std::endl;
+    }
+    
     // 写入CSV头部
     WriteCSVHeader(observation_file_, 65, "obs");  // Observation有65个数据点
     WriteCSVHeader(raw_action_file_, 12, "raw_action");  // Raw action有12个数据点
@@ -65,6 +118,15 @@ bool DataLogger::Initialize() {
     std::cout << "Observation file: " << observation_filename_ << std::endl;
     std::cout << "Raw action file: " << raw_action_filename_ << std::endl;
     std::cout << "Action file: " << action_filename_ << std::endl;
+    if (inference_timing_enabled_) {
+        std::cout << "Inference timing file: " << inference_timing_filename_ << std::endl;
+    }
+    if (recurrent_state_enabled_) {
+        std::cout << "Recurrent state file: " << recurrent_state_filename_ << std::endl;
+    }
+    if (shadow_action_enabled_) {
+        std::cout << "Shadow action file: " << shadow_action_filename_ << std::endl;
+    }
     
     return true;
 }
@@ -99,6 +161,75 @@ bool DataLogger::SaveAction(int timestamp, const RobotAction& action) {
     return true;
 }
 
+bool DataLogger::SaveInferenceTiming(int timestamp, const InferenceTiming& timing) {
+    if (!initialized_) {
+        std::cerr << "Data logger not initialized!" << std::endl;
+        return false;
+    }
+    if (!inference_timing_file_.is_open()) {
+        return false;
+    }
+    
+    inference_timing_file_ << timestamp << "," << timing.round_trip_ns << "," << timing.uplink_ns << ","
+                           << timing.server_queue_ns << "," << timing.compute_ns << "," << timing.server_reply_ns << ","
+                           << timing.downlink_ns << "," << timing.clock_offset_ns << '\n';
+    return true;
+}
+
+bool DataLogger::SaveRecurrentState(int timestamp, int state_size, float state_norm) {
+    if (!initialized_) {
+        std::cerr << "Data logger not initialized!" << std::endl;
+        return false;
+    }
+    if (!recurrent_state_file_.is_open()) {
+        return false;
+    }
+    
+    recurrent_state_file_ << timestamp << "," << state_size << "," << state_norm << '\n';
+    return true;
+}
+
+bool DataLogger::SaveShadowAction(int timestamp, uint64_t seq, const float* live_action,
+                                  const float* shadow_action) {
+    if (!initialized_) {
+        std::cerr << "Data logger not initialized!" << std::endl;
+        return false;
+    }
+    if (!shadow_action_file_.is_open()) {
+        return false;
+    }
+    
+    shadow_action_file_ << timestamp << "," << seq;
+    for (const float* action : {live_action, shadow_action}) {
+        for (int i = 0; i < 12; ++i) {
+            shadow_action_file_ << "," << std::fixed << std::setprecision(6) << action[i];
+        }
+    }
+    shadow_action_file_ << '\n';
+    return true;
+}
+
+void DataLogger::Flush() {
+    if (observation_file_.is_open()) {
+        observation_file_.flush();
+    }
+    if (raw_action_file_.is_open()) {
+        raw_action_file_.flush();
+    }
+    if (action_file_.is_open()) {
+        action_file_.flush();
+    }
+    if (inference_timing_file_.is_open()) {
+        inference_timing_file_.flush();
+    }
+    if (recurrent_state_file_.is_open()) {
+        recurrent_state_file_.flush();
+    }
+    if (shadow_action_file_.is_open()) {
+        shadow_action_file_.flush();
+    }
+}
+
 void DataLogger::Close() {
     if (observation_file_.is_open()) {
         observation_file_.close();
@@ -109,6 +240,15 @@ void DataLogger::Close() {
     if (action_file_.is_open()) {
         action_file_.close();
     }
+    if (inference_timing_file_.is_open()) {
+        inference_timing_file_.close();
+    }
+    if (recurrent_state_file_.is_open()) {
+        recurrent_state_file_.close();
+    }
+    if (shadow_action_file_.is_open()) {
+        shadow_action_file_.close();
+    }
     initialized_ = false;
 }
 
@@ -133,5 +273,5 @@ void DataLogger::WriteCSVRow(std::ofstream& file, int timestamp, const std::vect
     for (const auto& value : data) {
         file << "," << std::fixed << std::setprecision(6) << value;
     }
-    file << std::endl;
+    file << '\n';
 } 
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "../include/event_reactor.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kMaxEvents = 16;
+
+}  // namespace
+
+EventReactor::EventReactor(ControlClock* clock)
+    : epoll_fd_(-1), stop_fd_(-1), running_(false), missed_timer_ticks_(0),
+      sim_clock_(clock != nullptr && clock->IsSimulated() ? static_cast<SimulatedClock*>(clock) : nullptr) {
+}
+
+EventReactor::~EventReactor() {
+    for (const auto& source : sources_) {
+        if (source->owned) {
+            close(source->fd);
+        }
+    }
+    if (stop_fd_ >= 0) {
+        close(stop_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+bool EventReactor::Initialize() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        std::cerr << "Failed to create epoll instance: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    stop_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stop_fd_ < 0) {
+        std::cerr << "Failed to create reactor stop eventfd: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;  // nullptr 表示停止事件
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stop_fd_, &ev) < 0) {
+        std::cerr << "Failed to register reactor stop eventfd: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int EventReactor::AddTimer(int64_t period_us, Handler handler) {
+    if (sim_clock_ != nullptr) {
+        if (period_us <= 0) {
+            std::cerr << "Invalid simulated timer period: " << period_us << std::endl;
+            return -1;
+        }
+        uint64_t period_ns = static_cast<uint64_t>(period_us) * 1000;
+        sim_timers_.push_back(SimTimer{period_ns, sim_clock_->NowNs() + period_ns, std::move(handler)});
+        return static_cast<int>(sim_timers_.size()) - 1;
+    }
+
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd < 0) {
+        std::cerr << "Failed to create timerfd: " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = period_us / 1000000;
+    spec.it_interval.tv_nsec = (period_us % 1000000) * 1000;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(fd, 0, &spec, nullptr) < 0) {
+        std::cerr << "Failed to arm timerfd: " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+
+    if (!Register(fd, SourceType::kTimer, true, std::move(handler))) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int EventReactor::AddNotifier(Handler handler) {
+    int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd < 0) {
+        std::cerr << "Failed to create eventfd: " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    if (!Register(fd, SourceType::kNotifier, true, std::move(handler))) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool EventReactor::AddFd(int fd, Handler handler) {
+    return Register(fd, SourceType::kFd, false, std::move(handler));
+}
+
+bool EventReactor::Register(int fd, SourceType type, bool owned, Handler handler) {
+    std::unique_ptr<Source> source(new Source{fd, type, owned, std::move(handler)});
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = source.get();
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        std::cerr << "Failed to register fd " << fd << " with epoll: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    sources_.push_back(std::move(source));
+    return true;
+}
+
+void EventReactor::Notify(int notifier_fd) {
+    uint64_t one = 1;
+    if (write(notifier_fd, &one, sizeof(one)) < 0) {
+        // 计数器已饱和时对端必然有待处理的通知，忽略
+    }
+}
+
+void EventReactor::Run() {
+    running_ = true;
+
+    if (sim_clock_ != nullptr && !sim_timers_.empty()) {
+        // 仿真时钟：不等待，fd事件处理完后直接跳到下一个定时器
+        while (running_ && PollOnce(0)) {
+            FireNextSimTimer();
+        }
+    } else {
+        while (running_ && PollOnce(-1)) {
+        }
+    }
+    running_ = false;
+}
+
+bool EventReactor::PollOnce(int timeout_ms) {
+    struct epoll_event events[kMaxEvents];
+    int ready = epoll_wait(epoll_fd_, events, kMaxEvents, timeout_ms);
+    if (ready < 0) {
+        if (errno == EINTR) {
+            return true;
+        }
+        std::cerr << "epoll_wait failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    for (int i = 0; i < ready && running_; ++i) {
+        Source* source = static_cast<Source*>(events[i].data.ptr);
+        if (source == nullptr) {
+            return false;
+        }
+
+        uint64_t count = 0;
+        if (source->type != SourceType::kFd) {
+            if (read(source->fd, &count, sizeof(count)) != sizeof(count)) {
+                continue;  // 已被消费（EAGAIN）
+            }
+            if (source->type == SourceType::kTimer && count > 1) {
+                missed_timer_ticks_ += count - 1;
+            }
+        }
+        source->handler(count);
+    }
+    return running_;
+}
+
+void EventReactor::FireNextSimTimer() {
+    // 同时到期的定时器按注册顺序触发
+    SimTimer* next = &sim_timers_[0];
+    for (SimTimer& timer : sim_timers_) {
+        if (timer.deadline_ns < next->deadline_ns) {
+            next = &timer;
+        }
+    }
+
+    sim_clock_->AdvanceTo(next->deadline_ns);
+    next->deadline_ns += next->period_ns;
+    next->handler(1);
+}
+
+void EventReactor::Stop() {
+    running_ = false;
+    if (stop_fd_ >= 0) {
+        Notify(stop_fd_);
+    }
+}
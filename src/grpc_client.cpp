@@ -1,10 +1,15 @@
 #include "../include/grpc_client.h"
+#include "../include/async_logger.h"
 #include "../include/imu_processor.h"
+#include "../include/inference_timing.h"
 #include "../include/square_wave.h"
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/security/credentials.h>
+#include <google/protobuf/arena.h>
 #include <cstdlib>
 #include <ctime>
 #include <cmath>
@@ -19,42 +24,101 @@ static SquareWaveGenerator square_wave_generator;
 // 初始化随机数种子
 static bool random_initialized = false;
 
+// 中性关节角（站立姿态），观察中的关节位置偏差与动作都以此为基准
+static const float kNeutralJointValues[12] = {
+    -0.0f, -1.0f, 1.8f,  // FL: hip, thigh, calf
+    0.0f, -1.0f, 1.8f,  // FR: hip, thigh, calf
+    -0.0f, -1.0f, 1.8f,  // HL: hip, thigh, calf
+    0.0f, -1.0f, 1.8f   // HR: hip, thigh, calf
+};
+
+// 会话推理的观察与动作以小端float32原始字节传输，直接拷贝内存
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "session payloads assume a little-endian host");
+
+/// @brief 一个在途的异步请求，作为完成队列的tag
+struct GrpcClient::AsyncCall {
+    grpc::ClientContext context;
+    inference::InferenceResponse response;
+    grpc::Status status;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<inference::InferenceResponse>> reader;
+    PredictCallback callback;
+};
+
+/// @brief 对冲请求中发往一个服务器的调用，作为 hedge_cq_ 的tag
+struct GrpcClient::HedgeCall {
+    std::unique_ptr<grpc::ClientContext> context;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<inference::InferenceResponse>> reader;
+    grpc::Status status;
+    inference::InferenceResponse* response;  // 分配在客户端的arena上，跨调用复用
+    bool pending = false;
+};
+
 GrpcClient::GrpcClient(const std::string& server_address) 
-    : server_address_(server_address), connected_(false) {
+    : server_address_(server_address), connected_(false),
+      request_deadline_(std::chrono::milliseconds(kDefaultRequestDeadlineMs)), deadline_miss_count_(0),
+      health_stop_(false), reconnect_count_(0),
+      hedge_delay_(0), hedge_count_(0), hedge_win_count_(0),
+      reused_request_(google::protobuf::Arena::CreateMessage<inference::InferenceRequest>(&arena_)),
+      reused_response_(google::protobuf::Arena::CreateMessage<inference::InferenceResponse>(&arena_)),
+      reused_batch_request_(google::protobuf::Arena::CreateMessage<inference::BatchInferenceRequest>(&arena_)),
+      reused_batch_response_(google::protobuf::Arena::CreateMessage<inference::BatchInferenceResponse>(&arena_)),
+      state_response_(nullptr), recurrent_(false), tracing_(false), session_mode_(false), session_unsupported_(false),
+      reused_step_request_(google::protobuf::Arena::CreateMessage<inference::SessionStepRequest>(&arena_)),
+      reused_step_response_(google::protobuf::Arena::CreateMessage<inference::SessionStepResponse>(&arena_)),
+      session_open_count_(0),
+      max_in_flight_(kDefaultMaxInFlight),
+      stream_pending_(0), stream_unsupported_(false), stream_open_count_(0) {
 }
 
 GrpcClient::~GrpcClient() {
-    // gRPC会自动清理资源
+    StopHealthCheck();
+
+    // 对冲请求在 PredictInPlace() 返回前都已完成，队列中没有在途操作
+    hedge_cq_.Shutdown();
+    void* hedge_tag;
+    bool hedge_ok;
+    while (hedge_cq_.Next(&hedge_tag, &hedge_ok)) {
+    }
+
+    CloseStream();
+    stream_cq_.Shutdown();
+    void* stream_tag;
+    bool stream_ok;
+    while (stream_cq_.Next(&stream_tag, &stream_ok)) {
+    }
+
+    CancelAsync();
+    cq_.Shutdown();
+    if (cq_thread_.joinable()) {
+        cq_thread_.join();
+    } else {
+        // 完成队列销毁前须取空
+        void* tag;
+        bool ok;
+        while (cq_.Next(&tag, &ok)) {
+        }
+    }
 }
 
 bool GrpcClient::Connect() {
     try {
-        // 创建不安全的通道（用于测试，生产环境应使用SSL）
-        channel_ = grpc::CreateChannel(server_address_, grpc::InsecureChannelCredentials());
-        
-        // 创建stub
-        stub_ = inference::InferenceService::NewStub(channel_);
+        // 通道与stub只创建一次：健康检查线程重连时沿用它们，推理调用线程可同时使用
+        if (channel_ == nullptr) {
+            // 创建不安全的通道（用于测试，生产环境应使用SSL）
+            channel_ = grpc::CreateCustomChannel(server_address_, grpc::InsecureChannelCredentials(),
+                                                 MakeChannelArguments());
+            stub_ = inference::InferenceService::NewStub(channel_);
+        }
         
         // 测试连接
-        grpc::ClientContext context;
-        context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
-        
-        inference::InferenceRequest request;
-        inference::InferenceResponse response;
-        
-        // 发送一个简单的测试请求
-        request.add_observation(0.0f);
-        request.set_model_type("test");
-        request.set_deterministic(true);
-        
-        grpc::Status status = stub_->Predict(&context, request, &response);
-        
-        if (status.ok()) {
+        std::string error;
+        if (Probe(stub_.get(), 5000, &error)) {
             connected_ = true;
-            std::cout << "Successfully connected to gRPC server at " << server_address_ << std::endl;
+            std::cout << "Successfully connected to gRPC server at " << server_address_
+                      << (IsUnixAddress(server_address_) ? " (unix domain socket)" : " (tcp)") << std::endl;
             return true;
         } else {
-            std::cerr << "Failed to connect to gRPC server: " << status.error_message() << std::endl;
+            std::cerr << "Failed to connect to gRPC server: " << error << std::endl;
             connected_ = false;
             return false;
         }
@@ -65,6 +129,92 @@ bool GrpcClient::Connect() {
     }
 }
 
+bool GrpcClient::Probe(inference::InferenceService::Stub* stub, int timeout_ms, std::string* error) {
+    grpc::ClientContext context;
+    context.set_deadline(std::chrono::system_clock::now() + std::chrono::milliseconds(timeout_ms));
+    
+    inference::InferenceRequest request;
+    inference::InferenceResponse response;
+    
+    // 发送一个简单的测试请求
+    request.add_observation(0.0f);
+    request.set_model_type("test");
+    request.set_deterministic(true);
+    
+    grpc::Status status = stub->Predict(&context, request, &response);
+    if (!status.ok()) {
+        *error = status.error_message();
+        return false;
+    }
+    return true;
+}
+
+void GrpcClient::StartHealthCheck(int period_ms) {
+    if (health_thread_.joinable() || stub_ == nullptr) {
+        return;
+    }
+    health_stop_ = false;
+    health_thread_ = std::thread(&GrpcClient::HealthLoop, this, period_ms);
+}
+
+void GrpcClient::StopHealthCheck() {
+    {
+        std::lock_guard<std::mutex> lock(health_mutex_);
+        health_stop_ = true;
+    }
+    health_cv_.notify_all();
+    if (health_thread_.joinable()) {
+        health_thread_.join();
+    }
+}
+
+void GrpcClient::HealthLoop(int period_ms) {
+    int backoff_ms = kMinReconnectBackoffMs;
+    std::unique_lock<std::mutex> lock(health_mutex_);
+    while (!health_stop_) {
+        int wait_ms = period_ms;
+        if (connected_) {
+            // 只查看通道状态；gRPC 在后台自行重新建立底层连接
+            grpc_connectivity_state state = channel_->GetState(true);
+            if (state == GRPC_CHANNEL_TRANSIENT_FAILURE || state == GRPC_CHANNEL_SHUTDOWN) {
+                connected_ = false;
+                backoff_ms = kMinReconnectBackoffMs;
+                std::cerr << "Lost connection to gRPC server at " << server_address_ << ", reconnecting" << std::endl;
+            }
+        }
+        if (!connected_) {
+            lock.unlock();
+            std::string error;
+            bool ok = Probe(stub_.get(), kMaxReconnectBackoffMs, &error);
+            lock.lock();
+            if (ok) {
+                connected_ = true;
+                reconnect_count_.fetch_add(1, std::memory_order_relaxed);
+                backoff_ms = kMinReconnectBackoffMs;
+                std::cout << "Reconnected to gRPC server at " << server_address_ << std::endl;
+            } else {
+                wait_ms = backoff_ms;
+                backoff_ms = std::min(backoff_ms * 2, kMaxReconnectBackoffMs);
+            }
+        }
+        health_cv_.wait_for(lock, std::chrono::milliseconds(wait_ms), [this] { return health_stop_; });
+    }
+}
+
+void GrpcClient::SetHedging(const std::string& secondary_address, std::chrono::microseconds hedge_delay) {
+    hedge_address_ = secondary_address;
+    hedge_delay_ = hedge_delay;
+    hedge_channel_ = grpc::CreateCustomChannel(secondary_address, grpc::InsecureChannelCredentials(),
+                                               MakeChannelArguments());
+    hedge_stub_ = inference::InferenceService::NewStub(hedge_channel_);
+    // 提前建立连接，首个对冲请求不必等待握手
+    hedge_channel_->GetState(true);
+    for (std::unique_ptr<HedgeCall>& call : hedge_calls_) {
+        call.reset(new HedgeCall());
+        call->response = google::protobuf::Arena::CreateMessage<inference::InferenceResponse>(&arena_);
+    }
+}
+
 inference::InferenceResponse GrpcClient::Predict(const std::vector<float>& observation, 
                                                const std::string& model_type,
                                                bool deterministic) {
@@ -78,29 +228,17 @@ inference::InferenceResponse GrpcClient::Predict(const std::vector<float>& obser
     
     try {
         grpc::ClientContext context;
-        context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(10));
+        context.set_deadline(RequestDeadlineFromNow());
         
         inference::InferenceRequest request;
-        
-        // 设置观察数据
-        for (float obs : observation) {
-            request.add_observation(obs);
-        }
-        
-        // 设置desired_goal (1个值，通常为0.0表示任务未完成)
-        request.add_desired_goal(0.0f);
-        
-        // 设置achieved_goal (1个值，通常为0.0表示任务未完成)
-        request.add_achieved_goal(0.0f);
-        
-        // 设置其他参数
-        request.set_model_type(model_type);
-        request.set_deterministic(deterministic);
+        FillRequest(observation.data(), observation.size(), model_type.c_str(), deterministic, &request);
+        StampRequest(&request);
         
         // 发送请求
         grpc::Status status = stub_->Predict(&context, request, &response);
         
         if (!status.ok()) {
+            CountDeadlineMiss(status);
             response.set_success(false);
             response.set_error_message(status.error_message());
         }
@@ -113,10 +251,668 @@ inference::InferenceResponse GrpcClient::Predict(const std::vector<float>& obser
     return response;
 }
 
+const inference::InferenceResponse& GrpcClient::PredictInPlace(const float* observation, size_t count,
+                                                               const char* model_type, bool deterministic) {
+    inference::InferenceResponse* response = reused_response_;
+
+    if (hedge_stub_ != nullptr && !session_mode_) {
+        // 主服务器断开时直接发往备用服务器
+        CarryRecurrentState();
+        FillRequest(observation, count, model_type, deterministic, reused_request_);
+        StampRequest(reused_request_);
+        return HedgedPredict();
+    }
+
+    if (!connected_) {
+        response->Clear();
+        response->set_success(false);
+        response->set_error_message("Not connected to server");
+        return *response;
+    }
+
+    if (session_mode_ && !session_unsupported_) {
+        return SessionPredict(observation, count, model_type, deterministic);
+    }
+
+    // ClientContext 不能跨调用复用，每次调用仍须新建
+    grpc::ClientContext context;
+    context.set_deadline(RequestDeadlineFromNow());
+
+    CarryRecurrentState();
+    FillRequest(observation, count, model_type, deterministic, reused_request_);
+    StampRequest(reused_request_);
+
+    // 解析前会先 Clear()，repeated字段与字符串保留上一次的容量
+    grpc::Status status = stub_->Predict(&context, *reused_request_, response);
+    if (!status.ok()) {
+        CountDeadlineMiss(status);
+        response->Clear();
+        response->set_success(false);
+        response->set_error_message(status.error_message());
+    } else if (response->success()) {
+        state_response_ = response;
+    }
+    return *response;
+}
+
+void GrpcClient::CarryRecurrentState() {
+    if (recurrent_ && state_response_ != nullptr) {
+        // 两个消息都在 arena_ 上，Swap 只交换指针；交换出的旧状态在下一次解析时被覆盖，容量得以复用
+        reused_request_->mutable_states()->Swap(state_response_->mutable_states());
+        state_response_ = nullptr;
+    }
+}
+
+void GrpcClient::ResetRecurrentState() {
+    reused_request_->clear_states();
+    state_response_ = nullptr;
+}
+
+void GrpcClient::StartHedgeCall(inference::InferenceService::Stub* stub, HedgeCall* call,
+                                std::chrono::system_clock::time_point deadline) {
+    call->context.reset(new grpc::ClientContext());
+    call->context->set_deadline(deadline);
+    call->reader = stub->PrepareAsyncPredict(call->context.get(), *reused_request_, &hedge_cq_);
+    call->reader->StartCall();
+    call->reader->Finish(call->response, &call->status, call);
+    call->pending = true;
+}
+
+const inference::InferenceResponse& GrpcClient::HedgedPredict() {
+    HedgeCall* primary = hedge_calls_[0].get();
+    HedgeCall* secondary = hedge_calls_[1].get();
+    auto deadline = RequestDeadlineFromNow();
+    auto hedge_at = std::chrono::system_clock::now() + hedge_delay_;
+
+    int pending = 0;
+    if (connected_) {
+        StartHedgeCall(stub_.get(), primary, deadline);
+        pending++;
+    }
+
+    HedgeCall* winner = nullptr;
+    HedgeCall* failed = nullptr;
+    while (winner == nullptr) {
+        // 主服务器超过对冲时限未应答、先返回了失败或已断开时，发往备用服务器
+        if (!secondary->pending && secondary->reader == nullptr &&
+            (pending == 0 || std::chrono::system_clock::now() >= hedge_at)) {
+            StartHedgeCall(hedge_stub_.get(), secondary, deadline);
+            hedge_count_.fetch_add(1, std::memory_order_relaxed);
+            pending++;
+        }
+        if (pending == 0) {
+            break;
+        }
+
+        void* tag;
+        bool ok;
+        bool hedged = secondary->reader != nullptr;
+        grpc::CompletionQueue::NextStatus next = hedge_cq_.AsyncNext(&tag, &ok, hedged ? deadline + std::chrono::seconds(1)
+                                                                                       : hedge_at);
+        if (next == grpc::CompletionQueue::TIMEOUT) {
+            continue;
+        }
+        if (next == grpc::CompletionQueue::SHUTDOWN) {
+            break;
+        }
+        HedgeCall* call = static_cast<HedgeCall*>(tag);
+        call->pending = false;
+        pending--;
+        if (call->status.ok() && call->response->success()) {
+            winner = call;
+        } else {
+            failed = call;
+        }
+    }
+
+    // 取消仍在途的另一个请求，等它完成后才能复用其消息
+    for (std::unique_ptr<HedgeCall>& call : hedge_calls_) {
+        if (call->pending) {
+            call->context->TryCancel();
+        }
+    }
+    while (pending > 0) {
+        void* tag;
+        bool ok;
+        if (!hedge_cq_.Next(&tag, &ok)) {
+            break;
+        }
+        static_cast<HedgeCall*>(tag)->pending = false;
+        pending--;
+    }
+    primary->reader.reset();
+    secondary->reader.reset();
+
+    if (winner != nullptr) {
+        if (winner == secondary) {
+            hedge_win_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+        state_response_ = winner->response;
+        return *winner->response;
+    }
+
+    inference::InferenceResponse* response = reused_response_;
+    response->Clear();
+    response->set_success(false);
+    if (failed == nullptr) {
+        response->set_error_message("Not connected to server");
+    } else if (!failed->status.ok()) {
+        CountDeadlineMiss(failed->status);
+        response->set_error_message(failed->status.error_message());
+    } else {
+        response->set_error_message(failed->response->error_message());
+    }
+    return *response;
+}
+
+bool GrpcClient::OpenSession(const char* model_type, bool deterministic, size_t observation_size,
+                             std::string* error) {
+    grpc::ClientContext context;
+    // 握手发生在推理线程上（首次推理与服务器重启后），与单个请求同样受 SetRequestDeadline() 限制
+    context.set_deadline(RequestDeadlineFromNow());
+
+    inference::OpenSessionRequest request;
+    request.set_model_type(model_type);
+    request.set_deterministic(deterministic);
+    request.set_observation_schema(kObservationSchema);
+    request.set_observation_size(static_cast<uint32_t>(observation_size));
+    request.set_action_size(static_cast<uint32_t>(kActionSize));
+
+    inference::OpenSessionResponse response;
+    grpc::Status status = stub_->OpenSession(&context, request, &response);
+    if (status.error_code() == grpc::StatusCode::UNIMPLEMENTED) {
+        std::cerr << "Server does not support OpenSession, falling back to Predict" << std::endl;
+        session_unsupported_ = true;
+    }
+    if (!status.ok()) {
+        *error = status.error_message();
+        return false;
+    }
+    if (!response.success()) {
+        *error = response.error_message();
+        return false;
+    }
+    if (response.action_size() == 0) {
+        *error = "Session: unsupported action size " + std::to_string(response.action_size());
+        return false;
+    }
+
+    Session* session = FindSession(model_type, deterministic);
+    if (session == nullptr) {
+        if (sessions_.size() >= kMaxSessions) {
+            *error = "Session: too many sessions";
+            return false;
+        }
+        sessions_.push_back(Session());
+        session = &sessions_.back();
+        session->model_type = model_type;
+        session->deterministic = deterministic;
+    }
+    session->id = response.session_id();
+    session->observation_size = static_cast<uint32_t>(observation_size);
+    session->action_size = response.action_size();
+    session->next_seq = 0;
+    session_open_count_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+GrpcClient::Session* GrpcClient::FindSession(const char* model_type, bool deterministic) {
+    for (Session& session : sessions_) {
+        if (session.deterministic == deterministic && session.model_type == model_type) {
+            return &session;
+        }
+    }
+    return nullptr;
+}
+
+grpc::Status GrpcClient::SendSessionStep(Session* session, const float* observation, size_t count) {
+    grpc::ClientContext context;
+    context.set_deadline(RequestDeadlineFromNow());
+
+    FillSessionStep(session->id, session->next_seq++, observation, count, reused_step_request_);
+    return stub_->SessionPredict(&context, *reused_step_request_, reused_step_response_);
+}
+
+void GrpcClient::StampRequest(inference::InferenceRequest* request) const {
+    if (tracing_) {
+        request->set_client_send_ns(WallClockNs());
+    }
+}
+
+void GrpcClient::FillSessionStep(uint64_t session_id, uint64_t seq, const float* observation, size_t count,
+                                 inference::SessionStepRequest* request) {
+    request->set_session_id(session_id);
+    request->set_seq(seq);
+    // resize 在容量足够时不分配
+    std::string* payload = request->mutable_observation();
+    payload->resize(count * sizeof(float));
+    if (count > 0) {
+        memcpy(&(*payload)[0], observation, count * sizeof(float));
+    }
+}
+
+const inference::InferenceResponse& GrpcClient::SessionPredict(const float* observation, size_t count,
+                                                               const char* model_type, bool deterministic) {
+    inference::InferenceResponse* response = reused_response_;
+    const inference::SessionStepResponse& step = *reused_step_response_;
+    std::string error;
+
+    if (session_unsupported_) {
+        return PredictInPlace(observation, count, model_type, deterministic);
+    }
+    Session* session = FindSession(model_type, deterministic);
+    if (session == nullptr || session->observation_size != count) {
+        // 首次推理，或观察长度改变：按当前长度（重新）协商，失败的会话在下一步重试
+        session = OpenSession(model_type, deterministic, count, &error) ? FindSession(model_type, deterministic)
+                                                                        : nullptr;
+        if (session == nullptr && session_unsupported_) {
+            return PredictInPlace(observation, count, model_type, deterministic);
+        }
+    }
+
+    if (session != nullptr) {
+        grpc::Status status = SendSessionStep(session, observation, count);
+        if (status.error_code() == grpc::StatusCode::NOT_FOUND) {
+            // 服务器丢失了会话（如重启），重新打开后重发一次
+            status = OpenSession(model_type, deterministic, count, &error)
+                ? SendSessionStep(session, observation, count)
+                : grpc::Status(grpc::StatusCode::UNAVAILABLE, error);
+        }
+
+        if (!status.ok()) {
+            CountDeadlineMiss(status);
+            error = status.error_message();
+        } else if (!step.success()) {
+            error = step.error_message();
+        } else if (step.seq() != session->next_seq - 1) {
+            error = "Session: response sequence mismatch";
+        } else if (step.action().size() != session->action_size * sizeof(float)) {
+            error = "Session: unexpected action size";
+        } else {
+            response->Clear();
+            response->set_success(true);
+            response->mutable_action()->Resize(static_cast<int>(session->action_size), 0.0f);
+            memcpy(response->mutable_action()->mutable_data(), step.action().data(), step.action().size());
+            return *response;
+        }
+    }
+
+    response->Clear();
+    response->set_success(false);
+    response->set_error_message(error);
+    return *response;
+}
+
+std::vector<inference::InferenceResponse> GrpcClient::PredictBatch(const std::vector<BatchPredictItem>& items,
+                                                                   bool deterministic) {
+    std::vector<inference::InferenceResponse> responses(items.size());
+    std::string error;
+
+    if (!connected_) {
+        error = "Not connected to server";
+    } else {
+        try {
+            // 一次调用的全部消息都在arena上分配，调用结束时一起释放
+            google::protobuf::ArenaOptions arena_options;
+            arena_options.start_block_size = 4096;
+            google::protobuf::Arena arena(arena_options);
+            auto* request = google::protobuf::Arena::CreateMessage<inference::BatchInferenceRequest>(&arena);
+            auto* response = google::protobuf::Arena::CreateMessage<inference::BatchInferenceResponse>(&arena);
+
+            for (const BatchPredictItem& item : items) {
+                inference::InferenceRequest* item_request = request->add_requests();
+                FillRequest(item.observation->data(), item.observation->size(), item.model_type.c_str(), deterministic,
+                            item_request);
+                StampRequest(item_request);
+            }
+
+            grpc::ClientContext context;
+            context.set_deadline(RequestDeadlineFromNow());
+            grpc::Status status = stub_->BatchPredict(&context, *request, response);
+
+            if (status.ok()) {
+                size_t count = std::min(items.size(), static_cast<size_t>(response->responses_size()));
+                for (size_t i = 0; i < count; ++i) {
+                    responses[i] = response->responses(static_cast<int>(i));
+                }
+                for (size_t i = count; i < items.size(); ++i) {
+                    responses[i].set_success(false);
+                    responses[i].set_error_message("Missing response in batch");
+                }
+                return responses;
+            }
+            CountDeadlineMiss(status);
+            error = status.error_message();
+        } catch (const std::exception& e) {
+            error = std::string("Exception: ") + e.what();
+        }
+    }
+
+    for (inference::InferenceResponse& response : responses) {
+        response.set_success(false);
+        response.set_error_message(error);
+    }
+    return responses;
+}
+
+const google::protobuf::RepeatedPtrField<inference::InferenceResponse>& GrpcClient::PredictBatchInPlace(
+    const std::vector<BatchPredictItem>& items, bool deterministic) {
+    const int item_count = static_cast<int>(items.size());
+    google::protobuf::RepeatedPtrField<inference::InferenceResponse>* responses =
+        reused_batch_response_->mutable_responses();
+    std::string error;  // 只在调用失败时赋值，成功的调用不构造字符串
+    bool call_ok = false;
+    int answered = 0;
+
+    if (!connected_) {
+        error = "Not connected to server";
+    } else {
+        try {
+            // 项数改变时增删请求项；RemoveLast() 只清空元素，留给之后的 Add() 复用
+            google::protobuf::RepeatedPtrField<inference::InferenceRequest>* requests =
+                reused_batch_request_->mutable_requests();
+            while (requests->size() > item_count) {
+                requests->RemoveLast();
+            }
+            while (requests->size() < item_count) {
+                requests->Add();
+            }
+            for (int i = 0; i < item_count; ++i) {
+                const BatchPredictItem& item = items[static_cast<size_t>(i)];
+                inference::InferenceRequest* item_request = requests->Mutable(i);
+                FillRequest(item.observation->data(), item.observation->size(), item.model_type.c_str(), deterministic,
+                            item_request);
+                StampRequest(item_request);
+            }
+
+            grpc::ClientContext context;
+            context.set_deadline(RequestDeadlineFromNow());
+            // 解析前会先 Clear()，各项响应保留上一次的容量
+            grpc::Status status = stub_->BatchPredict(&context, *reused_batch_request_, reused_batch_response_);
+            if (status.ok()) {
+                call_ok = true;
+                answered = std::min(item_count, responses->size());
+            } else {
+                CountDeadlineMiss(status);
+                error = status.error_message();
+            }
+        } catch (const std::exception& e) {
+            error = std::string("Exception: ") + e.what();
+        }
+    }
+
+    // 响应与items一一对应：多余的去掉，缺少的与调用失败时的各项置为失败
+    while (responses->size() > item_count) {
+        responses->RemoveLast();
+    }
+    for (int i = answered; i < item_count; ++i) {
+        inference::InferenceResponse* response = i < responses->size() ? responses->Mutable(i) : responses->Add();
+        response->Clear();
+        response->set_success(false);
+        response->set_error_message(call_ok ? "Missing response in batch" : error);
+    }
+    return *responses;
+}
+
+bool GrpcClient::PredictAsync(const std::vector<float>& observation, const std::string& model_type,
+                              PredictCallback callback, int deadline_ms, bool deterministic) {
+    if (!connected_) {
+        return false;
+    }
+
+    // 未提前启动时在首次使用时启动完成队列线程
+    StartCompletionThread();
+
+    std::unique_ptr<AsyncCall> call(new AsyncCall);
+    call->callback = std::move(callback);
+    call->context.set_deadline(std::chrono::system_clock::now() + std::chrono::milliseconds(deadline_ms));
+
+    {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        if (static_cast<int>(in_flight_calls_.size()) >= max_in_flight_) {
+            return false;
+        }
+        in_flight_calls_.insert(call.get());
+    }
+
+    inference::InferenceRequest request;
+    FillRequest(observation.data(), observation.size(), model_type.c_str(), deterministic, &request);
+    StampRequest(&request);
+
+    // 请求在 PrepareAsyncPredict 中即被序列化，不必在调用期间保留
+    AsyncCall* raw_call = call.release();
+    raw_call->reader = stub_->PrepareAsyncPredict(&raw_call->context, request, &cq_);
+    raw_call->reader->StartCall();
+    raw_call->reader->Finish(&raw_call->response, &raw_call->status, raw_call);
+    return true;
+}
+
+std::future<inference::InferenceResponse> GrpcClient::PredictAsync(const std::vector<float>& observation,
+                                                                  const std::string& model_type,
+                                                                  int deadline_ms, bool deterministic) {
+    auto promise = std::make_shared<std::promise<inference::InferenceResponse>>();
+    std::future<inference::InferenceResponse> future = promise->get_future();
+
+    bool started = PredictAsync(observation, model_type, [promise](const inference::InferenceResponse& response) {
+        promise->set_value(response);
+    }, deadline_ms, deterministic);
+
+    if (!started) {
+        inference::InferenceResponse response;
+        response.set_success(false);
+        response.set_error_message(connected_ ? "Too many requests in flight" : "Not connected to server");
+        promise->set_value(response);
+    }
+    return future;
+}
+
+void GrpcClient::StartCompletionThread() {
+    std::call_once(cq_thread_once_, [this]() {
+        cq_thread_ = std::thread(&GrpcClient::CompletionLoop, this);
+    });
+}
+
+void GrpcClient::SetMaxInFlight(int max_in_flight) {
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    max_in_flight_ = max_in_flight < 1 ? 1 : max_in_flight;
+}
+
+int GrpcClient::InFlightCount() {
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    return static_cast<int>(in_flight_calls_.size());
+}
+
+void GrpcClient::CancelAsync() {
+    std::unique_lock<std::mutex> lock(async_mutex_);
+    for (AsyncCall* call : in_flight_calls_) {
+        call->context.TryCancel();
+    }
+    async_cv_.wait(lock, [this]() { return in_flight_calls_.empty(); });
+}
+
+void GrpcClient::CompletionLoop() {
+    void* tag;
+    bool ok;
+    while (cq_.Next(&tag, &ok)) {
+        AsyncCall* call = static_cast<AsyncCall*>(tag);
+        if (!ok) {
+            call->response.set_success(false);
+            call->response.set_error_message("Completion queue error");
+        } else if (!call->status.ok()) {
+            call->response.set_success(false);
+            call->response.set_error_message(call->status.error_message());
+        }
+
+        call->callback(call->response);
+
+        {
+            std::lock_guard<std::mutex> lock(async_mutex_);
+            in_flight_calls_.erase(call);
+        }
+        async_cv_.notify_all();
+        delete call;
+    }
+}
+
+inference::InferenceResponse GrpcClient::StreamPredict(const std::vector<float>& observation,
+                                                       const std::string& model_type,
+                                                       bool deterministic, int timeout_ms) {
+    if (!connected_ || stream_unsupported_) {
+        return Predict(observation, model_type, deterministic);
+    }
+
+    auto deadline = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout_ms);
+    inference::InferenceResponse response;
+    std::string error;
+
+    bool ok = stream_ != nullptr || OpenStream(deadline, &error);
+    if (ok) {
+        inference::InferenceRequest request;
+        FillRequest(observation.data(), observation.size(), model_type.c_str(), deterministic, &request);
+        StampRequest(&request);
+
+        stream_->Write(request, reinterpret_cast<void*>(kStreamWrite));
+        stream_->Read(&response, reinterpret_cast<void*>(kStreamRead));
+        stream_pending_ |= kStreamWrite | kStreamRead;
+        ok = WaitStream(deadline, &error);
+    }
+    if (ok) {
+        return response;
+    }
+
+    // 出错后关闭流，下次调用时重新打开
+    grpc::Status status = ResetStream(false);
+    if (status.error_code() == grpc::StatusCode::UNIMPLEMENTED) {
+        std::cerr << "Server does not implement StreamPredict, falling back to unary Predict" << std::endl;
+        stream_unsupported_ = true;
+        return Predict(observation, model_type, deterministic);
+    }
+    if (!status.ok() && status.error_code() != grpc::StatusCode::CANCELLED) {
+        error = status.error_message();
+    }
+
+    response.Clear();
+    response.set_success(false);
+    response.set_error_message("Stream: " + error);
+    return response;
+}
+
+void GrpcClient::CloseStream() {
+    if (stream_ != nullptr) {
+        ResetStream(true);
+    }
+}
+
+bool GrpcClient::OpenStream(std::chrono::system_clock::time_point deadline, std::string* error) {
+    stream_context_.reset(new grpc::ClientContext);
+    stream_ = stub_->PrepareAsyncStreamPredict(stream_context_.get(), &stream_cq_);
+    stream_->StartCall(reinterpret_cast<void*>(kStreamStart));
+    stream_pending_ |= kStreamStart;
+    stream_open_count_.fetch_add(1, std::memory_order_relaxed);
+    return WaitStream(deadline, error);
+}
+
+bool GrpcClient::WaitStream(std::chrono::system_clock::time_point deadline, std::string* error) {
+    bool all_ok = true;
+    while (stream_pending_ != 0) {
+        void* tag;
+        bool ok;
+        grpc::CompletionQueue::NextStatus next = stream_cq_.AsyncNext(&tag, &ok, deadline);
+        if (next != grpc::CompletionQueue::GOT_EVENT) {
+            *error = "timed out";
+            return false;
+        }
+        stream_pending_ &= ~static_cast<int>(reinterpret_cast<intptr_t>(tag));
+        if (!ok && all_ok) {
+            // 读写失败意味着流已断开，具体原因由 ResetStream() 的最终状态给出
+            *error = "stream closed";
+            all_ok = false;
+        }
+    }
+    return all_ok;
+}
+
+grpc::Status GrpcClient::ResetStream(bool graceful) {
+    const auto kCloseTimeout = std::chrono::milliseconds(100);
+    std::string error;
+
+    if (stream_pending_ != 0) {
+        // 仍有读写在途（超时），只能取消；取消后在途操作会很快完成，须全部取回后才能销毁流
+        stream_context_->TryCancel();
+        WaitStream(std::chrono::system_clock::time_point::max(), &error);
+    } else if (graceful) {
+        stream_->WritesDone(reinterpret_cast<void*>(kStreamWritesDone));
+        stream_pending_ |= kStreamWritesDone;
+        WaitStream(std::chrono::system_clock::now() + kCloseTimeout, &error);
+    }
+
+    // 流已由服务器结束时，Finish 取回其最终状态（例如 UNIMPLEMENTED）；否则超时后取消
+    grpc::Status status;
+    stream_->Finish(&status, reinterpret_cast<void*>(kStreamFinish));
+    stream_pending_ |= kStreamFinish;
+    if (!WaitStream(std::chrono::system_clock::now() + kCloseTimeout, &error)) {
+        stream_context_->TryCancel();
+        WaitStream(std::chrono::system_clock::time_point::max(), &error);
+    }
+
+    stream_.reset();
+    stream_context_.reset();
+    return status;
+}
+
+void GrpcClient::FillRequest(const float* observation, size_t count, const char* model_type,
+                             bool deterministic, inference::InferenceRequest* request) {
+    // 设置观察数据：一次调整长度后整块拷贝
+    google::protobuf::RepeatedField<float>* request_observation = request->mutable_observation();
+    request_observation->Resize(static_cast<int>(count), 0.0f);
+    if (count > 0) {
+        memcpy(request_observation->mutable_data(), observation, count * sizeof(float));
+    }
+    
+    // 设置desired_goal (1个值，通常为0.0表示任务未完成)
+    request->mutable_desired_goal()->Resize(1, 0.0f);
+    request->set_desired_goal(0, 0.0f);
+    
+    // 设置achieved_goal (1个值，通常为0.0表示任务未完成)
+    request->mutable_achieved_goal()->Resize(1, 0.0f);
+    request->set_achieved_goal(0, 0.0f);
+    
+    // 设置其他参数（模型类型不变时不重新赋值）
+    if (request->model_type() != model_type) {
+        request->set_model_type(model_type);
+    }
+    request->set_deterministic(deterministic);
+}
+
 bool GrpcClient::IsConnected() const {
     return connected_;
 }
 
+bool GrpcClient::IsUnixAddress(const std::string& server_address) {
+    return server_address.compare(0, 5, "unix:") == 0 || server_address.compare(0, 14, "unix-abstract:") == 0;
+}
+
+grpc::ChannelArguments GrpcClient::MakeChannelArguments() {
+    grpc::ChannelArguments args;
+
+    // 观察与动作都只有几百字节，压缩只会增加延迟
+    args.SetCompressionAlgorithm(GRPC_COMPRESS_NONE);
+
+    // 每个请求都有各自的截止时间，失败由调用者处理；关闭重试省去对请求消息的缓存
+    args.SetInt(GRPC_ARG_ENABLE_RETRIES, 0);
+
+    // BDP探测用于为大消息调整流控窗口，对小消息只是多余的ping
+    args.SetInt(GRPC_ARG_HTTP2_BDP_PROBE, 0);
+
+    // 有调用在途（如流式推理的长连接流）时每10秒探测一次，1秒内无回应即判定连接断开
+    args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS, 10000);
+    args.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, 1000);
+
+    // 独占子通道，不与进程内的其他通道共用连接
+    args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    return args;
+}
+
 struct Acceleration {
     float ax;
     float ay;
@@ -143,6 +939,16 @@ void gravity_compensation(const ImuData& imu, float g, Acceleration& acc)
 
 Observation ConvertRobotDataToObservation(const RobotData& robot_data, const std::vector<float>& action_data, const RobotMoveCommand& robot_move_command) {
     Observation obs;
+    ConvertRobotDataToObservation(robot_data, action_data, robot_move_command, &obs);
+    return obs;
+}
+
+void ConvertRobotDataToObservation(const RobotData& robot_data, const std::vector<float>& action_data,
+                                   const RobotMoveCommand& robot_move_command, Observation* observation) {
+    // 复用已有容量，稳态下不分配内存
+    Observation& obs = *observation;
+    obs.data.clear();
+    obs.data.reserve(kObservationSize);
 
     Acceleration acc;
     gravity_compensation(robot_data.imu, 9.80665f, acc);
@@ -187,15 +993,8 @@ Observation ConvertRobotDataToObservation(const RobotData& robot_data, const std
     //                         "FR_HipX_joint": 0.0, "FR_HipY_joint": -0.8, "FR_Knee_joint": 1.5,
     //                         "HL_HipX_joint": 0.0, "HL_HipY_joint": -1.0, "HL_Knee_joint": 1.5,
     //                         "HR_HipX_joint": 0.0, "HR_HipY_joint": -1.0, "HR_Knee_joint": 1.5},
-    const std::vector<float> neutral_joint_values = {
-        -0.0f, -1.0f, 1.8f,  // FL: hip, thigh, calf
-        0.0f, -1.0f, 1.8f,  // FR: hip, thigh, calf
-        -0.0f, -1.0f, 1.8f,  // HL: hip, thigh, calf
-        0.0f, -1.0f, 1.8f   // HR: hip, thigh, calf
-    };
-    
     for (int i = 0; i < 12; ++i) {
-        obs.data.push_back(robot_data.joint_data.joint_data[i].position - neutral_joint_values[i]);
+        obs.data.push_back(robot_data.joint_data.joint_data[i].position - kNeutralJointValues[i]);
     }
     
     // 7. 关节速度 (12个值)
@@ -213,8 +1012,6 @@ Observation ConvertRobotDataToObservation(const RobotData& robot_data, const std
         const float BODY_HEIGHT_TARGET = 0.0f; // 从 Python 程序中打印获得的目标高度。与初始关节角和机器人构型相关，更改默认关节角需要从新获得这个值
         obs.data.push_back(BODY_HEIGHT_TARGET);
     }
-    
-    return obs;
 }
 
 // 配置参数，对应Python代码中的LeggedObsConfig
@@ -364,51 +1161,50 @@ std::vector<float> getNoiseScaleVec() {
 
 Observation ApplyObservationScalingAndNoise(const Observation& obs) {
     Observation processed_obs;
-    
+    ApplyObservationScalingAndNoise(obs, &processed_obs);
+    return processed_obs;
+}
+
+void ApplyObservationScalingAndNoise(const Observation& obs, Observation* processed_obs) {
     if (obs.data.size() != 65) {
-        std::cerr << "Warning: Observation data size is " << obs.data.size() 
-                  << " (expected 65), skipping scaling and noise" << std::endl;
-        return obs;
+        ASYNC_LOG_EVERY_MS(kLogWarn, 1000, "Warning: Observation data size is {} (expected 65), skipping scaling and noise",
+                           obs.data.size());
+        processed_obs->data = obs.data;
+        return;
     }
     
-    // 获取缩放和噪声向量
-    std::vector<float> scale_vec = getObsScaleVec();
-    std::vector<float> noise_vec = getNoiseScaleVec();
+    // 缩放和噪声向量只依赖静态配置，首次调用时生成
+    static const std::vector<float> scale_vec = getObsScaleVec();
+    static const std::vector<float> noise_vec = getNoiseScaleVec();
     
-    // 应用缩放和噪声
+    // 应用缩放和噪声（复用输出的容量）
+    processed_obs->data.clear();
+    processed_obs->data.reserve(kObservationSize);
     for (size_t i = 0; i < obs.data.size(); ++i) {
         float scaled_value = obs.data[i] * scale_vec[i];
         float noise = noise_vec[i] * generateUniformNoise();
-        processed_obs.data.push_back(scaled_value + noise);
+        processed_obs->data.push_back(scaled_value + noise);
     }
-    
-    return processed_obs;
 }
 
 RobotCmd CreateRobotCmd(const RobotAction& action) {
     RobotCmd cmd;
     
-    // 初始化所有关节命令
+    // 初始化所有关节命令：位置为中立姿态，动作不足12个（如推理失败得到的空动作）时保持中立姿态，
+    // 而不是命令所有关节回到0位
     for (int i = 0; i < 12; ++i) {
-        cmd.joint_cmd[i].position = 0.0f;
+        cmd.joint_cmd[i].position = kNeutralJointValues[i];
         cmd.joint_cmd[i].velocity = 0.0f;
         cmd.joint_cmd[i].torque = 0.0f;
         cmd.joint_cmd[i].kp = 0.0f;  // 默认比例增益
         cmd.joint_cmd[i].kd = 0.0f;   // 默认微分增益
     }
 
-    const std::vector<float> neutral_joint_values = {
-        -0.0f, -1.0f, 1.8f,  // FL: hip, thigh, calf
-        0.0f, -1.0f, 1.8f,  // FR: hip, thigh, calf
-        -0.0f, -1.0f, 1.8f,  // HL: hip, thigh, calf
-        0.0f, -1.0f, 1.8f   // HR: hip, thigh, calf
-    };
-
 
     // 如果动作数据足够，则设置关节位置
     if (action.data.size() >= 12) {
         for (int i = 0; i < 12; ++i) {
-            cmd.joint_cmd[i].position = action.data[i] + neutral_joint_values[i];
+            cmd.joint_cmd[i].position = action.data[i] + kNeutralJointValues[i];
         }
     }
     
@@ -416,11 +1212,25 @@ RobotCmd CreateRobotCmd(const RobotAction& action) {
 }
 
 RobotAction ConvertResponseToAction(const inference::InferenceResponse& response) {
-    RobotAction action;
+    if (!response.success()) {
+        std::cerr << "Inference failed: " << response.error_message() << std::endl;
+        return RobotAction();
+    }
     
+    std::vector<float> raw_action(response.action().begin(), response.action().end());
+    return ConvertRawActionToAction(raw_action);
+}
+
+RobotAction ConvertRawActionToAction(const std::vector<float>& raw_action) {
+    RobotAction action;
+    ConvertRawActionToAction(raw_action, &action);
+    return action;
+}
+
+void ConvertRawActionToAction(const std::vector<float>& raw_action, RobotAction* action) {
     // 定义动作缩放因子，对应12个关节
     // 顺序：FL_HipX, FL_HipY, FL_Knee, FR_HipX, FR_HipY, FR_Knee, HL_HipX, HL_HipY, HL_Knee, HR_HipX, HR_HipY, HR_Knee
-    const std::vector<float> action_scale = {
+    static const float action_scale[kActionSize] = {
         0.25f,    // FL_HipX_joint: range="-0.523 0.523", neutral=0.0
         0.25f,    // FL_HipY_joint: range="-2.67 0.314", neutral=-1.0
         0.25f,    // FL_Knee_joint: range="0.524 2.792", neutral=1.8
@@ -438,21 +1248,17 @@ RobotAction ConvertResponseToAction(const inference::InferenceResponse& response
         0.25f,    // HR_Knee_joint: range="0.524 2.792", neutral=1.8
     };
     
-    if (response.success()) {
-        // 将响应中的动作数据复制到RobotAction结构，并应用缩放
-        for (int i = 0; i < response.action_size(); ++i) {
-            float scaled_action = response.action(i);
-            
-            // 应用缩放因子（如果索引在范围内）
-            if (i < action_scale.size()) {
-                scaled_action *= action_scale[i];
-            }
-            
-            action.data.push_back(scaled_action);
+    // 将原始动作数据复制到RobotAction结构（复用其容量），并应用缩放
+    action->data.clear();
+    action->data.reserve(kActionSize);
+    for (size_t i = 0; i < raw_action.size(); ++i) {
+        float scaled_action = raw_action[i];
+        
+        // 应用缩放因子（如果索引在范围内）
+        if (i < kActionSize) {
+            scaled_action *= action_scale[i];
         }
-    } else {
-        std::cerr << "Inference failed: " << response.error_message() << std::endl;
+        
+        action->data.push_back(scaled_action);
     }
-    
-    return action;
-} 
\ No newline at end of file
+}
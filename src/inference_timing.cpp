@@ -0,0 +1,63 @@
+#include "../include/inference_timing.h"
+#include <time.h>
+
+int64_t WallClockNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + static_cast<int64_t>(ts.tv_nsec);
+}
+
+ClockOffsetEstimator::ClockOffsetEstimator() {
+    Reset();
+}
+
+void ClockOffsetEstimator::Reset() {
+    samples_.fill(Sample{0, 0});
+    sample_count_ = 0;
+    offset_ns_ = 0;
+    delay_ns_ = 0;
+}
+
+void ClockOffsetEstimator::AddSample(int64_t client_send_ns, int64_t server_receive_ns, int64_t server_send_ns,
+                                     int64_t client_receive_ns) {
+    Sample sample;
+    sample.offset_ns = ((server_receive_ns - client_send_ns) + (server_send_ns - client_receive_ns)) / 2;
+    sample.delay_ns = (client_receive_ns - client_send_ns) - (server_send_ns - server_receive_ns);
+    samples_[sample_count_ % kWindow] = sample;
+    sample_count_++;
+
+    // 窗口很小，每次重新扫描即可
+    size_t count = sample_count_ < kWindow ? static_cast<size_t>(sample_count_) : kWindow;
+    const Sample* best = &samples_[0];
+    for (size_t i = 1; i < count; ++i) {
+        if (samples_[i].delay_ns < best->delay_ns) {
+            best = &samples_[i];
+        }
+    }
+    offset_ns_ = best->offset_ns;
+    delay_ns_ = best->delay_ns;
+}
+
+bool ComputeInferenceTiming(const inference::InferenceResponse& response, int64_t client_receive_ns,
+                            ClockOffsetEstimator* estimator, InferenceTiming* timing) {
+    *timing = InferenceTiming();
+    int64_t t1 = response.client_send_ns();
+    int64_t t2 = response.server_receive_ns();
+    int64_t t3 = response.server_send_ns();
+    if (t1 == 0 || t2 == 0 || t3 == 0 || response.compute_start_ns() == 0 || response.compute_end_ns() == 0) {
+        return false;
+    }
+
+    estimator->AddSample(t1, t2, t3, client_receive_ns);
+    int64_t offset = estimator->Offset();
+
+    timing->valid = true;
+    timing->round_trip_ns = client_receive_ns - t1;
+    timing->uplink_ns = (t2 - offset) - t1;
+    timing->server_queue_ns = response.compute_start_ns() - t2;
+    timing->compute_ns = response.compute_end_ns() - response.compute_start_ns();
+    timing->server_reply_ns = t3 - response.compute_end_ns();
+    timing->downlink_ns = client_receive_ns - (t3 - offset);
+    timing->clock_offset_ns = offset;
+    return true;
+}
@@ -0,0 +1,440 @@
+#include "../include/inference_worker.h"
+#include "../include/async_logger.h"
+#include "../include/event_reactor.h"
+#include "../include/trace_recorder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+
+int64_t ToMicroseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+}  // namespace
+
+InferenceWorker::InferenceWorker(InferenceBackend* backend)
+    : backend_(backend), name_("inference"), client_(dynamic_cast<GrpcClient*>(backend)), profiler_(nullptr), clock_(nullptr), completion_notifier_fd_(-1), running_(false), event_fd_(-1),
+      async_(false), streaming_(false), async_deadline_ms_(GrpcClient::kDefaultAsyncDeadlineMs), published_seq_(0),
+      tracing_(false), failure_log_site_(1000, false),
+      request_observation_(kObservationSize, 0.0f), backend_state_epoch_(0), backend_state_model_(nullptr),
+      reload_requested_(false),
+      next_seq_(1), state_epoch_(0), submitted_(0), overwritten_(0), control_ticks_(0), stale_ticks_(0), aged_ticks_(0),
+      max_action_age_us_(0), total_action_age_us_(0), completed_(0), failed_(0), superseded_(0),
+      state_resets_(0) {
+}
+
+InferenceWorker::~InferenceWorker() {
+    Stop();
+}
+
+void InferenceWorker::SetProfiler(PhaseProfiler* profiler) {
+    profiler_ = profiler;
+}
+
+void InferenceWorker::SetCompletionNotifier(int notifier_fd) {
+    completion_notifier_fd_.store(notifier_fd, std::memory_order_release);
+}
+
+void InferenceWorker::SetAsync(int max_in_flight, int deadline_ms) {
+    if (client_ == nullptr) {
+        std::cerr << "Async inference requires a gRPC backend" << std::endl;
+        return;
+    }
+    async_ = true;
+    async_deadline_ms_ = deadline_ms;
+    client_->SetMaxInFlight(max_in_flight);
+    // 在此启动而非首次请求时，使完成队列线程不继承控制线程的实时调度与CPU绑定
+    client_->StartCompletionThread();
+}
+
+void InferenceWorker::SetStreaming(bool streaming) {
+    if (streaming && client_ == nullptr) {
+        std::cerr << "Streaming inference requires a gRPC backend" << std::endl;
+        return;
+    }
+    streaming_ = streaming;
+}
+
+void InferenceWorker::SetTracing(bool tracing) {
+    if (client_ == nullptr) {
+        // 非gRPC后端从不追踪，关闭追踪无需处理
+        if (tracing) {
+            std::cerr << "Inference tracing requires a gRPC backend" << std::endl;
+        }
+        return;
+    }
+    tracing_ = tracing;
+    client_->SetTracing(tracing);
+}
+
+bool InferenceWorker::SetBatchModels(const std::vector<const char*>& model_types) {
+    if (model_types.size() > static_cast<size_t>(kMaxBatchModels)) {
+        std::cerr << "At most " << kMaxBatchModels << " models can be evaluated per batch" << std::endl;
+        return false;
+    }
+
+    if (!model_types.empty() && client_ == nullptr) {
+        std::cerr << "Batch inference requires a gRPC backend" << std::endl;
+        return false;
+    }
+
+    batch_items_.clear();
+    for (const char* model_type : model_types) {
+        batch_items_.push_back({&request_observation_, model_type});
+    }
+    return true;
+}
+
+bool InferenceWorker::Start() {
+    if (running_) {
+        return true;
+    }
+
+    event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (event_fd_ < 0) {
+        std::cerr << "Failed to create inference worker eventfd: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread(&InferenceWorker::Run, this);
+    return true;
+}
+
+void InferenceWorker::Stop() {
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    uint64_t one = 1;
+    if (write(event_fd_, &one, sizeof(one)) < 0) {
+        // 线程会在轮询超时后退出
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    close(event_fd_);
+    event_fd_ = -1;
+
+    // 工作线程退出后不再发出新请求，取消在途请求并等待其回调结束
+    if (async_) {
+        client_->CancelAsync();
+    }
+}
+
+void InferenceWorker::SubmitObservation(const std::vector<float>& observation, const char* model_type) {
+    ObservationSample& sample = observation_buffer_.WriteBuffer();
+
+    size_t count = std::min(observation.size(), sample.data.size());
+    std::copy(observation.begin(), observation.begin() + count, sample.data.begin());
+    std::fill(sample.data.begin() + count, sample.data.end(), 0.0f);
+    sample.model_type = model_type;
+    sample.seq = next_seq_++;
+    sample.stamp = Now();
+    sample.state_epoch = state_epoch_;
+
+    if (observation_buffer_.Publish()) {
+        overwritten_.fetch_add(1, std::memory_order_relaxed);
+    }
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+
+    // 唤醒推理线程（eventfd写入不会阻塞）
+    uint64_t one = 1;
+    if (write(event_fd_, &one, sizeof(one)) < 0) {
+        // 计数器溢出时推理线程必然已有待处理通知，忽略
+    }
+}
+
+bool InferenceWorker::FetchLatestAction(ActionSample* action) {
+    bool updated = action_buffer_.Update();
+    *action = action_buffer_.ReadBuffer();
+    return updated;
+}
+
+void InferenceWorker::RecordControlTick() {
+    const ActionSample& action = action_buffer_.ReadBuffer();
+    uint64_t latest_seq = next_seq_ - 1;
+
+    control_ticks_.fetch_add(1, std::memory_order_relaxed);
+    if (action.seq == 0 || action.seq < latest_seq) {
+        stale_ticks_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (action.seq == 0) {
+        return;
+    }
+
+    int64_t age_us = ToMicroseconds(Now() - action.obs_stamp);
+    aged_ticks_.fetch_add(1, std::memory_order_relaxed);
+    total_action_age_us_.fetch_add(age_us, std::memory_order_relaxed);
+    if (age_us > max_action_age_us_.load(std::memory_order_relaxed)) {
+        max_action_age_us_.store(age_us, std::memory_order_relaxed);
+    }
+}
+
+void InferenceWorker::ResetRecurrentState() {
+    ++state_epoch_;
+}
+
+InferenceWorkerStats InferenceWorker::GetStats() const {
+    InferenceWorkerStats stats;
+    stats.submitted = submitted_.load(std::memory_order_relaxed);
+    stats.overwritten = overwritten_.load(std::memory_order_relaxed);
+    stats.completed = completed_.load(std::memory_order_relaxed);
+    stats.failed = failed_.load(std::memory_order_relaxed);
+    stats.superseded = superseded_.load(std::memory_order_relaxed);
+    stats.control_ticks = control_ticks_.load(std::memory_order_relaxed);
+    stats.stale_ticks = stale_ticks_.load(std::memory_order_relaxed);
+    stats.max_action_age_ms = max_action_age_us_.load(std::memory_order_relaxed) / 1000.0;
+    stats.state_resets = state_resets_.load(std::memory_order_relaxed);
+
+    uint64_t aged_ticks = aged_ticks_.load(std::memory_order_relaxed);
+    stats.mean_action_age_ms = aged_ticks > 0
+        ? total_action_age_us_.load(std::memory_order_relaxed) / 1000.0 / aged_ticks
+        : 0.0;
+    return stats;
+}
+
+void InferenceWorker::PrintStats() const {
+    InferenceWorkerStats stats = GetStats();
+    std::cout << "Inference worker";
+    if (std::strcmp(name_, "inference") != 0) {
+        std::cout << " (" << name_ << ")";
+    }
+    std::cout << ": submitted " << stats.submitted
+              << ", overwritten " << stats.overwritten
+              << ", completed " << stats.completed
+              << ", failed " << stats.failed;
+    if (async_) {
+        std::cout << ", superseded " << stats.superseded;
+    }
+    if (streaming_) {
+        std::cout << ", stream opened " << client_->StreamOpenCount() << " time(s)";
+    }
+    if (client_ != nullptr && client_->SessionOpenCount() > 0) {
+        std::cout << ", session opened " << client_->SessionOpenCount() << " time(s)";
+    }
+    if (client_ != nullptr && client_->DeadlineMissCount() > 0) {
+        std::cout << ", deadline missed " << client_->DeadlineMissCount();
+    }
+    if (client_ != nullptr && client_->ReconnectCount() > 0) {
+        std::cout << ", reconnected " << client_->ReconnectCount() << " time(s)";
+    }
+    if (client_ != nullptr && client_->HedgeCount() > 0) {
+        std::cout << ", hedged " << client_->HedgeCount() << " (secondary used " << client_->HedgeWinCount() << ")";
+    }
+    if (stats.state_resets > 0) {
+        std::cout << ", recurrent state reset " << stats.state_resets << " time(s)";
+    }
+    std::cout << std::endl;
+    if (stats.control_ticks > 0) {
+        std::cout << "Action freshness: stale ticks " << stats.stale_ticks << "/" << stats.control_ticks
+                  << ", mean age " << stats.mean_action_age_ms << " ms"
+                  << ", max age " << stats.max_action_age_ms << " ms" << std::endl;
+    }
+}
+
+bool InferenceWorker::WaitForObservation() {
+    struct pollfd pfd;
+    pfd.fd = event_fd_;
+    pfd.events = POLLIN;
+
+    int ret = poll(&pfd, 1, 100);
+    if (ret <= 0) {
+        return false;
+    }
+
+    uint64_t count;
+    if (read(event_fd_, &count, sizeof(count)) < 0) {
+        return false;
+    }
+    return true;
+}
+
+void InferenceWorker::Run() {
+    TraceRecorder::Instance().SetThreadName(name_);
+    while (running_) {
+        if (!WaitForObservation() || !running_) {
+            continue;
+        }
+        if (!observation_buffer_.Update()) {
+            continue;
+        }
+
+        const ObservationSample& observation = observation_buffer_.ReadBuffer();
+        if (reload_requested_.exchange(false, std::memory_order_acq_rel)) {
+            // 加载在推理线程上完成，控制线程在此期间继续使用上一个动作
+            std::string error;
+            if (backend_->ReloadModel(observation.model_type, &error)) {
+                ASYNC_LOG(kLogInfo, "Reloaded model {} ({})", observation.model_type, name_);
+            } else {
+                ASYNC_LOG(kLogError, "Failed to reload model {} ({}): {}", observation.model_type, name_, error);
+            }
+        }
+        std::copy(observation.data.begin(), observation.data.end(), request_observation_.begin());
+
+        if (async_) {
+            RunAsync(observation);
+            continue;
+        }
+        if (!batch_items_.empty()) {
+            RunBatch(observation);
+            continue;
+        }
+
+        // 一元调用复用后端持有的请求与响应，动作直接从响应中拷出
+        inference::InferenceResponse stream_response;
+        const inference::InferenceResponse* response = &stream_response;
+        {
+            ScopedPhase phase(profiler_, kPhaseInference);
+            if (streaming_) {
+                // 流上的响应同样以一元请求的截止时间为限
+                int timeout_ms = static_cast<int>((client_->RequestDeadline().count() + 999) / 1000);
+                stream_response = client_->StreamPredict(request_observation_, observation.model_type, true,
+                                                         std::max(timeout_ms, 1));
+            } else {
+                // 重新站立或切换模型后，循环策略从初始隐状态开始
+                if (backend_state_model_ != nullptr &&
+                    (observation.state_epoch != backend_state_epoch_ ||
+                     std::strcmp(observation.model_type, backend_state_model_) != 0)) {
+                    backend_->ResetRecurrentState();
+                    state_resets_.fetch_add(1, std::memory_order_relaxed);
+                }
+                backend_state_epoch_ = observation.state_epoch;
+                backend_state_model_ = observation.model_type;
+                response = &backend_->PredictInPlace(request_observation_.data(), request_observation_.size(),
+                                                     observation.model_type, true);
+            }
+        }
+        TraceResponse(*response, WallClockNs());
+
+        PublishAction(*response, observation.seq, observation.stamp);
+    }
+}
+
+void InferenceWorker::RunBatch(const ObservationSample& observation) {
+    // 响应归客户端所有，在下一次批量推理前有效；发布时直接从中拷出各模型的动作
+    const google::protobuf::RepeatedPtrField<inference::InferenceResponse>* responses;
+    {
+        ScopedPhase phase(profiler_, kPhaseInference);
+        responses = &client_->PredictBatchInPlace(batch_items_, true);
+    }
+    int64_t receive_ns = WallClockNs();
+
+    // 提交时所选的模型作为主输出；未参与批量评估时取第一个模型
+    size_t primary = 0;
+    for (size_t i = 0; i < batch_items_.size(); ++i) {
+        if (batch_items_[i].model_type == observation.model_type) {
+            primary = i;
+            break;
+        }
+    }
+    TraceResponse(responses->Get(static_cast<int>(primary)), receive_ns);
+    PublishAction(responses->Get(static_cast<int>(primary)), observation.seq, observation.stamp, responses);
+}
+
+void InferenceWorker::RunAsync(const ObservationSample& observation) {
+    // 请求的分配与序列化都在推理线程上，响应由完成队列线程发布
+    uint64_t seq = observation.seq;
+    std::chrono::steady_clock::time_point stamp = observation.stamp;
+    uint64_t start_ns = PhaseProfiler::NowNs();
+    bool sent = client_->PredictAsync(request_observation_, observation.model_type,
+        [this, seq, stamp, start_ns](const inference::InferenceResponse& response) {
+            OnAsyncResponse(response, seq, stamp, start_ns);
+        }, async_deadline_ms_, true);
+    if (!sent) {
+        overwritten_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void InferenceWorker::OnAsyncResponse(const inference::InferenceResponse& response, uint64_t seq,
+                                      std::chrono::steady_clock::time_point obs_stamp, uint64_t start_ns) {
+    if (profiler_ != nullptr) {
+        profiler_->Record(kPhaseInference, PhaseProfiler::NowNs() - start_ns);
+    }
+    TraceResponse(response, WallClockNs());
+
+    // 多个请求在途时响应可能乱序到达，只发布比已发布动作更新的结果
+    if (response.success() && seq <= published_seq_) {
+        superseded_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (PublishAction(response, seq, obs_stamp)) {
+        published_seq_ = seq;
+    }
+}
+
+void InferenceWorker::TraceResponse(const inference::InferenceResponse& response, int64_t receive_ns) {
+    if (!tracing_ || !ComputeInferenceTiming(response, receive_ns, &clock_offset_, &timing_)) {
+        timing_ = InferenceTiming();
+        return;
+    }
+    if (profiler_ != nullptr) {
+        // 时钟偏差估计有误差时单个样本的上下行可能为负，计为0
+        profiler_->Record(kPhaseUplink, static_cast<uint64_t>(std::max<int64_t>(timing_.uplink_ns, 0)));
+        profiler_->Record(kPhaseServerQueue, static_cast<uint64_t>(std::max<int64_t>(timing_.server_queue_ns, 0)));
+        profiler_->Record(kPhaseCompute, static_cast<uint64_t>(std::max<int64_t>(timing_.compute_ns, 0)));
+        profiler_->Record(kPhaseServerReply, static_cast<uint64_t>(std::max<int64_t>(timing_.server_reply_ns, 0)));
+        profiler_->Record(kPhaseDownlink, static_cast<uint64_t>(std::max<int64_t>(timing_.downlink_ns, 0)));
+    }
+}
+
+bool InferenceWorker::PublishAction(const inference::InferenceResponse& response, uint64_t seq,
+                                    std::chrono::steady_clock::time_point obs_stamp,
+                                    const google::protobuf::RepeatedPtrField<inference::InferenceResponse>* batch_responses) {
+    auto invalid = [](const inference::InferenceResponse& candidate) {
+        return !candidate.success() || candidate.action_size() < static_cast<int>(kActionSize);
+    };
+    const inference::InferenceResponse* failed_response = invalid(response) ? &response : nullptr;
+    if (batch_responses != nullptr) {
+        for (const inference::InferenceResponse& model_response : *batch_responses) {
+            if (failed_response == nullptr && invalid(model_response)) {
+                failed_response = &model_response;
+            }
+        }
+    }
+    if (failed_response != nullptr) {
+        // 失败时不发布，控制线程继续持有上一个动作并计为过期
+        failed_.fetch_add(1, std::memory_order_relaxed);
+        AsyncLogger::Instance().Log(kLogError, &failure_log_site_, "Inference failed ({}): {}", name_,
+                                    failed_response->error_message());
+        return false;
+    }
+
+    ActionSample& action = action_buffer_.WriteBuffer();
+    std::copy(response.action().begin(), response.action().begin() + kActionSize, action.data.begin());
+    action.model_count = 0;
+    if (batch_responses != nullptr) {
+        for (int i = 0; i < batch_responses->size(); ++i) {
+            const inference::InferenceResponse& model_response = batch_responses->Get(i);
+            std::copy(model_response.action().begin(), model_response.action().begin() + kActionSize,
+                      action.model_data[i].begin());
+            action.model_types[i] = batch_items_[i].model_type.c_str();
+        }
+        action.model_count = batch_responses->size();
+    }
+    float state_square_sum = 0.0f;
+    for (float value : response.states()) {
+        state_square_sum += value * value;
+    }
+    action.state_size = response.states_size();
+    action.state_norm = std::sqrt(state_square_sum);
+    action.seq = seq;
+    action.timing = timing_;
+    action.obs_stamp = obs_stamp;
+    action.done_stamp = Now();
+    action_buffer_.Publish();
+    completed_.fetch_add(1, std::memory_order_relaxed);
+
+    int notifier_fd = completion_notifier_fd_.load(std::memory_order_acquire);
+    if (notifier_fd >= 0) {
+        EventReactor::Notify(notifier_fd);
+    }
+    return true;
+}
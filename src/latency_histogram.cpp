@@ -0,0 +1,88 @@
+#include "../include/latency_histogram.h"
+#include <cstdio>
+
+LatencyHistogram::LatencyHistogram() {
+    Reset();
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t value_ns) {
+    if (value_ns < kSubBucketCount) {
+        return static_cast<size_t>(value_ns);
+    }
+
+    int msb = 63 - __builtin_clzll(value_ns);
+    if (msb >= kMaxValueBits) {
+        return kBucketCount - 1;
+    }
+
+    // msb之下的kSubBucketBits位决定子桶
+    int shift = msb - kSubBucketBits;
+    uint64_t sub_bucket = (value_ns >> shift) & (kSubBucketCount - 1);
+    return kSubBucketCount + static_cast<size_t>(shift) * kSubBucketCount + static_cast<size_t>(sub_bucket);
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+
+    size_t shift = (index - kSubBucketCount) / kSubBucketCount;
+    uint64_t sub_bucket = (index - kSubBucketCount) % kSubBucketCount;
+    int msb = static_cast<int>(shift) + kSubBucketBits;
+    uint64_t lower = (1ULL << msb) | (sub_bucket << shift);
+    return lower + (1ULL << shift) - 1;
+}
+
+uint64_t LatencyHistogram::ValueAtPercentile(double percentile) const {
+    uint64_t total = Count();
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(percentile / 100.0 * total + 0.5);
+    if (target < 1) {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            uint64_t upper = BucketUpperBound(i);
+            uint64_t max = Max();
+            return upper < max ? upper : max;
+        }
+    }
+    return Max();
+}
+
+LatencyHistogram::Summary LatencyHistogram::GetSummary() const {
+    Summary summary;
+    summary.count = Count();
+    summary.mean_us = summary.count > 0
+        ? total_ns_.load(std::memory_order_relaxed) / 1000.0 / summary.count
+        : 0.0;
+    summary.p50_us = ValueAtPercentile(50.0) / 1000.0;
+    summary.p99_us = ValueAtPercentile(99.0) / 1000.0;
+    summary.p999_us = ValueAtPercentile(99.9) / 1000.0;
+    summary.max_us = Max() / 1000.0;
+    return summary;
+}
+
+std::string LatencyHistogram::FormatSummary(const char* name) const {
+    Summary summary = GetSummary();
+    char line[192];
+    snprintf(line, sizeof(line), "%-22s n=%-9llu mean=%9.1fus p50=%9.1fus p99=%9.1fus p99.9=%9.1fus max=%9.1fus",
+             name, static_cast<unsigned long long>(summary.count), summary.mean_us,
+             summary.p50_us, summary.p99_us, summary.p999_us, summary.max_us);
+    return std::string(line);
+}
+
+void LatencyHistogram::Reset() {
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+    total_count_.store(0, std::memory_order_relaxed);
+    total_ns_.store(0, std::memory_order_relaxed);
+    max_ns_.store(0, std::memory_order_relaxed);
+}
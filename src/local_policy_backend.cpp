@@ -0,0 +1,221 @@
+#include "../include/local_policy_backend.h"
+#include "../include/grpc_client.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <dirent.h>
+#include <iostream>
+#include <unistd.h>
+
+namespace {
+
+/// @brief 模型文件的扩展名，同一模型类型两种文件都存在时视为重名
+const char* const kModelExtensions[] = {".safetensors", ".mlp"};
+
+/// @brief 由文件名得到模型类型，扩展名不符时返回false
+bool ModelTypeFromFile(const std::string& name, std::string* model_type) {
+    for (const char* extension : kModelExtensions) {
+        const size_t length = strlen(extension);
+        if (name.size() > length && name.compare(name.size() - length, length, extension) == 0) {
+            *model_type = name.substr(0, name.size() - length);
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+LocalPolicyBackend::LocalPolicyBackend(const std::string& address)
+    : directory_(IsLocalAddress(address) ? address.substr(6) : address), connected_(false),
+      response_(google::protobuf::Arena::CreateMessage<inference::InferenceResponse>(&arena_)),
+      state_model_(nullptr) {
+    // 动作字段预留容量，之后每次推理只改写其内容
+    response_->mutable_action()->Reserve(static_cast<int>(kActionSize));
+}
+
+bool LocalPolicyBackend::IsLocalAddress(const std::string& address) {
+    return address.compare(0, 6, "local:") == 0;
+}
+
+bool LocalPolicyBackend::Connect() {
+    if (!directory_.empty()) {
+        ModelList models;
+        auto start = std::chrono::steady_clock::now();
+        if (!LoadDirectory(&models)) {
+            return false;
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (models.empty()) {
+            std::cerr << "No local policy (*.safetensors or *.mlp) found in " << directory_ << std::endl;
+            return false;
+        }
+        models_.swap(models);
+        ResetRecurrentState();
+        std::cout << "Loaded " << models_.size() << " local policies from " << directory_ << " in "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() << " us" << std::endl;
+    }
+
+    if (models_.empty()) {
+        std::cerr << "No local policy loaded" << std::endl;
+        return false;
+    }
+    for (const auto& model : models_) {
+        std::cout << "Loaded local policy " << model.first << ": " << model.second->Describe() << ", "
+                  << model.second->ParameterCount() << " parameters"
+                  << (model.second->StateSize() > 0 ? " (recurrent)" : "")
+                  << (model.second->IsMapped() ? " (memory-mapped)" : "") << std::endl;
+    }
+    connected_ = true;
+    return true;
+}
+
+bool LocalPolicyBackend::LoadDirectory(ModelList* models) {
+    DIR* dir = opendir(directory_.c_str());
+    if (dir == nullptr) {
+        std::cerr << "Failed to open policy directory " << directory_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::vector<std::pair<std::string, std::string>> files;  // 模型类型、文件名
+    while (struct dirent* entry = readdir(dir)) {
+        std::string model_type;
+        if (ModelTypeFromFile(entry->d_name, &model_type)) {
+            files.emplace_back(model_type, entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+
+    for (const auto& file : files) {
+        std::unique_ptr<MlpPolicy> policy(new MlpPolicy());
+        std::string error;
+        if (!policy->Load(directory_ + "/" + file.second, &error) ||
+            !CheckModel(*models, file.first, *policy, &error)) {
+            std::cerr << "Failed to load local policy " << file.first << ": " << error << std::endl;
+            return false;
+        }
+        models->emplace_back(file.first, std::move(policy));
+    }
+    return true;
+}
+
+bool LocalPolicyBackend::ReloadModel(const std::string& model_type, std::string* error) {
+    for (const char* extension : kModelExtensions) {
+        std::string path = directory_ + "/" + model_type + extension;
+        if (access(path.c_str(), R_OK) != 0) {
+            continue;
+        }
+        std::unique_ptr<MlpPolicy> policy(new MlpPolicy());
+        if (!policy->Load(path, error) || !CheckModel(ModelList(), model_type, *policy, error)) {
+            return false;
+        }
+        for (auto& model : models_) {
+            if (model.first == model_type) {
+                // 旧模型（及其映射）在这里释放；隐状态属于旧模型
+                model.second = std::move(policy);
+                ResetRecurrentState();
+                return true;
+            }
+        }
+        if (models_.size() >= kMaxModels) {
+            *error = "too many models (at most " + std::to_string(kMaxModels) + ")";
+            return false;
+        }
+        models_.emplace_back(model_type, std::move(policy));
+        return true;
+    }
+    *error = "no " + model_type + ".safetensors or " + model_type + ".mlp in " + directory_;
+    return false;
+}
+
+bool LocalPolicyBackend::AddModel(const std::string& model_type, std::unique_ptr<MlpPolicy> policy,
+                                  std::string* error) {
+    if (!CheckModel(models_, model_type, *policy, error)) {
+        return false;
+    }
+    models_.emplace_back(model_type, std::move(policy));
+    return true;
+}
+
+bool LocalPolicyBackend::CheckModel(const ModelList& models, const std::string& model_type, const MlpPolicy& policy,
+                                    std::string* error) {
+    if (policy.InputSize() != kObservationSize || policy.OutputSize() != kActionSize) {
+        *error = "expected " + std::to_string(kObservationSize) + " inputs (the observation layout) and " +
+                 std::to_string(kActionSize) + " outputs (one per joint), got " + policy.Describe();
+        return false;
+    }
+    for (const auto& model : models) {
+        if (model.first == model_type) {
+            *error = "duplicate model type";
+            return false;
+        }
+    }
+    if (models.size() >= kMaxModels) {
+        *error = "too many models (at most " + std::to_string(kMaxModels) + ")";
+        return false;
+    }
+    return true;
+}
+
+MlpPolicy* LocalPolicyBackend::FindModel(const char* model_type) {
+    for (auto& model : models_) {
+        if (model.first == model_type) {
+            return model.second.get();
+        }
+    }
+    return nullptr;
+}
+
+inference::InferenceResponse LocalPolicyBackend::Predict(const std::vector<float>& observation,
+                                                         const std::string& model_type, bool deterministic) {
+    return PredictInPlace(observation.data(), observation.size(), model_type.c_str(), deterministic);
+}
+
+const inference::InferenceResponse& LocalPolicyBackend::PredictInPlace(const float* observation, size_t count,
+                                                                       const char* model_type, bool) {
+    if (!connected_) {
+        return Fail("Local: no policy loaded");
+    }
+    MlpPolicy* policy = FindModel(model_type);
+    if (policy == nullptr) {
+        return Fail("Local: unknown model type");
+    }
+
+    response_->Clear();
+    response_->mutable_action()->Resize(static_cast<int>(kActionSize), 0.0f);
+    float* action = response_->mutable_action()->mutable_data();
+    const size_t state_size = policy->StateSize();
+    if (state_size == 0) {
+        if (!policy->Evaluate(observation, count, action)) {
+            return Fail("Local: observation size mismatch");
+        }
+    } else {
+        if (policy != state_model_) {
+            state_.clear();
+            state_model_ = policy;
+        }
+        auto* states = response_->mutable_states();
+        states->Resize(static_cast<int>(state_size), 0.0f);
+        if (!policy->EvaluateRecurrent(observation, count, state_.empty() ? nullptr : state_.data(),
+                                       states->mutable_data(), action)) {
+            return Fail("Local: observation size mismatch");
+        }
+        // clear() 保留容量，首次推理之后不再分配
+        state_.assign(states->begin(), states->end());
+    }
+    response_->set_success(true);
+    return *response_;
+}
+
+void LocalPolicyBackend::ResetRecurrentState() {
+    state_.clear();
+    state_model_ = nullptr;
+}
+
+const inference::InferenceResponse& LocalPolicyBackend::Fail(const char* error) {
+    response_->Clear();
+    response_->set_success(false);
+    response_->set_error_message(error);
+    return *response_;
+}
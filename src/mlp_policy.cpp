@@ -0,0 +1,936 @@
+#include "../include/mlp_policy.h"
+#include "../include/safetensors_file.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "Eigen/Dense"
+
+namespace {
+
+typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatrix;
+
+const char* kTextMagic = "lite3_mlp";
+const int kTextVersion = 1;
+
+/// @brief 读取下一个记号，跳过注释行
+bool NextToken(std::istream& in, std::string* token) {
+    while (in >> *token) {
+        if ((*token)[0] != '#') {
+            return true;
+        }
+        std::string rest;
+        std::getline(in, rest);
+    }
+    return false;
+}
+
+/// @brief 读取count个浮点数
+bool ReadFloats(std::istream& in, float* values, size_t count) {
+    std::string token;
+    for (size_t i = 0; i < count; ++i) {
+        if (!NextToken(in, &token)) {
+            return false;
+        }
+        char* end = nullptr;
+        values[i] = std::strtof(token.c_str(), &end);
+        if (*end != '\0') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief IEEE半精度转fp32：指数与尾数左移到fp32的位置，再乘以 2^(127-15) 调整指数偏置，
+/// 非规格化数由乘法自然处理；无分支，循环中可以向量化
+inline float HalfBitsToFloat(uint16_t half) {
+    const float kExponentAdjust = 5.192296858534828e+33f;  // 2^112
+    uint32_t bits = static_cast<uint32_t>(half & 0x7fffu) << 13;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    value *= kExponentAdjust;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if (value >= 65536.0f) {
+        bits |= 0x7f800000u;  // 无穷大与NaN
+    }
+    bits |= static_cast<uint32_t>(half & 0x8000u) << 16;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+#if defined(__aarch64__)
+// aarch64有半精度转换指令（fcvtl），直接按 __fp16 读取
+typedef __fp16 __attribute__((__may_alias__)) AliasedHalf;
+inline float LoadHalf(const uint16_t* half) {
+    return static_cast<float>(*reinterpret_cast<const AliasedHalf*>(half));
+}
+#else
+inline float LoadHalf(const uint16_t* half) {
+    return HalfBitsToFloat(*half);
+}
+#endif
+
+/// @brief 点积的独立累加器个数，让编译器把浮点累加展开为SIMD向量（不依赖 -ffast-math）
+const size_t kLanes = 8;
+
+/// @brief fp16权重的矩阵向量乘：y = W x + b，权重转换为fp32后累加
+void GemvHalf(const uint16_t* weight, const float* x, const float* bias, float* y, size_t rows, size_t cols) {
+    const size_t vector_cols = cols - cols % kLanes;
+    for (size_t row = 0; row < rows; ++row) {
+        const uint16_t* w = weight + row * cols;
+        float lanes[kLanes] = {};
+        for (size_t col = 0; col < vector_cols; col += kLanes) {
+            for (size_t lane = 0; lane < kLanes; ++lane) {
+                lanes[lane] += LoadHalf(w + col + lane) * x[col + lane];
+            }
+        }
+        float sum = bias[row];
+        for (size_t col = vector_cols; col < cols; ++col) {
+            sum += LoadHalf(w + col) * x[col];
+        }
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            sum += lanes[lane];
+        }
+        y[row] = sum;
+    }
+}
+
+/// @brief 按各输入维的量化步长把输入量化为 [-127, 127] 的整数：q = round(x / input_scale)
+///
+/// 结果存为int16，int8权重与之相乘时只需符号扩展权重，编译器可以用 pmaddwd / smlal 类指令成对累加
+void QuantizeInput(const float* x, const float* input_scale, int16_t* q, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        float value = std::min(127.0f, std::max(-127.0f, x[i] / input_scale[i]));
+        float half = value >= 0.0f ? 0.5f : -0.5f;
+        q[i] = static_cast<int16_t>(value + half);
+    }
+}
+
+/// @brief int8的矩阵向量乘：int32累加后乘以输出通道的缩放系数，再加偏置
+void GemvInt8(const int8_t* weight, const int16_t* x, const float* weight_scale, const float* bias, float* y,
+              size_t rows, size_t cols) {
+    for (size_t row = 0; row < rows; ++row) {
+        const int8_t* w = weight + row * cols;
+        // 每项乘积不超过 127*127，int32累加十万个输入也不会溢出
+        int32_t sum = 0;
+        for (size_t col = 0; col < cols; ++col) {
+            sum += static_cast<int16_t>(w[col]) * x[col];
+        }
+        y[row] = static_cast<float>(sum) * weight_scale[row] + bias[row];
+    }
+}
+
+/// @brief int8标定范围的余量
+///
+/// 标定数据有限，运行时的输入会超出记录到的最大值；超出的输入被截断，误差远大于舍入误差，
+/// 因此量化步长按记录范围的1.5倍计算（65 -> 512 -> 256 -> 128 -> 12 的策略上最大动作误差从13%降到3%以下）
+const float kInputRangeHeadroom = 1.5f;
+
+/// @brief logistic函数
+inline float Sigmoid(float value) {
+    return 1.0f / (1.0f + std::exp(-value));
+}
+
+/// @brief 张量名的后缀是否为 suffix
+bool EndsWith(const std::string& name, const std::string& suffix) {
+    return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}  // namespace
+
+bool ParsePrecision(const std::string& name, WeightPrecision* precision) {
+    if (name == "fp32") {
+        *precision = WeightPrecision::kFloat32;
+    } else if (name == "fp16") {
+        *precision = WeightPrecision::kFloat16;
+    } else if (name == "int8") {
+        *precision = WeightPrecision::kInt8;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* PrecisionName(WeightPrecision precision) {
+    switch (precision) {
+        case WeightPrecision::kFloat32: return "fp32";
+        case WeightPrecision::kFloat16: return "fp16";
+        case WeightPrecision::kInt8: return "int8";
+    }
+    return "unknown";
+}
+
+uint16_t FloatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    bits &= 0x7fffffffu;
+
+    if (bits >= 0x47800000u) {
+        // 超出半精度范围：无穷大；NaN保持为NaN
+        return static_cast<uint16_t>(sign | (bits > 0x7f800000u ? 0x7e00u : 0x7c00u));
+    }
+    if (bits < 0x38800000u) {
+        // 非规格化数：加上 0.5 让硬件按当前（就近偶数）舍入对齐尾数
+        float magnitude;
+        std::memcpy(&magnitude, &bits, sizeof(magnitude));
+        magnitude += 0.5f;
+        uint32_t rounded;
+        std::memcpy(&rounded, &magnitude, sizeof(rounded));
+        return static_cast<uint16_t>(sign | (rounded - 0x3f000000u));
+    }
+    // 规格化数：调整指数偏置，按尾数奇偶就近舍入
+    const uint32_t odd = (bits >> 13) & 1u;
+    bits += 0xc8000fffu + odd;  // (15 - 127) << 23，加舍入量
+    return static_cast<uint16_t>(sign | (bits >> 13));
+}
+
+float HalfToFloat(uint16_t half) {
+    return HalfBitsToFloat(half);
+}
+
+bool ReadObservationCsv(const std::string& path, size_t observation_size, std::vector<float>* observations,
+                        std::string* error) {
+    std::ifstream in(path);
+    if (!in) {
+        *error = "cannot open " + path;
+        return false;
+    }
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (line.empty() || line.compare(0, 9, "timestamp") == 0) {
+            continue;
+        }
+        const char* cursor = line.c_str();
+        char* end = nullptr;
+        std::strtod(cursor, &end);  // timestamp
+        size_t columns = 0;
+        while (end != cursor && *end == ',') {
+            cursor = end + 1;
+            float value = std::strtof(cursor, &end);
+            if (end == cursor) {
+                break;
+            }
+            observations->push_back(value);
+            ++columns;
+        }
+        if (columns != observation_size || (*end != '\0' && *end != '\r')) {
+            *error = path + ":" + std::to_string(line_number) + ": expected a timestamp and " +
+                     std::to_string(observation_size) + " values";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ParseActivation(const std::string& name, Activation* activation) {
+    if (name == "identity" || name == "linear") {
+        *activation = Activation::kIdentity;
+    } else if (name == "relu") {
+        *activation = Activation::kRelu;
+    } else if (name == "elu") {
+        *activation = Activation::kElu;
+    } else if (name == "tanh") {
+        *activation = Activation::kTanh;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* ActivationName(Activation activation) {
+    switch (activation) {
+        case Activation::kIdentity: return "identity";
+        case Activation::kRelu: return "relu";
+        case Activation::kElu: return "elu";
+        case Activation::kTanh: return "tanh";
+    }
+    return "unknown";
+}
+
+MlpPolicy::MlpPolicy() : gru_() {
+    // 层的 weight/bias 指向各自的 storage，vector 扩容时移动 storage 不会改变其数据地址
+    layers_.reserve(kMaxLayers);
+}
+
+MlpPolicy::~MlpPolicy() {
+}
+
+bool MlpPolicy::AddLayer(const float* weight, const float* bias, size_t output_size, size_t input_size,
+                         Activation activation, std::string* error) {
+    Layer layer;
+    layer.storage.resize(output_size * input_size + output_size);
+    std::copy(weight, weight + output_size * input_size, layer.storage.begin());
+    std::copy(bias, bias + output_size, layer.storage.begin() + output_size * input_size);
+    layer.precision = WeightPrecision::kFloat32;
+    layer.weight = layer.storage.data();
+    layer.bias = layer.storage.data() + output_size * input_size;
+    layer.weight_scale = nullptr;
+    layer.input_scale = nullptr;
+    layer.output_size = output_size;
+    layer.input_size = input_size;
+    layer.activation = activation;
+    return AppendLayer(std::move(layer), error);
+}
+
+bool MlpPolicy::AttachLayer(const float* weight, const float* bias, size_t output_size, size_t input_size,
+                            Activation activation, std::string* error) {
+    Layer layer;
+    layer.precision = WeightPrecision::kFloat32;
+    layer.weight = weight;
+    layer.bias = bias;
+    layer.weight_scale = nullptr;
+    layer.input_scale = nullptr;
+    layer.output_size = output_size;
+    layer.input_size = input_size;
+    layer.activation = activation;
+    return AppendLayer(std::move(layer), error);
+}
+
+bool MlpPolicy::SetGru(const float* weight_ih, const float* weight_hh, const float* bias_ih, const float* bias_hh,
+                       size_t hidden_size, size_t input_size, std::string* error) {
+    const size_t gates = 3 * hidden_size;
+    std::vector<float> storage(gates * input_size + gates * hidden_size + 2 * gates);
+    float* cursor = storage.data();
+    const float* copied_ih = cursor;
+    cursor = std::copy(weight_ih, weight_ih + gates * input_size, cursor);
+    const float* copied_hh = cursor;
+    cursor = std::copy(weight_hh, weight_hh + gates * hidden_size, cursor);
+    const float* copied_bias_ih = cursor;
+    cursor = std::copy(bias_ih, bias_ih + gates, cursor);
+    const float* copied_bias_hh = cursor;
+    std::copy(bias_hh, bias_hh + gates, cursor);
+    if (!AttachGru(copied_ih, copied_hh, copied_bias_ih, copied_bias_hh, hidden_size, input_size, error)) {
+        return false;
+    }
+    // 移动 vector 不改变其数据地址
+    gru_.storage = std::move(storage);
+    return true;
+}
+
+bool MlpPolicy::AttachGru(const float* weight_ih, const float* weight_hh, const float* bias_ih, const float* bias_hh,
+                          size_t hidden_size, size_t input_size, std::string* error) {
+    if (!layers_.empty() || gru_.hidden_size > 0) {
+        *error = "the GRU must be set once, before the layers";
+        return false;
+    }
+    if (hidden_size == 0 || input_size == 0) {
+        *error = "empty GRU";
+        return false;
+    }
+    gru_.weight_ih = weight_ih;
+    gru_.weight_hh = weight_hh;
+    gru_.bias_ih = bias_ih;
+    gru_.bias_hh = bias_hh;
+    gru_.hidden_size = hidden_size;
+    gru_.input_size = input_size;
+    for (std::vector<float>& gates : gates_) {
+        gates.assign(3 * hidden_size, 0.0f);
+    }
+    zero_state_.assign(hidden_size, 0.0f);
+    return true;
+}
+
+bool MlpPolicy::AppendLayer(Layer layer, std::string* error) {
+    const size_t output_size = layer.output_size;
+    const size_t input_size = layer.input_size;
+    if (layers_.size() >= kMaxLayers) {
+        *error = "too many layers (at most " + std::to_string(kMaxLayers) + ")";
+        return false;
+    }
+    if (output_size == 0 || input_size == 0) {
+        *error = "empty layer";
+        return false;
+    }
+    if (!layers_.empty() && layers_.back().output_size != input_size) {
+        *error = "layer " + std::to_string(layers_.size()) + " expects " + std::to_string(input_size) +
+                 " inputs but the previous layer has " + std::to_string(layers_.back().output_size) + " outputs";
+        return false;
+    }
+    if (layers_.empty() && gru_.hidden_size > 0 && gru_.hidden_size != input_size) {
+        *error = "the first layer expects " + std::to_string(input_size) + " inputs but the GRU has " +
+                 std::to_string(gru_.hidden_size) + " hidden units";
+        return false;
+    }
+
+    layers_.push_back(std::move(layer));
+
+    for (std::vector<float>& buffer : buffers_) {
+        buffer.resize(std::max(buffer.size(), output_size), 0.0f);
+    }
+    quantized_input_.resize(std::max(quantized_input_.size(), input_size), 0);
+    return true;
+}
+
+bool MlpPolicy::Load(const std::string& path, std::string* error) {
+    const std::string extension = ".safetensors";
+    if (path.size() > extension.size() &&
+        path.compare(path.size() - extension.size(), extension.size(), extension) == 0) {
+        return LoadSafetensors(path, error);
+    }
+    return LoadText(path, error);
+}
+
+bool MlpPolicy::LoadSafetensors(const std::string& path, std::string* error) {
+    Clear();
+    std::unique_ptr<SafetensorsFile> file(new SafetensorsFile());
+    if (!file->Open(path, error)) {
+        return false;
+    }
+
+    const std::string prefix = file->Metadata("prefix", "actor.");
+    Activation hidden_activation;
+    const std::string activation_name = file->Metadata("activation", "elu");
+    if (!ParseActivation(activation_name, &hidden_activation)) {
+        *error = path + ": unknown activation '" + activation_name + "'";
+        return false;
+    }
+
+    // 找出 "<前缀><序号>.weight" 并按序号排列（nn.Sequential 中激活函数也占序号，序号不连续）
+    std::vector<std::pair<unsigned long, const SafetensorsTensor*>> weights;
+    for (const SafetensorsTensor& tensor : file->Tensors()) {
+        const std::string& name = tensor.name;
+        const std::string suffix = ".weight";
+        if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            !EndsWith(name, suffix)) {
+            continue;
+        }
+        std::string index = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+        if (index.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+        weights.emplace_back(std::stoul(index), &tensor);
+    }
+    std::sort(weights.begin(), weights.end());
+    if (weights.empty()) {
+        *error = path + ": no '" + prefix + "<N>.weight' tensors";
+        return false;
+    }
+
+    // 循环策略：rsl_rl 的 memory_a.rnn（单层GRU）
+    const std::string memory_prefix = file->Metadata("memory_prefix", "memory_a.rnn.");
+    const SafetensorsTensor* weight_ih = file->Find(memory_prefix + "weight_ih_l0");
+    if (weight_ih != nullptr) {
+        const SafetensorsTensor* weight_hh = file->Find(memory_prefix + "weight_hh_l0");
+        const SafetensorsTensor* bias_ih = file->Find(memory_prefix + "bias_ih_l0");
+        const SafetensorsTensor* bias_hh = file->Find(memory_prefix + "bias_hh_l0");
+        if (file->Find(memory_prefix + "weight_ih_l1") != nullptr) {
+            *error = path + ": only a single-layer GRU is supported";
+            return false;
+        }
+        const size_t hidden_size = weight_hh != nullptr && weight_hh->shape.size() == 2 ? weight_hh->shape[1] : 0;
+        const size_t gates = 3 * hidden_size;
+        auto is_f32 = [](const SafetensorsTensor* tensor, std::vector<size_t> shape) {
+            return tensor != nullptr && tensor->dtype == "F32" && tensor->shape == shape;
+        };
+        if (hidden_size == 0 || weight_ih->shape.size() != 2 || !is_f32(weight_ih, {gates, weight_ih->shape[1]}) ||
+            !is_f32(weight_hh, {gates, hidden_size}) || !is_f32(bias_ih, {gates}) || !is_f32(bias_hh, {gates})) {
+            // nn.LSTM 的张量同名，但有4个门
+            *error = path + ": '" + memory_prefix + "*_l0' must be an F32 GRU (3 gates, LSTM is not supported)";
+            return false;
+        }
+        std::string gru_error;
+        if (!AttachGru(static_cast<const float*>(weight_ih->data), static_cast<const float*>(weight_hh->data),
+                       static_cast<const float*>(bias_ih->data), static_cast<const float*>(bias_hh->data), hidden_size,
+                       weight_ih->shape[1], &gru_error)) {
+            *error = path + ": " + gru_error;
+            Clear();
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < weights.size(); ++i) {
+        const SafetensorsTensor& weight = *weights[i].second;
+        const std::string base = weight.name.substr(0, weight.name.size() - 6);  // 去掉 "weight"
+        const SafetensorsTensor* bias = file->Find(base + "bias");
+        if (weight.shape.size() != 2 || bias == nullptr || bias->dtype != "F32" || bias->shape.size() != 1 ||
+            bias->shape[0] != weight.shape[0]) {
+            *error = path + ": '" + weight.name + "' must be an [outputs, inputs] matrix with an F32 [outputs] bias";
+            Clear();
+            return false;
+        }
+
+        Layer layer;
+        layer.weight = weight.data;
+        layer.bias = static_cast<const float*>(bias->data);
+        layer.weight_scale = nullptr;
+        layer.input_scale = nullptr;
+        layer.output_size = weight.shape[0];
+        layer.input_size = weight.shape[1];
+        layer.activation = i + 1 < weights.size() ? hidden_activation : Activation::kIdentity;
+        if (weight.dtype == "F32") {
+            layer.precision = WeightPrecision::kFloat32;
+        } else if (weight.dtype == "F16") {
+            layer.precision = WeightPrecision::kFloat16;
+        } else if (weight.dtype == "I8") {
+            layer.precision = WeightPrecision::kInt8;
+            const SafetensorsTensor* weight_scale = file->Find(base + "weight_scale");
+            const SafetensorsTensor* input_scale = file->Find(base + "input_scale");
+            if (weight_scale == nullptr || weight_scale->dtype != "F32" || weight_scale->shape.size() != 1 ||
+                weight_scale->shape[0] != layer.output_size || input_scale == nullptr || input_scale->dtype != "F32" ||
+                input_scale->shape.size() != 1 || input_scale->shape[0] != layer.input_size) {
+                *error = path + ": int8 '" + weight.name + "' needs F32 '" + base + "weight_scale' [outputs] and '" +
+                         base + "input_scale' [inputs]";
+                Clear();
+                return false;
+            }
+            layer.weight_scale = static_cast<const float*>(weight_scale->data);
+            layer.input_scale = static_cast<const float*>(input_scale->data);
+            for (size_t j = 0; j < layer.input_size; ++j) {
+                if (!(layer.input_scale[j] > 0.0f) || !std::isfinite(layer.input_scale[j])) {
+                    *error = path + ": '" + base + "input_scale' must be positive";
+                    Clear();
+                    return false;
+                }
+            }
+        } else {
+            *error = path + ": '" + weight.name + "' has unsupported dtype " + weight.dtype + " (F32, F16 or I8)";
+            Clear();
+            return false;
+        }
+
+        std::string layer_error;
+        if (!AppendLayer(std::move(layer), &layer_error)) {
+            *error = path + ": " + layer_error;
+            Clear();
+            return false;
+        }
+    }
+    mapped_ = std::move(file);
+    return true;
+}
+
+bool MlpPolicy::LoadText(const std::string& path, std::string* error) {
+    Clear();
+    std::ifstream in(path);
+    if (!in) {
+        *error = "cannot open " + path;
+        return false;
+    }
+
+    std::string token;
+    int version = 0;
+    if (!NextToken(in, &token) || token != kTextMagic || !(in >> version) || version != kTextVersion) {
+        *error = path + ": not a " + kTextMagic + " v" + std::to_string(kTextVersion) + " file";
+        return false;
+    }
+
+    std::vector<float> values;
+    while (NextToken(in, &token)) {
+        size_t output_size = 0;
+        size_t input_size = 0;
+        if (token == "gru") {
+            if (!(in >> output_size >> input_size)) {
+                *error = path + ": expected 'gru <hidden> <inputs>'";
+                Clear();
+                return false;
+            }
+            const size_t gates = 3 * output_size;
+            values.resize(gates * input_size + gates * output_size + 2 * gates);
+            std::string gru_error;
+            const float* weight_hh = values.data() + gates * input_size;
+            const float* bias_ih = weight_hh + gates * output_size;
+            if (!ReadFloats(in, values.data(), values.size())) {
+                *error = path + ": truncated or invalid values in the GRU";
+                Clear();
+                return false;
+            }
+            if (!SetGru(values.data(), weight_hh, bias_ih, bias_ih + gates, output_size, input_size, &gru_error)) {
+                *error = path + ": " + gru_error;
+                Clear();
+                return false;
+            }
+            continue;
+        }
+        std::string activation_name;
+        Activation activation;
+        if (token != "layer" || !(in >> output_size >> input_size >> activation_name)) {
+            *error = path + ": expected 'layer <outputs> <inputs> <activation>'";
+            Clear();
+            return false;
+        }
+        if (!ParseActivation(activation_name, &activation)) {
+            *error = path + ": unknown activation '" + activation_name + "'";
+            Clear();
+            return false;
+        }
+        values.resize(output_size * input_size + output_size);
+        if (!ReadFloats(in, values.data(), values.size())) {
+            *error = path + ": truncated or invalid values in layer " + std::to_string(layers_.size());
+            Clear();
+            return false;
+        }
+        std::string layer_error;
+        if (!AddLayer(values.data(), values.data() + output_size * input_size, output_size, input_size, activation,
+                      &layer_error)) {
+            *error = path + ": " + layer_error;
+            Clear();
+            return false;
+        }
+    }
+
+    if (layers_.empty()) {
+        *error = path + ": no layers";
+        return false;
+    }
+    return true;
+}
+
+bool MlpPolicy::Quantize(const MlpPolicy& source, WeightPrecision precision, const std::vector<float>& input_ranges,
+                         std::string* error) {
+    Clear();
+    if (source.layers_.empty()) {
+        *error = "the source model has no layers";
+        return false;
+    }
+    if (source.StateSize() > 0) {
+        *error = "recurrent models are not quantized";
+        return false;
+    }
+    size_t range_count = 0;
+    for (const Layer& layer : source.layers_) {
+        range_count += layer.input_size;
+    }
+    if (precision == WeightPrecision::kInt8 && input_ranges.size() != range_count) {
+        *error = "int8 needs the range of every layer input (run CalibrateInputRanges first)";
+        return false;
+    }
+
+    const float* layer_ranges = input_ranges.data();
+    for (size_t i = 0; i < source.layers_.size(); ++i) {
+        const Layer& from = source.layers_[i];
+        if (from.precision != WeightPrecision::kFloat32) {
+            *error = "the source model must be fp32";
+            Clear();
+            return false;
+        }
+        const float* weight = static_cast<const float*>(from.weight);
+        const size_t rows = from.output_size;
+        const size_t cols = from.input_size;
+
+        Layer layer;
+        layer.precision = precision;
+        layer.weight = nullptr;
+        layer.bias = nullptr;
+        layer.weight_scale = nullptr;
+        layer.input_scale = nullptr;
+        layer.output_size = rows;
+        layer.input_size = cols;
+        layer.activation = from.activation;
+        switch (precision) {
+            case WeightPrecision::kFloat32:
+                layer.storage.assign(weight, weight + rows * cols);
+                layer.storage.insert(layer.storage.end(), from.bias, from.bias + rows);
+                layer.weight = layer.storage.data();
+                layer.bias = layer.storage.data() + rows * cols;
+                break;
+            case WeightPrecision::kFloat16:
+                layer.half_storage.resize(rows * cols);
+                for (size_t j = 0; j < rows * cols; ++j) {
+                    layer.half_storage[j] = FloatToHalf(weight[j]);
+                }
+                layer.storage.assign(from.bias, from.bias + rows);
+                layer.weight = layer.half_storage.data();
+                layer.bias = layer.storage.data();
+                break;
+            case WeightPrecision::kInt8: {
+                // storage 依次为偏置、每个输出通道的缩放系数与每个输入维的量化步长。
+                // 各输入维的范围相差很大（如关节位置与速度），步长按维取 range/127，
+                // 并把它乘进权重的对应列（W x = (W diag(s)) (x / s)），再按行取权重的缩放系数
+                layer.storage.assign(from.bias, from.bias + rows);
+                layer.storage.resize(2 * rows + cols);
+                float* weight_scale = layer.storage.data() + rows;
+                float* input_scale = layer.storage.data() + 2 * rows;
+                for (size_t col = 0; col < cols; ++col) {
+                    // 标定中始终为0的输入按范围1处理
+                    float range = layer_ranges[col] > 0.0f ? layer_ranges[col] * kInputRangeHeadroom : 1.0f;
+                    input_scale[col] = range / 127.0f;
+                }
+                layer.int8_storage.resize(rows * cols);
+                for (size_t row = 0; row < rows; ++row) {
+                    const float* w = weight + row * cols;
+                    float max_abs = 0.0f;
+                    for (size_t col = 0; col < cols; ++col) {
+                        max_abs = std::max(max_abs, std::fabs(w[col] * input_scale[col]));
+                    }
+                    float scale = max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+                    weight_scale[row] = scale;
+                    for (size_t col = 0; col < cols; ++col) {
+                        float value = std::round(w[col] * input_scale[col] / scale);
+                        layer.int8_storage[row * cols + col] =
+                            static_cast<int8_t>(std::max(-127.0f, std::min(127.0f, value)));
+                    }
+                }
+                layer.weight = layer.int8_storage.data();
+                layer.bias = layer.storage.data();
+                layer.weight_scale = weight_scale;
+                layer.input_scale = input_scale;
+                break;
+            }
+        }
+        layer_ranges += cols;
+        if (!AppendLayer(std::move(layer), error)) {
+            Clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MlpPolicy::CalibrateInputRanges(const float* observation, size_t count, std::vector<float>* input_ranges) {
+    if (layers_.empty() || count != InputSize() || StateSize() > 0) {
+        return false;
+    }
+    size_t range_count = 0;
+    for (const Layer& layer : layers_) {
+        range_count += layer.input_size;
+    }
+    if (input_ranges->size() != range_count) {
+        input_ranges->assign(range_count, 0.0f);
+    }
+    std::vector<float> action(OutputSize());
+    Forward(observation, action.data(), input_ranges->data());
+    return true;
+}
+
+bool MlpPolicy::SaveSafetensors(const std::string& path, std::string* error) const {
+    if (layers_.empty()) {
+        *error = "no layers to save";
+        return false;
+    }
+    const Activation hidden_activation = layers_.size() > 1 ? layers_.front().activation : Activation::kIdentity;
+    for (size_t i = 0; i < layers_.size(); ++i) {
+        Activation expected = i + 1 < layers_.size() ? hidden_activation : Activation::kIdentity;
+        if (layers_[i].activation != expected) {
+            *error = "safetensors needs one hidden activation and a linear last layer";
+            return false;
+        }
+    }
+
+    std::vector<SafetensorsTensor> tensors;
+    for (size_t i = 0; i < layers_.size(); ++i) {
+        const Layer& layer = layers_[i];
+        const std::string base = "actor." + std::to_string(2 * i) + ".";
+        const size_t rows = layer.output_size;
+        const size_t cols = layer.input_size;
+        switch (layer.precision) {
+            case WeightPrecision::kFloat32:
+                tensors.push_back({base + "weight", "F32", {rows, cols}, layer.weight, rows * cols * sizeof(float)});
+                break;
+            case WeightPrecision::kFloat16:
+                tensors.push_back({base + "weight", "F16", {rows, cols}, layer.weight, rows * cols * sizeof(uint16_t)});
+                break;
+            case WeightPrecision::kInt8:
+                tensors.push_back({base + "weight", "I8", {rows, cols}, layer.weight, rows * cols});
+                tensors.push_back({base + "weight_scale", "F32", {rows}, layer.weight_scale, rows * sizeof(float)});
+                tensors.push_back({base + "input_scale", "F32", {cols}, layer.input_scale, cols * sizeof(float)});
+                break;
+        }
+        tensors.push_back({base + "bias", "F32", {rows}, layer.bias, rows * sizeof(float)});
+    }
+    std::vector<std::pair<std::string, std::string>> metadata = {
+        {"format", "lite3_mlp"},
+        {"activation", ActivationName(hidden_activation)},
+        {"prefix", "actor."},
+        {"precision", PrecisionName(Precision())},
+    };
+    if (gru_.hidden_size > 0) {
+        const std::string base = "memory_a.rnn.";
+        const size_t gates = 3 * gru_.hidden_size;
+        tensors.push_back({base + "weight_ih_l0", "F32", {gates, gru_.input_size}, gru_.weight_ih,
+                           gates * gru_.input_size * sizeof(float)});
+        tensors.push_back({base + "weight_hh_l0", "F32", {gates, gru_.hidden_size}, gru_.weight_hh,
+                           gates * gru_.hidden_size * sizeof(float)});
+        tensors.push_back({base + "bias_ih_l0", "F32", {gates}, gru_.bias_ih, gates * sizeof(float)});
+        tensors.push_back({base + "bias_hh_l0", "F32", {gates}, gru_.bias_hh, gates * sizeof(float)});
+        metadata.push_back({"memory_prefix", base});
+    }
+    return SafetensorsFile::Write(path, tensors, metadata, error);
+}
+
+void MlpPolicy::Clear() {
+    layers_.clear();
+    gru_ = Gru();
+    mapped_.reset();
+    for (std::vector<float>& buffer : buffers_) {
+        buffer.clear();
+    }
+    for (std::vector<float>& gates : gates_) {
+        gates.clear();
+    }
+    zero_state_.clear();
+    quantized_input_.clear();
+}
+
+size_t MlpPolicy::InputSize() const {
+    if (layers_.empty()) {
+        return 0;
+    }
+    return gru_.hidden_size > 0 ? gru_.input_size : layers_.front().input_size;
+}
+
+size_t MlpPolicy::OutputSize() const {
+    return layers_.empty() ? 0 : layers_.back().output_size;
+}
+
+size_t MlpPolicy::ParameterCount() const {
+    size_t count = 3 * gru_.hidden_size * (gru_.input_size + gru_.hidden_size + 2);
+    for (const Layer& layer : layers_) {
+        count += layer.output_size * layer.input_size + layer.output_size;
+    }
+    return count;
+}
+
+size_t MlpPolicy::WeightBytes() const {
+    size_t bytes = 3 * gru_.hidden_size * (gru_.input_size + gru_.hidden_size + 2) * sizeof(float);
+    for (const Layer& layer : layers_) {
+        const size_t weights = layer.output_size * layer.input_size;
+        bytes += layer.output_size * sizeof(float);  // 偏置
+        switch (layer.precision) {
+            case WeightPrecision::kFloat32: bytes += weights * sizeof(float); break;
+            case WeightPrecision::kFloat16: bytes += weights * sizeof(uint16_t); break;
+            case WeightPrecision::kInt8:
+                bytes += weights + (layer.output_size + layer.input_size) * sizeof(float);
+                break;
+        }
+    }
+    return bytes;
+}
+
+WeightPrecision MlpPolicy::Precision() const {
+    return layers_.empty() ? WeightPrecision::kFloat32 : layers_.front().precision;
+}
+
+std::string MlpPolicy::Describe() const {
+    std::ostringstream out;
+    out << InputSize();
+    if (gru_.hidden_size > 0) {
+        out << " -> gru " << gru_.hidden_size;
+    }
+    for (const Layer& layer : layers_) {
+        out << " -> " << layer.output_size;
+    }
+    if (!layers_.empty()) {
+        out << " (" << ActivationName(layers_.front().activation);
+        if (Precision() != WeightPrecision::kFloat32) {
+            out << ", " << PrecisionName(Precision());
+        }
+        out << ")";
+    }
+    return out.str();
+}
+
+void MlpPolicy::Activate(Activation activation, float* values, size_t count) {
+    switch (activation) {
+        case Activation::kIdentity:
+            break;
+        case Activation::kRelu:
+            for (size_t i = 0; i < count; ++i) {
+                values[i] = values[i] > 0.0f ? values[i] : 0.0f;
+            }
+            break;
+        case Activation::kElu:
+            for (size_t i = 0; i < count; ++i) {
+                values[i] = values[i] > 0.0f ? values[i] : std::expm1(values[i]);
+            }
+            break;
+        case Activation::kTanh:
+            for (size_t i = 0; i < count; ++i) {
+                values[i] = std::tanh(values[i]);
+            }
+            break;
+    }
+}
+
+bool MlpPolicy::Evaluate(const float* observation, size_t count, float* action) {
+    if (layers_.empty() || count != InputSize() || StateSize() > 0) {
+        return false;
+    }
+    Forward(observation, action, nullptr);
+    return true;
+}
+
+bool MlpPolicy::EvaluateRecurrent(const float* observation, size_t count, const float* state, float* next_state,
+                                  float* action) {
+    if (layers_.empty() || count != InputSize() || StateSize() == 0) {
+        return false;
+    }
+    const size_t hidden = gru_.hidden_size;
+    const size_t gates = 3 * hidden;
+
+    Eigen::Map<const RowMajorMatrix> weight_ih(gru_.weight_ih, gates, gru_.input_size);
+    Eigen::Map<const Eigen::VectorXf> x(observation, gru_.input_size);
+    Eigen::Map<Eigen::VectorXf> input_gates(gates_[0].data(), gates);
+    input_gates.noalias() = weight_ih * x;
+    input_gates += Eigen::Map<const Eigen::VectorXf>(gru_.bias_ih, gates);
+
+    Eigen::Map<Eigen::VectorXf> hidden_gates(gates_[1].data(), gates);
+    if (state != nullptr) {
+        Eigen::Map<const RowMajorMatrix> weight_hh(gru_.weight_hh, gates, hidden);
+        hidden_gates.noalias() = weight_hh * Eigen::Map<const Eigen::VectorXf>(state, hidden);
+        hidden_gates += Eigen::Map<const Eigen::VectorXf>(gru_.bias_hh, gates);
+    } else {
+        // 零状态时 W_hh h 为0，省去一次矩阵向量乘
+        hidden_gates = Eigen::Map<const Eigen::VectorXf>(gru_.bias_hh, gates);
+        state = zero_state_.data();
+    }
+
+    // 逐个单元计算三个门与新的隐状态；每个单元先读 state[i] 再写 next_state[i]，两者可以相同
+    const float* gi = gates_[0].data();
+    const float* gh = gates_[1].data();
+    for (size_t i = 0; i < hidden; ++i) {
+        float reset = Sigmoid(gi[i] + gh[i]);
+        float update = Sigmoid(gi[hidden + i] + gh[hidden + i]);
+        float candidate = std::tanh(gi[2 * hidden + i] + reset * gh[2 * hidden + i]);
+        next_state[i] = candidate + update * (state[i] - candidate);
+    }
+
+    Forward(next_state, action, nullptr);
+    return true;
+}
+
+void MlpPolicy::Forward(const float* observation, float* action, float* input_ranges) {
+    const float* input = observation;
+    for (size_t i = 0; i < layers_.size(); ++i) {
+        const Layer& layer = layers_[i];
+        // 最后一层直接写入输出
+        float* output = i + 1 == layers_.size() ? action : buffers_[i % 2].data();
+
+        if (input_ranges != nullptr) {
+            for (size_t j = 0; j < layer.input_size; ++j) {
+                input_ranges[j] = std::max(input_ranges[j], std::fabs(input[j]));
+            }
+            input_ranges += layer.input_size;
+        }
+
+        switch (layer.precision) {
+            case WeightPrecision::kFloat32: {
+                Eigen::Map<const RowMajorMatrix> weight(static_cast<const float*>(layer.weight), layer.output_size,
+                                                        layer.input_size);
+                Eigen::Map<const Eigen::VectorXf> x(input, layer.input_size);
+                Eigen::Map<const Eigen::VectorXf> bias(layer.bias, layer.output_size);
+                Eigen::Map<Eigen::VectorXf> y(output, layer.output_size);
+                // noalias() 让乘积直接写入 y，不经过临时向量
+                y.noalias() = weight * x;
+                y += bias;
+                break;
+            }
+            case WeightPrecision::kFloat16:
+                GemvHalf(static_cast<const uint16_t*>(layer.weight), input, layer.bias, output, layer.output_size,
+                         layer.input_size);
+                break;
+            case WeightPrecision::kInt8:
+                QuantizeInput(input, layer.input_scale, quantized_input_.data(), layer.input_size);
+                GemvInt8(static_cast<const int8_t*>(layer.weight), quantized_input_.data(), layer.weight_scale,
+                         layer.bias, output, layer.output_size, layer.input_size);
+                break;
+        }
+        Activate(layer.activation, output, layer.output_size);
+
+        input = output;
+    }
+}
@@ -0,0 +1,71 @@
+#include "../include/phase_profiler.h"
+#include <chrono>
+#include <iostream>
+
+PhaseProfiler::PhaseProfiler()
+    : reporter_stop_(false) {
+}
+
+PhaseProfiler::~PhaseProfiler() {
+    StopReporter();
+}
+
+void PhaseProfiler::StartReporter(int period_s) {
+    if (period_s <= 0 || reporter_.joinable()) {
+        return;
+    }
+    reporter_stop_ = false;
+    reporter_ = std::thread(&PhaseProfiler::ReporterLoop, this, period_s);
+}
+
+void PhaseProfiler::StopReporter() {
+    {
+        std::lock_guard<std::mutex> lock(reporter_mutex_);
+        reporter_stop_ = true;
+    }
+    reporter_cv_.notify_all();
+    if (reporter_.joinable()) {
+        reporter_.join();
+    }
+}
+
+void PhaseProfiler::ReporterLoop(int period_s) {
+    std::unique_lock<std::mutex> lock(reporter_mutex_);
+    while (!reporter_cv_.wait_for(lock, std::chrono::seconds(period_s), [this] { return reporter_stop_; })) {
+        PrintSummary("Phase latency (cumulative)");
+    }
+}
+
+void PhaseProfiler::PrintSummary(const char* title) const {
+    // 先拼好整段文本再一次输出，减少与控制线程输出的交错
+    std::string text = std::string(title) + ":\n";
+    for (int i = 0; i < kPhaseCount; ++i) {
+        ControlPhase phase = static_cast<ControlPhase>(i);
+        if (phase >= kPhaseUplink && histograms_[i].Count() == 0) {
+            continue;  // 未开启延迟追踪
+        }
+        text += "  " + histograms_[i].FormatSummary(PhaseName(phase)) + "\n";
+    }
+    std::cout << text << std::flush;
+}
+
+const char* PhaseProfiler::PhaseName(ControlPhase phase) {
+    switch (phase) {
+        case kPhaseObservation: return "observation";
+        case kPhaseScaling: return "scaling_noise";
+        case kPhaseInference: return "grpc_round_trip";
+        case kPhaseLogObservation: return "log_observation";
+        case kPhaseLogRawAction: return "log_raw_action";
+        case kPhaseLogAction: return "log_action";
+        case kPhaseSendCmd: return "send_cmd";
+        case kPhaseControlTick: return "control_tick";
+        case kPhaseStateToCmd: return "state_to_cmd";
+        case kPhaseStateInterval: return "state_interval";
+        case kPhaseUplink: return "inference_uplink";
+        case kPhaseServerQueue: return "server_queue";
+        case kPhaseCompute: return "model_compute";
+        case kPhaseServerReply: return "server_reply";
+        case kPhaseDownlink: return "inference_downlink";
+        default: return "unknown";
+    }
+}
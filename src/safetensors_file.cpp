@@ -0,0 +1,420 @@
+#include "../include/safetensors_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+/// @brief 头部长度上限，与官方实现相同（100MB）
+const uint64_t kMaxHeaderSize = 100 * 1024 * 1024;
+
+/// @brief safetensors头部所需的最小JSON解析器：对象、字符串、非负整数数组，其余值只跳过
+class HeaderParser {
+public:
+    HeaderParser(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+    void SkipSpace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+            ++p_;
+        }
+    }
+
+    /// @brief 跳过空白后若下一个字符为 c 则消费它
+    bool Consume(char c) {
+        SkipSpace();
+        if (p_ < end_ && *p_ == c) {
+            ++p_;
+            return true;
+        }
+        return false;
+    }
+
+    bool AtEnd() {
+        SkipSpace();
+        return p_ == end_;
+    }
+
+    bool ParseString(std::string* out) {
+        if (!Consume('"')) {
+            return false;
+        }
+        out->clear();
+        while (p_ < end_ && *p_ != '"') {
+            char c = *p_++;
+            if (c == '\\') {
+                if (p_ == end_) {
+                    return false;
+                }
+                c = *p_++;
+                switch (c) {
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'n': c = '\n'; break;
+                    case 'r': c = '\r'; break;
+                    case 't': c = '\t'; break;
+                    case 'u':
+                        // 张量名与元数据中不会出现非ASCII转义，这里只保留占位
+                        if (end_ - p_ < 4) {
+                            return false;
+                        }
+                        p_ += 4;
+                        c = '?';
+                        break;
+                    default: break;  // '"'、'\\'、'/'
+                }
+            }
+            out->push_back(c);
+        }
+        return Consume('"');
+    }
+
+    bool ParseUnsigned(uint64_t* out) {
+        SkipSpace();
+        if (p_ == end_ || *p_ < '0' || *p_ > '9') {
+            return false;
+        }
+        uint64_t value = 0;
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+            uint64_t digit = static_cast<uint64_t>(*p_++ - '0');
+            if (value > (UINT64_MAX - digit) / 10) {
+                return false;
+            }
+            value = value * 10 + digit;
+        }
+        *out = value;
+        return true;
+    }
+
+    bool ParseUnsignedArray(std::vector<uint64_t>* out) {
+        out->clear();
+        if (!Consume('[')) {
+            return false;
+        }
+        if (Consume(']')) {
+            return true;
+        }
+        do {
+            uint64_t value = 0;
+            if (!ParseUnsigned(&value)) {
+                return false;
+            }
+            out->push_back(value);
+        } while (Consume(','));
+        return Consume(']');
+    }
+
+    /// @brief 跳过任意一个JSON值
+    bool SkipValue(int depth = 0) {
+        SkipSpace();
+        if (p_ == end_ || depth > 32) {
+            return false;
+        }
+        std::string ignored;
+        switch (*p_) {
+            case '"':
+                return ParseString(&ignored);
+            case '{':
+                ++p_;
+                if (Consume('}')) {
+                    return true;
+                }
+                do {
+                    if (!ParseString(&ignored) || !Consume(':') || !SkipValue(depth + 1)) {
+                        return false;
+                    }
+                } while (Consume(','));
+                return Consume('}');
+            case '[':
+                ++p_;
+                if (Consume(']')) {
+                    return true;
+                }
+                do {
+                    if (!SkipValue(depth + 1)) {
+                        return false;
+                    }
+                } while (Consume(','));
+                return Consume(']');
+            default:
+                // 数字、true、false、null
+                while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ']' && *p_ != ' ' && *p_ != '\n') {
+                    ++p_;
+                }
+                return true;
+        }
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+};
+
+/// @brief 写出JSON字符串（张量名与元数据只含可打印ASCII，只需转义引号与反斜杠）
+void AppendJsonString(const std::string& value, std::string* out) {
+    out->push_back('"');
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out->push_back('\\');
+        }
+        out->push_back(c);
+    }
+    out->push_back('"');
+}
+
+}  // namespace
+
+SafetensorsFile::SafetensorsFile() : mapping_(nullptr), mapped_size_(0) {
+}
+
+SafetensorsFile::~SafetensorsFile() {
+    Close();
+}
+
+void SafetensorsFile::Close() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapped_size_);
+        mapping_ = nullptr;
+    }
+    mapped_size_ = 0;
+    tensors_.clear();
+    metadata_.clear();
+}
+
+size_t SafetensorsFile::DtypeSize(const std::string& dtype) {
+    if (dtype == "F64" || dtype == "I64" || dtype == "U64") return 8;
+    if (dtype == "F32" || dtype == "I32" || dtype == "U32") return 4;
+    if (dtype == "F16" || dtype == "BF16" || dtype == "I16" || dtype == "U16") return 2;
+    if (dtype == "I8" || dtype == "U8" || dtype == "BOOL") return 1;
+    return 0;
+}
+
+bool SafetensorsFile::Open(const std::string& path, std::string* error) {
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        *error = "cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 8) {
+        *error = path + ": too small for a safetensors file";
+        close(fd);
+        return false;
+    }
+    size_t file_size = static_cast<size_t>(st.st_size);
+    // 预缺页：加载时一次读入，推理时不再触发缺页
+    void* address = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        *error = "cannot map " + path + ": " + strerror(errno);
+        return false;
+    }
+    mapping_ = address;
+    mapped_size_ = file_size;
+
+    const char* bytes = static_cast<const char*>(mapping_);
+    uint64_t header_size = 0;
+    for (int i = 7; i >= 0; --i) {
+        header_size = (header_size << 8) | static_cast<unsigned char>(bytes[i]);
+    }
+    if (header_size > kMaxHeaderSize || header_size > file_size - 8) {
+        *error = path + ": invalid header size";
+        Close();
+        return false;
+    }
+    const char* data = bytes + 8 + header_size;
+    size_t data_size = file_size - 8 - static_cast<size_t>(header_size);
+
+    HeaderParser parser(bytes + 8, data);
+    std::string key;
+    bool ok = parser.Consume('{');
+    if (ok && !parser.Consume('}')) {
+        do {
+            ok = parser.ParseString(&key) && parser.Consume(':');
+            if (!ok) {
+                break;
+            }
+            if (key == "__metadata__") {
+                std::string name;
+                std::string value;
+                ok = parser.Consume('{');
+                if (ok && !parser.Consume('}')) {
+                    do {
+                        ok = parser.ParseString(&name) && parser.Consume(':') && parser.ParseString(&value);
+                        if (ok) {
+                            metadata_.emplace_back(name, value);
+                        }
+                    } while (ok && parser.Consume(','));
+                    ok = ok && parser.Consume('}');
+                }
+                if (!ok) {
+                    break;
+                }
+                continue;
+            }
+
+            SafetensorsTensor tensor;
+            tensor.name = key;
+            std::vector<uint64_t> shape;
+            std::vector<uint64_t> offsets;
+            std::string field;
+            ok = parser.Consume('{');
+            if (ok && !parser.Consume('}')) {
+                do {
+                    ok = parser.ParseString(&field) && parser.Consume(':');
+                    if (!ok) {
+                        break;
+                    }
+                    if (field == "dtype") {
+                        ok = parser.ParseString(&tensor.dtype);
+                    } else if (field == "shape") {
+                        ok = parser.ParseUnsignedArray(&shape);
+                    } else if (field == "data_offsets") {
+                        ok = parser.ParseUnsignedArray(&offsets);
+                    } else {
+                        ok = parser.SkipValue();
+                    }
+                } while (ok && parser.Consume(','));
+                ok = ok && parser.Consume('}');
+            }
+            if (!ok) {
+                break;
+            }
+
+            size_t element_size = DtypeSize(tensor.dtype);
+            if (element_size == 0 || offsets.size() != 2 || offsets[0] > offsets[1] || offsets[1] > data_size) {
+                *error = path + ": tensor '" + key + "' has an unknown dtype or out-of-range data_offsets";
+                Close();
+                return false;
+            }
+            // 元素数与字节数都不会超过数据区大小，先比较再相乘，避免畸形的形状溢出后绕过大小检查
+            uint64_t elements = 1;
+            bool fits = true;
+            for (uint64_t dimension : shape) {
+                if (dimension != 0 && elements > data_size / dimension) {
+                    fits = false;
+                    break;
+                }
+                elements *= dimension;
+                tensor.shape.push_back(static_cast<size_t>(dimension));
+            }
+            tensor.size_bytes = static_cast<size_t>(offsets[1] - offsets[0]);
+            tensor.data = data + offsets[0];
+            if (!fits || elements > data_size / element_size || elements * element_size != tensor.size_bytes) {
+                *error = path + ": tensor '" + key + "' size does not match its shape";
+                Close();
+                return false;
+            }
+            // 张量原地使用，数据必须按元素大小对齐（官方导出工具总是满足）
+            if (reinterpret_cast<uintptr_t>(tensor.data) % element_size != 0) {
+                *error = path + ": tensor '" + key + "' is not aligned";
+                Close();
+                return false;
+            }
+            tensors_.push_back(tensor);
+        } while (parser.Consume(','));
+        ok = ok && parser.Consume('}');
+    }
+    if (!ok || !parser.AtEnd()) {
+        *error = path + ": malformed header";
+        Close();
+        return false;
+    }
+    return true;
+}
+
+const SafetensorsTensor* SafetensorsFile::Find(const std::string& name) const {
+    for (const SafetensorsTensor& tensor : tensors_) {
+        if (tensor.name == name) {
+            return &tensor;
+        }
+    }
+    return nullptr;
+}
+
+std::string SafetensorsFile::Metadata(const std::string& key, const std::string& fallback) const {
+    for (const auto& entry : metadata_) {
+        if (entry.first == key) {
+            return entry.second;
+        }
+    }
+    return fallback;
+}
+
+bool SafetensorsFile::Write(const std::string& path, const std::vector<SafetensorsTensor>& tensors,
+                            const std::vector<std::pair<std::string, std::string>>& metadata, std::string* error) {
+    std::string header = "{";
+    if (!metadata.empty()) {
+        header += "\"__metadata__\":{";
+        for (size_t i = 0; i < metadata.size(); ++i) {
+            if (i > 0) {
+                header += ",";
+            }
+            AppendJsonString(metadata[i].first, &header);
+            header += ":";
+            AppendJsonString(metadata[i].second, &header);
+        }
+        header += "}";
+    }
+    // 数据按元素大小从大到小存放，数据区起点对齐到8字节后每个张量都按元素大小对齐（张量之间不能留空）
+    std::vector<size_t> order(tensors.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&tensors](size_t a, size_t b) {
+        return DtypeSize(tensors[a].dtype) > DtypeSize(tensors[b].dtype);
+    });
+    std::vector<size_t> offsets(tensors.size());
+    size_t offset = 0;
+    for (size_t index : order) {
+        offsets[index] = offset;
+        offset += tensors[index].size_bytes;
+    }
+
+    for (size_t index = 0; index < tensors.size(); ++index) {
+        const SafetensorsTensor& tensor = tensors[index];
+        if (header.size() > 1) {
+            header += ",";
+        }
+        AppendJsonString(tensor.name, &header);
+        header += ":{\"dtype\":";
+        AppendJsonString(tensor.dtype, &header);
+        header += ",\"shape\":[";
+        for (size_t i = 0; i < tensor.shape.size(); ++i) {
+            header += (i > 0 ? "," : "") + std::to_string(tensor.shape[i]);
+        }
+        header += "],\"data_offsets\":[" + std::to_string(offsets[index]) + "," +
+                  std::to_string(offsets[index] + tensor.size_bytes) + "]}";
+    }
+    header += "}";
+    header.append((8 - header.size() % 8) % 8, ' ');
+
+    const std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        *error = "cannot create " + temporary;
+        return false;
+    }
+    uint64_t header_size = header.size();
+    for (int i = 0; i < 8; ++i) {
+        out.put(static_cast<char>((header_size >> (8 * i)) & 0xff));
+    }
+    out.write(header.data(), static_cast<std::streamsize>(header.size()));
+    for (size_t index : order) {
+        out.write(static_cast<const char*>(tensors[index].data), static_cast<std::streamsize>(tensors[index].size_bytes));
+    }
+    out.close();
+    if (!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        *error = "cannot write " + path + ": " + strerror(errno);
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,111 @@
+#include "../include/shadow_comparator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+namespace {
+
+/// @brief 动作各维对应的关节，与 ConvertResponseToAction 的顺序相同
+const char* const kJointNames[kActionSize] = {
+    "FL hip", "FL thigh", "FL calf", "FR hip", "FR thigh", "FR calf",
+    "HL hip", "HL thigh", "HL calf", "HR hip", "HR thigh", "HR calf",
+};
+
+}  // namespace
+
+ShadowComparator::ShadowComparator()
+    : live_count_(0), shadow_count_(0), matched_count_(0) {
+    for (Slot& slot : live_) {
+        slot.seq = 0;
+    }
+    for (Slot& slot : shadow_) {
+        slot.seq = 0;
+    }
+    sum_abs_.fill(0.0);
+    sum_square_.fill(0.0);
+    max_abs_.fill(0.0);
+}
+
+void ShadowComparator::Store(std::array<Slot, kPendingSlots>* slots, uint64_t seq, const float* action) {
+    Slot& slot = (*slots)[seq % kPendingSlots];
+    slot.seq = seq;
+    std::copy(action, action + kActionSize, slot.action.begin());
+}
+
+void ShadowComparator::AddLive(uint64_t seq, const float* action) {
+    if (seq == 0) {
+        return;
+    }
+    Store(&live_, seq, action);
+    ++live_count_;
+}
+
+void ShadowComparator::AddShadow(uint64_t seq, const float* action) {
+    if (seq == 0) {
+        return;
+    }
+    Store(&shadow_, seq, action);
+    ++shadow_count_;
+}
+
+bool ShadowComparator::NextMatch(uint64_t* seq, const float** live, const float** shadow) {
+    // 同一序号在两边落在同一个槽里
+    size_t matched = kPendingSlots;
+    for (size_t i = 0; i < kPendingSlots; ++i) {
+        if (shadow_[i].seq != 0 && shadow_[i].seq == live_[i].seq &&
+            (matched == kPendingSlots || shadow_[i].seq < shadow_[matched].seq)) {
+            matched = i;
+        }
+    }
+    if (matched == kPendingSlots) {
+        return false;
+    }
+
+    Slot& live_slot = live_[matched];
+    Slot& shadow_slot = shadow_[matched];
+    for (size_t joint = 0; joint < kActionSize; ++joint) {
+        double difference = std::fabs(static_cast<double>(shadow_slot.action[joint]) - live_slot.action[joint]);
+        sum_abs_[joint] += difference;
+        sum_square_[joint] += difference * difference;
+        max_abs_[joint] = std::max(max_abs_[joint], difference);
+    }
+    ++matched_count_;
+
+    *seq = shadow_slot.seq;
+    *live = live_slot.action.data();
+    *shadow = shadow_slot.action.data();
+    // 槽中的数据保留到下一次写入，清除序号使其不再配对
+    live_slot.seq = 0;
+    shadow_slot.seq = 0;
+    return true;
+}
+
+JointDivergence ShadowComparator::Joint(size_t joint) const {
+    JointDivergence divergence = {0.0, 0.0, 0.0};
+    if (matched_count_ > 0) {
+        double count = static_cast<double>(matched_count_);
+        divergence.mean_abs = sum_abs_[joint] / count;
+        divergence.rms = std::sqrt(sum_square_[joint] / count);
+        divergence.max_abs = max_abs_[joint];
+    }
+    return divergence;
+}
+
+void ShadowComparator::PrintStats() const {
+    std::cout << "Shadow policy: compared " << matched_count_ << " action(s) (live " << live_count_ << ", shadow "
+              << shadow_count_ << ")" << std::endl;
+    if (matched_count_ == 0) {
+        return;
+    }
+    std::cout << "Shadow divergence per joint (raw action):" << std::endl;
+    char line[96];
+    snprintf(line, sizeof(line), "  %-10s %10s %10s %10s", "joint", "mean|d|", "rms", "max|d|");
+    std::cout << line << std::endl;
+    for (size_t joint = 0; joint < kActionSize; ++joint) {
+        JointDivergence divergence = Joint(joint);
+        snprintf(line, sizeof(line), "  %-10s %10.5f %10.5f %10.5f", kJointNames[joint], divergence.mean_abs,
+                 divergence.rms, divergence.max_abs);
+        std::cout << line << std::endl;
+    }
+}
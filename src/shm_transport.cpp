@@ -0,0 +1,289 @@
+#include "../include/shm_transport.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+/// @brief 进入futex等待前让出CPU自旋的时长：对端在此期间作答时省去一次休眠与唤醒
+constexpr auto kSpinDuration = std::chrono::microseconds(20);
+
+/// @brief 服务器退出检查的间隔（毫秒）
+constexpr int kServerPollMs = 100;
+
+/// @brief 回显服务器返回的动作数
+constexpr size_t kEchoActionSize = 12;
+
+/// @brief 在futex字上等待其值不再为expected（区域为进程间共享，不能用 FUTEX_PRIVATE）
+void FutexWait(std::atomic<uint32_t>* word, uint32_t expected, std::chrono::nanoseconds timeout) {
+    if (timeout.count() <= 0) {
+        return;
+    }
+    struct timespec relative;
+    relative.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+    relative.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &relative, nullptr, 0);
+}
+
+void FutexWake(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+/// @brief 等待futex字的值变得不同于current，先自旋再休眠
+/// @return 是否在截止时间前发生了变化
+bool WaitWhileEqual(std::atomic<uint32_t>* word, uint32_t current,
+                    std::chrono::steady_clock::time_point deadline) {
+    auto spin_until = std::min(std::chrono::steady_clock::now() + kSpinDuration, deadline);
+    while (word->load(std::memory_order_acquire) == current) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return false;
+        }
+        if (now < spin_until) {
+            sched_yield();
+        } else {
+            FutexWait(word, current, deadline - now);
+        }
+    }
+    return true;
+}
+
+std::string ShmPath(const std::string& name) {
+    return name[0] == '/' ? name : "/" + name;
+}
+
+}  // namespace
+
+ShmClient::ShmClient(const std::string& server_address)
+    : name_(IsShmAddress(server_address) ? server_address.substr(4) : server_address), region_(nullptr),
+      connected_(false), timeout_(std::chrono::milliseconds(kDefaultTimeoutMs)), next_seq_(0),
+      response_(google::protobuf::Arena::CreateMessage<inference::InferenceResponse>(&arena_)) {
+}
+
+ShmClient::~ShmClient() {
+    if (region_ != nullptr) {
+        munmap(region_, sizeof(ShmRegion));
+    }
+}
+
+bool ShmClient::IsShmAddress(const std::string& server_address) {
+    return server_address.compare(0, 4, "shm:") == 0;
+}
+
+bool ShmClient::Connect() {
+    if (region_ != nullptr) {
+        munmap(region_, sizeof(ShmRegion));
+        region_ = nullptr;
+    }
+    connected_ = false;
+
+    int fd = shm_open(ShmPath(name_).c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        std::cerr << "Failed to open shared memory /dev/shm/" << name_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShmRegion)) {
+        std::cerr << "Shared memory /dev/shm/" << name_ << " is too small" << std::endl;
+        close(fd);
+        return false;
+    }
+    void* address = mmap(nullptr, sizeof(ShmRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory: " << strerror(errno) << std::endl;
+        return false;
+    }
+    region_ = static_cast<ShmRegion*>(address);
+
+    const ShmHeader& header = region_->header;
+    if (__atomic_load_n(&header.magic, __ATOMIC_ACQUIRE) != kShmMagic || header.version != kShmVersion ||
+        header.slot_count != kShmSlotCount || header.slot_size != sizeof(ShmSlot)) {
+        std::cerr << "Shared memory /dev/shm/" << name_ << " has an incompatible layout" << std::endl;
+        return false;
+    }
+    next_seq_ = region_->header.request_seq.load(std::memory_order_acquire);
+    connected_ = true;
+
+    // 发送一个简单的测试请求
+    float test_observation = 0.0f;
+    const inference::InferenceResponse& response = PredictInPlace(&test_observation, 1, "test", true);
+    if (!response.success()) {
+        std::cerr << "Failed to connect to shared memory server: " << response.error_message() << std::endl;
+        connected_ = false;
+        return false;
+    }
+    std::cout << "Successfully connected to shared memory server at /dev/shm/" << name_ << std::endl;
+    return true;
+}
+
+bool ShmClient::IsConnected() const {
+    return connected_;
+}
+
+inference::InferenceResponse ShmClient::Predict(const std::vector<float>& observation,
+                                                const std::string& model_type, bool deterministic) {
+    return PredictInPlace(observation.data(), observation.size(), model_type.c_str(), deterministic);
+}
+
+const inference::InferenceResponse& ShmClient::PredictInPlace(const float* observation, size_t count,
+                                                              const char* model_type, bool deterministic) {
+    if (!connected_) {
+        return Fail("Not connected to server");
+    }
+    if (count > kShmMaxObservation) {
+        return Fail("Observation too long for shared memory slot");
+    }
+    if (region_->header.server_pid.load(std::memory_order_acquire) == 0) {
+        return Fail("Shm: server stopped");
+    }
+
+    ShmSlot& slot = region_->slots[next_seq_ % kShmSlotCount];
+    if (slot.state.load(std::memory_order_acquire) == kShmSlotRequest) {
+        // 该槽位上超时的请求还没被服务器处理
+        return Fail("Shm: server is behind");
+    }
+
+    // 写入请求（槽位上若有超时请求迟到的响应，一并覆盖）
+    slot.seq = next_seq_;
+    slot.deterministic = deterministic ? 1 : 0;
+    slot.observation_count = static_cast<uint32_t>(count);
+    strncpy(slot.model_type, model_type, kShmModelTypeSize - 1);
+    slot.model_type[kShmModelTypeSize - 1] = '\0';
+    memcpy(slot.observation, observation, count * sizeof(float));
+    slot.state.store(kShmSlotRequest, std::memory_order_release);
+
+    next_seq_++;
+    region_->header.request_seq.store(next_seq_, std::memory_order_release);
+    FutexWake(&region_->header.request_seq);
+
+    auto deadline = std::chrono::steady_clock::now() + timeout_;
+    if (!WaitWhileEqual(&slot.state, kShmSlotRequest, deadline)) {
+        return Fail("Shm: timed out");
+    }
+
+    // 读出响应后归还槽位
+    response_->Clear();
+    size_t action_count = std::min<size_t>(slot.action_count, kShmMaxAction);
+    response_->mutable_action()->Resize(static_cast<int>(action_count), 0.0f);
+    if (action_count > 0) {
+        memcpy(response_->mutable_action()->mutable_data(), slot.action, action_count * sizeof(float));
+    }
+    response_->set_success(slot.success != 0);
+    if (slot.success == 0) {
+        slot.error_message[kShmErrorSize - 1] = '\0';
+        response_->set_error_message(slot.error_message);
+    }
+    slot.state.store(kShmSlotFree, std::memory_order_release);
+    return *response_;
+}
+
+const inference::InferenceResponse& ShmClient::Fail(const char* error) {
+    response_->Clear();
+    response_->set_success(false);
+    response_->set_error_message(error);
+    return *response_;
+}
+
+ShmServer::ShmServer(const std::string& name)
+    : name_(name), region_(nullptr), next_seq_(0), running_(false) {
+}
+
+ShmServer::~ShmServer() {
+    if (region_ != nullptr) {
+        region_->header.server_pid.store(0, std::memory_order_release);
+        munmap(region_, sizeof(ShmRegion));
+        shm_unlink(ShmPath(name_).c_str());
+    }
+}
+
+bool ShmServer::Create() {
+    std::string path = ShmPath(name_);
+    // 替换旧区域，仍映射着旧区域的客户端须重新连接
+    shm_unlink(path.c_str());
+    int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (fd < 0) {
+        std::cerr << "Failed to create shared memory /dev/shm/" << name_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, sizeof(ShmRegion)) != 0) {
+        std::cerr << "Failed to size shared memory: " << strerror(errno) << std::endl;
+        close(fd);
+        shm_unlink(path.c_str());
+        return false;
+    }
+    void* address = mmap(nullptr, sizeof(ShmRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory: " << strerror(errno) << std::endl;
+        shm_unlink(path.c_str());
+        return false;
+    }
+
+    // 新建的区域全为0，即所有槽位空闲；头部最后写入魔数
+    region_ = static_cast<ShmRegion*>(address);
+    region_->header.version = kShmVersion;
+    region_->header.slot_count = kShmSlotCount;
+    region_->header.slot_size = sizeof(ShmSlot);
+    region_->header.server_pid.store(static_cast<uint32_t>(getpid()), std::memory_order_relaxed);
+    next_seq_ = 0;
+    __atomic_store_n(&region_->header.magic, kShmMagic, __ATOMIC_RELEASE);
+    return true;
+}
+
+int ShmServer::ServeOnce(const Handler& handler, int timeout_ms) {
+    std::atomic<uint32_t>* request_seq = &region_->header.request_seq;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    if (request_seq->load(std::memory_order_acquire) == next_seq_ &&
+        !WaitWhileEqual(request_seq, next_seq_, deadline)) {
+        return 0;
+    }
+
+    int served = 0;
+    uint32_t submitted = request_seq->load(std::memory_order_acquire);
+    while (next_seq_ != submitted) {
+        ShmSlot& slot = region_->slots[next_seq_ % kShmSlotCount];
+        if (slot.state.load(std::memory_order_acquire) == kShmSlotRequest && slot.seq == next_seq_) {
+            slot.observation_count = std::min<uint32_t>(slot.observation_count, kShmMaxObservation);
+            slot.model_type[kShmModelTypeSize - 1] = '\0';
+            slot.success = 0;
+            slot.action_count = 0;
+            slot.error_message[0] = '\0';
+            handler(&slot);
+            slot.state.store(kShmSlotResponse, std::memory_order_release);
+            FutexWake(&slot.state);
+            served++;
+        }
+        next_seq_++;
+    }
+    return served;
+}
+
+void ShmServer::Run(const Handler& handler) {
+    running_.store(true, std::memory_order_release);
+    while (running_.load(std::memory_order_acquire)) {
+        ServeOnce(handler, kServerPollMs);
+    }
+}
+
+void ShmServer::Stop() {
+    running_.store(false, std::memory_order_release);
+}
+
+void ShmServer::Echo(ShmSlot* slot) {
+    for (size_t i = 0; i < kEchoActionSize; ++i) {
+        slot->action[i] = i < slot->observation_count ? slot->observation[i] : 0.0f;
+    }
+    slot->action_count = kEchoActionSize;
+    slot->success = 1;
+}
@@ -0,0 +1,100 @@
+#include "../include/stale_action_policy.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+StaleActionPolicy::StaleActionPolicy(const StaleActionConfig& config)
+    : config_(config), started_(false), damping_(false), scale_(1.0f), missed_(0), counted_missed_(0),
+      stats_(), miss_counts_() {
+}
+
+void StaleActionPolicy::Start(std::chrono::steady_clock::time_point now) {
+    start_ = now;
+    started_ = true;
+}
+
+void StaleActionPolicy::Reset(std::chrono::steady_clock::time_point now) {
+    Start(now);
+    damping_ = false;
+    scale_ = 1.0f;
+    missed_ = 0;
+    counted_missed_ = 0;
+}
+
+ActionFallback StaleActionPolicy::Update(uint64_t action_seq, std::chrono::steady_clock::time_point obs_stamp,
+                                         std::chrono::steady_clock::time_point now) {
+    if (!started_) {
+        Start(now);
+    }
+    stats_.ticks++;
+
+    // 尚无动作时，视作 Start() 前一个周期提交的观察，首个动作同样应在一个周期内到达
+    const std::chrono::steady_clock::duration period = config_.policy_period;
+    std::chrono::steady_clock::duration age = action_seq == 0 ? (now - start_) + period : now - obs_stamp;
+    if (action_seq != 0) {
+        age_histogram_.Record(static_cast<uint64_t>(
+            std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(age).count(), 0)));
+    }
+
+    double periods = std::chrono::duration<double>(age) / std::chrono::duration<double>(period);
+    missed_ = std::max(0, static_cast<int>(std::floor(periods)) - 1);
+    miss_counts_[std::min(missed_, kMissBuckets - 1)]++;
+
+    // 一次连续错过中每多错过一个周期计一次；迟到的新动作不会重复计入已计过的周期
+    if (missed_ == 0) {
+        counted_missed_ = 0;
+    } else if (missed_ > counted_missed_) {
+        stats_.missed_periods += static_cast<uint64_t>(missed_ - counted_missed_);
+        counted_missed_ = missed_;
+    }
+    stats_.max_missed_streak = std::max(stats_.max_missed_streak, static_cast<uint64_t>(missed_));
+
+    if (!damping_ && config_.damp_after > 0 && missed_ >= config_.damp_after) {
+        damping_ = true;
+        stats_.damping_entries++;
+    }
+    if (damping_) {
+        scale_ = 0.0f;
+        stats_.damping_ticks++;
+        return ActionFallback::kDamping;
+    }
+
+    scale_ = 1.0f;
+    if (missed_ == 0) {
+        return ActionFallback::kFresh;
+    }
+    if (config_.mode == StaleActionMode::kHold) {
+        stats_.held_ticks++;
+        return ActionFallback::kHold;
+    }
+
+    // 从错过截止时间的那一刻起连续衰减，避免每个周期跳变一次
+    scale_ = static_cast<float>(std::pow(config_.decay_per_period, periods - 2.0));
+    stats_.decayed_ticks++;
+    return ActionFallback::kDecay;
+}
+
+uint64_t StaleActionPolicy::MissHistogram(int missed) const {
+    if (missed < 0) {
+        return 0;
+    }
+    return miss_counts_[std::min(missed, kMissBuckets - 1)];
+}
+
+void StaleActionPolicy::PrintStats() const {
+    std::cout << "Stale actions: missed " << stats_.missed_periods << " policy period(s)"
+              << ", longest streak " << stats_.max_missed_streak
+              << ", held " << stats_.held_ticks << ", decayed " << stats_.decayed_ticks
+              << ", damping " << stats_.damping_ticks << " of " << stats_.ticks << " ticks";
+    if (stats_.damping_entries > 0) {
+        std::cout << " (damping entered " << stats_.damping_entries << " time(s))";
+    }
+    std::cout << std::endl;
+
+    std::cout << "Missed periods per tick:";
+    for (int i = 0; i < kMissBuckets; ++i) {
+        std::cout << " " << i << (i == kMissBuckets - 1 ? "+" : "") << ":" << miss_counts_[i];
+    }
+    std::cout << std::endl;
+    std::cout << age_histogram_.FormatSummary("action_age") << std::endl;
+}
@@ -0,0 +1,145 @@
+#include "../include/task_executor.h"
+#include "../include/phase_profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+
+namespace {
+
+/// @brief 自动相位计算时考虑的最大超周期（节拍数）
+const uint64_t kMaxHyperperiod = 10000;
+
+}  // namespace
+
+TaskExecutor::TaskExecutor(int64_t tick_period_us)
+    : tick_period_us_(tick_period_us > 0 ? tick_period_us : 1), tick_(0),
+      tick_overruns_(0), max_tick_ns_(0) {
+}
+
+int TaskExecutor::AddTask(const char* name, int period_ticks, Task task, int phase,
+                          uint64_t start_tick, uint64_t end_tick, int64_t budget_us) {
+    if (period_ticks < 1 || !task || start_tick >= end_tick) {
+        std::cerr << "Invalid task parameters: " << name << std::endl;
+        return -1;
+    }
+    if (phase == kAutoPhase) {
+        phase = ChooseAutoPhase(period_ticks);
+    } else if (phase < 0 || phase >= period_ticks) {
+        std::cerr << "Invalid phase " << phase << " for task " << name << std::endl;
+        return -1;
+    }
+
+    TaskEntry entry;
+    entry.name = name;
+    entry.period_ticks = period_ticks;
+    entry.phase = phase;
+    entry.start_tick = start_tick;
+    entry.end_tick = end_tick;
+    entry.budget_ns = static_cast<uint64_t>(budget_us > 0 ? budget_us : tick_period_us_) * 1000;
+    entry.task = std::move(task);
+    entry.runs = 0;
+    entry.overruns = 0;
+    entry.max_ns = 0;
+    entry.total_ns = 0;
+    tasks_.push_back(std::move(entry));
+    return static_cast<int>(tasks_.size()) - 1;
+}
+
+int TaskExecutor::ChooseAutoPhase(int period_ticks) const {
+    // 在所有周期的超周期内统计每个节拍已有的任务数
+    uint64_t hyperperiod = period_ticks;
+    for (const TaskEntry& entry : tasks_) {
+        hyperperiod = std::lcm(hyperperiod, static_cast<uint64_t>(entry.period_ticks));
+        if (hyperperiod > kMaxHyperperiod) {
+            hyperperiod = kMaxHyperperiod;
+            break;
+        }
+    }
+
+    std::vector<int> load(hyperperiod, 0);
+    for (const TaskEntry& entry : tasks_) {
+        for (uint64_t t = entry.phase; t < hyperperiod; t += entry.period_ticks) {
+            load[t]++;
+        }
+    }
+
+    // 选择最坏节拍负载最小的相位，其次比较总负载，再其次取最小相位
+    int best_phase = 0;
+    int best_peak = std::numeric_limits<int>::max();
+    int best_sum = std::numeric_limits<int>::max();
+    for (int phase = 0; phase < period_ticks; ++phase) {
+        int peak = 0;
+        int sum = 0;
+        for (uint64_t t = phase; t < hyperperiod; t += period_ticks) {
+            peak = std::max(peak, load[t]);
+            sum += load[t];
+        }
+        if (peak < best_peak || (peak == best_peak && sum < best_sum)) {
+            best_phase = phase;
+            best_peak = peak;
+            best_sum = sum;
+        }
+    }
+    return best_phase;
+}
+
+void TaskExecutor::Tick() {
+    uint64_t tick_start_ns = PhaseProfiler::NowNs();
+
+    for (TaskEntry& entry : tasks_) {
+        if (tick_ < entry.start_tick || tick_ >= entry.end_tick ||
+            tick_ % entry.period_ticks != static_cast<uint64_t>(entry.phase)) {
+            continue;
+        }
+
+        uint64_t start_ns = PhaseProfiler::NowNs();
+        entry.task(tick_);
+        uint64_t elapsed_ns = PhaseProfiler::NowNs() - start_ns;
+
+        entry.runs++;
+        entry.total_ns += elapsed_ns;
+        if (elapsed_ns > entry.max_ns) {
+            entry.max_ns = elapsed_ns;
+        }
+        if (elapsed_ns > entry.budget_ns) {
+            entry.overruns++;
+        }
+    }
+
+    uint64_t tick_ns = PhaseProfiler::NowNs() - tick_start_ns;
+    if (tick_ns > max_tick_ns_) {
+        max_tick_ns_ = tick_ns;
+    }
+    if (tick_ns > static_cast<uint64_t>(tick_period_us_) * 1000) {
+        tick_overruns_++;
+    }
+    tick_++;
+}
+
+TaskStats TaskExecutor::GetTaskStats(int index) const {
+    const TaskEntry& entry = tasks_.at(index);
+    TaskStats stats;
+    stats.name = entry.name;
+    stats.period_ticks = entry.period_ticks;
+    stats.phase = entry.phase;
+    stats.runs = entry.runs;
+    stats.overruns = entry.overruns;
+    stats.max_us = entry.max_ns / 1000.0;
+    stats.mean_us = entry.runs > 0 ? entry.total_ns / 1000.0 / entry.runs : 0.0;
+    return stats;
+}
+
+void TaskExecutor::PrintStats() const {
+    std::cout << "Task executor: " << tick_ << " ticks of " << tick_period_us_ << " us, "
+              << tick_overruns_ << " tick overruns, max tick " << max_tick_ns_ / 1000.0 << " us" << std::endl;
+    for (int i = 0; i < TaskCount(); ++i) {
+        TaskStats stats = GetTaskStats(i);
+        char line[160];
+        snprintf(line, sizeof(line), "  %-16s period=%-4d phase=%-4d runs=%-9llu overruns=%-6llu mean=%8.1fus max=%8.1fus",
+                 stats.name, stats.period_ticks, stats.phase,
+                 static_cast<unsigned long long>(stats.runs), static_cast<unsigned long long>(stats.overruns),
+                 stats.mean_us, stats.max_us);
+        std::cout << line << std::endl;
+    }
+}
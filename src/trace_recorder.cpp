@@ -0,0 +1,245 @@
+#include "../include/trace_recorder.h"
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+/// @brief SIGUSR1 处理函数写入的eventfd（write是异步信号安全的）
+std::atomic<int> g_signal_fd(-1);
+
+uint64_t NowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/// @brief 导出时的事件快照
+struct EventCopy {
+    const char* name;
+    uint64_t ts_ns;
+    uint8_t type;
+};
+
+}  // namespace
+
+thread_local TraceRecorder::ThreadBuffer* TraceRecorder::current_buffer_ = nullptr;
+
+TraceRecorder& TraceRecorder::Instance() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+TraceRecorder::TraceRecorder() : enabled_(false), signal_thread_stop_(false), dump_count_(0) {
+}
+
+TraceRecorder::~TraceRecorder() {
+    Disable();
+}
+
+bool TraceRecorder::Enable(const std::string& path) {
+    if (signal_thread_.joinable()) {
+        return false;
+    }
+
+    int fd = eventfd(0, EFD_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to create trace signal eventfd: " << strerror(errno) << std::endl;
+        return false;
+    }
+    g_signal_fd.store(fd, std::memory_order_release);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = &TraceRecorder::OnSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGUSR1, &action, nullptr) != 0) {
+        std::cerr << "Failed to install SIGUSR1 handler: " << strerror(errno) << std::endl;
+        g_signal_fd.store(-1, std::memory_order_release);
+        close(fd);
+        return false;
+    }
+
+    path_ = path;
+    signal_thread_stop_.store(false, std::memory_order_relaxed);
+    signal_thread_ = std::thread(&TraceRecorder::SignalLoop, this);
+    enabled_.store(true, std::memory_order_release);
+    return true;
+}
+
+void TraceRecorder::Disable() {
+    enabled_.store(false, std::memory_order_release);
+    if (!signal_thread_.joinable()) {
+        return;
+    }
+
+    signal(SIGUSR1, SIG_DFL);
+    signal_thread_stop_.store(true, std::memory_order_release);
+    int fd = g_signal_fd.load(std::memory_order_acquire);
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) < 0) {
+        // 计数器溢出时导出线程必然已被唤醒，忽略
+    }
+    signal_thread_.join();
+    g_signal_fd.store(-1, std::memory_order_release);
+    close(fd);
+}
+
+void TraceRecorder::OnSignal(int) {
+    int fd = g_signal_fd.load(std::memory_order_relaxed);
+    if (fd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(fd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void TraceRecorder::SignalLoop() {
+    int fd = g_signal_fd.load(std::memory_order_acquire);
+    while (true) {
+        uint64_t count = 0;
+        if (read(fd, &count, sizeof(count)) < 0 && errno != EINTR) {
+            break;
+        }
+        if (signal_thread_stop_.load(std::memory_order_acquire)) {
+            break;
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        std::string path = path_ + "." + std::to_string(++dump_count_);
+        if (Dump(path)) {
+            std::cout << "Trace written to " << path << std::endl;
+        }
+    }
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::CurrentBuffer() {
+    if (current_buffer_ != nullptr) {
+        return current_buffer_;
+    }
+
+    // 每个线程只在首次记录时注册一次（分配与加锁都在这里）
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+    buffer->tid = static_cast<int>(syscall(SYS_gettid));
+    buffer->name.store(nullptr, std::memory_order_relaxed);
+    buffer->events.reset(new Event[kEventsPerThread]);
+    buffer->write_index.store(0, std::memory_order_relaxed);
+    buffer->claim_index.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    buffers_.push_back(std::move(buffer));
+    current_buffer_ = buffers_.back().get();
+    return current_buffer_;
+}
+
+void TraceRecorder::SetThreadName(const char* name) {
+    if (!IsEnabled()) {
+        return;
+    }
+    ThreadBuffer* buffer = CurrentBuffer();
+    if (buffer->name.load(std::memory_order_relaxed) != name) {
+        buffer->name.store(name, std::memory_order_release);
+    }
+}
+
+void TraceRecorder::Record(EventType type, const char* name) {
+    if (!IsEnabled()) {
+        return;
+    }
+
+    ThreadBuffer* buffer = CurrentBuffer();
+    uint64_t index = buffer->write_index.load(std::memory_order_relaxed);
+
+    // 先声明将要覆盖的槽位，导出线程据此丢弃可能被改写的旧事件
+    buffer->claim_index.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Event& event = buffer->events[index & (kEventsPerThread - 1)];
+    event.name.store(name, std::memory_order_relaxed);
+    event.ts_ns.store(NowNs(), std::memory_order_relaxed);
+    event.type.store(type, std::memory_order_relaxed);
+    buffer->write_index.store(index + 1, std::memory_order_release);
+}
+
+bool TraceRecorder::Dump(const std::string& path) {
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        for (const auto& buffer : buffers_) {
+            buffers.push_back(buffer.get());
+        }
+    }
+
+    // 先写临时文件再改名，读者不会看到写了一半的文件
+    std::string temp_path = path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "w");
+    if (file == nullptr) {
+        std::cerr << "Failed to open trace file " << temp_path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Lite_motion\"}}");
+
+    std::vector<EventCopy> events;
+    for (ThreadBuffer* buffer : buffers) {
+        const char* thread_name = buffer->name.load(std::memory_order_acquire);
+        if (thread_name != nullptr) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    buffer->tid, thread_name);
+        }
+
+        // 拷贝环形缓冲区中最近的事件，再丢弃拷贝期间可能被写线程覆盖的部分
+        uint64_t end = buffer->write_index.load(std::memory_order_acquire);
+        uint64_t begin = end > kEventsPerThread ? end - kEventsPerThread : 0;
+        events.clear();
+        for (uint64_t i = begin; i < end; ++i) {
+            const Event& event = buffer->events[i & (kEventsPerThread - 1)];
+            events.push_back({event.name.load(std::memory_order_relaxed), event.ts_ns.load(std::memory_order_relaxed),
+                              event.type.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t claimed = buffer->claim_index.load(std::memory_order_relaxed);
+        uint64_t valid_begin = claimed > kEventsPerThread ? claimed - kEventsPerThread : 0;
+        size_t skip = valid_begin > begin ? static_cast<size_t>(valid_begin - begin) : 0;
+
+        // 起始处被覆盖掉开始事件的结束事件无法配对，一并跳过
+        int depth = 0;
+        for (size_t i = skip; i < events.size(); ++i) {
+            const EventCopy& event = events[i];
+            if (event.type == kBegin) {
+                depth++;
+            } else if (event.type == kEnd) {
+                if (depth == 0) {
+                    continue;
+                }
+                depth--;
+            }
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d%s}", event.name,
+                    static_cast<char>(event.type), event.ts_ns / 1000.0, buffer->tid,
+                    event.type == kInstant ? ",\"s\":\"t\"" : "");
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    bool ok = ferror(file) == 0;
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    if (ok && rename(temp_path.c_str(), path.c_str()) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        std::cerr << "Failed to write trace file " << path << std::endl;
+        unlink(temp_path.c_str());
+    }
+    return ok;
+}
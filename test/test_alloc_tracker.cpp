@@ -0,0 +1,145 @@
+/// @file test_alloc_tracker.cpp
+/// @brief 测试堆分配检查：按阶段计数、预热前与未标记线程不计数、对齐分配计数
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/alloc_tracker.h"
+#include "../include/phase_profiler.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <malloc.h>
+#include <new>
+#include <thread>
+#include <vector>
+
+// 直接调用 operator new，避免编译器省略配对的 new 表达式与 delete
+void* volatile g_sink = nullptr;
+
+void AllocateOnce() {
+    g_sink = ::operator new(16);
+    ::operator delete(g_sink);
+}
+
+bool testDisarmedAndUntracked() {
+    std::cout << "\n=== 测试预热前与未标记线程 ===" << std::endl;
+
+    AllocTracker::SetMode(AllocTracker::kReport);
+    AllocTracker::Disarm();
+    AllocateOnce();
+
+    // 标记前的主线程与其他线程都不计数
+    AllocTracker::Arm();
+    AllocateOnce();
+    std::thread other([]() {
+        AllocTracker::TrackCurrentThread();
+    });
+    other.join();
+    uint64_t count = AllocTracker::TotalCount();
+    AllocTracker::Disarm();
+
+    bool ok = count == 0;
+    std::cout << (ok ? "✓ 未标记线程不计数" : "✗ 未标记线程被计数") << std::endl;
+    return ok;
+}
+
+bool testPhaseCounting() {
+    std::cout << "\n=== 测试按阶段计数 ===" << std::endl;
+
+    PhaseProfiler profiler;
+    AllocTracker::TrackCurrentThread();
+    AllocTracker::Arm();
+
+    AllocateOnce();
+    {
+        ScopedPhase outer(&profiler, kPhaseControlTick);
+        AllocateOnce();
+        {
+            ScopedPhase inner(&profiler, kPhaseScaling);
+            AllocateOnce();
+            AllocateOnce();
+        }
+        AllocateOnce();
+    }
+    // 未传入分析器时同样标记阶段
+    {
+        ScopedPhase phase(nullptr, kPhaseObservation);
+        AllocateOnce();
+    }
+    AllocTracker::Disarm();
+    AllocateOnce();
+
+    bool ok = AllocTracker::PhaseCount(-1) == 1 &&
+              AllocTracker::PhaseCount(kPhaseControlTick) == 2 &&
+              AllocTracker::PhaseCount(kPhaseScaling) == 2 &&
+              AllocTracker::PhaseCount(kPhaseObservation) == 1 &&
+              AllocTracker::TotalCount() == 6;
+    AllocTracker::PrintReport();
+    std::cout << (ok ? "✓ 分配按阶段归类" : "✗ 分配归类错误") << std::endl;
+    return ok;
+}
+
+bool testAlignedAllocations() {
+    std::cout << "\n=== 测试对齐分配 ===" << std::endl;
+
+    AllocTracker::TrackCurrentThread();
+    AllocTracker::Arm();
+    void* ptr = nullptr;
+    int result = posix_memalign(&ptr, 64, 256);
+    bool aligned = result == 0 && reinterpret_cast<uintptr_t>(ptr) % 64 == 0;
+    free(ptr);
+    g_sink = aligned_alloc(64, 256);
+    free(g_sink);
+    g_sink = memalign(64, 256);
+    free(g_sink);
+    g_sink = valloc(256);
+    free(g_sink);
+    g_sink = ::operator new(256, std::align_val_t(64));
+    ::operator delete(g_sink, std::align_val_t(64));
+    // 非法对齐不分配也不计数
+    bool rejected = posix_memalign(&ptr, 3, 256) == EINVAL;
+    uint64_t count = AllocTracker::TotalCount();
+    AllocTracker::Disarm();
+
+    bool ok = aligned && rejected && count == 5;
+    std::cout << (ok ? "✓ " : "✗ ") << "5次对齐分配计数 " << count << " 次" << std::endl;
+    return ok;
+}
+
+bool testReusedBuffers() {
+    std::cout << "\n=== 测试复用缓冲区不分配 ===" << std::endl;
+
+    std::vector<float> source(65, 1.0f);
+    std::vector<float> buffer;
+    buffer.reserve(65);
+
+    AllocTracker::TrackCurrentThread();
+    AllocTracker::Arm();
+    for (int i = 0; i < 1000; ++i) {
+        buffer.clear();
+        for (float value : source) {
+            buffer.push_back(value * 0.5f);
+        }
+        buffer.assign(source.begin(), source.end());
+    }
+    uint64_t count = AllocTracker::TotalCount();
+    AllocTracker::Disarm();
+
+    bool ok = count == 0;
+    std::cout << (ok ? "✓ 稳态下无分配" : "✗ 稳态下发生分配") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::cout << "堆分配检查测试程序" << std::endl;
+    std::cout << "==================" << std::endl;
+
+    bool ok = testDisarmedAndUntracked();
+    ok = testPhaseCounting() && ok;
+    ok = testAlignedAllocations() && ok;
+    ok = testReusedBuffers() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
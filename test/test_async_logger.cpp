@@ -0,0 +1,179 @@
+/// @file test_async_logger.cpp
+/// @brief 测试异步日志的格式化、去重、限频与多线程写入
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/async_logger.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+/// @brief 将stdout重定向到临时文件，运行fn后停止日志器并返回输出内容
+template <typename Fn>
+std::string CaptureStdout(Fn fn) {
+    char path[] = "/tmp/test_async_logger_XXXXXX";
+    int fd = mkstemp(path);
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(fd, STDOUT_FILENO);
+
+    AsyncLogger::Instance().Start();
+    fn();
+    AsyncLogger::Instance().Stop();
+
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    close(fd);
+
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    unlink(path);
+    return content.str();
+}
+
+int CountLines(const std::string& text, const std::string& needle) {
+    int count = 0;
+    std::istringstream stream(text);
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (line.find(needle) != std::string::npos) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool testFormat() {
+    std::cout << "\n=== 测试格式化 ===" << std::endl;
+
+    std::string dynamic = "dynamic";
+    std::string output = CaptureStdout([&] {
+        ASYNC_LOG(kLogInfo, "Move Command - F:{} L:{} T:{}", 0.5f, -0.2, 3);
+        ASYNC_LOG(kLogInfo, "id={} name={} flag={} missing={}", 42u, dynamic, true);
+        ASYNC_LOG(kLogInfo, "long={}", std::string(200, 'x'));
+    });
+
+    bool ok = true;
+    if (output.find("Move Command - F:0.5 L:-0.2 T:3\n") == std::string::npos) {
+        std::cout << "✗ 数值格式化错误" << std::endl;
+        ok = false;
+    }
+    if (output.find("id=42 name=dynamic flag=true missing=\n") == std::string::npos) {
+        std::cout << "✗ 字符串参数或缺失参数处理错误" << std::endl;
+        ok = false;
+    }
+    if (output.find("long=" + std::string(LogRecord::kInlineTextSize - 1, 'x') + "\n") == std::string::npos) {
+        std::cout << "✗ 超长字符串应被截断" << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "✓ 格式化正确" : "✗ 格式化错误") << std::endl;
+    return ok;
+}
+
+bool testDedupAndRateLimit() {
+    std::cout << "\n=== 测试去重与限频 ===" << std::endl;
+
+    std::string output = CaptureStdout([] {
+        for (int i = 0; i < 200; ++i) {
+            ASYNC_LOG_DEDUP(kLogInfo, "try to stand");
+        }
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 5; ++j) {
+                ASYNC_LOG_DEDUP(kLogInfo, "value {}", i);
+            }
+        }
+        for (int i = 0; i < 100; ++i) {
+            ASYNC_LOG_EVERY_MS(kLogInfo, 1000, "limited {}", i);
+        }
+    });
+
+    bool ok = true;
+    if (CountLines(output, "try to stand") != 1) {
+        std::cout << "✗ 重复内容应只输出一次" << std::endl;
+        ok = false;
+    }
+    if (CountLines(output, "value ") != 3 || output.find("value 1 [+4 suppressed]") == std::string::npos) {
+        std::cout << "✗ 内容变化时应输出，并附带被合并的条数" << std::endl;
+        ok = false;
+    }
+    if (CountLines(output, "limited ") != 1 || output.find("limited 0\n") == std::string::npos) {
+        std::cout << "✗ 限频调用点在间隔内应只输出第一条" << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "✓ 去重与限频正确" : "✗ 去重与限频错误") << std::endl;
+    return ok;
+}
+
+bool testConcurrentWriters() {
+    std::cout << "\n=== 测试多线程写入 ===" << std::endl;
+
+    const int kThreads = 4;
+    const int kPerThread = 200;
+    uint64_t dropped_before = AsyncLogger::Instance().DroppedCount();
+
+    std::string output = CaptureStdout([&] {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([t] {
+                for (int i = 0; i < kPerThread; ++i) {
+                    ASYNC_LOG(kLogInfo, "writer {} seq {}", t, i);
+                    if (i % 50 == 0) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    });
+
+    uint64_t dropped = AsyncLogger::Instance().DroppedCount() - dropped_before;
+    int lines = CountLines(output, "writer ");
+    bool ok = lines + static_cast<int>(dropped) == kThreads * kPerThread;
+    std::cout << "输出 " << lines << " 条，丢弃 " << dropped << " 条" << std::endl;
+    std::cout << (ok ? "✓ 没有记录丢失或重复" : "✗ 记录丢失或重复") << std::endl;
+    return ok;
+}
+
+bool testQueueFull() {
+    std::cout << "\n=== 测试队列满时丢弃 ===" << std::endl;
+
+    uint64_t dropped_before = AsyncLogger::Instance().DroppedCount();
+    // 不启动后台线程，写入超过容量的记录
+    for (int i = 0; i < 1500; ++i) {
+        ASYNC_LOG(kLogInfo, "flood {}", i);
+    }
+    uint64_t dropped = AsyncLogger::Instance().DroppedCount() - dropped_before;
+
+    std::string output = CaptureStdout([] {});
+    int lines = CountLines(output, "flood ");
+
+    bool ok = dropped > 0 && lines + static_cast<int>(dropped) == 1500;
+    std::cout << "输出 " << lines << " 条，丢弃 " << dropped << " 条" << std::endl;
+    std::cout << (ok ? "✓ 队列满时不阻塞并计数" : "✗ 队列满时处理错误") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::cout << "异步日志测试程序" << std::endl;
+    std::cout << "================" << std::endl;
+
+    bool ok = testFormat();
+    ok = testDedupAndRateLimit() && ok;
+    ok = testConcurrentWriters() && ok;
+    ok = testQueueFull() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+/// @file test_control_clock.cpp
+/// @brief 测试仿真时钟驱动的事件反应器：定时器顺序、速度与通知处理
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/control_clock.h"
+#include "../include/event_reactor.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+bool testRealTimeClock() {
+    std::cout << "\n=== 测试真实时钟 ===" << std::endl;
+
+    RealTimeClock clock;
+    double start = clock.GetCurrentTime();
+    uint64_t a = clock.NowNs();
+    uint64_t b = clock.NowNs();
+
+    bool ok = !clock.IsSimulated() && b >= a && clock.GetIntervalTime(start) >= 0.0;
+    std::cout << (ok ? "✓ 真实时钟单调" : "✗ 真实时钟异常") << std::endl;
+
+    // 与 steady_clock 同为 CLOCK_MONOTONIC，时间点可以互相比较
+    auto before = std::chrono::steady_clock::now();
+    auto now = clock.Now();
+    auto after = std::chrono::steady_clock::now();
+    bool comparable = before <= now && now <= after;
+    std::cout << (comparable ? "✓ 真实时钟的时间点与 steady_clock 一致" : "✗ 真实时钟的时间点与 steady_clock 不一致")
+              << std::endl;
+    return ok && comparable;
+}
+
+bool testSimulatedTimers() {
+    std::cout << "\n=== 测试仿真定时器 ===" << std::endl;
+
+    SimulatedClock clock;
+    EventReactor reactor(&clock);
+    if (!reactor.Initialize()) {
+        std::cout << "✗ 初始化失败" << std::endl;
+        return false;
+    }
+
+    // 一小时的5ms控制周期与20ms输入周期
+    const uint64_t kControlTicks = 3600ULL * 200;
+    uint64_t control_ticks = 0;
+    uint64_t input_ticks = 0;
+    uint64_t last_control_ns = 0;
+    bool ok = true;
+    std::string order;
+
+    reactor.AddTimer(20000, [&](uint64_t) {
+        input_ticks++;
+        if (input_ticks == 1) {
+            order += 'i';
+        }
+    });
+    reactor.AddTimer(5000, [&](uint64_t count) {
+        control_ticks++;
+        if (control_ticks <= 4) {
+            order += 'c';
+        }
+        uint64_t now = clock.NowNs();
+        if (count != 1 || now != control_ticks * 5000000ULL || now <= last_control_ns) {
+            ok = false;
+        }
+        last_control_ns = now;
+        if (control_ticks == kControlTicks) {
+            reactor.Stop();
+        }
+    });
+
+    auto wall_start = std::chrono::steady_clock::now();
+    reactor.Run();
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    // 20ms时两个定时器同时到期，先注册的输入定时器先触发
+    if (order != "cccic") {
+        std::cout << "✗ 触发顺序错误: " << order << std::endl;
+        ok = false;
+    }
+    if (input_ticks != kControlTicks / 4) {
+        std::cout << "✗ 输入定时器次数错误: " << input_ticks << std::endl;
+        ok = false;
+    }
+    if (clock.GetCurrentTime() != 3600.0) {
+        std::cout << "✗ 仿真时间错误: " << clock.GetCurrentTime() << std::endl;
+        ok = false;
+    }
+    if (wall_s > 60.0) {
+        std::cout << "✗ 仿真耗时过长" << std::endl;
+        ok = false;
+    }
+
+    std::cout << "仿真 3600 s 用时 " << wall_s << " s" << std::endl;
+    std::cout << (ok ? "✓ 仿真定时器正确" : "✗ 仿真定时器错误") << std::endl;
+    return ok;
+}
+
+bool testSimulatedTimePoint() {
+    std::cout << "\n=== 测试仿真时钟的时间点 ===" << std::endl;
+
+    // 动作新鲜度按仿真时间计算：推进20ms后，之前取得的时间点相差20ms
+    SimulatedClock clock;
+    auto stamp = clock.Now();
+    clock.Advance(20 * 1000000ULL);
+    bool ok = clock.Now() - stamp == std::chrono::milliseconds(20);
+    std::cout << (ok ? "✓ 时间点随仿真时钟推进" : "✗ 时间点未随仿真时钟推进") << std::endl;
+    return ok;
+}
+
+bool testSimulatedNotifier() {
+    std::cout << "\n=== 测试仿真时钟下的通知 ===" << std::endl;
+
+    SimulatedClock clock;
+    EventReactor reactor(&clock);
+    reactor.Initialize();
+
+    // 通知在下一个定时器之前被处理
+    int notifier_fd = -1;
+    uint64_t notified_at_ns = 0;
+    notifier_fd = reactor.AddNotifier([&](uint64_t) {
+        notified_at_ns = clock.NowNs();
+    });
+    int ticks = 0;
+    reactor.AddTimer(5000, [&](uint64_t) {
+        ticks++;
+        if (ticks == 2) {
+            EventReactor::Notify(notifier_fd);
+        }
+        if (ticks == 4) {
+            reactor.Stop();
+        }
+    });
+    reactor.Run();
+
+    bool ok = notified_at_ns == 10000000ULL;
+    std::cout << (ok ? "✓ 通知在同一仿真时刻被处理" : "✗ 通知处理时刻错误") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::cout << "控制时钟测试程序" << std::endl;
+    std::cout << "================" << std::endl;
+
+    bool ok = testRealTimeClock();
+    ok = testSimulatedTimers() && ok;
+    ok = testSimulatedTimePoint() && ok;
+    ok = testSimulatedNotifier() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
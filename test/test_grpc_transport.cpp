@@ -0,0 +1,808 @@
+/// @file test_grpc_transport.cpp
+/// @brief 对比TCP回环与Unix域套接字上的推理往返延迟及一元、流式与异步推理，测试会话推理、延迟追踪、复用消息的批量推理、异步推理、截止时间、重连、对冲请求与循环策略的隐状态（进程内回显服务器，65个浮点数的真实观察）
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/alloc_tracker.h"
+#include "../include/grpc_client.h"
+#include "../include/inference_worker.h"
+#include "../include/inference_timing.h"
+#include "../include/latency_histogram.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+const char* kSocketPath = "/tmp/test_grpc_transport.sock";
+const int kWarmupRequests = 200;
+const int kMeasuredRequests = 5000;
+
+/// @brief 回显服务器：返回12个动作，不做推理，只留下传输本身的开销
+///
+/// 会话推理同样回显观察的第一个元素；ForgetSessions() 模拟服务器重启后丢失会话。
+/// SetDelay() 与 SetActionOffset() 模拟慢服务器并区分应答的服务器。
+/// SetStateSize() 模拟循环策略：返回的隐状态为请求中的隐状态各加1（请求不带隐状态时从0开始），即连续推理的步数。
+class EchoService final : public inference::InferenceService::Service {
+public:
+    explicit EchoService(bool sessions_enabled = true)
+        : sessions_enabled_(sessions_enabled), next_session_id_(1), delay_ms_(0), action_offset_(0.0f),
+          state_size_(0) {}
+
+    grpc::Status Predict(grpc::ServerContext*, const inference::InferenceRequest* request,
+                         inference::InferenceResponse* response) override {
+        int64_t receive_ns = request->client_send_ns() != 0 ? WallClockNs() : 0;
+        int delay_ms = delay_ms_.load();
+        if (delay_ms > 0 && request->model_type() != "test") {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+        }
+        for (size_t i = 0; i < kActionSize; ++i) {
+            response->add_action((request->observation_size() > 0 ? request->observation(0) : 0.0f) + action_offset_);
+        }
+        for (int i = 0; i < state_size_; ++i) {
+            response->add_states((i < request->states_size() ? request->states(i) : 0.0f) + 1.0f);
+        }
+        response->set_success(true);
+        if (receive_ns != 0) {
+            // 请求带有发送时刻时填写各阶段时间戳；回显没有计算，计算区间取为空
+            int64_t now_ns = WallClockNs();
+            response->set_client_send_ns(request->client_send_ns());
+            response->set_server_receive_ns(receive_ns);
+            response->set_compute_start_ns(now_ns);
+            response->set_compute_end_ns(now_ns);
+            response->set_server_send_ns(WallClockNs());
+        }
+        return grpc::Status::OK;
+    }
+
+    grpc::Status BatchPredict(grpc::ServerContext* context, const inference::BatchInferenceRequest* request,
+                              inference::BatchInferenceResponse* response) override {
+        for (const inference::InferenceRequest& item : request->requests()) {
+            Predict(context, &item, response->add_responses());
+        }
+        return grpc::Status::OK;
+    }
+
+    grpc::Status StreamPredict(
+        grpc::ServerContext* context,
+        grpc::ServerReaderWriter<inference::InferenceResponse, inference::InferenceRequest>* stream) override {
+        inference::InferenceRequest request;
+        while (stream->Read(&request)) {
+            inference::InferenceResponse response;
+            Predict(context, &request, &response);
+            if (!stream->Write(response)) {
+                break;
+            }
+        }
+        return grpc::Status::OK;
+    }
+
+    grpc::Status OpenSession(grpc::ServerContext*, const inference::OpenSessionRequest* request,
+                             inference::OpenSessionResponse* response) override {
+        if (!sessions_enabled_) {
+            return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "OpenSession not implemented");
+        }
+        int delay_ms = delay_ms_.load();
+        if (delay_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+        }
+        // 接受不超过真实观察长度的任意长度，便于测试观察长度改变后的重新协商
+        if (request->observation_schema() != GrpcClient::kObservationSchema || request->observation_size() == 0 ||
+            request->observation_size() > kObservationSize) {
+            response->set_success(false);
+            response->set_error_message("unsupported observation");
+            return grpc::Status::OK;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t id = next_session_id_++;
+        sessions_[id] = request->observation_size();
+        response->set_success(true);
+        response->set_session_id(id);
+        response->set_action_size(kActionSize);
+        return grpc::Status::OK;
+    }
+
+    grpc::Status SessionPredict(grpc::ServerContext*, const inference::SessionStepRequest* request,
+                                inference::SessionStepResponse* response) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = sessions_.find(request->session_id());
+            if (it == sessions_.end()) {
+                return grpc::Status(grpc::StatusCode::NOT_FOUND, "unknown session");
+            }
+            if (request->observation().size() != it->second * sizeof(float)) {
+                response->set_success(false);
+                response->set_error_message("observation size mismatch");
+                return grpc::Status::OK;
+            }
+        }
+        float first;
+        memcpy(&first, request->observation().data(), sizeof(float));
+        float action[kActionSize];
+        for (size_t i = 0; i < kActionSize; ++i) {
+            action[i] = first;
+        }
+        response->set_seq(request->seq());
+        response->set_action(action, sizeof(action));
+        response->set_success(true);
+        return grpc::Status::OK;
+    }
+
+    /// @brief 设置 Predict 与 OpenSession 的处理延迟（探测请求不延迟）
+    void SetDelay(int delay_ms) { delay_ms_.store(delay_ms); }
+
+    /// @brief 设置加在回显动作上的偏移
+    void SetActionOffset(float offset) { action_offset_ = offset; }
+
+    /// @brief 设置返回的隐状态维数，0为无状态
+    void SetStateSize(int state_size) { state_size_ = state_size; }
+
+    /// @brief 丢弃所有会话
+    void ForgetSessions() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sessions_.clear();
+    }
+
+private:
+    bool sessions_enabled_;
+    std::mutex mutex_;
+    uint64_t next_session_id_;
+    std::map<uint64_t, uint32_t> sessions_;  // 会话号 -> 观察长度
+    std::atomic<int> delay_ms_;
+    float action_offset_;
+    int state_size_;
+};
+
+bool testUnixAddress() {
+    std::cout << "\n=== 测试地址识别 ===" << std::endl;
+
+    bool ok = GrpcClient::IsUnixAddress("unix:/tmp/inference.sock") &&
+              GrpcClient::IsUnixAddress("unix-abstract:inference") &&
+              !GrpcClient::IsUnixAddress("localhost:50151") &&
+              !GrpcClient::IsUnixAddress("192.168.1.120:50151");
+    std::cout << (ok ? "✓ unix: 地址识别正确" : "✗ unix: 地址识别错误") << std::endl;
+    return ok;
+}
+
+/// @brief 测量一个地址上的往返延迟
+/// @param session 是否使用会话推理
+/// @return 成功的请求数
+int MeasureRoundTrip(const std::string& address, bool session, LatencyHistogram* histogram) {
+    GrpcClient client(address);
+    client.SetSessionMode(session);
+    if (!client.Connect()) {
+        return 0;
+    }
+
+    std::vector<float> observation(kObservationSize);
+    for (size_t i = 0; i < observation.size(); ++i) {
+        observation[i] = 0.01f * static_cast<float>(i);
+    }
+    for (int i = 0; i < kWarmupRequests; ++i) {
+        client.PredictInPlace(observation.data(), observation.size());
+    }
+
+    int succeeded = 0;
+    for (int i = 0; i < kMeasuredRequests; ++i) {
+        observation[0] = static_cast<float>(i);
+        auto start = std::chrono::steady_clock::now();
+        const inference::InferenceResponse& response = client.PredictInPlace(observation.data(), observation.size());
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        histogram->Record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        if (response.success() && response.action_size() == static_cast<int>(kActionSize) &&
+            response.action(0) == observation[0]) {
+            succeeded++;
+        }
+    }
+    return succeeded;
+}
+
+bool testTcpVersusUnixSocket() {
+    std::cout << "\n=== 对比TCP回环与Unix域套接字 ===" << std::endl;
+
+    unlink(kSocketPath);
+    EchoService service;
+    int tcp_port = 0;
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &tcp_port);
+    builder.AddListeningPort(std::string("unix:") + kSocketPath, grpc::InsecureServerCredentials());
+    builder.RegisterService(&service);
+    std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+    if (server == nullptr || tcp_port == 0) {
+        std::cout << "✗ 服务器启动失败" << std::endl;
+        return false;
+    }
+
+    LatencyHistogram tcp_histogram;
+    LatencyHistogram unix_histogram;
+    LatencyHistogram session_histogram;
+    int tcp_succeeded = MeasureRoundTrip("127.0.0.1:" + std::to_string(tcp_port), false, &tcp_histogram);
+    int unix_succeeded = MeasureRoundTrip(std::string("unix:") + kSocketPath, false, &unix_histogram);
+    int session_succeeded = MeasureRoundTrip(std::string("unix:") + kSocketPath, true, &session_histogram);
+    server->Shutdown();
+    unlink(kSocketPath);
+
+    std::cout << tcp_histogram.FormatSummary("tcp_loopback") << std::endl;
+    std::cout << unix_histogram.FormatSummary("unix_socket") << std::endl;
+    std::cout << session_histogram.FormatSummary("unix_socket_session") << std::endl;
+    double tcp_p50 = static_cast<double>(tcp_histogram.ValueAtPercentile(50));
+    double unix_p50 = static_cast<double>(unix_histogram.ValueAtPercentile(50));
+    if (tcp_p50 > 0) {
+        std::cout << "Unix域套接字 p50 相对TCP回环: " << (unix_p50 - tcp_p50) / tcp_p50 * 100.0 << "%" << std::endl;
+    }
+    double session_p50 = static_cast<double>(session_histogram.ValueAtPercentile(50));
+    if (unix_p50 > 0) {
+        std::cout << "会话推理 p50 相对普通请求: " << (session_p50 - unix_p50) / unix_p50 * 100.0 << "%" << std::endl;
+    }
+
+    bool ok = tcp_succeeded == kMeasuredRequests && unix_succeeded == kMeasuredRequests &&
+              session_succeeded == kMeasuredRequests;
+    std::cout << (ok ? "✓ 各种传输上的请求全部成功" : "✗ 存在失败的请求") << std::endl;
+    return ok;
+}
+
+bool testSessionRecovery() {
+    std::cout << "\n=== 测试会话重开与回退 ===" << std::endl;
+
+    unlink(kSocketPath);
+    EchoService service;
+    EchoService legacy_service(false);
+    int legacy_port = 0;
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort(std::string("unix:") + kSocketPath, grpc::InsecureServerCredentials());
+    builder.RegisterService(&service);
+    std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+    grpc::ServerBuilder legacy_builder;
+    legacy_builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &legacy_port);
+    legacy_builder.RegisterService(&legacy_service);
+    std::unique_ptr<grpc::Server> legacy_server = legacy_builder.BuildAndStart();
+    if (server == nullptr || legacy_server == nullptr || legacy_port == 0) {
+        std::cout << "✗ 服务器启动失败" << std::endl;
+        return false;
+    }
+
+    std::vector<float> observation(kObservationSize, 0.5f);
+    GrpcClient client(std::string("unix:") + kSocketPath);
+    client.SetSessionMode(true);
+    bool ok = client.Connect();
+    ok = ok && client.PredictInPlace(observation.data(), observation.size(), "flat_terrain").success();
+    ok = ok && client.PredictInPlace(observation.data(), observation.size(), "rough_terrain").success();
+    ok = ok && client.SessionOpenCount() == 2;
+
+    // 服务器丢失会话后，下一步重新打开会话并重发
+    service.ForgetSessions();
+    observation[0] = 2.0f;
+    const inference::InferenceResponse& reopened =
+        client.PredictInPlace(observation.data(), observation.size(), "flat_terrain");
+    ok = ok && reopened.success() && reopened.action(0) == 2.0f && client.SessionOpenCount() == 3;
+    std::cout << (ok ? "✓ 会话丢失后自动重开" : "✗ 会话丢失后未能恢复") << std::endl;
+
+    // 观察长度改变后按新长度重新协商，之后换回原长度同样重新协商
+    const inference::InferenceResponse& resized = client.PredictInPlace(observation.data(), 45, "flat_terrain");
+    bool renegotiated = resized.success() && resized.action(0) == 2.0f && client.SessionOpenCount() == 4 &&
+                        client.PredictInPlace(observation.data(), 45, "flat_terrain").success() &&
+                        client.PredictInPlace(observation.data(), observation.size(), "flat_terrain").success() &&
+                        client.SessionOpenCount() == 5;
+    std::cout << (renegotiated ? "✓ 观察长度改变后重新打开会话" : "✗ 观察长度改变后会话未恢复") << std::endl;
+
+    // 服务器不接受的观察长度
+    bool rejected = !client.PredictInPlace(observation.data(), 0, "flat_terrain").success() &&
+                    !client.PredictInPlace(observation.data(), 0, "new_model").success() &&
+                    client.PredictInPlace(observation.data(), observation.size(), "flat_terrain").success();
+    std::cout << (rejected ? "✓ 观察长度不被接受时拒绝，之后照常恢复" : "✗ 观察长度不被接受时未拒绝") << std::endl;
+
+    // 未实现会话的服务器上退回 Predict
+    GrpcClient legacy_client("127.0.0.1:" + std::to_string(legacy_port));
+    legacy_client.SetSessionMode(true);
+    bool fallback = legacy_client.Connect();
+    for (int i = 0; i < 3 && fallback; ++i) {
+        const inference::InferenceResponse& response = legacy_client.PredictInPlace(observation.data(), observation.size());
+        fallback = response.success() && response.action(0) == 2.0f;
+    }
+    fallback = fallback && legacy_client.SessionOpenCount() == 0;
+    std::cout << (fallback ? "✓ 服务器未实现会话时退回 Predict" : "✗ 未能退回 Predict") << std::endl;
+
+    server->Shutdown();
+    legacy_server->Shutdown();
+    unlink(kSocketPath);
+    return ok && renegotiated && rejected && fallback;
+}
+
+bool testInferenceTracing() {
+    std::cout << "\n=== 测试延迟追踪 ===" << std::endl;
+
+    EchoService service;
+    int port = 0;
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+    builder.RegisterService(&service);
+    std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+    if (server == nullptr || port == 0) {
+        std::cout << "✗ 服务器启动失败" << std::endl;
+        return false;
+    }
+
+    GrpcClient client("127.0.0.1:" + std::to_string(port));
+    client.SetTracing(true);
+    bool ok = client.Connect();
+
+    std::vector<float> observation(kObservationSize, 0.25f);
+    ClockOffsetEstimator estimator;
+    InferenceTiming timing;
+    LatencyHistogram uplink;
+    LatencyHistogram downlink;
+    int traced = 0;
+    for (int i = 0; i < kWarmupRequests && ok; ++i) {
+        const inference::InferenceResponse& response = client.PredictInPlace(observation.data(), observation.size());
+        if (ComputeInferenceTiming(response, WallClockNs(), &estimator, &timing)) {
+            traced++;
+            uplink.Record(static_cast<uint64_t>(std::max<int64_t>(timing.uplink_ns, 0)));
+            downlink.Record(static_cast<uint64_t>(std::max<int64_t>(timing.downlink_ns, 0)));
+        }
+    }
+    server->Shutdown();
+
+    std::cout << uplink.FormatSummary("uplink") << std::endl;
+    std::cout << downlink.FormatSummary("downlink") << std::endl;
+    std::cout << "估计的时钟偏差: " << estimator.Offset() / 1000.0 << " us（同一台机器，应接近0）" << std::endl;
+
+    // 同一时钟下偏差误差不超过最小网络延迟的一半
+    ok = ok && traced == kWarmupRequests && std::abs(estimator.Offset()) <= estimator.Delay() / 2 + 1;
+    ok = ok && timing.uplink_ns + timing.server_queue_ns + timing.compute_ns + timing.server_reply_ns +
+               timing.downlink_ns == timing.round_trip_ns;
+    std::cout << (ok ? "✓ 每个响应都带有完整的时间分解" : "✗ 时间分解缺失或错误") << std::endl;
+    return ok;
+}
+
+/// @brief 在 path 上启动一个回显服务器
+std::unique_ptr<grpc::Server> StartUnixServer(const char* path, EchoService* service) {
+    unlink(path);
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort(std::string("unix:") + path, grpc::InsecureServerCredentials());
+    builder.RegisterService(service);
+    return builder.BuildAndStart();
+}
+
+/// @brief 等待连接状态变为 connected，至多 timeout_ms
+bool WaitForConnected(const GrpcClient& client, bool connected, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (client.IsConnected() != connected) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+bool testRpcModes() {
+    std::cout << "\n=== 对比一元、复用消息、流式与异步流水线推理（Unix域套接字）===" << std::endl;
+
+    EchoService service;
+    std::unique_ptr<grpc::Server> server = StartUnixServer(kSocketPath, &service);
+    GrpcClient client(std::string("unix:") + kSocketPath);
+    if (server == nullptr || !client.Connect()) {
+        std::cout << "✗ 服务器启动或连接失败" << std::endl;
+        return false;
+    }
+    std::vector<float> observation(kObservationSize, 0.0f);
+    LatencyHistogram unary_histogram;
+    LatencyHistogram in_place_histogram;
+    LatencyHistogram stream_histogram;
+    int unary_succeeded = 0;
+    int in_place_succeeded = 0;
+    int stream_succeeded = 0;
+    for (int i = 0; i < kWarmupRequests + kMeasuredRequests; ++i) {
+        observation[0] = static_cast<float>(i);
+        bool measured = i >= kWarmupRequests;
+
+        auto start = std::chrono::steady_clock::now();
+        inference::InferenceResponse unary = client.Predict(observation);
+        auto unary_ns = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        const inference::InferenceResponse& in_place = client.PredictInPlace(observation.data(), observation.size());
+        auto in_place_ns = std::chrono::steady_clock::now() - start;
+        bool in_place_ok = in_place.success() && in_place.action(0) == observation[0];
+
+        start = std::chrono::steady_clock::now();
+        inference::InferenceResponse streamed = client.StreamPredict(observation, "default", true);
+        auto stream_ns = std::chrono::steady_clock::now() - start;
+
+        if (measured) {
+            unary_histogram.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(unary_ns).count());
+            in_place_histogram.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(in_place_ns).count());
+            stream_histogram.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(stream_ns).count());
+            unary_succeeded += unary.success() && unary.action(0) == observation[0];
+            in_place_succeeded += in_place_ok;
+            stream_succeeded += streamed.success() && streamed.action(0) == observation[0];
+        }
+    }
+
+    // 流水线：至多 kDefaultMaxInFlight 个请求同时在途，已满时稍候重试
+    std::atomic<int> async_done(0);
+    std::atomic<int> async_succeeded(0);
+    auto async_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kMeasuredRequests; ++i) {
+        while (!client.PredictAsync(observation, "default", [&](const inference::InferenceResponse& response) {
+                   async_succeeded += response.success();
+                   async_done++;
+               })) {
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+    }
+    while (async_done.load() < kMeasuredRequests) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double async_us =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - async_start).count();
+    // 服务器关闭时等待流处理结束，先由客户端结束流
+    client.CloseStream();
+    server->Shutdown();
+    unlink(kSocketPath);
+
+    std::cout << unary_histogram.FormatSummary("unary_predict") << std::endl;
+    std::cout << in_place_histogram.FormatSummary("unary_in_place") << std::endl;
+    std::cout << stream_histogram.FormatSummary("stream_predict") << std::endl;
+    std::cout << "async_pipelined: " << async_us / kMeasuredRequests << " us/请求（" << GrpcClient::kDefaultMaxInFlight
+              << " 个在途）" << std::endl;
+    bool ok = unary_succeeded == kMeasuredRequests && in_place_succeeded == kMeasuredRequests &&
+              stream_succeeded == kMeasuredRequests && async_succeeded.load() == kMeasuredRequests &&
+              client.StreamOpenCount() == 1;
+    std::cout << (ok ? "✓ 四种方式的请求全部成功，流只打开一次" : "✗ 存在失败的请求") << std::endl;
+    return ok;
+}
+
+bool testReconnect() {
+    std::cout << "\n=== 测试服务器重启后的后台重连 ===" << std::endl;
+
+    EchoService service;
+    std::unique_ptr<grpc::Server> server = StartUnixServer(kSocketPath, &service);
+    GrpcClient client(std::string("unix:") + kSocketPath);
+    bool ok = server != nullptr && client.Connect();
+    client.StartHealthCheck(50);
+
+    // 服务器停止后健康检查将连接标记为断开，推理调用立刻失败
+    server->Shutdown();
+    server.reset();
+    bool lost = ok && WaitForConnected(client, false, 3000);
+    std::vector<float> observation(kObservationSize, 1.0f);
+    auto start = std::chrono::steady_clock::now();
+    bool failed_fast = !client.PredictInPlace(observation.data(), observation.size()).success() &&
+                       std::chrono::steady_clock::now() - start < std::chrono::milliseconds(5);
+    std::cout << (lost && failed_fast ? "✓ 断开后推理立即失败" : "✗ 未发现断开或推理阻塞") << std::endl;
+
+    // 服务器重启后自动恢复
+    server = StartUnixServer(kSocketPath, &service);
+    bool restored = server != nullptr && WaitForConnected(client, true, 5000) &&
+                    client.PredictInPlace(observation.data(), observation.size()).success() &&
+                    client.ReconnectCount() == 1;
+    std::cout << (restored ? "✓ 服务器重启后自动重连" : "✗ 未能自动重连") << std::endl;
+
+    client.StopHealthCheck();
+    if (server != nullptr) {
+        server->Shutdown();
+    }
+    unlink(kSocketPath);
+    return ok && lost && failed_fast && restored;
+}
+
+bool testHedging() {
+    std::cout << "\n=== 测试对冲请求 ===" << std::endl;
+
+    const char* kSecondaryPath = "/tmp/test_grpc_transport_secondary.sock";
+    EchoService primary_service;
+    EchoService secondary_service;
+    secondary_service.SetActionOffset(100.0f);
+    std::unique_ptr<grpc::Server> primary = StartUnixServer(kSocketPath, &primary_service);
+    std::unique_ptr<grpc::Server> secondary = StartUnixServer(kSecondaryPath, &secondary_service);
+
+    GrpcClient client(std::string("unix:") + kSocketPath);
+    bool ok = primary != nullptr && secondary != nullptr && client.Connect();
+    client.SetHedging(std::string("unix:") + kSecondaryPath, std::chrono::milliseconds(5));
+    std::vector<float> observation(kObservationSize, 1.0f);
+
+    // 主服务器及时应答时不对冲
+    bool fast = true;
+    for (int i = 0; i < 20 && ok; ++i) {
+        const inference::InferenceResponse& response = client.PredictInPlace(observation.data(), observation.size());
+        fast = fast && response.success() && response.action(0) == 1.0f;
+    }
+    fast = fast && client.HedgeCount() == 0;
+    std::cout << (fast ? "✓ 主服务器及时应答时只发一次" : "✗ 不必要的对冲") << std::endl;
+
+    // 主服务器变慢时备用服务器的响应胜出，延迟受对冲时限约束
+    primary_service.SetDelay(50);
+    LatencyHistogram histogram;
+    bool hedged = ok;
+    for (int i = 0; i < 10 && ok; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        const inference::InferenceResponse& response = client.PredictInPlace(observation.data(), observation.size());
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        histogram.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        hedged = hedged && response.success() && response.action(0) == 101.0f;
+    }
+    std::cout << histogram.FormatSummary("hedged_slow_primary") << std::endl;
+    hedged = hedged && client.HedgeCount() == 10 && client.HedgeWinCount() == 10 &&
+             histogram.ValueAtPercentile(50) < 40 * 1000 * 1000;
+    std::cout << (hedged ? "✓ 主服务器慢时采用备用服务器的响应" : "✗ 对冲未生效") << std::endl;
+
+    // 主服务器停止后立即改发备用服务器
+    primary_service.SetDelay(0);
+    primary->Shutdown();
+    const inference::InferenceResponse& failover = client.PredictInPlace(observation.data(), observation.size());
+    bool failed_over = failover.success() && failover.action(0) == 101.0f;
+    std::cout << (failed_over ? "✓ 主服务器停止时由备用服务器应答" : "✗ 主服务器停止时推理失败") << std::endl;
+
+    secondary->Shutdown();
+    unlink(kSocketPath);
+    unlink(kSecondaryPath);
+    return ok && fast && hedged && failed_over;
+}
+
+bool testBatchInPlace() {
+    std::cout << "\n=== 测试复用消息的批量推理 ===" << std::endl;
+
+    EchoService service;
+    std::unique_ptr<grpc::Server> server = StartUnixServer(kSocketPath, &service);
+    GrpcClient client(std::string("unix:") + kSocketPath);
+    bool ok = server != nullptr && client.Connect();
+    std::vector<float> flat_observation(kObservationSize, 1.0f);
+    std::vector<float> rough_observation(kObservationSize, 2.0f);
+    std::vector<BatchPredictItem> items = {{&flat_observation, "flat_terrain"}, {&rough_observation, "rough_terrain"}};
+
+    // 与拷贝出响应的 PredictBatch() 结果一致，之后的调用解析进同一组消息
+    std::vector<inference::InferenceResponse> copied = client.PredictBatch(items);
+    const google::protobuf::RepeatedPtrField<inference::InferenceResponse>& responses =
+        client.PredictBatchInPlace(items);
+    const inference::InferenceResponse* first = &responses.Get(0);
+    bool matches = ok && copied.size() == 2 && responses.size() == 2;
+    for (int i = 0; matches && i < 2; ++i) {
+        matches = responses.Get(i).success() && responses.Get(i).action(0) == copied[i].action(0) &&
+                  responses.Get(i).action_size() == static_cast<int>(kActionSize);
+    }
+    bool reused = true;
+    for (int step = 0; step < 100 && ok; ++step) {
+        flat_observation[0] = static_cast<float>(step);
+        client.PredictBatchInPlace(items);
+        reused = reused && &responses.Get(0) == first && responses.Get(0).action(0) == static_cast<float>(step) &&
+                 responses.Get(1).action(0) == 2.0f;
+    }
+    std::cout << (matches && reused ? "✓ 结果与拷贝的批量推理一致，100步复用同一组响应消息"
+                                    : "✗ 复用消息的批量推理结果错误")
+              << std::endl;
+
+    // 项数改变时响应数随之改变
+    items.pop_back();
+    bool resized = ok && client.PredictBatchInPlace(items).size() == 1 && responses.Get(0).success();
+    std::cout << (resized ? "✓ 项数减少后响应与请求一一对应" : "✗ 项数改变后响应数错误") << std::endl;
+
+    // 调用失败时每一项都为失败
+    items.push_back({&rough_observation, "rough_terrain"});
+    client.SetRequestDeadline(std::chrono::milliseconds(20));
+    service.SetDelay(50);
+    client.PredictBatchInPlace(items);
+    bool failed = ok && responses.size() == 2 && !responses.Get(0).success() && !responses.Get(1).success() &&
+                  !responses.Get(1).error_message().empty();
+    service.SetDelay(0);
+    std::cout << (failed ? "✓ 超时时每一项都为失败: " + responses.Get(1).error_message() : "✗ 失败的调用返回了成功的响应")
+              << std::endl;
+
+    server->Shutdown();
+    unlink(kSocketPath);
+    return ok && matches && reused && resized && failed;
+}
+
+/// @brief 本进程当前的线程数
+int ThreadCount() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 8, "Threads:") == 0) {
+            return std::atoi(line.c_str() + 8);
+        }
+    }
+    return -1;
+}
+
+bool testAsyncWorker() {
+    std::cout << "\n=== 测试异步推理的工作线程 ===" << std::endl;
+
+    EchoService service;
+    std::unique_ptr<grpc::Server> server = StartUnixServer(kSocketPath, &service);
+    GrpcClient client(std::string("unix:") + kSocketPath);
+    bool ok = server != nullptr && client.Connect();
+
+    // 完成队列线程在 SetAsync() 中创建，而不是在首次请求时由提交观察的线程创建
+    InferenceWorker worker(&client);
+    int threads_before = ThreadCount();
+    worker.SetAsync(2, 100);
+    bool eager = ok && ThreadCount() == threads_before + 1;
+    std::cout << (eager ? "✓ 完成队列线程在设置异步模式时启动" : "✗ 完成队列线程未提前启动") << std::endl;
+    ok = ok && worker.Start();
+
+    // 提交观察只写三缓冲，请求由工作线程发出
+    std::vector<float> observation(kObservationSize, 0.0f);
+    ActionSample action;
+    bool echoed = true;
+    AllocTracker::SetMode(AllocTracker::kReport);
+    AllocTracker::TrackCurrentThread();
+    for (int tick = 1; tick <= 200 && ok; ++tick) {
+        observation[0] = static_cast<float>(tick);
+        AllocTracker::Arm();
+        worker.SubmitObservation(observation, "flat_terrain");
+        bool fetched = worker.FetchLatestAction(&action);
+        AllocTracker::Disarm();
+        // 观察序号与提交的第几个观察相同，回显的动作即该观察的第一个元素
+        echoed = echoed && (!fetched || action.data[0] == static_cast<float>(action.seq));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    uint64_t submit_allocs = AllocTracker::TotalCount();
+    AllocTracker::SetMode(AllocTracker::kOff);
+    worker.Stop();
+
+    InferenceWorkerStats stats = worker.GetStats();
+    worker.PrintStats();
+    bool published = ok && stats.completed > 0 && echoed;
+    std::cout << (published ? "✓" : "✗") << " 完成 " << stats.completed << " 次异步推理，动作与观察对应" << std::endl;
+    bool no_allocs = ok && submit_allocs == 0;
+    std::cout << (no_allocs ? "✓" : "✗") << " 提交观察与读取动作共分配 " << submit_allocs << " 次" << std::endl;
+
+    server->Shutdown();
+    unlink(kSocketPath);
+    return ok && eager && published && no_allocs;
+}
+
+bool testRequestDeadline() {
+    std::cout << "\n=== 测试按策略周期设置的截止时间 ===" << std::endl;
+
+    EchoService service;
+    std::unique_ptr<grpc::Server> server = StartUnixServer(kSocketPath, &service);
+    GrpcClient client(std::string("unix:") + kSocketPath);
+    bool ok = server != nullptr && client.Connect();
+    client.SetRequestDeadline(std::chrono::milliseconds(20));
+    std::vector<float> observation(kObservationSize, 1.0f);
+
+    // 服务器需要50ms时请求在截止时间后失败，而不是等到应答
+    service.SetDelay(50);
+    auto start = std::chrono::steady_clock::now();
+    bool missed = ok && !client.PredictInPlace(observation.data(), observation.size()).success();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    missed = missed && elapsed < std::chrono::milliseconds(40) && client.DeadlineMissCount() == 1;
+    std::cout << "超时请求耗时: " << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / 1000.0
+              << " ms" << std::endl;
+    std::cout << (missed ? "✓ 超过截止时间的请求及时失败" : "✗ 截止时间未生效") << std::endl;
+
+    // 服务器恢复后照常应答
+    service.SetDelay(0);
+    bool recovered = ok && client.PredictInPlace(observation.data(), observation.size()).success() &&
+                     client.DeadlineMissCount() == 1;
+    std::cout << (recovered ? "✓ 服务器恢复后照常应答" : "✗ 服务器恢复后仍失败") << std::endl;
+
+    // 打开会话的握手同样受截止时间限制，不会让推理线程等待服务器应答
+    GrpcClient session_client(std::string("unix:") + kSocketPath);
+    session_client.SetSessionMode(true);
+    bool session_ok = session_client.Connect();
+    session_client.SetRequestDeadline(std::chrono::milliseconds(20));
+    service.SetDelay(50);
+    start = std::chrono::steady_clock::now();
+    bool handshake_bounded = session_ok &&
+                             !session_client.PredictInPlace(observation.data(), observation.size()).success();
+    elapsed = std::chrono::steady_clock::now() - start;
+    handshake_bounded = handshake_bounded && elapsed < std::chrono::milliseconds(40);
+    service.SetDelay(0);
+    handshake_bounded = handshake_bounded &&
+                        session_client.PredictInPlace(observation.data(), observation.size()).success();
+    std::cout << (handshake_bounded ? "✓ 打开会话在截止时间后失败，之后重新打开" : "✗ 打开会话不受截止时间限制")
+              << std::endl;
+
+    // 失败得到的空动作保持中立姿态，而不是所有关节回到0位
+    RobotAction empty;
+    RobotAction zero;
+    zero.data.assign(kActionSize, 0.0f);
+    RobotCmd empty_cmd = CreateRobotCmd(empty);
+    RobotCmd zero_cmd = CreateRobotCmd(zero);
+    bool neutral = true;
+    for (int i = 0; i < 12; ++i) {
+        neutral = neutral && empty_cmd.joint_cmd[i].position == zero_cmd.joint_cmd[i].position;
+    }
+    neutral = neutral && empty_cmd.joint_cmd[2].position > 1.0f;
+    std::cout << (neutral ? "✓ 空动作保持中立姿态" : "✗ 空动作命令关节回到0位") << std::endl;
+
+    server->Shutdown();
+    unlink(kSocketPath);
+    return ok && missed && recovered && handshake_bounded && neutral;
+}
+
+/// @brief 响应的隐状态是否为 state_size 个 steps
+bool HasState(const inference::InferenceResponse& response, int state_size, float steps) {
+    if (!response.success() || response.states_size() != state_size) {
+        return false;
+    }
+    for (float value : response.states()) {
+        if (value != steps) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool testRecurrentState() {
+    std::cout << "\n=== 测试循环策略的隐状态 ===" << std::endl;
+
+    const int kStateSize = 64;
+    EchoService service;
+    service.SetStateSize(kStateSize);
+    std::unique_ptr<grpc::Server> server = StartUnixServer(kSocketPath, &service);
+    GrpcClient client(std::string("unix:") + kSocketPath);
+    client.SetRecurrent(true);
+    bool ok = server != nullptr && client.Connect();
+    std::vector<float> observation(kObservationSize, 1.0f);
+
+    // 未开启时不带回隐状态，与流式、异步等推理方式一致
+    GrpcClient stateless_client(std::string("unix:") + kSocketPath);
+    bool ignored = ok && stateless_client.Connect() &&
+                   HasState(stateless_client.PredictInPlace(observation.data(), observation.size()), kStateSize, 1.0f) &&
+                   HasState(stateless_client.PredictInPlace(observation.data(), observation.size()), kStateSize, 1.0f);
+    std::cout << (ignored ? "✓ 未开启时不带回隐状态" : "✗ 未开启时仍带回了隐状态") << std::endl;
+
+    // 每个请求带上上一个响应的隐状态，服务器不保存状态
+    bool carried = ok;
+    for (int step = 1; step <= 5 && ok; ++step) {
+        carried = carried && HasState(client.PredictInPlace(observation.data(), observation.size()), kStateSize,
+                                      static_cast<float>(step));
+    }
+    std::cout << (carried ? "✓ 隐状态随请求往返，连续5步" : "✗ 隐状态未被带回") << std::endl;
+
+    // 失败的请求不改变隐状态，之后从最后一次成功的状态继续
+    client.SetRequestDeadline(std::chrono::milliseconds(20));
+    service.SetDelay(50);
+    bool failed = ok && !client.PredictInPlace(observation.data(), observation.size()).success();
+    service.SetDelay(0);
+    bool resumed = failed && HasState(client.PredictInPlace(observation.data(), observation.size()), kStateSize, 6.0f);
+    std::cout << (resumed ? "✓ 失败的请求之后从最后一次成功的隐状态继续" : "✗ 失败的请求破坏了隐状态") << std::endl;
+
+    // 清除后从初始状态开始
+    client.ResetRecurrentState();
+    bool reset = ok && HasState(client.PredictInPlace(observation.data(), observation.size()), kStateSize, 1.0f) &&
+                 HasState(client.PredictInPlace(observation.data(), observation.size()), kStateSize, 2.0f);
+    std::cout << (reset ? "✓ 清除后从初始状态重新开始" : "✗ 清除隐状态未生效") << std::endl;
+
+    // 无状态的策略不带隐状态
+    service.SetStateSize(0);
+    client.PredictInPlace(observation.data(), observation.size());
+    bool stateless = ok && HasState(client.PredictInPlace(observation.data(), observation.size()), 0, 0.0f);
+    std::cout << (stateless ? "✓ 无状态策略的请求与响应不带隐状态" : "✗ 无状态策略收到了隐状态") << std::endl;
+
+    server->Shutdown();
+    unlink(kSocketPath);
+    return ok && ignored && carried && resumed && reset && stateless;
+}
+
+int main() {
+    std::cout << "gRPC传输延迟测试程序" << std::endl;
+    std::cout << "====================" << std::endl;
+
+    bool ok = testUnixAddress();
+    ok = testTcpVersusUnixSocket() && ok;
+    ok = testRpcModes() && ok;
+    ok = testSessionRecovery() && ok;
+    ok = testInferenceTracing() && ok;
+    ok = testBatchInPlace() && ok;
+    ok = testAsyncWorker() && ok;
+    ok = testRequestDeadline() && ok;
+    ok = testReconnect() && ok;
+    ok = testHedging() && ok;
+    ok = testRecurrentState() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+/// @file test_inference_timing.cpp
+/// @brief 测试推理时间分解与NTP式时钟偏差估计
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/inference_timing.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+const int64_t kMicrosecond = 1000;
+const int64_t kMillisecond = 1000 * kMicrosecond;
+
+/// @brief 模拟的一次推理：服务器时钟比客户端快offset_ns
+struct SimulatedCall {
+    int64_t uplink_ns;
+    int64_t queue_ns;
+    int64_t compute_ns;
+    int64_t reply_ns;
+    int64_t downlink_ns;
+};
+
+/// @brief 按模拟的耗时生成带时间戳的响应
+/// @return 客户端收到响应的时刻（客户端时钟）
+int64_t MakeResponse(int64_t client_send_ns, int64_t offset_ns, const SimulatedCall& call,
+                     inference::InferenceResponse* response) {
+    int64_t server_receive = client_send_ns + call.uplink_ns + offset_ns;
+    response->set_client_send_ns(client_send_ns);
+    response->set_server_receive_ns(server_receive);
+    response->set_compute_start_ns(server_receive + call.queue_ns);
+    response->set_compute_end_ns(server_receive + call.queue_ns + call.compute_ns);
+    response->set_server_send_ns(server_receive + call.queue_ns + call.compute_ns + call.reply_ns);
+    return client_send_ns + call.uplink_ns + call.queue_ns + call.compute_ns + call.reply_ns + call.downlink_ns;
+}
+
+bool testBreakdown() {
+    std::cout << "\n=== 测试时间分解 ===" << std::endl;
+
+    ClockOffsetEstimator estimator;
+    InferenceTiming timing;
+    inference::InferenceResponse response;
+
+    // 对称的网络延迟下偏差估计精确，各阶段与模拟值一致
+    const int64_t offset = 3 * kMillisecond;
+    SimulatedCall call = {400 * kMicrosecond, 50 * kMicrosecond, 900 * kMicrosecond, 30 * kMicrosecond,
+                          400 * kMicrosecond};
+    int64_t receive = MakeResponse(1700000000LL * 1000 * kMillisecond, offset, call, &response);
+    bool ok = ComputeInferenceTiming(response, receive, &estimator, &timing) && timing.valid;
+    ok = ok && timing.clock_offset_ns == offset && timing.uplink_ns == call.uplink_ns &&
+         timing.server_queue_ns == call.queue_ns && timing.compute_ns == call.compute_ns &&
+         timing.server_reply_ns == call.reply_ns && timing.downlink_ns == call.downlink_ns;
+    ok = ok && timing.uplink_ns + timing.server_queue_ns + timing.compute_ns + timing.server_reply_ns +
+               timing.downlink_ns == timing.round_trip_ns;
+    std::cout << (ok ? "✓ 各阶段耗时之和等于往返时间" : "✗ 时间分解错误") << std::endl;
+
+    // 服务器未填写时间戳
+    inference::InferenceResponse plain;
+    plain.set_success(true);
+    plain.set_client_send_ns(1);
+    bool rejected = !ComputeInferenceTiming(plain, receive, &estimator, &timing) && !timing.valid &&
+                    estimator.SampleCount() == 1;
+    std::cout << (rejected ? "✓ 时间戳不完整时不计入" : "✗ 时间戳不完整时仍被计入") << std::endl;
+    return ok && rejected;
+}
+
+bool testOffsetUnderAsymmetricQueueing() {
+    std::cout << "\n=== 测试上下行不对称时的偏差估计 ===" << std::endl;
+
+    // 上行偶尔排队数毫秒；单个样本的偏差误差可达排队时长的一半，取延迟最小的样本后误差很小
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int64_t> queueing(0, 4 * kMillisecond);
+    std::uniform_int_distribution<int64_t> jitter(0, 20 * kMicrosecond);
+    const int64_t offset = -250 * kMillisecond;
+
+    ClockOffsetEstimator estimator;
+    InferenceTiming timing;
+    inference::InferenceResponse response;
+    int64_t now = 1700000000LL * 1000 * kMillisecond;
+    int64_t worst_single_error = 0;
+    for (size_t i = 0; i < ClockOffsetEstimator::kWindow; ++i) {
+        SimulatedCall call = {300 * kMicrosecond + (i % 8 == 0 ? jitter(rng) : queueing(rng)), 20 * kMicrosecond,
+                              1 * kMillisecond, 10 * kMicrosecond, 300 * kMicrosecond + jitter(rng)};
+        int64_t receive = MakeResponse(now, offset, call, &response);
+        ComputeInferenceTiming(response, receive, &estimator, &timing);
+        int64_t single = ((response.server_receive_ns() - now) + (response.server_send_ns() - receive)) / 2;
+        worst_single_error = std::max(worst_single_error, std::abs(single - offset));
+        now += 20 * kMillisecond;
+    }
+
+    int64_t error = std::abs(estimator.Offset() - offset);
+    std::cout << "单个样本最大误差: " << worst_single_error / kMicrosecond << " us, 估计误差: "
+              << error / kMicrosecond << " us" << std::endl;
+    bool ok = error <= 20 * kMicrosecond && worst_single_error > kMillisecond;
+    ok = ok && timing.uplink_ns + timing.server_queue_ns + timing.compute_ns + timing.server_reply_ns +
+               timing.downlink_ns == timing.round_trip_ns;
+    std::cout << (ok ? "✓ 估计误差远小于单个样本" : "✗ 偏差估计误差过大") << std::endl;
+    return ok;
+}
+
+bool testOffsetFollowsClockStep() {
+    std::cout << "\n=== 测试时钟跳变后的跟随 ===" << std::endl;
+
+    ClockOffsetEstimator estimator;
+    InferenceTiming timing;
+    inference::InferenceResponse response;
+    int64_t now = 1700000000LL * 1000 * kMillisecond;
+
+    // 先有一个延迟极小的样本，之后服务器时钟跳变
+    SimulatedCall fast = {50 * kMicrosecond, 0, 1 * kMillisecond, 0, 50 * kMicrosecond};
+    SimulatedCall slow = {500 * kMicrosecond, 0, 1 * kMillisecond, 0, 500 * kMicrosecond};
+    ComputeInferenceTiming(response, MakeResponse(now, 0, fast, &response), &estimator, &timing);
+    for (size_t i = 0; i < ClockOffsetEstimator::kWindow - 1; ++i) {
+        now += 20 * kMillisecond;
+        ComputeInferenceTiming(response, MakeResponse(now, 7 * kMillisecond, slow, &response), &estimator, &timing);
+    }
+    bool held = estimator.Offset() == 0;
+
+    // 延迟极小的旧样本移出窗口后，估计跟随新的偏差
+    now += 20 * kMillisecond;
+    ComputeInferenceTiming(response, MakeResponse(now, 7 * kMillisecond, slow, &response), &estimator, &timing);
+    bool followed = estimator.Offset() == 7 * kMillisecond && estimator.Delay() == 1 * kMillisecond;
+
+    bool ok = held && followed;
+    std::cout << (ok ? "✓ 旧样本移出窗口后跟随新偏差" : "✗ 窗口更新错误") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::cout << "推理时间分解测试程序" << std::endl;
+    std::cout << "====================" << std::endl;
+
+    bool ok = testBreakdown();
+    ok = testOffsetUnderAsymmetricQueueing() && ok;
+    ok = testOffsetFollowsClockStep() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+/// @file test_latency_histogram.cpp
+/// @brief 测试延迟直方图的分桶精度与分位数计算
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+bool testBucketBounds() {
+    std::cout << "\n=== 测试分桶边界与精度 ===" << std::endl;
+
+    bool ok = true;
+    size_t last_index = 0;
+    for (uint64_t value = 0; value < (1ULL << 36); value = value < 64 ? value + 1 : value + value / 7) {
+        size_t index = LatencyHistogram::BucketIndex(value);
+        uint64_t upper = LatencyHistogram::BucketUpperBound(index);
+
+        // 桶索引随值单调不减，值不超过所在桶的上界
+        if (index < last_index || value > upper) {
+            std::cout << "✗ 分桶错误: value=" << value << " index=" << index << " upper=" << upper << std::endl;
+            ok = false;
+            break;
+        }
+        // 相对误差不超过 1/32
+        if (value > 0 && static_cast<double>(upper - value) / value > 1.0 / 32) {
+            std::cout << "✗ 精度不足: value=" << value << " upper=" << upper << std::endl;
+            ok = false;
+            break;
+        }
+        last_index = index;
+    }
+
+    if (LatencyHistogram::BucketIndex(~0ULL) != LatencyHistogram::kBucketCount - 1) {
+        std::cout << "✗ 超出范围的值应落入最后一个桶" << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "✓ 分桶边界正确" : "✗ 分桶边界错误") << std::endl;
+    return ok;
+}
+
+bool testPercentiles() {
+    std::cout << "\n=== 测试分位数 ===" << std::endl;
+
+    LatencyHistogram histogram;
+    std::vector<uint64_t> samples;
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> distribution(11.0, 0.8);  // 中位数约60us
+
+    for (int i = 0; i < 200000; ++i) {
+        uint64_t value = static_cast<uint64_t>(distribution(rng));
+        samples.push_back(value);
+        histogram.Record(value);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    bool ok = true;
+    const double percentiles[] = {50.0, 99.0, 99.9};
+    for (double p : percentiles) {
+        uint64_t exact = samples[static_cast<size_t>(p / 100.0 * samples.size()) - 1];
+        uint64_t estimate = histogram.ValueAtPercentile(p);
+        double error = std::abs(static_cast<double>(estimate) - exact) / exact;
+        std::cout << "p" << p << ": 精确 " << exact << "ns, 估计 " << estimate << "ns, 误差 " << error * 100 << "%" << std::endl;
+        if (error > 0.04) {
+            ok = false;
+        }
+    }
+
+    if (histogram.Max() != samples.back() || histogram.Count() != samples.size()) {
+        std::cout << "✗ 最大值或计数错误" << std::endl;
+        ok = false;
+    }
+
+    std::cout << histogram.FormatSummary("lognormal") << std::endl;
+
+    histogram.Reset();
+    if (histogram.Count() != 0 || histogram.ValueAtPercentile(50.0) != 0) {
+        std::cout << "✗ Reset() 后应为空" << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "✓ 分位数误差在范围内" : "✗ 分位数误差过大") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::cout << "延迟直方图测试程序" << std::endl;
+    std::cout << "==================" << std::endl;
+
+    bool ok = testBucketBounds();
+    ok = testPercentiles() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,852 @@
+/// @file test_mlp_policy.cpp
+/// @brief 测试进程内MLP策略：与朴素实现对比的正确性、文本与safetensors加载、维数检查、启动时间与内存、零分配、循环策略（GRU），以及与gRPC往返的延迟对比
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/alloc_tracker.h"
+#include "../include/grpc_client.h"
+#include "../include/inference_worker.h"
+#include "../include/latency_histogram.h"
+#include "../include/local_policy_backend.h"
+#include "../include/mlp_policy.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <iostream>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+const char* kPolicyDirectory = "/tmp/test_mlp_policy";
+const char* kSocketPath = "/tmp/test_mlp_policy.sock";
+const int kWarmupRequests = 200;
+const int kMeasuredRequests = 5000;
+
+/// @brief 一层的参数，行主序权重
+struct LayerSpec {
+    size_t output_size;
+    size_t input_size;
+    Activation activation;
+    std::vector<float> weight;
+    std::vector<float> bias;
+};
+
+/// @brief 按维数生成随机网络，隐藏层使用 activation，最后一层不加激活函数
+std::vector<LayerSpec> RandomNetwork(const std::vector<size_t>& sizes, Activation activation, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<LayerSpec> layers;
+    for (size_t i = 0; i + 1 < sizes.size(); ++i) {
+        LayerSpec layer;
+        layer.input_size = sizes[i];
+        layer.output_size = sizes[i + 1];
+        layer.activation = i + 2 < sizes.size() ? activation : Activation::kIdentity;
+        float scale = 1.0f / std::sqrt(static_cast<float>(layer.input_size));
+        std::uniform_real_distribution<float> weight(-2.0f * scale, 2.0f * scale);
+        std::uniform_real_distribution<float> bias(-0.5f, 0.5f);
+        for (size_t j = 0; j < layer.output_size * layer.input_size; ++j) {
+            layer.weight.push_back(weight(rng));
+        }
+        for (size_t j = 0; j < layer.output_size; ++j) {
+            layer.bias.push_back(bias(rng));
+        }
+        layers.push_back(layer);
+    }
+    return layers;
+}
+
+bool BuildPolicy(const std::vector<LayerSpec>& layers, MlpPolicy* policy) {
+    std::string error;
+    for (const LayerSpec& layer : layers) {
+        if (!policy->AddLayer(layer.weight.data(), layer.bias.data(), layer.output_size, layer.input_size,
+                              layer.activation, &error)) {
+            std::cout << "AddLayer 失败: " << error << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief 朴素的双精度参考实现
+std::vector<double> ReferenceForward(const std::vector<LayerSpec>& layers, const std::vector<float>& observation) {
+    std::vector<double> x(observation.begin(), observation.end());
+    for (const LayerSpec& layer : layers) {
+        std::vector<double> y(layer.output_size);
+        for (size_t row = 0; row < layer.output_size; ++row) {
+            double sum = layer.bias[row];
+            for (size_t col = 0; col < layer.input_size; ++col) {
+                sum += static_cast<double>(layer.weight[row * layer.input_size + col]) * x[col];
+            }
+            switch (layer.activation) {
+                case Activation::kIdentity: break;
+                case Activation::kRelu: sum = sum > 0.0 ? sum : 0.0; break;
+                case Activation::kElu: sum = sum > 0.0 ? sum : std::exp(sum) - 1.0; break;
+                case Activation::kTanh: sum = std::tanh(sum); break;
+            }
+            y[row] = sum;
+        }
+        x = y;
+    }
+    return x;
+}
+
+std::vector<float> RandomObservation(unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+    std::vector<float> observation(kObservationSize);
+    for (float& v : observation) {
+        v = value(rng);
+    }
+    return observation;
+}
+
+/// @brief GRU的参数，门的顺序为 r、z、n
+struct GruSpec {
+    size_t hidden_size;
+    size_t input_size;
+    std::vector<float> weight_ih;
+    std::vector<float> weight_hh;
+    std::vector<float> bias_ih;
+    std::vector<float> bias_hh;
+};
+
+GruSpec RandomGru(size_t hidden_size, size_t input_size, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> value(-0.4f, 0.4f);
+    GruSpec gru;
+    gru.hidden_size = hidden_size;
+    gru.input_size = input_size;
+    for (size_t i = 0; i < 3 * hidden_size * input_size; ++i) {
+        gru.weight_ih.push_back(value(rng));
+    }
+    for (size_t i = 0; i < 3 * hidden_size * hidden_size; ++i) {
+        gru.weight_hh.push_back(value(rng));
+    }
+    for (size_t i = 0; i < 3 * hidden_size; ++i) {
+        gru.bias_ih.push_back(value(rng));
+        gru.bias_hh.push_back(value(rng));
+    }
+    return gru;
+}
+
+/// @brief 朴素的双精度GRU单步，与PyTorch nn.GRU 的公式相同
+std::vector<double> ReferenceGruStep(const GruSpec& gru, const std::vector<float>& observation,
+                                     const std::vector<double>& state) {
+    const size_t hidden = gru.hidden_size;
+    auto gate = [&](size_t row, bool from_hidden) {
+        double sum = from_hidden ? gru.bias_hh[row] : gru.bias_ih[row];
+        if (from_hidden) {
+            for (size_t col = 0; col < hidden; ++col) {
+                sum += static_cast<double>(gru.weight_hh[row * hidden + col]) * state[col];
+            }
+        } else {
+            for (size_t col = 0; col < gru.input_size; ++col) {
+                sum += static_cast<double>(gru.weight_ih[row * gru.input_size + col]) * observation[col];
+            }
+        }
+        return sum;
+    };
+    std::vector<double> next(hidden);
+    for (size_t i = 0; i < hidden; ++i) {
+        double r = 1.0 / (1.0 + std::exp(-(gate(i, false) + gate(i, true))));
+        double z = 1.0 / (1.0 + std::exp(-(gate(hidden + i, false) + gate(hidden + i, true))));
+        double n = std::tanh(gate(2 * hidden + i, false) + r * gate(2 * hidden + i, true));
+        next[i] = (1.0 - z) * n + z * state[i];
+    }
+    return next;
+}
+
+/// @brief 按 include/mlp_policy.h 中的文本格式写出网络
+void WriteText(const std::string& path, const std::vector<LayerSpec>& layers, const GruSpec* gru = nullptr) {
+    std::ofstream out(path);
+    out << "# written by test_mlp_policy\n";
+    out << "lite3_mlp 1\n";
+    if (gru != nullptr) {
+        out << "gru " << gru->hidden_size << " " << gru->input_size << "\n";
+        out.precision(9);
+        for (const std::vector<float>* values : {&gru->weight_ih, &gru->weight_hh, &gru->bias_ih, &gru->bias_hh}) {
+            for (float value : *values) {
+                out << value << " ";
+            }
+            out << "\n";
+        }
+    }
+    for (const LayerSpec& layer : layers) {
+        out << "layer " << layer.output_size << " " << layer.input_size << " " << ActivationName(layer.activation)
+            << "\n";
+        out.precision(9);
+        for (size_t j = 0; j < layer.weight.size(); ++j) {
+            out << layer.weight[j] << ((j + 1) % layer.input_size == 0 ? "\n" : " ");
+        }
+        for (size_t j = 0; j < layer.bias.size(); ++j) {
+            out << layer.bias[j] << (j + 1 == layer.bias.size() ? "\n" : " ");
+        }
+    }
+}
+
+bool testMatchesReference() {
+    std::cout << "\n=== 测试各激活函数与朴素实现一致 ===" << std::endl;
+
+    bool ok = true;
+    const Activation activations[] = {Activation::kIdentity, Activation::kRelu, Activation::kElu, Activation::kTanh};
+    for (Activation activation : activations) {
+        std::vector<LayerSpec> layers = RandomNetwork({kObservationSize, 64, 32, kActionSize}, activation, 7);
+        MlpPolicy policy;
+        if (!BuildPolicy(layers, &policy)) {
+            return false;
+        }
+
+        double max_error = 0.0;
+        for (unsigned trial = 0; trial < 20; ++trial) {
+            std::vector<float> observation = RandomObservation(trial);
+            std::vector<double> expected = ReferenceForward(layers, observation);
+            float action[kActionSize];
+            if (!policy.Evaluate(observation.data(), observation.size(), action)) {
+                std::cout << "✗ Evaluate 失败" << std::endl;
+                return false;
+            }
+            for (size_t i = 0; i < kActionSize; ++i) {
+                max_error = std::max(max_error, std::fabs(action[i] - expected[i]));
+            }
+        }
+        bool passed = max_error < 1e-4;
+        std::cout << (passed ? "✓ " : "✗ ") << ActivationName(activation) << ": 最大误差 " << max_error << std::endl;
+        ok = ok && passed;
+    }
+
+    MlpPolicy policy;
+    BuildPolicy(RandomNetwork({kObservationSize, 512, 256, 128, kActionSize}, Activation::kElu, 1), &policy);
+    bool described = policy.Describe() == "65 -> 512 -> 256 -> 128 -> 12 (elu)" && policy.LayerCount() == 4 &&
+                     policy.ParameterCount() == 65 * 512 + 512 + 512 * 256 + 256 + 256 * 128 + 128 + 128 * 12 + 12;
+    std::cout << (described ? "✓ " : "✗ ") << "网络描述: " << policy.Describe() << ", " << policy.ParameterCount()
+              << " 个参数" << std::endl;
+    return ok && described;
+}
+
+bool testTextFormat() {
+    std::cout << "\n=== 测试文本格式与目录加载 ===" << std::endl;
+
+    mkdir(kPolicyDirectory, 0755);
+    std::vector<LayerSpec> flat = RandomNetwork({kObservationSize, 64, kActionSize}, Activation::kElu, 11);
+    std::vector<LayerSpec> rough = RandomNetwork({kObservationSize, 32, 32, kActionSize}, Activation::kTanh, 12);
+    WriteText(std::string(kPolicyDirectory) + "/flat_terrain.mlp", flat);
+    WriteText(std::string(kPolicyDirectory) + "/rough_terrain.mlp", rough);
+
+    MlpPolicy loaded;
+    std::string error;
+    bool ok = loaded.LoadText(std::string(kPolicyDirectory) + "/flat_terrain.mlp", &error);
+    std::cout << (ok ? "✓ 文本文件加载成功: " + loaded.Describe() : "✗ 加载失败: " + error) << std::endl;
+
+    LocalPolicyBackend backend(std::string("local:") + kPolicyDirectory);
+    bool connected = backend.Connect() && backend.IsConnected() && backend.ModelCount() == 2;
+    std::cout << (connected ? "✓ 目录下的两个模型加载成功" : "✗ 目录加载失败") << std::endl;
+
+    std::vector<float> observation = RandomObservation(3);
+    std::vector<double> expected_flat = ReferenceForward(flat, observation);
+    std::vector<double> expected_rough = ReferenceForward(rough, observation);
+    double max_error = 0.0;
+    bool answered = true;
+    const inference::InferenceResponse& flat_response =
+        backend.PredictInPlace(observation.data(), observation.size(), "flat_terrain");
+    answered = answered && flat_response.success() && flat_response.action_size() == static_cast<int>(kActionSize);
+    for (int i = 0; answered && i < flat_response.action_size(); ++i) {
+        max_error = std::max(max_error, std::fabs(flat_response.action(i) - expected_flat[i]));
+    }
+    inference::InferenceResponse rough_response = backend.Predict(observation, "rough_terrain");
+    answered = answered && rough_response.success() && rough_response.action_size() == static_cast<int>(kActionSize);
+    for (int i = 0; answered && i < rough_response.action_size(); ++i) {
+        max_error = std::max(max_error, std::fabs(rough_response.action(i) - expected_rough[i]));
+    }
+    bool matched = answered && max_error < 1e-4;
+    std::cout << (matched ? "✓ " : "✗ ") << "按模型类型推理，最大误差 " << max_error << std::endl;
+
+    const inference::InferenceResponse& unknown =
+        backend.PredictInPlace(observation.data(), observation.size(), "stand_still");
+    bool rejected = !unknown.success() && unknown.error_message() == "Local: unknown model type";
+    std::cout << (rejected ? "✓ 未知模型类型返回失败" : "✗ 未知模型类型未被拒绝") << std::endl;
+
+    return ok && connected && matched && rejected;
+}
+
+bool testRejectsBadShapes() {
+    std::cout << "\n=== 测试维数与格式检查 ===" << std::endl;
+
+    std::string error;
+    std::vector<LayerSpec> layers = RandomNetwork({kObservationSize, 16, kActionSize}, Activation::kRelu, 5);
+    MlpPolicy policy;
+    bool chained = policy.AddLayer(layers[0].weight.data(), layers[0].bias.data(), 16, kObservationSize,
+                                   Activation::kRelu, &error) &&
+                   !policy.AddLayer(layers[1].weight.data(), layers[1].bias.data(), kActionSize, 15,
+                                    Activation::kIdentity, &error);
+    std::cout << (chained ? "✓ 相邻层维数不符被拒绝: " + error : "✗ 相邻层维数不符未被拒绝") << std::endl;
+
+    MlpPolicy short_input;
+    BuildPolicy(RandomNetwork({kObservationSize - 1, 16, kActionSize}, Activation::kRelu, 6), &short_input);
+    std::vector<float> observation = RandomObservation(1);
+    float action[kActionSize];
+    bool count_checked = !short_input.Evaluate(observation.data(), observation.size(), action);
+    std::cout << (count_checked ? "✓ 观察长度不符时 Evaluate 失败" : "✗ 观察长度不符未被拒绝") << std::endl;
+
+    LocalPolicyBackend backend("local:");
+    std::unique_ptr<MlpPolicy> wrong(new MlpPolicy());
+    BuildPolicy(RandomNetwork({kObservationSize, 16, kActionSize + 1}, Activation::kRelu, 8), wrong.get());
+    bool model_checked = !backend.AddModel("default", std::move(wrong), &error);
+    std::cout << (model_checked ? "✓ 动作维数不符的模型被拒绝: " + error : "✗ 动作维数不符的模型未被拒绝")
+              << std::endl;
+
+    std::string truncated_path = std::string(kPolicyDirectory) + "/truncated.txt";
+    mkdir(kPolicyDirectory, 0755);
+    {
+        std::ofstream out(truncated_path);
+        out << "lite3_mlp 1\nlayer 12 65 elu\n0.1 0.2 0.3\n";
+    }
+    MlpPolicy truncated;
+    bool truncation_checked = !truncated.LoadText(truncated_path, &error) && truncated.LayerCount() == 0;
+    std::cout << (truncation_checked ? "✓ 截断的文件被拒绝: " + error : "✗ 截断的文件未被拒绝") << std::endl;
+    {
+        std::ofstream out(truncated_path);
+        out << "lite3_mlp 2\n";
+    }
+    bool version_checked = !truncated.LoadText(truncated_path, &error);
+    std::cout << (version_checked ? "✓ 不支持的版本被拒绝: " + error : "✗ 不支持的版本未被拒绝") << std::endl;
+    unlink(truncated_path.c_str());
+
+    return chained && count_checked && model_checked && truncation_checked && version_checked;
+}
+
+/// @brief 按safetensors格式写出网络（张量名与rsl_rl相同：actor.0、actor.2 ...）
+/// @param dtype 权重的dtype，用于构造不支持的文件
+/// @param truncate 截掉文件末尾的字节数
+void WriteSafetensors(const std::string& path, const std::vector<LayerSpec>& layers, const std::string& dtype = "F32",
+                      size_t truncate = 0) {
+    std::string header = "{\"__metadata__\":{\"activation\":\"" +
+                         std::string(ActivationName(layers.front().activation)) + "\"}";
+    std::string data;
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const LayerSpec& layer = layers[i];
+        std::string name = "actor." + std::to_string(2 * i);
+        header += ",\"" + name + ".weight\":{\"dtype\":\"" + dtype + "\",\"shape\":[" +
+                  std::to_string(layer.output_size) + "," + std::to_string(layer.input_size) +
+                  "],\"data_offsets\":[" + std::to_string(data.size()) + "," +
+                  std::to_string(data.size() + layer.weight.size() * sizeof(float)) + "]}";
+        data.append(reinterpret_cast<const char*>(layer.weight.data()), layer.weight.size() * sizeof(float));
+        header += ",\"" + name + ".bias\":{\"dtype\":\"F32\",\"shape\":[" + std::to_string(layer.output_size) +
+                  "],\"data_offsets\":[" + std::to_string(data.size()) + "," +
+                  std::to_string(data.size() + layer.bias.size() * sizeof(float)) + "]}";
+        data.append(reinterpret_cast<const char*>(layer.bias.data()), layer.bias.size() * sizeof(float));
+    }
+    header += ",\"critic.0.weight\":{\"dtype\":\"F32\",\"shape\":[0],\"data_offsets\":[0,0]}}";
+    header.append((8 - header.size() % 8) % 8, ' ');
+
+    std::string file;
+    uint64_t header_size = header.size();
+    for (int i = 0; i < 8; ++i) {
+        file.push_back(static_cast<char>((header_size >> (8 * i)) & 0xff));
+    }
+    file += header + data;
+    file.resize(file.size() - truncate);
+
+    // 写入临时文件后 rename，与 scripts/export_policy.py 相同，已映射的旧文件不受影响
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        out.write(file.data(), static_cast<std::streamsize>(file.size()));
+    }
+    rename(temporary.c_str(), path.c_str());
+}
+
+/// @brief 读取 /proc/self/status 中的一项（kB）
+long ReadStatusKb(const char* field) {
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    const size_t length = strlen(field);
+    while (std::getline(in, line)) {
+        if (line.compare(0, length, field) == 0 && line.size() > length && line[length] == ':') {
+            return std::atol(line.c_str() + length + 1);
+        }
+    }
+    return -1;
+}
+
+/// @brief 对比一个后端上的推理结果与参考实现，返回最大误差
+double MaxErrorAgainstReference(LocalPolicyBackend* backend, const char* model_type,
+                                const std::vector<LayerSpec>& layers) {
+    std::vector<float> observation = RandomObservation(21);
+    std::vector<double> expected = ReferenceForward(layers, observation);
+    const inference::InferenceResponse& response =
+        backend->PredictInPlace(observation.data(), observation.size(), model_type);
+    if (!response.success() || response.action_size() != static_cast<int>(kActionSize)) {
+        return 1e9;
+    }
+    double max_error = 0.0;
+    for (size_t i = 0; i < kActionSize; ++i) {
+        max_error = std::max(max_error, std::fabs(response.action(i) - expected[i]));
+    }
+    return max_error;
+}
+
+bool testSafetensors() {
+    std::cout << "\n=== 测试safetensors内存映射加载与替换 ===" << std::endl;
+
+    const std::string directory = std::string(kPolicyDirectory) + "_safetensors";
+    mkdir(directory.c_str(), 0755);
+    std::vector<LayerSpec> flat = RandomNetwork({kObservationSize, 64, 32, kActionSize}, Activation::kElu, 31);
+    std::vector<LayerSpec> rough = RandomNetwork({kObservationSize, 48, kActionSize}, Activation::kTanh, 32);
+    WriteSafetensors(directory + "/flat_terrain.safetensors", flat);
+    WriteSafetensors(directory + "/rough_terrain.safetensors", rough);
+
+    LocalPolicyBackend backend("local:" + directory);
+    bool connected = backend.Connect() && backend.ModelCount() == 2;
+    double flat_error = MaxErrorAgainstReference(&backend, "flat_terrain", flat);
+    double rough_error = MaxErrorAgainstReference(&backend, "rough_terrain", rough);
+    bool loaded = connected && flat_error < 1e-4 && rough_error < 1e-4;
+    std::cout << (loaded ? "✓ " : "✗ ") << "映射加载两个模型，最大误差 " << std::max(flat_error, rough_error)
+              << std::endl;
+
+    MlpPolicy policy;
+    std::string error;
+    bool mapped = policy.Load(directory + "/flat_terrain.safetensors", &error) && policy.IsMapped() &&
+                  policy.Describe() == "65 -> 64 -> 32 -> 12 (elu)";
+    std::cout << (mapped ? "✓ 权重直接使用映射内存: " + policy.Describe() : "✗ 未使用映射: " + error) << std::endl;
+
+    // 训练出新权重后原子替换文件，再重新加载；旧映射在替换前一直有效
+    std::vector<LayerSpec> retrained = RandomNetwork({kObservationSize, 64, 32, kActionSize}, Activation::kElu, 33);
+    WriteSafetensors(directory + "/flat_terrain.safetensors", retrained);
+    double stale_error = MaxErrorAgainstReference(&backend, "flat_terrain", flat);
+    bool reloaded = backend.ReloadModel("flat_terrain", &error) &&
+                    MaxErrorAgainstReference(&backend, "flat_terrain", retrained) < 1e-4;
+    std::cout << (stale_error < 1e-4 && reloaded ? "✓ 替换文件后旧模型仍可用，重新加载后使用新权重"
+                                                 : "✗ 模型替换失败: " + error)
+              << std::endl;
+
+    // 维数不符的新文件不会替换正在使用的模型
+    WriteSafetensors(directory + "/rough_terrain.safetensors",
+                     RandomNetwork({kObservationSize - 1, 48, kActionSize}, Activation::kTanh, 34));
+    bool kept = !backend.ReloadModel("rough_terrain", &error) && !backend.Connect() &&
+                MaxErrorAgainstReference(&backend, "rough_terrain", rough) < 1e-4;
+    std::cout << (kept ? "✓ 观察维数不符被拒绝，继续使用旧模型: " + error : "✗ 维数不符的模型替换了旧模型")
+              << std::endl;
+
+    const std::string bad_path = directory + "/bad.safetensors";
+    WriteSafetensors(bad_path, flat, "I32");
+    bool dtype_checked = !policy.LoadSafetensors(bad_path, &error) && policy.LayerCount() == 0;
+    std::cout << (dtype_checked ? "✓ 非F32权重被拒绝: " + error : "✗ 非F32权重未被拒绝") << std::endl;
+    WriteSafetensors(bad_path, flat, "F32", 16);
+    bool truncation_checked = !policy.LoadSafetensors(bad_path, &error);
+    std::cout << (truncation_checked ? "✓ 截断的文件被拒绝: " + error : "✗ 截断的文件未被拒绝") << std::endl;
+    {
+        std::ofstream out(bad_path, std::ios::binary);
+        out.write("\x10\0\0\0\0\0\0\0{\"a\":{\"dtype\":", 24);
+    }
+    bool header_checked = !policy.LoadSafetensors(bad_path, &error);
+    std::cout << (header_checked ? "✓ 损坏的头部被拒绝: " + error : "✗ 损坏的头部未被拒绝") << std::endl;
+    {
+        // 2^62个F32元素的字节数按64位相乘恰好回绕为0，与空的data_offsets相符
+        std::string header = "{\"x\":{\"dtype\":\"F32\",\"shape\":[4611686018427387904],\"data_offsets\":[0,0]}}";
+        header.append((8 - header.size() % 8) % 8, ' ');
+        std::string file(8, '\0');
+        for (int i = 0; i < 8; ++i) {
+            file[i] = static_cast<char>((static_cast<uint64_t>(header.size()) >> (8 * i)) & 0xff);
+        }
+        file += header + std::string(8, '\0');
+        std::ofstream out(bad_path, std::ios::binary);
+        out.write(file.data(), static_cast<std::streamsize>(file.size()));
+    }
+    bool overflow_checked = !policy.LoadSafetensors(bad_path, &error) &&
+                            error.find("size does not match its shape") != std::string::npos;
+    std::cout << (overflow_checked ? "✓ 元素数溢出的形状被拒绝: " + error : "✗ 元素数溢出的形状未被拒绝: " + error)
+              << std::endl;
+    unlink(bad_path.c_str());
+
+    return loaded && mapped && stale_error < 1e-4 && reloaded && kept && dtype_checked && truncation_checked &&
+           header_checked && overflow_checked;
+}
+
+/// @brief 经推理线程推理一次，返回动作与参考实现的最大误差（超时返回一个大数）
+double WorkerErrorAgainstReference(InferenceWorker* worker, const std::vector<LayerSpec>& layers) {
+    std::vector<float> observation = RandomObservation(22);
+    std::vector<double> expected = ReferenceForward(layers, observation);
+    ActionSample action;
+    worker->FetchLatestAction(&action);
+    uint64_t last_seq = action.seq;
+    worker->SubmitObservation(observation, "flat_terrain");
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!worker->FetchLatestAction(&action) || action.seq == last_seq) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return 1e9;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double max_error = 0.0;
+    for (size_t i = 0; i < kActionSize; ++i) {
+        max_error = std::max(max_error, std::fabs(action.data[i] - expected[i]));
+    }
+    return max_error;
+}
+
+bool testWorkerReload() {
+    std::cout << "\n=== 测试运行中经推理线程重新加载模型 ===" << std::endl;
+
+    const std::string directory = std::string(kPolicyDirectory) + "_reload";
+    mkdir(directory.c_str(), 0755);
+    const std::string path = directory + "/flat_terrain.safetensors";
+    std::vector<LayerSpec> original = RandomNetwork({kObservationSize, 32, kActionSize}, Activation::kElu, 41);
+    WriteSafetensors(path, original);
+
+    LocalPolicyBackend backend("local:" + directory);
+    InferenceWorker worker(&backend);
+    if (!backend.Connect() || !worker.Start()) {
+        std::cout << "✗ 无法加载模型或启动推理线程" << std::endl;
+        return false;
+    }
+
+    // 替换文件本身不影响运行中的模型，请求重新加载后下一次推理使用新权重
+    std::vector<LayerSpec> retrained = RandomNetwork({kObservationSize, 32, kActionSize}, Activation::kElu, 42);
+    WriteSafetensors(path, retrained);
+    bool unchanged = WorkerErrorAgainstReference(&worker, original) < 1e-4;
+    worker.RequestReload();
+    bool reloaded = WorkerErrorAgainstReference(&worker, retrained) < 1e-4;
+    std::cout << (unchanged && reloaded ? "✓ 请求重新加载后推理线程使用新权重" : "✗ 推理线程未按请求重新加载")
+              << std::endl;
+
+    // 维数不符的新文件被拒绝，推理继续使用已加载的模型
+    WriteSafetensors(path, RandomNetwork({kObservationSize - 1, 32, kActionSize}, Activation::kElu, 43));
+    worker.RequestReload();
+    bool kept = WorkerErrorAgainstReference(&worker, retrained) < 1e-4;
+    std::cout << (kept ? "✓ 重新加载失败时继续使用旧模型" : "✗ 重新加载失败后推理结果错误") << std::endl;
+
+    worker.Stop();
+    unlink(path.c_str());
+    rmdir(directory.c_str());
+    return unchanged && reloaded && kept;
+}
+
+/// @brief 加载一个目录，测量耗时与常驻内存的变化
+bool MeasureStartup(const std::string& directory, const char* label, double* load_ms, long* anon_kb,
+                    long* file_kb, std::unique_ptr<LocalPolicyBackend>* backend) {
+    long anon_before = ReadStatusKb("RssAnon");
+    long file_before = ReadStatusKb("RssFile");
+    auto start = std::chrono::steady_clock::now();
+    backend->reset(new LocalPolicyBackend("local:" + directory));
+    bool ok = (*backend)->Connect() && (*backend)->ModelCount() == 2;
+    *load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    *anon_kb = ReadStatusKb("RssAnon") - anon_before;
+    *file_kb = ReadStatusKb("RssFile") - file_before;
+    std::cout << label << ": 加载 " << *load_ms << " ms，RssAnon +" << *anon_kb << " kB，RssFile +" << *file_kb
+              << " kB" << std::endl;
+    return ok;
+}
+
+bool testStartupAndMemory() {
+    std::cout << "\n=== 对比两个地形模型的启动时间与常驻内存（65 -> 512 -> 256 -> 128 -> 12）===" << std::endl;
+
+    const std::string text_directory = std::string(kPolicyDirectory) + "_text";
+    const std::string mapped_directory = std::string(kPolicyDirectory) + "_mapped";
+    mkdir(text_directory.c_str(), 0755);
+    mkdir(mapped_directory.c_str(), 0755);
+    std::vector<LayerSpec> flat = RandomNetwork({kObservationSize, 512, 256, 128, kActionSize}, Activation::kElu, 41);
+    std::vector<LayerSpec> rough = RandomNetwork({kObservationSize, 512, 256, 128, kActionSize}, Activation::kElu, 42);
+    WriteText(text_directory + "/flat_terrain.mlp", flat);
+    WriteText(text_directory + "/rough_terrain.mlp", rough);
+    WriteSafetensors(mapped_directory + "/flat_terrain.safetensors", flat);
+    WriteSafetensors(mapped_directory + "/rough_terrain.safetensors", rough);
+    const long weight_kb = static_cast<long>(2 * 199564 * sizeof(float) / 1024);
+    std::cout << "两个模型共 " << weight_kb << " kB 权重（文件刚写出，位于页缓存中）" << std::endl;
+
+    // 先测映射加载，避免文本加载释放的堆内存被复用而掩盖差异
+    std::unique_ptr<LocalPolicyBackend> mapped;
+    std::unique_ptr<LocalPolicyBackend> text;
+    double mapped_ms = 0.0;
+    double text_ms = 0.0;
+    long mapped_anon = 0, mapped_file = 0, text_anon = 0, text_file = 0;
+    bool ok = MeasureStartup(mapped_directory, "safetensors", &mapped_ms, &mapped_anon, &mapped_file, &mapped);
+    ok = MeasureStartup(text_directory, "text", &text_ms, &text_anon, &text_file, &text) && ok;
+
+    bool same = ok && MaxErrorAgainstReference(mapped.get(), "flat_terrain", flat) < 1e-4 &&
+                MaxErrorAgainstReference(text.get(), "rough_terrain", rough) < 1e-4;
+    bool faster = mapped_ms < text_ms;
+    bool in_place = mapped_anon < weight_kb / 2 && text_anon >= weight_kb / 2;
+    std::cout << (same ? "✓ 两种格式的结果一致" : "✗ 加载失败或结果不一致") << std::endl;
+    std::cout << (faster ? "✓ " : "✗ ") << "映射加载比文本解析快 " << (mapped_ms > 0 ? text_ms / mapped_ms : 0.0)
+              << " 倍" << std::endl;
+    std::cout << (in_place ? "✓ 映射的权重不占用堆内存（计入页缓存共享的 RssFile）" : "✗ 映射加载仍拷贝了权重")
+              << std::endl;
+    return same && faster && in_place;
+}
+
+/// @brief 构造一个 65 -> 512 -> 256 -> 128 -> 12 的ELU策略后端
+bool BuildBenchmarkBackend(LocalPolicyBackend* backend) {
+    std::unique_ptr<MlpPolicy> policy(new MlpPolicy());
+    if (!BuildPolicy(RandomNetwork({kObservationSize, 512, 256, 128, kActionSize}, Activation::kElu, 42),
+                     policy.get())) {
+        return false;
+    }
+    std::string error;
+    if (!backend->AddModel("flat_terrain", std::move(policy), &error) || !backend->Connect()) {
+        std::cout << "✗ 后端初始化失败: " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool testZeroAllocation() {
+    std::cout << "\n=== 测试稳态推理不分配内存 ===" << std::endl;
+
+    LocalPolicyBackend backend("local:");
+    if (!BuildBenchmarkBackend(&backend)) {
+        return false;
+    }
+    std::vector<float> observation = RandomObservation(9);
+    backend.PredictInPlace(observation.data(), observation.size(), "flat_terrain");
+
+    AllocTracker::SetMode(AllocTracker::kReport);
+    AllocTracker::TrackCurrentThread();
+    AllocTracker::Arm();
+    bool succeeded = true;
+    for (int i = 0; i < 1000; ++i) {
+        observation[0] = 0.001f * static_cast<float>(i);
+        succeeded = backend.PredictInPlace(observation.data(), observation.size(), "flat_terrain").success() &&
+                    succeeded;
+    }
+    uint64_t allocs = AllocTracker::TotalCount();
+    AllocTracker::Disarm();
+
+    bool ok = succeeded && allocs == 0;
+    std::cout << (ok ? "✓ " : "✗ ") << "1000次推理分配 " << allocs << " 次" << std::endl;
+    return ok;
+}
+
+/// @brief 由GRU与各层构造循环策略
+bool BuildRecurrentPolicy(const GruSpec& gru, const std::vector<LayerSpec>& layers, MlpPolicy* policy) {
+    std::string error;
+    if (!policy->SetGru(gru.weight_ih.data(), gru.weight_hh.data(), gru.bias_ih.data(), gru.bias_hh.data(),
+                        gru.hidden_size, gru.input_size, &error)) {
+        std::cout << "SetGru 失败: " << error << std::endl;
+        return false;
+    }
+    return BuildPolicy(layers, policy);
+}
+
+/// @brief 以参考实现连续推理 steps 步，返回最后的动作
+std::vector<double> ReferenceRecurrent(const GruSpec& gru, const std::vector<LayerSpec>& layers, int steps,
+                                       std::vector<double>* state) {
+    std::vector<double> action;
+    for (int step = 0; step < steps; ++step) {
+        *state = ReferenceGruStep(gru, RandomObservation(100 + step), *state);
+        action = ReferenceForward(layers, std::vector<float>(state->begin(), state->end()));
+    }
+    return action;
+}
+
+double MaxError(const float* actual, const std::vector<double>& expected) {
+    double max_error = 0.0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        max_error = std::max(max_error, std::fabs(actual[i] - expected[i]));
+    }
+    return max_error;
+}
+
+bool testRecurrent() {
+    std::cout << "\n=== 测试循环策略（GRU） ===" << std::endl;
+
+    const size_t kHidden = 32;
+    GruSpec gru = RandomGru(kHidden, kObservationSize, 51);
+    std::vector<LayerSpec> layers = RandomNetwork({kHidden, 32, kActionSize}, Activation::kElu, 52);
+    MlpPolicy policy;
+    if (!BuildRecurrentPolicy(gru, layers, &policy)) {
+        return false;
+    }
+    bool described = policy.Describe() == "65 -> gru 32 -> 32 -> 12 (elu)" && policy.StateSize() == kHidden &&
+                     policy.InputSize() == kObservationSize;
+    std::cout << (described ? "✓ " : "✗ ") << "网络描述: " << policy.Describe() << std::endl;
+
+    // 隐状态就地更新（state 与 next_state 相同），与参考实现逐步对比
+    std::vector<float> state(kHidden);
+    std::vector<double> expected_state(kHidden, 0.0);
+    double max_error = 0.0;
+    float action[kActionSize];
+    bool evaluated = true;
+    for (int step = 0; step < 20; ++step) {
+        std::vector<float> observation = RandomObservation(100 + step);
+        evaluated = policy.EvaluateRecurrent(observation.data(), observation.size(), step == 0 ? nullptr : state.data(),
+                                             state.data(), action) && evaluated;
+        expected_state = ReferenceGruStep(gru, observation, expected_state);
+        std::vector<double> expected_action =
+            ReferenceForward(layers, std::vector<float>(expected_state.begin(), expected_state.end()));
+        max_error = std::max({max_error, MaxError(action, expected_action), MaxError(state.data(), expected_state)});
+    }
+    bool matched = evaluated && max_error < 1e-4;
+    std::cout << (matched ? "✓ " : "✗ ") << "连续20步的隐状态与动作，最大误差 " << max_error << std::endl;
+
+    std::string error;
+    std::vector<float> observation = RandomObservation(100);
+    MlpPolicy mismatched;
+    std::vector<LayerSpec> narrow = RandomNetwork({kHidden - 1, kActionSize}, Activation::kElu, 53);
+    MlpPolicy quantized;
+    bool rejected = !policy.Evaluate(observation.data(), observation.size(), action) &&
+                    mismatched.SetGru(gru.weight_ih.data(), gru.weight_hh.data(), gru.bias_ih.data(),
+                                      gru.bias_hh.data(), kHidden, kObservationSize, &error) &&
+                    !mismatched.AddLayer(narrow[0].weight.data(), narrow[0].bias.data(), kActionSize, kHidden - 1,
+                                         Activation::kIdentity, &error) &&
+                    !quantized.Quantize(policy, WeightPrecision::kFloat16, {}, &error);
+    std::cout << (rejected ? "✓ 无状态推理、维数不符的第一层与量化被拒绝: " + error : "✗ 未拒绝无效的用法")
+              << std::endl;
+
+    // safetensors（内存映射）与文本格式
+    const std::string directory = std::string(kPolicyDirectory) + "_recurrent";
+    mkdir(directory.c_str(), 0755);
+    MlpPolicy loaded;
+    bool saved = policy.SaveSafetensors(directory + "/flat_terrain.safetensors", &error) &&
+                 loaded.Load(directory + "/flat_terrain.safetensors", &error) && loaded.IsMapped() &&
+                 loaded.StateSize() == kHidden && loaded.Describe() == policy.Describe();
+    WriteText(directory + "/rough_terrain.mlp", layers, &gru);
+    saved = saved && loaded.Load(directory + "/rough_terrain.mlp", &error) && loaded.StateSize() == kHidden;
+    std::cout << (saved ? "✓ safetensors与文本格式的GRU加载成功" : "✗ GRU加载失败: " + error) << std::endl;
+
+    // 后端保存隐状态：连续推理、清除与切换模型
+    LocalPolicyBackend backend("local:" + directory);
+    bool connected = backend.Connect() && backend.ModelCount() == 2;
+    auto step_error = [&](const char* model_type, int step, int expected_steps) {
+        std::vector<float> step_observation = RandomObservation(100 + step);
+        const inference::InferenceResponse& response =
+            backend.PredictInPlace(step_observation.data(), step_observation.size(), model_type);
+        std::vector<double> reference_state(kHidden, 0.0);
+        std::vector<double> expected = ReferenceRecurrent(gru, layers, expected_steps, &reference_state);
+        if (!response.success() || response.states_size() != static_cast<int>(kHidden)) {
+            return 1e9;
+        }
+        return std::max(MaxError(response.action().data(), expected),
+                        MaxError(response.states().data(), reference_state));
+    };
+    double carry_error = 0.0;
+    for (int step = 0; step < 3; ++step) {
+        carry_error = std::max(carry_error, step_error("flat_terrain", step, step + 1));
+    }
+    bool carried = connected && carry_error < 1e-4;
+    std::cout << (carried ? "✓ " : "✗ ") << "后端在推理之间保存隐状态，最大误差 " << carry_error << std::endl;
+
+    backend.ResetRecurrentState();
+    bool reset = step_error("flat_terrain", 0, 1) < 1e-4;
+    step_error("flat_terrain", 1, 2);
+    // 切换模型后从零状态开始，切回来也是
+    reset = reset && step_error("rough_terrain", 0, 1) < 1e-4 && step_error("flat_terrain", 0, 1) < 1e-4;
+    std::cout << (reset ? "✓ 清除隐状态与切换模型后从零状态开始" : "✗ 隐状态未被清除") << std::endl;
+
+    AllocTracker::SetMode(AllocTracker::kReport);
+    AllocTracker::TrackCurrentThread();
+    AllocTracker::Arm();
+    bool succeeded = true;
+    for (int i = 0; i < 1000; ++i) {
+        observation[0] = 0.001f * static_cast<float>(i);
+        succeeded = backend.PredictInPlace(observation.data(), observation.size(), "flat_terrain").success() &&
+                    succeeded;
+    }
+    uint64_t allocs = AllocTracker::TotalCount();
+    AllocTracker::Disarm();
+    bool no_alloc = succeeded && allocs == 0;
+    std::cout << (no_alloc ? "✓ " : "✗ ") << "1000次循环策略推理分配 " << allocs << " 次" << std::endl;
+
+    return described && matched && rejected && saved && connected && carried && reset && no_alloc;
+}
+
+/// @brief 回显服务器：返回12个动作，只留下gRPC传输本身的开销
+class EchoService final : public inference::InferenceService::Service {
+public:
+    grpc::Status Predict(grpc::ServerContext*, const inference::InferenceRequest* request,
+                         inference::InferenceResponse* response) override {
+        for (size_t i = 0; i < kActionSize; ++i) {
+            response->add_action(request->observation_size() > 0 ? request->observation(0) : 0.0f);
+        }
+        response->set_success(true);
+        return grpc::Status::OK;
+    }
+};
+
+/// @brief 测量一个后端上的推理延迟
+/// @return 成功的请求数
+int MeasurePredict(InferenceBackend* backend, const char* model_type, LatencyHistogram* histogram) {
+    std::vector<float> observation = RandomObservation(4);
+    for (int i = 0; i < kWarmupRequests; ++i) {
+        backend->PredictInPlace(observation.data(), observation.size(), model_type);
+    }
+
+    int succeeded = 0;
+    for (int i = 0; i < kMeasuredRequests; ++i) {
+        observation[0] = 0.001f * static_cast<float>(i);
+        auto start = std::chrono::steady_clock::now();
+        const inference::InferenceResponse& response =
+            backend->PredictInPlace(observation.data(), observation.size(), model_type);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        histogram->Record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        if (response.success() && response.action_size() == static_cast<int>(kActionSize)) {
+            succeeded++;
+        }
+    }
+    return succeeded;
+}
+
+bool testLocalVersusGrpc() {
+    std::cout << "\n=== 对比进程内推理与gRPC往返（65 -> 512 -> 256 -> 128 -> 12 ELU）===" << std::endl;
+
+    LocalPolicyBackend local("local:");
+    if (!BuildBenchmarkBackend(&local)) {
+        return false;
+    }
+    LatencyHistogram local_histogram;
+    int local_succeeded = MeasurePredict(&local, "flat_terrain", &local_histogram);
+
+    // gRPC一侧只测传输：回显服务器不做推理，真实服务器的耗时还要加上模型计算
+    unlink(kSocketPath);
+    EchoService service;
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort(std::string("unix:") + kSocketPath, grpc::InsecureServerCredentials());
+    builder.RegisterService(&service);
+    std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+    if (server == nullptr) {
+        std::cout << "✗ 服务器启动失败" << std::endl;
+        return false;
+    }
+    GrpcClient grpc_client(std::string("unix:") + kSocketPath);
+    LatencyHistogram grpc_histogram;
+    int grpc_succeeded = grpc_client.Connect() ? MeasurePredict(&grpc_client, "flat_terrain", &grpc_histogram) : 0;
+    server->Shutdown();
+    unlink(kSocketPath);
+
+    std::cout << local_histogram.FormatSummary("local_mlp") << std::endl;
+    std::cout << grpc_histogram.FormatSummary("grpc_unix_echo") << std::endl;
+    double local_p50 = static_cast<double>(local_histogram.ValueAtPercentile(50));
+    double grpc_p50 = static_cast<double>(grpc_histogram.ValueAtPercentile(50));
+    if (local_p50 > 0) {
+        std::cout << "进程内推理 p50 " << local_p50 / 1000.0 << " us，gRPC回显往返 p50 " << grpc_p50 / 1000.0
+                  << " us（" << grpc_p50 / local_p50 << " 倍）" << std::endl;
+    }
+
+    bool ok = local_succeeded == kMeasuredRequests && grpc_succeeded == kMeasuredRequests;
+    std::cout << (ok ? "✓ 两种方式的请求全部成功" : "✗ 存在失败的请求") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::cout << "进程内MLP策略测试程序" << std::endl;
+    std::cout << "====================" << std::endl;
+
+    bool ok = testMatchesReference();
+    ok = testTextFormat() && ok;
+    ok = testRejectsBadShapes() && ok;
+    ok = testSafetensors() && ok;
+    ok = testWorkerReload() && ok;
+    ok = testStartupAndMemory() && ok;
+    ok = testZeroAllocation() && ok;
+    ok = testRecurrent() && ok;
+    ok = testLocalVersusGrpc() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
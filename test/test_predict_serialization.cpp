@@ -0,0 +1,237 @@
+/// @file test_predict_serialization.cpp
+/// @brief 测试并对比推理请求的填充、序列化与响应解析：逐个追加的新消息 vs arena上复用的消息 vs 会话请求
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/grpc_client.h"
+#include "../include/alloc_tracker.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <google/protobuf/arena.h>
+
+const int kIterations = 100000;
+
+std::vector<float> MakeObservation(float offset) {
+    std::vector<float> observation(kObservationSize);
+    for (size_t i = 0; i < observation.size(); ++i) {
+        observation[i] = offset + 0.01f * static_cast<float>(i);
+    }
+    return observation;
+}
+
+/// @brief 服务器返回的响应在线上的编码
+std::string MakeResponseWire() {
+    inference::InferenceResponse response;
+    for (size_t i = 0; i < kActionSize; ++i) {
+        response.add_action(0.1f * static_cast<float>(i));
+    }
+    response.set_success(true);
+    std::string wire;
+    response.SerializeToString(&wire);
+    return wire;
+}
+
+/// @brief 原先的做法：每步新建消息，逐个追加观察，再逐个拷出动作
+void BuildFresh(const std::vector<float>& observation, const char* model_type, const std::string& response_wire,
+                std::string* request_wire, std::vector<float>* action) {
+    inference::InferenceRequest request;
+    for (float obs : observation) {
+        request.add_observation(obs);
+    }
+    request.add_desired_goal(0.0f);
+    request.add_achieved_goal(0.0f);
+    request.set_model_type(model_type);
+    request.set_deterministic(true);
+    request.SerializeToString(request_wire);
+
+    inference::InferenceResponse response;
+    response.ParseFromString(response_wire);
+    for (int i = 0; i < response.action_size(); ++i) {
+        (*action)[i] = response.action(i);
+    }
+}
+
+bool testEncodingMatches() {
+    std::cout << "\n=== 测试复用消息的编码与新建消息一致 ===" << std::endl;
+
+    google::protobuf::Arena arena;
+    auto* request = google::protobuf::Arena::CreateMessage<inference::InferenceRequest>(&arena);
+    std::string response_wire = MakeResponseWire();
+    std::vector<float> action(kActionSize);
+
+    // 依次改变观察、模型类型与观察长度，复用的请求都应与新建的请求逐字节相同
+    struct Case {
+        std::vector<float> observation;
+        const char* model_type;
+        bool deterministic;
+    };
+    std::vector<Case> cases = {
+        {MakeObservation(0.0f), "flat_terrain", true},
+        {MakeObservation(1.0f), "flat_terrain", true},
+        {MakeObservation(2.0f), "rough_terrain", false},
+        {std::vector<float>(3, 0.5f), "default", true},
+        {MakeObservation(3.0f), "flat_terrain", true},
+    };
+
+    bool ok = true;
+    for (const Case& test_case : cases) {
+        std::string expected;
+        BuildFresh(test_case.observation, test_case.model_type, response_wire, &expected, &action);
+        if (!test_case.deterministic) {
+            inference::InferenceRequest fresh;
+            fresh.ParseFromString(expected);
+            fresh.set_deterministic(false);
+            fresh.SerializeToString(&expected);
+        }
+
+        GrpcClient::FillRequest(test_case.observation.data(), test_case.observation.size(), test_case.model_type,
+                                test_case.deterministic, request);
+        std::string actual;
+        request->SerializeToString(&actual);
+        ok = ok && actual == expected;
+    }
+    std::cout << (ok ? "✓ 编码逐字节一致" : "✗ 编码不一致") << std::endl;
+    return ok;
+}
+
+bool testReusedMessagesDoNotAllocate() {
+    std::cout << "\n=== 对比每步的耗时与堆分配 ===" << std::endl;
+
+    std::vector<float> observation = MakeObservation(0.0f);
+    std::string response_wire = MakeResponseWire();
+
+    // 原先的做法
+    std::string request_wire;
+    std::vector<float> fresh_action(kActionSize);
+    BuildFresh(observation, "rough_terrain", response_wire, &request_wire, &fresh_action);
+
+    AllocTracker::SetMode(AllocTracker::kReport);
+    AllocTracker::TrackCurrentThread();
+    AllocTracker::Arm();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        observation[0] = static_cast<float>(i);
+        BuildFresh(observation, "rough_terrain", response_wire, &request_wire, &fresh_action);
+    }
+    auto fresh_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    uint64_t fresh_allocs = AllocTracker::TotalCount();
+    AllocTracker::Disarm();
+
+    // 复用arena上的消息，序列化进预先分配的缓冲，动作直接从响应中读取
+    google::protobuf::Arena arena;
+    auto* request = google::protobuf::Arena::CreateMessage<inference::InferenceRequest>(&arena);
+    auto* response = google::protobuf::Arena::CreateMessage<inference::InferenceResponse>(&arena);
+    std::vector<char> buffer(1024);
+    GrpcClient::FillRequest(observation.data(), observation.size(), "rough_terrain", true, request);
+    response->ParseFromArray(response_wire.data(), static_cast<int>(response_wire.size()));
+
+    float checksum = 0.0f;
+    AllocTracker::Arm();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        observation[0] = static_cast<float>(i);
+        GrpcClient::FillRequest(observation.data(), observation.size(), "rough_terrain", true, request);
+        request->SerializeToArray(buffer.data(), static_cast<int>(request->ByteSizeLong()));
+        response->ParseFromArray(response_wire.data(), static_cast<int>(response_wire.size()));
+        const float* action = response->action().data();
+        checksum += action[kActionSize - 1];
+    }
+    auto reused_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    uint64_t reused_allocs = AllocTracker::TotalCount();
+    AllocTracker::Disarm();
+
+    std::cout << "新建消息: " << fresh_ns.count() / kIterations << " ns/步, "
+              << static_cast<double>(fresh_allocs) / kIterations << " 次分配/步" << std::endl;
+    std::cout << "复用消息: " << reused_ns.count() / kIterations << " ns/步, "
+              << static_cast<double>(reused_allocs) / kIterations << " 次分配/步" << std::endl;
+
+    bool ok = fresh_allocs > 0 && reused_allocs == 0 && checksum > 0.0f &&
+              response->action_size() == static_cast<int>(kActionSize);
+    std::cout << (ok ? "✓ 复用消息在稳态下无分配" : "✗ 复用消息仍有分配") << std::endl;
+    return ok;
+}
+
+bool testSessionStepPayload() {
+    std::cout << "\n=== 对比会话请求与普通请求 ===" << std::endl;
+
+    std::vector<float> observation = MakeObservation(0.0f);
+    google::protobuf::Arena arena;
+    auto* request = google::protobuf::Arena::CreateMessage<inference::InferenceRequest>(&arena);
+    auto* response = google::protobuf::Arena::CreateMessage<inference::InferenceResponse>(&arena);
+    auto* step = google::protobuf::Arena::CreateMessage<inference::SessionStepRequest>(&arena);
+    auto* step_response = google::protobuf::Arena::CreateMessage<inference::SessionStepResponse>(&arena);
+    std::vector<char> buffer(1024);
+
+    std::string response_wire = MakeResponseWire();
+    float action[kActionSize];
+    for (size_t i = 0; i < kActionSize; ++i) {
+        action[i] = 0.1f * static_cast<float>(i);
+    }
+    step_response->set_seq(1);
+    step_response->set_action(action, sizeof(action));
+    step_response->set_success(true);
+    std::string step_response_wire;
+    step_response->SerializeToString(&step_response_wire);
+
+    GrpcClient::FillRequest(observation.data(), observation.size(), "rough_terrain", true, request);
+    GrpcClient::FillSessionStep(1, 1, observation.data(), observation.size(), step);
+    size_t request_bytes = request->ByteSizeLong();
+    size_t step_bytes = step->ByteSizeLong();
+
+    // 编码逐字节还原观察
+    std::string step_wire;
+    step->SerializeToString(&step_wire);
+    inference::SessionStepRequest decoded;
+    decoded.ParseFromString(step_wire);
+    bool ok = decoded.observation().size() == observation.size() * sizeof(float) &&
+              memcmp(decoded.observation().data(), observation.data(), decoded.observation().size()) == 0;
+
+    // 每步：填充并序列化请求，解析响应并读出动作
+    float checksum = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        observation[0] = static_cast<float>(i);
+        GrpcClient::FillRequest(observation.data(), observation.size(), "rough_terrain", true, request);
+        request->SerializeToArray(buffer.data(), static_cast<int>(request->ByteSizeLong()));
+        response->ParseFromArray(response_wire.data(), static_cast<int>(response_wire.size()));
+        checksum += response->action(kActionSize - 1);
+    }
+    auto request_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    AllocTracker::Arm();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        observation[0] = static_cast<float>(i);
+        GrpcClient::FillSessionStep(1, static_cast<uint64_t>(i), observation.data(), observation.size(), step);
+        step->SerializeToArray(buffer.data(), static_cast<int>(step->ByteSizeLong()));
+        step_response->ParseFromArray(step_response_wire.data(), static_cast<int>(step_response_wire.size()));
+        memcpy(action, step_response->action().data(), sizeof(action));
+        checksum += action[kActionSize - 1];
+    }
+    auto step_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    uint64_t step_allocs = AllocTracker::TotalCount();
+    AllocTracker::Disarm();
+
+    std::cout << "普通请求: " << request_bytes << " 字节, " << request_ns.count() / kIterations << " ns/步" << std::endl;
+    std::cout << "会话请求: " << step_bytes << " 字节, " << step_ns.count() / kIterations << " ns/步, "
+              << static_cast<double>(step_allocs) / kIterations << " 次分配/步" << std::endl;
+
+    ok = ok && step_bytes < request_bytes && step_allocs == 0 && checksum > 0.0f;
+    std::cout << (ok ? "✓ 会话请求更小且稳态下无分配" : "✗ 会话请求编码或分配不符合预期") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::cout << "推理请求序列化测试程序" << std::endl;
+    std::cout << "======================" << std::endl;
+
+    bool ok = testEncodingMatches();
+    ok = testReusedMessagesDoNotAllocate() && ok;
+    ok = testSessionStepPayload() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+/// @file test_quantized_policy.cpp
+/// @brief 测试量化的MLP策略：半精度转换、按DataLogger观察CSV标定、int8/fp16相对fp32的动作误差上限、safetensors往返，以及三种精度的推理基准
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/latency_histogram.h"
+#include "../include/mlp_policy.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+const size_t kObservationSize = 65;  // 与 grpc_client.h 相同，本测试不依赖protobuf
+const size_t kActionSize = 12;
+const char* kCsvPath = "/tmp/test_quantized_policy_observation.csv";
+const char* kModelPath = "/tmp/test_quantized_policy.safetensors";
+const int kCalibrationSamples = 2000;
+const int kEvaluationSamples = 2000;
+const int kMeasuredSteps = 5000;
+
+/// @brief int8动作误差上限（相对fp32动作的最大绝对值）
+const double kInt8ErrorBound = 0.05;
+
+/// @brief fp16动作误差上限（相对fp32动作的最大绝对值）
+const double kFloat16ErrorBound = 0.002;
+
+/// @brief 构造 65 -> 512 -> 256 -> 128 -> 12 的ELU策略，权重按输入维数缩放
+bool BuildPolicy(unsigned seed, MlpPolicy* policy) {
+    const size_t sizes[] = {kObservationSize, 512, 256, 128, kActionSize};
+    std::mt19937 rng(seed);
+    std::string error;
+    for (size_t i = 0; i + 1 < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        const size_t rows = sizes[i + 1];
+        const size_t cols = sizes[i];
+        std::normal_distribution<float> weight(0.0f, 1.0f / std::sqrt(static_cast<float>(cols)));
+        std::uniform_real_distribution<float> bias(-0.1f, 0.1f);
+        std::vector<float> w(rows * cols);
+        std::vector<float> b(rows);
+        for (float& value : w) {
+            value = weight(rng);
+        }
+        for (float& value : b) {
+            value = bias(rng);
+        }
+        Activation activation = i + 2 < sizeof(sizes) / sizeof(sizes[0]) ? Activation::kElu : Activation::kIdentity;
+        if (!policy->AddLayer(w.data(), b.data(), rows, cols, activation, &error)) {
+            std::cout << "AddLayer 失败: " << error << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief 类似机器人观察的随机数据：各维的幅值不同（角速度、重力、指令、关节位置与速度、上一次动作）
+std::vector<float> RandomObservations(int count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::vector<float> observations;
+    for (int i = 0; i < count; ++i) {
+        for (size_t j = 0; j < kObservationSize; ++j) {
+            float scale = j < 3 ? 1.5f : (j < 6 ? 0.3f : (j < 9 ? 0.8f : (j < 29 ? 0.4f : (j < 41 ? 4.0f : 1.0f))));
+            observations.push_back(scale * normal(rng));
+        }
+    }
+    return observations;
+}
+
+/// @brief 按 DataLogger 的格式写出观察CSV
+void WriteObservationCsv(const std::string& path, const std::vector<float>& observations) {
+    std::ofstream out(path);
+    out << "timestamp";
+    for (size_t i = 0; i < kObservationSize; ++i) {
+        out << ",obs_" << i;
+    }
+    out << std::endl;
+    for (size_t row = 0; row * kObservationSize < observations.size(); ++row) {
+        out << row * 20;
+        for (size_t i = 0; i < kObservationSize; ++i) {
+            out << "," << std::fixed << std::setprecision(6) << observations[row * kObservationSize + i];
+        }
+        out << '\n';
+    }
+}
+
+/// @brief 与fp32模型对比动作误差
+/// @return 最大绝对误差相对fp32动作最大绝对值的比例
+double RelativeActionError(MlpPolicy* reference, MlpPolicy* quantized, const std::vector<float>& observations,
+                           double* mean_error) {
+    double max_error = 0.0;
+    double max_action = 0.0;
+    double sum_error = 0.0;
+    size_t count = 0;
+    float expected[kActionSize];
+    float actual[kActionSize];
+    for (size_t row = 0; row * kObservationSize < observations.size(); ++row) {
+        const float* observation = observations.data() + row * kObservationSize;
+        reference->Evaluate(observation, kObservationSize, expected);
+        quantized->Evaluate(observation, kObservationSize, actual);
+        for (size_t i = 0; i < kActionSize; ++i) {
+            double error = std::fabs(static_cast<double>(actual[i]) - expected[i]);
+            max_error = std::max(max_error, error);
+            max_action = std::max(max_action, std::fabs(static_cast<double>(expected[i])));
+            sum_error += error;
+            ++count;
+        }
+    }
+    *mean_error = count > 0 ? sum_error / static_cast<double>(count) : 0.0;
+    return max_action > 0.0 ? max_error / max_action : 0.0;
+}
+
+bool testHalfConversion() {
+    std::cout << "\n=== 测试半精度转换 ===" << std::endl;
+
+    struct Case {
+        float value;
+        uint16_t half;
+    };
+    const Case cases[] = {
+        {0.0f, 0x0000},     {-0.0f, 0x8000},      {1.0f, 0x3c00},      {-2.0f, 0xc000},
+        {65504.0f, 0x7bff}, {1e6f, 0x7c00},       {-1e6f, 0xfc00},     {5.9604645e-8f, 0x0001},
+        {6.1035156e-5f, 0x0400}, {0.33333334f, 0x3555}, {1.00048828125f, 0x3c00},  // 恰在中点，舍入到偶数
+        {1.00146484375f, 0x3c02},                                                   // 中点，向上舍入到偶数
+    };
+    bool ok = true;
+    for (const Case& c : cases) {
+        uint16_t half = FloatToHalf(c.value);
+        if (half != c.half) {
+            std::cout << "✗ FloatToHalf(" << c.value << ") = 0x" << std::hex << half << "，期望 0x" << c.half << std::dec
+                      << std::endl;
+            ok = false;
+        }
+    }
+
+    // 全部有限的半精度值往返不变
+    for (uint32_t bits = 0; bits < 0x10000; ++bits) {
+        uint16_t half = static_cast<uint16_t>(bits);
+        if ((half & 0x7c00) == 0x7c00) {
+            continue;
+        }
+        if (FloatToHalf(HalfToFloat(half)) != half) {
+            std::cout << "✗ 半精度值 0x" << std::hex << bits << std::dec << " 往返后改变" << std::endl;
+            ok = false;
+            break;
+        }
+    }
+    bool special = std::isinf(HalfToFloat(0x7c00)) && std::isnan(HalfToFloat(0x7e00)) && HalfToFloat(0x3c00) == 1.0f;
+    std::cout << (ok && special ? "✓ 舍入、非规格化数、无穷大与全部有限值的往返均正确" : "✗ 半精度转换错误")
+              << std::endl;
+    return ok && special;
+}
+
+bool testQuantizationError() {
+    std::cout << "\n=== 测试按观察CSV标定后的动作误差（65 -> 512 -> 256 -> 128 -> 12 ELU）===" << std::endl;
+
+    MlpPolicy reference;
+    if (!BuildPolicy(1, &reference)) {
+        return false;
+    }
+    WriteObservationCsv(kCsvPath, RandomObservations(kCalibrationSamples, 2));
+    std::vector<float> calibration;
+    std::string error;
+    bool read = ReadObservationCsv(kCsvPath, kObservationSize, &calibration, &error) &&
+                calibration.size() == kCalibrationSamples * kObservationSize;
+    std::cout << (read ? "✓ 读取 " + std::to_string(calibration.size() / kObservationSize) + " 条观察"
+                       : "✗ 读取CSV失败: " + error)
+              << std::endl;
+    std::remove(kCsvPath);
+    if (!read) {
+        return false;
+    }
+
+    std::vector<float> input_ranges;
+    for (size_t row = 0; row < kCalibrationSamples; ++row) {
+        reference.CalibrateInputRanges(calibration.data() + row * kObservationSize, kObservationSize, &input_ranges);
+    }
+    std::cout << "各层输入的最大范围:";
+    size_t offset = 0;
+    for (size_t layer = 0; layer < reference.LayerCount(); ++layer) {
+        const size_t inputs = reference.LayerInputSize(layer);
+        std::cout << " " << *std::max_element(input_ranges.begin() + offset, input_ranges.begin() + offset + inputs);
+        offset += inputs;
+    }
+    std::cout << std::endl;
+
+    // 在标定之外的观察上评估
+    std::vector<float> evaluation = RandomObservations(kEvaluationSamples, 3);
+    bool ok = true;
+    const WeightPrecision precisions[] = {WeightPrecision::kFloat16, WeightPrecision::kInt8};
+    for (WeightPrecision precision : precisions) {
+        MlpPolicy quantized;
+        if (!quantized.Quantize(reference, precision, input_ranges, &error)) {
+            std::cout << "✗ 量化失败: " << error << std::endl;
+            return false;
+        }
+        double mean_error = 0.0;
+        double relative = RelativeActionError(&reference, &quantized, evaluation, &mean_error);
+        double bound = precision == WeightPrecision::kInt8 ? kInt8ErrorBound : kFloat16ErrorBound;
+        bool passed = relative < bound;
+        std::cout << (passed ? "✓ " : "✗ ") << PrecisionName(precision) << ": 最大误差为fp32动作幅值的 "
+                  << relative * 100.0 << "%（上限 " << bound * 100.0 << "%），平均绝对误差 " << mean_error
+                  << "，权重 " << quantized.WeightBytes() / 1024 << " kB（fp32 " << reference.WeightBytes() / 1024
+                  << " kB）" << std::endl;
+        ok = ok && passed;
+    }
+
+    MlpPolicy uncalibrated;
+    bool rejected = !uncalibrated.Quantize(reference, WeightPrecision::kInt8, std::vector<float>(), &error);
+    std::cout << (rejected ? "✓ 未标定时拒绝int8量化" : "✗ 未标定的int8量化未被拒绝") << std::endl;
+    return ok && rejected;
+}
+
+bool testSafetensorsRoundTrip() {
+    std::cout << "\n=== 测试量化模型的safetensors往返 ===" << std::endl;
+
+    MlpPolicy reference;
+    BuildPolicy(4, &reference);
+    std::vector<float> observations = RandomObservations(200, 5);
+    std::vector<float> input_ranges;
+    for (size_t row = 0; row < 200; ++row) {
+        reference.CalibrateInputRanges(observations.data() + row * kObservationSize, kObservationSize, &input_ranges);
+    }
+
+    bool ok = true;
+    const WeightPrecision precisions[] = {WeightPrecision::kFloat32, WeightPrecision::kFloat16, WeightPrecision::kInt8};
+    for (WeightPrecision precision : precisions) {
+        MlpPolicy quantized;
+        MlpPolicy loaded;
+        std::string error;
+        bool saved = quantized.Quantize(reference, precision, input_ranges, &error) &&
+                     quantized.SaveSafetensors(kModelPath, &error) && loaded.Load(kModelPath, &error);
+        double mean_error = 0.0;
+        bool identical = saved && loaded.IsMapped() && loaded.Precision() == precision &&
+                         loaded.Describe() == quantized.Describe() &&
+                         RelativeActionError(&quantized, &loaded, observations, &mean_error) == 0.0;
+        std::cout << (identical ? "✓ " : "✗ ") << PrecisionName(precision) << ": "
+                  << (saved ? loaded.Describe() + "，映射加载后结果逐位相同" : error) << std::endl;
+        ok = ok && identical;
+    }
+    std::remove(kModelPath);
+    return ok;
+}
+
+bool testBenchmark() {
+#if defined(__aarch64__)
+    const char* platform = "aarch64";
+#else
+    const char* platform = "x86_64";
+#endif
+    std::cout << "\n=== 三种精度的单步推理基准（" << platform << "）===" << std::endl;
+
+    MlpPolicy reference;
+    BuildPolicy(6, &reference);
+    std::vector<float> observations = RandomObservations(256, 7);
+    std::vector<float> input_ranges;
+    for (size_t row = 0; row < 256; ++row) {
+        reference.CalibrateInputRanges(observations.data() + row * kObservationSize, kObservationSize, &input_ranges);
+    }
+
+    bool ok = true;
+    double fp32_p50 = 0.0;
+    const WeightPrecision precisions[] = {WeightPrecision::kFloat32, WeightPrecision::kFloat16, WeightPrecision::kInt8};
+    for (WeightPrecision precision : precisions) {
+        MlpPolicy policy;
+        std::string error;
+        if (!policy.Quantize(reference, precision, input_ranges, &error)) {
+            std::cout << "✗ 量化失败: " << error << std::endl;
+            return false;
+        }
+        float action[kActionSize];
+        for (int i = 0; i < 200; ++i) {
+            policy.Evaluate(observations.data() + (i % 256) * kObservationSize, kObservationSize, action);
+        }
+        LatencyHistogram histogram;
+        for (int i = 0; i < kMeasuredSteps; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            ok = policy.Evaluate(observations.data() + (i % 256) * kObservationSize, kObservationSize, action) && ok;
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            histogram.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+        std::cout << histogram.FormatSummary((std::string("mlp_") + PrecisionName(precision)).c_str()) << std::endl;
+        double p50 = static_cast<double>(histogram.ValueAtPercentile(50));
+        if (precision == WeightPrecision::kFloat32) {
+            fp32_p50 = p50;
+        } else if (p50 > 0) {
+            std::cout << PrecisionName(precision) << " p50 相对fp32: " << fp32_p50 / p50 << " 倍速度，权重 "
+                      << policy.WeightBytes() * 100 / reference.WeightBytes() << "%" << std::endl;
+        }
+    }
+    std::cout << (ok ? "✓ 基准完成" : "✗ 推理失败") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::cout << "量化策略测试程序" << std::endl;
+    std::cout << "================" << std::endl;
+
+    bool ok = testHalfConversion();
+    ok = testQuantizationError() && ok;
+    ok = testSafetensorsRoundTrip() && ok;
+    ok = testBenchmark() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+/// @file test_shadow_policy.cpp
+/// @brief 测试影子策略评估：按观察序号配对在线与影子动作、逐关节偏差统计，以及慢影子策略不拖慢在线推理、落后时丢弃旧观察
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/inference_worker.h"
+#include "../include/shadow_comparator.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+const int kControlTicks = 300;
+const auto kControlPeriod = std::chrono::milliseconds(2);
+
+/// @brief 进程内的假策略：每个动作为观察的第一个元素加上固定偏移，推理耗时 delay 模拟慢模型
+class FakePolicy : public InferenceBackend {
+public:
+    FakePolicy(float action_offset, std::chrono::milliseconds delay) : action_offset_(action_offset), delay_(delay) {}
+
+    bool Connect() override { return true; }
+    bool IsConnected() const override { return true; }
+    void SetRequestDeadline(std::chrono::microseconds) override {}
+
+    inference::InferenceResponse Predict(const std::vector<float>& observation, const std::string& model_type,
+                                         bool deterministic) override {
+        return PredictInPlace(observation.data(), observation.size(), model_type.c_str(), deterministic);
+    }
+
+    const inference::InferenceResponse& PredictInPlace(const float* observation, size_t count, const char*,
+                                                       bool) override {
+        if (delay_.count() > 0) {
+            std::this_thread::sleep_for(delay_);
+        }
+        response_.Clear();
+        response_.set_success(count > 0);
+        for (size_t i = 0; i < kActionSize; ++i) {
+            response_.add_action(observation[0] + action_offset_);
+        }
+        return response_;
+    }
+
+private:
+    float action_offset_;
+    std::chrono::milliseconds delay_;
+    inference::InferenceResponse response_;
+};
+
+bool Near(double actual, double expected) {
+    return std::fabs(actual - expected) < 1e-9;
+}
+
+bool testPairing() {
+    std::cout << "\n=== 测试按观察序号配对 ===" << std::endl;
+
+    std::array<float, kActionSize> zero;
+    zero.fill(0.0f);
+    std::array<float, kActionSize> first;
+    std::array<float, kActionSize> second;
+    for (size_t joint = 0; joint < kActionSize; ++joint) {
+        first[joint] = 0.25f * joint;
+        second[joint] = -0.5f * joint;
+    }
+
+    ShadowComparator comparator;
+    uint64_t seq;
+    const float* live;
+    const float* shadow;
+
+    // 只有一路到达时不配对
+    comparator.AddLive(1, zero.data());
+    comparator.AddShadow(2, second.data());
+    bool waits = !comparator.NextMatch(&seq, &live, &shadow);
+    std::cout << (waits ? "✓ 只有一路动作时等待另一路" : "✗ 未到齐的动作被配对") << std::endl;
+
+    comparator.AddShadow(1, first.data());
+    comparator.AddLive(2, zero.data());
+    bool first_match = comparator.NextMatch(&seq, &live, &shadow) && seq == 1 && shadow[3] == first[3] && live[3] == 0.0f;
+    bool second_match = comparator.NextMatch(&seq, &live, &shadow) && seq == 2 && shadow[3] == second[3];
+    bool drained = !comparator.NextMatch(&seq, &live, &shadow);
+    bool ordered = first_match && second_match && drained;
+    std::cout << (ordered ? "✓ 乱序到达的动作按序号配对、依次取出" : "✗ 配对顺序或内容错误") << std::endl;
+
+    // 序号 1、2 的偏差分别为 0.25j 与 0.5j
+    bool stats = comparator.MatchedCount() == 2 && comparator.LiveCount() == 2 && comparator.ShadowCount() == 2;
+    for (size_t joint = 0; joint < kActionSize; ++joint) {
+        JointDivergence divergence = comparator.Joint(joint);
+        stats = stats && Near(divergence.mean_abs, 0.375 * joint) &&
+                Near(divergence.rms, std::sqrt((0.0625 + 0.25) / 2.0) * joint) && Near(divergence.max_abs, 0.5 * joint);
+    }
+    std::cout << (stats ? "✓ 逐关节平均、均方根与最大偏差正确" : "✗ 逐关节偏差统计错误") << std::endl;
+
+    // 落后 kPendingSlots 个观察的动作被覆盖，不再配对
+    comparator.AddLive(3, zero.data());
+    comparator.AddLive(3 + ShadowComparator::kPendingSlots, zero.data());
+    comparator.AddShadow(3, first.data());
+    bool evicted = !comparator.NextMatch(&seq, &live, &shadow);
+    comparator.AddShadow(3 + ShadowComparator::kPendingSlots, first.data());
+    bool newest = comparator.NextMatch(&seq, &live, &shadow) && seq == 3 + ShadowComparator::kPendingSlots;
+    std::cout << (evicted && newest ? "✓ 落后太多的动作被新动作覆盖" : "✗ 过旧的动作仍被配对") << std::endl;
+
+    // 序号0表示尚无动作
+    comparator.AddLive(0, zero.data());
+    comparator.AddShadow(0, zero.data());
+    bool ignored = !comparator.NextMatch(&seq, &live, &shadow) && comparator.LiveCount() == 4;
+    std::cout << (ignored ? "✓ 忽略序号为0的空动作" : "✗ 空动作被记录") << std::endl;
+
+    comparator.PrintStats();
+    return waits && ordered && stats && evicted && newest && ignored;
+}
+
+bool testSlowShadow() {
+    std::cout << "\n=== 测试慢影子策略不拖慢在线推理 ===" << std::endl;
+
+    // 影子策略每次推理10ms，是控制周期的5倍，仍在 kPendingSlots 个观察之内
+    FakePolicy live_policy(0.0f, std::chrono::milliseconds(0));
+    FakePolicy shadow_policy(0.5f, std::chrono::milliseconds(10));
+    InferenceWorker live_worker(&live_policy);
+    InferenceWorker shadow_worker(&shadow_policy);
+    shadow_worker.SetName("shadow");
+    shadow_worker.SetTracing(false);  // 非gRPC后端上关闭追踪是空操作
+    if (!live_worker.Start() || !shadow_worker.Start()) {
+        std::cout << "✗ 无法启动推理线程" << std::endl;
+        return false;
+    }
+
+    ShadowComparator comparator;
+    ActionSample live_sample;
+    ActionSample shadow_sample;
+    std::vector<float> observation(kObservationSize, 0.0f);
+    double max_submit_us = 0.0;
+    bool offsets = true;
+    uint64_t last_seq = 0;
+    bool increasing = true;
+    auto next_tick = std::chrono::steady_clock::now();
+    for (int tick = 1; tick <= kControlTicks; ++tick) {
+        observation[0] = static_cast<float>(tick);
+        auto start = std::chrono::steady_clock::now();
+        live_worker.SubmitObservation(observation, "flat_terrain");
+        shadow_worker.SubmitObservation(observation, "flat_terrain");
+        max_submit_us = std::max(max_submit_us, std::chrono::duration<double, std::micro>(
+                                                    std::chrono::steady_clock::now() - start).count());
+
+        if (live_worker.FetchLatestAction(&live_sample)) {
+            comparator.AddLive(live_sample.seq, live_sample.data.data());
+        }
+        if (shadow_worker.FetchLatestAction(&shadow_sample)) {
+            comparator.AddShadow(shadow_sample.seq, shadow_sample.data.data());
+        }
+        uint64_t seq;
+        const float* live;
+        const float* shadow;
+        while (comparator.NextMatch(&seq, &live, &shadow)) {
+            // 两路动作来自同一观察：影子动作恰好比在线动作大0.5，在线动作等于该观察的提交序号
+            offsets = offsets && live[0] == static_cast<float>(seq) && shadow[0] - live[0] == 0.5f;
+            increasing = increasing && seq > last_seq;
+            last_seq = seq;
+        }
+
+        next_tick += kControlPeriod;
+        std::this_thread::sleep_until(next_tick);
+    }
+    live_worker.Stop();
+    shadow_worker.Stop();
+
+    InferenceWorkerStats live_stats = live_worker.GetStats();
+    InferenceWorkerStats shadow_stats = shadow_worker.GetStats();
+    live_worker.PrintStats();
+    shadow_worker.PrintStats();
+    comparator.PrintStats();
+
+    bool fast_submit = max_submit_us < 1000.0;
+    std::cout << (fast_submit ? "✓" : "✗") << " 提交观察最长耗时 " << max_submit_us << " us，不等待影子推理"
+              << std::endl;
+    // 理想情况下在线策略约完成影子策略的5倍，只要求2倍，留出调度抖动的余量
+    bool live_kept_up = live_stats.completed > shadow_stats.completed * 2;
+    std::cout << (live_kept_up ? "✓" : "✗") << " 在线策略完成 " << live_stats.completed << " 次推理，影子策略 "
+              << shadow_stats.completed << " 次" << std::endl;
+    bool dropped = shadow_stats.overwritten > 0;
+    std::cout << (dropped ? "✓" : "✗") << " 影子策略落后时丢弃了 " << shadow_stats.overwritten << " 个旧观察"
+              << std::endl;
+    // 控制线程只取最新的在线动作，被更新动作取代的在线动作没有可配对的影子动作
+    bool matched = comparator.MatchedCount() * 2 >= shadow_stats.completed && offsets && increasing;
+    std::cout << (matched ? "✓" : "✗") << " 配对 " << comparator.MatchedCount() << " 个动作，均来自同一观察"
+              << std::endl;
+    return fast_submit && live_kept_up && dropped && matched;
+}
+
+int main() {
+    std::cout << "影子策略评估测试程序" << std::endl;
+    std::cout << "====================" << std::endl;
+
+    bool ok = testPairing();
+    ok = testSlowShadow() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
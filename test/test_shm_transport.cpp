@@ -0,0 +1,161 @@
+/// @file test_shm_transport.cpp
+/// @brief 测试共享内存推理传输：跨进程往返延迟、失败与超时、服务器退出
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/shm_transport.h"
+#include "../include/latency_histogram.h"
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+const char* kRegionName = "test_shm_transport";
+const int kWarmupRequests = 1000;
+const int kMeasuredRequests = 20000;
+
+/// @brief 反复连接，直到服务器创建好区域
+bool ConnectWithRetry(ShmClient* client) {
+    for (int i = 0; i < 200; ++i) {
+        if (client->Connect()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+bool testCrossProcessRoundTrip() {
+    std::cout << "\n=== 测试跨进程往返延迟 ===" << std::endl;
+
+    pid_t child = fork();
+    if (child == 0) {
+        ShmServer server(kRegionName);
+        if (!server.Create()) {
+            _exit(1);
+        }
+        server.Run(&ShmServer::Echo);
+        _exit(0);
+    }
+
+    ShmClient client(std::string("shm:") + kRegionName);
+    bool ok = ConnectWithRetry(&client);
+
+    std::vector<float> observation(65);
+    for (size_t i = 0; i < observation.size(); ++i) {
+        observation[i] = 0.01f * static_cast<float>(i);
+    }
+    for (int i = 0; i < kWarmupRequests && ok; ++i) {
+        client.PredictInPlace(observation.data(), observation.size(), "flat_terrain");
+    }
+
+    LatencyHistogram histogram;
+    int succeeded = 0;
+    for (int i = 0; i < kMeasuredRequests && ok; ++i) {
+        observation[0] = static_cast<float>(i);
+        auto start = std::chrono::steady_clock::now();
+        const inference::InferenceResponse& response =
+            client.PredictInPlace(observation.data(), observation.size(), "flat_terrain");
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        histogram.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        if (response.success() && response.action_size() == 12 && response.action(0) == observation[0] &&
+            response.action(11) == observation[11]) {
+            succeeded++;
+        }
+    }
+    std::cout << histogram.FormatSummary("shm_round_trip") << std::endl;
+
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+    shm_unlink((std::string("/") + kRegionName).c_str());
+
+    ok = ok && succeeded == kMeasuredRequests;
+    std::cout << (ok ? "✓ 跨进程请求全部成功" : "✗ 存在失败的请求") << std::endl;
+    return ok;
+}
+
+bool testErrorsAndTimeout() {
+    std::cout << "\n=== 测试失败响应与超时 ===" << std::endl;
+
+    ShmServer server(kRegionName);
+    if (!server.Create()) {
+        std::cout << "✗ 创建区域失败" << std::endl;
+        return false;
+    }
+    std::thread server_thread([&server]() {
+        server.Run([](ShmSlot* slot) {
+            if (strcmp(slot->model_type, "slow") == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+            if (strcmp(slot->model_type, "missing") == 0) {
+                strncpy(slot->error_message, "unknown model", kShmErrorSize - 1);
+                return;
+            }
+            ShmServer::Echo(slot);
+        });
+    });
+
+    ShmClient client(std::string("shm:") + kRegionName);
+    bool ok = client.Connect();
+
+    std::vector<float> observation(65, 1.5f);
+    inference::InferenceResponse missing = client.Predict(observation, "missing");
+    ok = ok && !missing.success() && missing.error_message() == "unknown model";
+
+    // 超时后下一个请求等服务器处理完迟到的请求后照常成功
+    client.SetTimeout(10);
+    const inference::InferenceResponse& slow = client.PredictInPlace(observation.data(), observation.size(), "slow");
+    ok = ok && !slow.success() && slow.error_message() == "Shm: timed out";
+    client.SetTimeout(ShmClient::kDefaultTimeoutMs);
+    for (size_t i = 0; i < 2 * kShmSlotCount; ++i) {
+        const inference::InferenceResponse& response = client.PredictInPlace(observation.data(), observation.size());
+        ok = ok && response.success() && response.action(0) == 1.5f;
+    }
+
+    server.Stop();
+    server_thread.join();
+    std::cout << (ok ? "✓ 失败原因与超时处理正确" : "✗ 失败或超时处理错误") << std::endl;
+    return ok;
+}
+
+bool testServerGone() {
+    std::cout << "\n=== 测试服务器不存在与退出 ===" << std::endl;
+
+    ShmClient absent("shm:test_shm_transport_absent");
+    bool ok = !absent.Connect();
+
+    ShmClient client(std::string("shm:") + kRegionName);
+    {
+        ShmServer server(kRegionName);
+        ok = server.Create() && ok;
+        std::thread server_thread([&server]() {
+            server.ServeOnce(&ShmServer::Echo, 1000);
+        });
+        ok = client.Connect() && ok;
+        server_thread.join();
+    }
+    std::vector<float> observation(65, 0.0f);
+    inference::InferenceResponse response = client.Predict(observation);
+    ok = ok && !response.success() && response.error_message() == "Shm: server stopped";
+    std::cout << (ok ? "✓ 服务器不存在或退出时立即失败" : "✗ 服务器不存在或退出时处理错误") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::cout << "共享内存推理传输测试程序" << std::endl;
+    std::cout << "========================" << std::endl;
+
+    // 跨进程测试在创建任何线程之前fork
+    bool ok = testCrossProcessRoundTrip();
+    ok = testErrorsAndTimeout() && ok;
+    ok = testServerGone() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/// @file test_stale_action_policy.cpp
+/// @brief 测试过期动作策略：错过周期的计数、保持、衰减与阻尼
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/stale_action_policy.h"
+#include <cmath>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+const std::chrono::milliseconds kPeriod(20);
+const std::chrono::milliseconds kTick(5);
+
+StaleActionConfig MakeConfig(StaleActionMode mode, int damp_after) {
+    StaleActionConfig config;
+    config.mode = mode;
+    config.policy_period = kPeriod;
+    config.decay_per_period = 0.5;
+    config.damp_after = damp_after;
+    return config;
+}
+
+bool testOnTimeActions() {
+    std::cout << "\n=== 测试按时到达的动作 ===" << std::endl;
+
+    // 每个周期提交一个观察，动作在15ms后到达，所用动作的年龄在15ms到35ms之间
+    StaleActionPolicy policy(MakeConfig(StaleActionMode::kHold, 3));
+    Clock::time_point start = Clock::now();
+    policy.Start(start);
+    bool ok = true;
+    uint64_t seq = 0;
+    Clock::time_point obs_stamp;
+    for (int tick = 0; tick < 400; ++tick) {
+        Clock::time_point now = start + tick * kTick;
+        if (tick % 4 == 3) {
+            seq++;
+            obs_stamp = now - std::chrono::milliseconds(15);
+        }
+        ok = policy.Update(seq, obs_stamp, now) == ActionFallback::kFresh && ok;
+    }
+
+    StaleActionStats stats = policy.GetStats();
+    ok = ok && stats.missed_periods == 0 && stats.held_ticks == 0 && policy.MissHistogram(0) == 400 &&
+         policy.AgeHistogram().Count() == 400 - 3;
+    std::cout << (ok ? "✓ 按时到达时不计错过" : "✗ 按时到达的动作被计为过期") << std::endl;
+    return ok;
+}
+
+bool testHoldAndDamping() {
+    std::cout << "\n=== 测试保持与阻尼 ===" << std::endl;
+
+    StaleActionPolicy policy(MakeConfig(StaleActionMode::kHold, 3));
+    Clock::time_point start = Clock::now();
+    policy.Start(start);
+    Clock::time_point obs_stamp = start;
+
+    // 年龄达到2个周期时错过第1个周期，保持上一个动作
+    bool fresh = policy.Update(1, obs_stamp, start + std::chrono::milliseconds(39)) == ActionFallback::kFresh;
+    bool held = policy.Update(1, obs_stamp, start + std::chrono::milliseconds(40)) == ActionFallback::kHold &&
+                policy.MissedPeriods() == 1 && policy.Scale() == 1.0f;
+    held = held && policy.Update(1, obs_stamp, start + std::chrono::milliseconds(65)) == ActionFallback::kHold &&
+           policy.MissedPeriods() == 2;
+    std::cout << (fresh && held ? "✓ 错过截止时间后保持上一个动作" : "✗ 保持判断错误") << std::endl;
+
+    // 连续错过3个周期后切换为阻尼，新动作到达后仍保持阻尼
+    bool damping = policy.Update(1, obs_stamp, start + std::chrono::milliseconds(80)) == ActionFallback::kDamping;
+    damping = damping && policy.Update(2, start + std::chrono::milliseconds(85), start + std::chrono::milliseconds(90)) ==
+                             ActionFallback::kDamping;
+    StaleActionStats stats = policy.GetStats();
+    damping = damping && policy.IsDamping() && stats.damping_entries == 1 && stats.damping_ticks == 2 &&
+              stats.missed_periods == 3 && stats.max_missed_streak == 3;
+    std::cout << (damping ? "✓ 连续错过后切换为阻尼并保持" : "✗ 阻尼切换错误") << std::endl;
+
+    // Reset() 后恢复使用新动作
+    policy.Reset(start + std::chrono::milliseconds(100));
+    bool reset = policy.Update(3, start + std::chrono::milliseconds(95), start + std::chrono::milliseconds(100)) ==
+                 ActionFallback::kFresh && !policy.IsDamping();
+    std::cout << (reset ? "✓ Reset() 后退出阻尼" : "✗ Reset() 后仍为阻尼") << std::endl;
+    return fresh && held && damping && reset;
+}
+
+bool testDecay() {
+    std::cout << "\n=== 测试向中立姿态衰减 ===" << std::endl;
+
+    StaleActionPolicy policy(MakeConfig(StaleActionMode::kDecay, 0));
+    Clock::time_point start = Clock::now();
+    policy.Start(start);
+
+    // 从错过截止时间起连续衰减：每多一个周期乘以0.5
+    bool ok = policy.Update(1, start, start + std::chrono::milliseconds(40)) == ActionFallback::kDecay &&
+              std::fabs(policy.Scale() - 1.0f) < 1e-6f;
+    ok = ok && policy.Update(1, start, start + std::chrono::milliseconds(50)) == ActionFallback::kDecay &&
+         std::fabs(policy.Scale() - std::sqrt(0.5f)) < 1e-4f;
+    ok = ok && policy.Update(1, start, start + std::chrono::milliseconds(80)) == ActionFallback::kDecay &&
+         std::fabs(policy.Scale() - 0.25f) < 1e-6f;
+
+    // 从不切换为阻尼，新动作到达后恢复
+    ok = ok && policy.Update(1, start, start + std::chrono::seconds(2)) == ActionFallback::kDecay &&
+         policy.Scale() < 1e-6f && !policy.IsDamping();
+    ok = ok && policy.Update(2, start + std::chrono::milliseconds(1990), start + std::chrono::seconds(2)) ==
+                   ActionFallback::kFresh && policy.Scale() == 1.0f;
+    std::cout << (ok ? "✓ 动作按错过的时长连续衰减" : "✗ 衰减系数错误") << std::endl;
+    return ok;
+}
+
+bool testMissCounting() {
+    std::cout << "\n=== 测试错过周期的计数 ===" << std::endl;
+
+    StaleActionPolicy policy(MakeConfig(StaleActionMode::kHold, 0));
+    Clock::time_point start = Clock::now();
+    policy.Start(start);
+
+    // 尚无动作时从 Start() 起计算，首个动作应在一个周期内到达
+    bool first = policy.Update(0, Clock::time_point(), start + std::chrono::milliseconds(19)) == ActionFallback::kFresh;
+    first = first && policy.Update(0, Clock::time_point(), start + std::chrono::milliseconds(45)) ==
+                         ActionFallback::kHold && policy.MissedPeriods() == 2;
+
+    // 迟到的新动作本身已过期时，不重复计入已计过的周期
+    policy.Update(1, start + std::chrono::milliseconds(10), start + std::chrono::milliseconds(60));
+    StaleActionStats stats = policy.GetStats();
+    bool counted = stats.missed_periods == 2 && policy.MissedPeriods() == 1;
+    policy.Update(1, start + std::chrono::milliseconds(10), start + std::chrono::milliseconds(90));
+    counted = counted && policy.GetStats().missed_periods == 3;
+
+    // 按时的动作结束一次连续错过，之后的错过重新计数
+    policy.Update(2, start + std::chrono::milliseconds(95), start + std::chrono::milliseconds(100));
+    policy.Update(2, start + std::chrono::milliseconds(95), start + std::chrono::milliseconds(135));
+    stats = policy.GetStats();
+    counted = counted && stats.missed_periods == 4 && stats.max_missed_streak == 3 && policy.MissHistogram(0) == 2 &&
+              policy.MissHistogram(1) == 2 && policy.MissHistogram(2) == 1 && policy.MissHistogram(3) == 1;
+    std::cout << (first && counted ? "✓ 错过周期计数正确" : "✗ 错过周期计数错误") << std::endl;
+    policy.PrintStats();
+    return first && counted;
+}
+
+int main() {
+    std::cout << "过期动作策略测试程序" << std::endl;
+    std::cout << "====================" << std::endl;
+
+    bool ok = testOnTimeActions();
+    ok = testHoldAndDamping() && ok;
+    ok = testDecay() && ok;
+    ok = testMissCounting() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+/// @file test_task_executor.cpp
+/// @brief 测试多速率任务调度器的周期、窗口、执行顺序、相位分散与超时统计
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/task_executor.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+bool testPeriodAndWindow() {
+    std::cout << "\n=== 测试周期与运行窗口 ===" << std::endl;
+
+    TaskExecutor executor(5000);
+    std::vector<uint64_t> fast_ticks, slow_ticks, window_ticks;
+    executor.AddTask("fast", 1, [&](uint64_t tick) { fast_ticks.push_back(tick); }, 0);
+    executor.AddTask("slow", 4, [&](uint64_t tick) { slow_ticks.push_back(tick); }, 2);
+    executor.AddTask("window", 1, [&](uint64_t tick) { window_ticks.push_back(tick); }, 0, 3, 6);
+
+    for (int i = 0; i < 12; ++i) {
+        executor.Tick();
+    }
+
+    bool ok = true;
+    if (fast_ticks.size() != 12) {
+        std::cout << "✗ 周期1的任务应每拍运行，实际 " << fast_ticks.size() << " 次" << std::endl;
+        ok = false;
+    }
+    if (slow_ticks != std::vector<uint64_t>({2, 6, 10})) {
+        std::cout << "✗ 周期4相位2的任务运行节拍错误" << std::endl;
+        ok = false;
+    }
+    if (window_ticks != std::vector<uint64_t>({3, 4, 5})) {
+        std::cout << "✗ 窗口 [3,6) 的任务运行节拍错误" << std::endl;
+        ok = false;
+    }
+    if (executor.CurrentTick() != 12 || executor.MsToTicks(10000) != 2000) {
+        std::cout << "✗ 节拍计数或换算错误" << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "✓ 周期与窗口正确" : "✗ 周期与窗口错误") << std::endl;
+    return ok;
+}
+
+bool testFixedOrder() {
+    std::cout << "\n=== 测试同一节拍内的执行顺序 ===" << std::endl;
+
+    TaskExecutor executor(5000);
+    std::string trace;
+    executor.AddTask("a", 2, [&](uint64_t) { trace += 'a'; }, 0);
+    executor.AddTask("b", 1, [&](uint64_t) { trace += 'b'; }, 0);
+    executor.AddTask("c", 2, [&](uint64_t) { trace += 'c'; }, 0);
+
+    executor.Tick();
+    executor.Tick();
+
+    bool ok = trace == "abcb";
+    std::cout << "执行序列: " << trace << std::endl;
+    std::cout << (ok ? "✓ 按注册顺序执行" : "✗ 执行顺序错误") << std::endl;
+    return ok;
+}
+
+bool testAutoPhaseSpreading() {
+    std::cout << "\n=== 测试自动相位分散 ===" << std::endl;
+
+    TaskExecutor executor(5000);
+    auto noop = [](uint64_t) {};
+    executor.AddTask("control", 1, noop);
+    int policy = executor.AddTask("policy", 4, noop);
+    int estimator = executor.AddTask("estimator", 4, noop);
+    int flush = executor.AddTask("flush", 20, noop);
+    int monitor = executor.AddTask("monitor", 2, noop);
+
+    // 统计一个超周期内每拍运行的任务数
+    int peak = 0;
+    std::vector<int> load(20, 0);
+    for (int i = 0; i < executor.TaskCount(); ++i) {
+        TaskStats stats = executor.GetTaskStats(i);
+        for (int t = stats.phase; t < 20; t += stats.period_ticks) {
+            load[t]++;
+            peak = std::max(peak, load[t]);
+        }
+    }
+
+    bool ok = true;
+    int policy_phase = executor.GetTaskStats(policy).phase;
+    int estimator_phase = executor.GetTaskStats(estimator).phase;
+    int monitor_phase = executor.GetTaskStats(monitor).phase;
+    if (policy_phase == estimator_phase) {
+        std::cout << "✗ 两个同周期任务不应落在同一相位" << std::endl;
+        ok = false;
+    }
+    if (monitor_phase % 2 == policy_phase % 2 && monitor_phase % 2 == estimator_phase % 2) {
+        std::cout << "✗ 周期2的任务应避开已占用的相位" << std::endl;
+        ok = false;
+    }
+    if (peak > 3) {
+        std::cout << "✗ 最坏节拍任务数为 " << peak << "，期望不超过3" << std::endl;
+        ok = false;
+    }
+
+    std::cout << "相位: policy=" << policy_phase << " estimator=" << estimator_phase
+              << " flush=" << executor.GetTaskStats(flush).phase << " monitor=" << monitor_phase
+              << "，最坏节拍任务数 " << peak << std::endl;
+    std::cout << (ok ? "✓ 任务被分散到不同节拍" : "✗ 相位分散失败") << std::endl;
+    return ok;
+}
+
+bool testOverruns() {
+    std::cout << "\n=== 测试超时统计 ===" << std::endl;
+
+    TaskExecutor executor(1000);
+    int slow = executor.AddTask("slow", 2, [](uint64_t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }, 0);
+    int fast = executor.AddTask("fast", 1, [](uint64_t) {}, 0, 0, TaskExecutor::kNoEnd, 500);
+
+    for (int i = 0; i < 6; ++i) {
+        executor.Tick();
+    }
+
+    bool ok = true;
+    TaskStats slow_stats = executor.GetTaskStats(slow);
+    TaskStats fast_stats = executor.GetTaskStats(fast);
+    if (slow_stats.runs != 3 || slow_stats.overruns != 3) {
+        std::cout << "✗ 慢任务应运行3次且全部超时，实际 " << slow_stats.runs << "/" << slow_stats.overruns << std::endl;
+        ok = false;
+    }
+    if (fast_stats.runs != 6 || fast_stats.overruns != 0) {
+        std::cout << "✗ 快任务不应超时" << std::endl;
+        ok = false;
+    }
+    if (executor.TickOverruns() != 3) {
+        std::cout << "✗ 节拍超时次数应为3，实际 " << executor.TickOverruns() << std::endl;
+        ok = false;
+    }
+    if (executor.AddTask("bad", 4, [](uint64_t) {}, 4) != -1) {
+        std::cout << "✗ 非法相位应注册失败" << std::endl;
+        ok = false;
+    }
+
+    executor.PrintStats();
+    std::cout << (ok ? "✓ 超时统计正确" : "✗ 超时统计错误") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::cout << "任务调度器测试程序" << std::endl;
+    std::cout << "==================" << std::endl;
+
+    bool ok = testPeriodAndWindow();
+    ok = testFixedOrder() && ok;
+    ok = testAutoPhaseSpreading() && ok;
+    ok = testOverruns() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+/// @file test_trace_recorder.cpp
+/// @brief 测试时间线记录：事件导出、环形覆盖、并发导出与 SIGUSR1 快照
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/trace_recorder.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+const char* kTracePath = "/tmp/test_trace_recorder.json";
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+size_t CountOf(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+bool testDisabled() {
+    std::cout << "\n=== 测试未启用时不记录 ===" << std::endl;
+
+    TraceRecorder& recorder = TraceRecorder::Instance();
+    recorder.Begin("disabled_phase");
+    recorder.End("disabled_phase");
+    recorder.Dump(kTracePath);
+
+    bool ok = !recorder.IsEnabled() && CountOf(ReadFile(kTracePath), "disabled_phase") == 0;
+    std::cout << (ok ? "✓ 未启用时忽略事件" : "✗ 未启用时记录了事件") << std::endl;
+    return ok;
+}
+
+bool testThreadsAndEvents() {
+    std::cout << "\n=== 测试多线程事件导出 ===" << std::endl;
+
+    TraceRecorder& recorder = TraceRecorder::Instance();
+    recorder.SetThreadName("control");
+    for (int i = 0; i < 10; ++i) {
+        recorder.Begin("control_tick");
+        recorder.Begin("send_cmd");
+        recorder.End("send_cmd");
+        recorder.End("control_tick");
+    }
+    std::thread worker([&recorder]() {
+        recorder.SetThreadName("inference");
+        for (int i = 0; i < 5; ++i) {
+            recorder.Begin("grpc_round_trip");
+            recorder.End("grpc_round_trip");
+            recorder.Instant("state_packet");
+        }
+    });
+    worker.join();
+
+    if (!recorder.Dump(kTracePath)) {
+        std::cout << "✗ 导出失败" << std::endl;
+        return false;
+    }
+    std::string trace = ReadFile(kTracePath);
+
+    bool ok = CountOf(trace, "\"name\":\"control_tick\",\"ph\":\"B\"") == 10 &&
+              CountOf(trace, "\"name\":\"send_cmd\",\"ph\":\"E\"") == 10 &&
+              CountOf(trace, "\"name\":\"grpc_round_trip\"") == 10 &&
+              CountOf(trace, "\"name\":\"state_packet\",\"ph\":\"i\"") == 5 &&
+              CountOf(trace, "\"args\":{\"name\":\"control\"}") == 1 &&
+              CountOf(trace, "\"args\":{\"name\":\"inference\"}") == 1 &&
+              trace.find("{\"displayTimeUnit") == 0 && trace.find("\n]}") != std::string::npos;
+    std::cout << (ok ? "✓ 事件与线程名正确导出" : "✗ 导出内容错误") << std::endl;
+    return ok;
+}
+
+bool testWrapAround() {
+    std::cout << "\n=== 测试环形缓冲区覆盖 ===" << std::endl;
+
+    TraceRecorder& recorder = TraceRecorder::Instance();
+    std::thread writer([&recorder]() {
+        // 开始事件落在偶数位置，覆盖后缓冲区以一个结束事件开头
+        recorder.Begin("first");
+        recorder.End("first");
+        for (size_t i = 0; i < TraceRecorder::kEventsPerThread / 2; ++i) {
+            recorder.Begin("wrapped");
+            recorder.End("wrapped");
+        }
+        recorder.Instant("marker");
+        recorder.Begin("last");
+        recorder.End("last");
+    });
+    writer.join();
+
+    recorder.Dump(kTracePath);
+    std::string trace = ReadFile(kTracePath);
+
+    size_t wrapped_begin = CountOf(trace, "\"name\":\"wrapped\",\"ph\":\"B\"");
+    size_t wrapped_end = CountOf(trace, "\"name\":\"wrapped\",\"ph\":\"E\"");
+    bool ok = CountOf(trace, "\"name\":\"first\"") == 0 && CountOf(trace, "\"name\":\"last\"") == 2 &&
+              CountOf(trace, "\"name\":\"marker\"") == 1 && wrapped_begin == wrapped_end &&
+              wrapped_begin == TraceRecorder::kEventsPerThread / 2 - 2;
+    std::cout << "保留 wrapped 开始/结束事件: " << wrapped_begin << "/" << wrapped_end << std::endl;
+    std::cout << (ok ? "✓ 只保留最近的事件且成对" : "✗ 覆盖处理错误") << std::endl;
+    return ok;
+}
+
+bool testConcurrentDumpAndSignal() {
+    std::cout << "\n=== 测试并发导出与 SIGUSR1 快照 ===" << std::endl;
+
+    TraceRecorder& recorder = TraceRecorder::Instance();
+    std::string snapshot_path = std::string(kTracePath) + ".1";
+    unlink(snapshot_path.c_str());
+
+    std::atomic<bool> stop(false);
+    std::atomic<bool> started(false);
+    std::thread writer([&]() {
+        recorder.SetThreadName("writer");
+        started.store(true, std::memory_order_release);
+        while (!stop.load(std::memory_order_relaxed)) {
+            recorder.Begin("busy");
+            recorder.End("busy");
+        }
+    });
+
+    while (!started.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+    bool ok = true;
+    for (int i = 0; i < 5; ++i) {
+        ok = recorder.Dump(kTracePath) && ok;
+    }
+    kill(getpid(), SIGUSR1);
+    for (int i = 0; i < 200 && access(snapshot_path.c_str(), F_OK) != 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    stop.store(true, std::memory_order_relaxed);
+    writer.join();
+
+    std::string snapshot = ReadFile(snapshot_path);
+    ok = ok && CountOf(snapshot, "\"args\":{\"name\":\"writer\"}") == 1 && snapshot.find("\n]}") != std::string::npos;
+    std::cout << (ok ? "✓ 记录中导出与信号快照成功" : "✗ 并发导出或信号快照失败") << std::endl;
+    unlink(snapshot_path.c_str());
+    return ok;
+}
+
+int main() {
+    std::cout << "时间线记录测试程序" << std::endl;
+    std::cout << "==================" << std::endl;
+
+    bool ok = testDisabled();
+    if (!TraceRecorder::Instance().Enable(kTracePath)) {
+        std::cout << "✗ 启用失败" << std::endl;
+        return 1;
+    }
+    ok = testThreadsAndEvents() && ok;
+    ok = testWrapAround() && ok;
+    ok = testConcurrentDumpAndSignal() && ok;
+    TraceRecorder::Instance().Disable();
+    unlink(kTracePath);
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/// @file test_triple_buffer.cpp
+/// @brief 测试无锁三缓冲的单线程语义与跨线程数据一致性
+/// @version 0.1
+/// @date 2026-10-16
+
+#include "../include/triple_buffer.h"
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+struct Payload {
+    uint64_t seq;
+    float values[65];
+};
+
+bool testSingleThread() {
+    std::cout << "\n=== 测试单线程语义 ===" << std::endl;
+
+    TripleBuffer<Payload> buffer;
+    bool ok = true;
+
+    // 尚未发布时不应读到新数据
+    if (buffer.Update()) {
+        std::cout << "✗ 未发布时 Update() 返回了 true" << std::endl;
+        ok = false;
+    }
+
+    buffer.WriteBuffer().seq = 1;
+    bool overwritten = buffer.Publish();
+    if (overwritten) {
+        std::cout << "✗ 首次发布不应报告覆盖" << std::endl;
+        ok = false;
+    }
+
+    // 连续发布两次，第一次的数据应被覆盖
+    buffer.WriteBuffer().seq = 2;
+    overwritten = buffer.Publish();
+    if (!overwritten) {
+        std::cout << "✗ 未读取的数据被覆盖时应报告覆盖" << std::endl;
+        ok = false;
+    }
+
+    if (!buffer.Update() || buffer.ReadBuffer().seq != 2) {
+        std::cout << "✗ 应读到最新的数据 seq=2" << std::endl;
+        ok = false;
+    }
+    if (buffer.Update()) {
+        std::cout << "✗ 数据已被读取，Update() 应返回 false" << std::endl;
+        ok = false;
+    }
+    if (buffer.ReadBuffer().seq != 2) {
+        std::cout << "✗ 读取缓冲区应保持 seq=2" << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "✓ 单线程语义正确" : "✗ 单线程语义错误") << std::endl;
+    return ok;
+}
+
+bool testConcurrentConsistency() {
+    std::cout << "\n=== 测试跨线程数据一致性 ===" << std::endl;
+
+    const uint64_t kIterations = 2000000;
+    TripleBuffer<Payload> buffer;
+    std::atomic<bool> done(false);
+
+    std::thread producer([&]() {
+        for (uint64_t seq = 1; seq <= kIterations; ++seq) {
+            Payload& payload = buffer.WriteBuffer();
+            payload.seq = seq;
+            for (int i = 0; i < 65; ++i) {
+                payload.values[i] = static_cast<float>(seq % 1000) + i;
+            }
+            buffer.Publish();
+        }
+        done = true;
+    });
+
+    uint64_t last_seq = 0;
+    uint64_t reads = 0;
+    bool ok = true;
+    while (ok) {
+        bool finished = done;
+        if (!buffer.Update()) {
+            if (finished) {
+                break;
+            }
+            continue;
+        }
+        const Payload& payload = buffer.ReadBuffer();
+        ++reads;
+
+        // 序号必须单调递增
+        if (payload.seq <= last_seq) {
+            std::cout << "✗ 序号倒退: " << payload.seq << " <= " << last_seq << std::endl;
+            ok = false;
+            break;
+        }
+        // 同一条数据不能被撕裂
+        for (int i = 0; i < 65; ++i) {
+            if (payload.values[i] != static_cast<float>(payload.seq % 1000) + i) {
+                std::cout << "✗ 数据撕裂: seq=" << payload.seq << " index=" << i << std::endl;
+                ok = false;
+                break;
+            }
+        }
+        last_seq = payload.seq;
+    }
+    producer.join();
+
+    if (last_seq != kIterations) {
+        std::cout << "✗ 最终未读到最新数据: " << last_seq << std::endl;
+        ok = false;
+    }
+
+    std::cout << "读取次数: " << reads << " / 发布次数: " << kIterations << std::endl;
+    std::cout << (ok ? "✓ 跨线程数据一致" : "✗ 跨线程数据不一致") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::cout << "三缓冲测试程序" << std::endl;
+    std::cout << "==============" << std::endl;
+
+    bool ok = testSingleThread();
+    ok = testConcurrentConsistency() && ok;
+
+    std::cout << "\n" << (ok ? "所有测试通过" : "存在失败的测试") << std::endl;
+    return ok ? 0 : 1;
+}